@@ -51,6 +51,13 @@ namespace clan
 		/// \brief Calculate a CRC32 checksum on the data. 
 		static uint32_t crc32(const void *data, int size, uint32_t running_crc = 0);
 
+		/// \brief Calculate the CRC32 checksum of two concatenated blocks from the checksum of each block
+		///
+		/// \param crc1 = Checksum of the first block
+		/// \param crc2 = Checksum of the second block
+		/// \param size2 = Length of the second block in bytes
+		static uint32_t crc32_combine(uint32_t crc1, uint32_t crc2, int64_t size2);
+
 		/// \brief Calculate a CRC32 checksum on the data. 
 		static uint32_t adler32(const void *data, int size, uint32_t running_adler32 = 0);
 
@@ -0,0 +1,181 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#pragma once
+
+#include "file_system.h"
+#include "../System/databuffer.h"
+#include <memory>
+#include <functional>
+#include <string>
+
+namespace clan
+{
+	/// \addtogroup clanCore_I_O_Data clanCore I/O Data
+	/// \{
+
+	class AsyncFileRequest_Impl;
+	class AsyncFileLoader_Impl;
+
+	/// \brief Handle to a file read queued on an AsyncFileLoader
+	///
+	/// Request objects are handles and can be copied freely; all copies refer to the same request.
+	class AsyncFileRequest
+	{
+	public:
+		/// \brief Request states
+		enum Status
+		{
+			/// \brief Waiting for an I/O thread
+			status_pending,
+
+			/// \brief Being read by an I/O thread
+			status_reading,
+
+			/// \brief The file was read successfully
+			status_completed,
+
+			/// \brief The file could not be read. See get_error()
+			status_failed,
+
+			/// \brief The request was cancelled before it completed
+			status_cancelled
+		};
+
+		/// \brief Constructs a null instance
+		AsyncFileRequest();
+
+		/// \brief Returns true if this object is invalid
+		bool is_null() const { return !impl; }
+
+		/// \brief Throw an exception if this object is invalid
+		void throw_if_null() const;
+
+		/// \brief Returns the name of the file being read
+		std::string get_filename() const;
+
+		/// \brief Returns the priority the request was queued with
+		int get_priority() const;
+
+		/// \brief Returns the current state of the request
+		Status get_status() const;
+
+		/// \brief Returns true if the request has completed, failed or been cancelled
+		bool is_done() const;
+
+		/// \brief Cancels the request
+		///
+		/// A pending request is cancelled immediately. A request that is being read stops at the next chunk boundary,
+		/// unless the read finishes first. The completion callback is not called for cancelled requests.
+		void cancel();
+
+		/// \brief Blocks until the request is done
+		void wait() const;
+
+		/// \brief Blocks until the request is done or the timeout expires
+		///
+		/// \return true if the request is done
+		bool wait(int timeout_ms) const;
+
+		/// \brief Returns the file contents, waiting for the request if it is not done yet
+		///
+		/// Throws an exception if the request failed or was cancelled.
+		DataBuffer get_data() const;
+
+		/// \brief Returns the error message of a failed request
+		std::string get_error() const;
+
+	private:
+		AsyncFileRequest(const std::shared_ptr<AsyncFileRequest_Impl> &impl) : impl(impl) { }
+
+		std::shared_ptr<AsyncFileRequest_Impl> impl;
+
+		friend class AsyncFileLoader;
+		friend class AsyncFileLoader_Impl;
+	};
+
+	/// \brief Reads files on a bounded pool of I/O threads
+	///
+	/// Requests are served highest priority first, and in the order they were queued within a priority.
+	/// Files are read in chunks through FileSystem::open_file, so both native and zip file systems are supported.
+	/// The file systems passed to read_bytes must not be mounted or unmounted while their requests are pending.
+	///
+	/// Completion callbacks are handed to the dispatcher given to the constructor. Without a dispatcher they are
+	/// queued until process_completed() is called. A display application can pass RunLoop::main_thread_async
+	/// as the dispatcher to receive its completions on the main thread.
+	class AsyncFileLoader
+	{
+	public:
+		typedef std::function<void(std::function<void()>)> Dispatcher;
+		typedef std::function<void(const AsyncFileRequest &)> Callback;
+
+		/// \brief Constructs an async file loader
+		///
+		/// \param num_threads Number of I/O threads (clamped to 1-16)
+		/// \param dispatcher Function used to invoke completion callbacks, or empty to queue them for process_completed()
+		AsyncFileLoader(int num_threads = 2, const Dispatcher &dispatcher = Dispatcher());
+
+		/// \brief Cancels all pending requests and waits for the I/O threads to exit
+		~AsyncFileLoader();
+
+		/// \brief Queues a read of a file in the native file system
+		///
+		/// \param filename File to read
+		/// \param priority Higher priority requests are read first
+		/// \param callback Called with the request when it has completed or failed
+		AsyncFileRequest read_bytes(const std::string &filename, int priority = 0, const Callback &callback = Callback());
+
+		/// \brief Queues a read of a file in a virtual file system
+		///
+		/// \param fs File system used to open the file
+		/// \param filename File to read
+		/// \param priority Higher priority requests are read first
+		/// \param callback Called with the request when it has completed or failed
+		AsyncFileRequest read_bytes(const FileSystem &fs, const std::string &filename, int priority = 0, const Callback &callback = Callback());
+
+		/// \brief Returns the number of requests that are queued or being read
+		int get_requests_pending() const;
+
+		/// \brief Returns the number of I/O threads
+		int get_num_threads() const;
+
+		/// \brief Cancels every request that has not completed yet
+		void cancel_all();
+
+		/// \brief Invokes the completion callbacks queued since the last call
+		///
+		/// Only used when the loader has no dispatcher. Call it periodically on the thread that should receive completions.
+		void process_completed();
+
+	private:
+		std::shared_ptr<AsyncFileLoader_Impl> impl;
+	};
+
+	/// \}
+}
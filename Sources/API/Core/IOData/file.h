@@ -37,6 +37,9 @@ namespace clan
 	/// \{
 
 	/// \brief File I/O device.
+	///
+	/// Files use a 4 KB read-ahead buffer unless opened with flag_no_buffering or flag_memory_mapped. Writes are unbuffered
+	/// by default. See IODevice::set_buffer_size.
 	class File : public IODevice
 	{
 	public:
@@ -107,7 +110,10 @@ namespace clan
 			flag_write_through = 1,
 			flag_no_buffering = 2,
 			flag_random_access = 4,
-			flag_sequential_scan = 8
+			flag_sequential_scan = 8,
+
+			/// \brief Map the file into memory. Requires open_existing and access_read only. See IODevice::get_mapped_data.
+			flag_memory_mapped = 16
 		};
 
 		/// \brief Constructs a file object.
@@ -131,6 +137,11 @@ namespace clan
 
 		~File();
 
+		/// \brief Opens an existing file read only and maps it into memory
+		///
+		/// Reads are served from the mapping and IODevice::get_mapped_data returns a pointer to the whole file.
+		static File open_mapped(const std::string &filename);
+
 		/// \brief Opens a file read only.
 		///
 		/// PathHelp::normalize(filename, PathHelp::path_type_file) is called
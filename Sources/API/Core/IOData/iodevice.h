@@ -88,6 +88,13 @@ namespace clan
 			\return The size (-1 if position is unknown)*/
 		int get_position() const;
 
+		/// \brief Returns a pointer to the entire data stream if it is available in memory.
+		///
+		/// Memory mapped files and memory devices return their data, which lets loaders parse in place instead of copying
+		/// it with receive. The pointer is valid while the device is open and the size is unchanged.
+		/** \return The data (nullptr if the data stream is not in memory)*/
+		const void *get_mapped_data() const;
+
 		/// \brief Returns true if the input source is in little endian mode.
 		/** \return true if little endian*/
 		bool is_little_endian() const;
@@ -96,8 +103,32 @@ namespace clan
 		const IODeviceProvider *get_provider() const;
 
 		/// \brief Returns the provider for this object
+		///
+		/// Pending buffered writes are flushed and unread buffered data is given back to the provider before it is returned.
 		IODeviceProvider *get_provider();
 
+		/// \brief Returns the size of the read-ahead buffer (0 if reads are not buffered)
+		int get_read_ahead_size() const;
+
+		/// \brief Returns the size of the write-behind buffer (0 if writes are not buffered)
+		int get_write_behind_size() const;
+
+		/// \brief Sets the size of the read-ahead and write-behind buffers.
+		///
+		/// Small reads, including the typed read functions, are served from the read-ahead buffer and only reach the provider
+		/// when it runs empty. Small writes are collected in the write-behind buffer until it is full, flush() is called, or
+		/// the device reads, seeks or is destroyed. Requests larger than a buffer go directly to the provider.
+		///
+		/// Mixing buffered reads and writes requires a seekable provider. Write errors detected when the device is destroyed
+		/// are lost, so call flush() when write-behind buffering is enabled.
+		///
+		/// \param read_ahead_size Size of the read-ahead buffer in bytes (0 = unbuffered)
+		/// \param write_behind_size Size of the write-behind buffer in bytes (0 = unbuffered)
+		void set_buffer_size(int read_ahead_size, int write_behind_size = 0);
+
+		/// \brief Writes any data held in the write-behind buffer to the provider
+		void flush();
+
 		/// \brief Send data to device.
 		/** If the device databuffer is too small, it will be extended (ie grow memory block size or file size)
 			\param data Data to send
@@ -63,6 +63,9 @@ namespace clan
 
 		/// \brief Seek in data stream.
 		virtual bool seek(int /*position*/, IODevice::SeekMode /*mode*/) { return false; }
+
+		/// \brief Returns a pointer to the entire data stream, or nullptr if the stream is not available in memory.
+		virtual const void *get_mapped_data() const { return nullptr; }
 	};
 
 	/// \}
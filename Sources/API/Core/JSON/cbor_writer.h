@@ -0,0 +1,81 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include "json_value.h"
+
+namespace clan
+{
+	/// \addtogroup clanCore_JSON clanCore JSON
+	/// \{
+
+	class IODevice;
+	class CborWriter_Impl;
+
+	/// \brief Streaming CBOR (RFC 8949) encoder
+	///
+	/// Writes values one at a time so large arrays and objects never need to exist as a whole in memory.
+	/// Output is collected in a 64 KB buffer and written to the device when it fills up, on flush() and on destruction.
+	///
+	/// Containers started with a count must receive exactly that many values (for objects: key and value pairs).
+	/// Containers started without a count are written with indefinite length.
+	class CborWriter
+	{
+	public:
+		CborWriter(IODevice &device);
+		~CborWriter();
+
+		void begin_array();
+		void begin_array(size_t count);
+		void end_array();
+
+		void begin_object();
+		void begin_object(size_t count);
+		void end_object();
+
+		/// \brief Writes the key of the next object member
+		void write_key(const std::string &key);
+
+		void write_value(const JsonValue &value);
+		void write_string(const std::string &value);
+		void write_number(double value);
+		void write_boolean(bool value);
+		void write_null();
+
+		/// \brief Writes buffered output to the device
+		void flush();
+
+	private:
+		std::shared_ptr<CborWriter_Impl> impl;
+	};
+
+	/// \}
+}
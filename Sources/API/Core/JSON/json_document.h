@@ -0,0 +1,235 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include "json_value.h"
+
+namespace clan
+{
+	/// \addtogroup clanCore_JSON clanCore JSON
+	/// \{
+
+	class JsonReader;
+	class JsonDocument_Impl;
+	class JsonNodeMember;
+	class JsonNodeItems;
+	class JsonNodeProperties;
+	struct JsonNodeData;
+	struct JsonMemberData;
+
+	/// \brief Read-only value in a JsonDocument
+	///
+	/// A node is a pointer into the document and is only valid while the document is alive. A default constructed
+	/// node, or the result of looking up a missing property, is undefined.
+	class JsonNode
+	{
+	public:
+		JsonNode() { }
+
+		JsonType type() const;
+		bool is_undefined() const { return type() == JsonType::undefined; }
+		bool is_null() const { return type() == JsonType::null; }
+		bool is_object() const { return type() == JsonType::object; }
+		bool is_array() const { return type() == JsonType::array; }
+		bool is_number() const { return type() == JsonType::number; }
+		bool is_boolean() const { return type() == JsonType::boolean; }
+		bool is_string() const { return type() == JsonType::string; }
+
+		/// \brief Looks up an object member by name
+		JsonNode prop(const std::string &name) const { return prop(name.data(), name.size()); }
+		JsonNode prop(const char *name) const;
+		JsonNode prop(const char *name, size_t length) const;
+
+		/// \brief Returns the number of array items or object members
+		size_t size() const;
+
+		/// \brief Returns an array item
+		JsonNode at(size_t index) const;
+
+		JsonNodeItems items() const;
+		JsonNodeProperties properties() const;
+
+		double to_number() const;
+		bool to_boolean() const;
+		std::string to_string() const;
+
+		/// \brief Returns the string without copying it. The data is null terminated
+		const char *get_string_data() const;
+		size_t get_string_length() const;
+
+		double to_double() const { return to_number(); }
+		float to_float() const { return static_cast<float>(to_number()); }
+		int to_int() const { return static_cast<int>(to_number()); }
+		unsigned int to_uint() const { return static_cast<unsigned int>(to_number()); }
+		short to_short() const { return static_cast<short>(to_number()); }
+		unsigned short to_ushort() const { return static_cast<unsigned short>(to_number()); }
+		char to_char() const { return static_cast<char>(to_number()); }
+		unsigned char to_uchar() const { return static_cast<unsigned char>(to_number()); }
+
+		/// \brief Copies the node into a JsonValue tree
+		JsonValue to_value() const;
+
+		std::string to_json() const;
+
+		JsonNode operator[](const std::string &name) const { return prop(name); }
+		JsonNode operator[](const char *name) const { return prop(name); }
+		JsonNode operator[](size_t index) const { return at(index); }
+
+	private:
+		explicit JsonNode(const JsonNodeData *data) : data(data) { }
+
+		const JsonNodeData *data = nullptr;
+
+		friend class JsonNodeMember;
+		friend class JsonNodeItems;
+		friend class JsonDocument;
+	};
+
+	/// \brief Object member returned when iterating JsonNode::properties()
+	class JsonNodeMember
+	{
+	public:
+		std::string name() const;
+		const char *get_name_data() const;
+		size_t get_name_length() const;
+		JsonNode value() const;
+
+	private:
+		explicit JsonNodeMember(const JsonMemberData *data) : data(data) { }
+
+		const JsonMemberData *data;
+
+		friend class JsonNodeProperties;
+	};
+
+	/// \brief Range over the items of an array node
+	class JsonNodeItems
+	{
+	public:
+		class iterator
+		{
+		public:
+			JsonNode operator*() const { return JsonNode(item); }
+			iterator &operator++();
+			bool operator==(const iterator &other) const { return item == other.item; }
+			bool operator!=(const iterator &other) const { return item != other.item; }
+
+		private:
+			explicit iterator(const JsonNodeData *item) : item(item) { }
+			const JsonNodeData *item;
+			friend class JsonNodeItems;
+		};
+
+		iterator begin() const { return iterator(first); }
+		iterator end() const;
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+		JsonNode operator[](size_t index) const;
+
+	private:
+		JsonNodeItems(const JsonNodeData *first, size_t count) : first(first), count(count) { }
+
+		const JsonNodeData *first;
+		size_t count;
+
+		friend class JsonNode;
+	};
+
+	/// \brief Range over the members of an object node, in document order
+	class JsonNodeProperties
+	{
+	public:
+		class iterator
+		{
+		public:
+			JsonNodeMember operator*() const { return JsonNodeMember(member); }
+			iterator &operator++();
+			bool operator==(const iterator &other) const { return member == other.member; }
+			bool operator!=(const iterator &other) const { return member != other.member; }
+
+		private:
+			explicit iterator(const JsonMemberData *member) : member(member) { }
+			const JsonMemberData *member;
+			friend class JsonNodeProperties;
+		};
+
+		iterator begin() const { return iterator(first); }
+		iterator end() const;
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+
+	private:
+		JsonNodeProperties(const JsonMemberData *first, size_t count) : first(first), count(count) { }
+
+		const JsonMemberData *first;
+		size_t count;
+
+		friend class JsonNode;
+	};
+
+	/// \brief Compact read-only JSON document
+	///
+	/// All nodes, strings and member tables live in one arena owned by the document. Nodes are 16 byte tagged
+	/// variants, arrays and objects store their children contiguously, member names are interned once per document
+	/// and larger objects get an open-addressed hash index. Use JsonValue when the tree needs to be modified.
+	class JsonDocument
+	{
+	public:
+		/// \brief Constructs an undefined document
+		JsonDocument();
+
+		/// \brief Copies a JsonValue tree into a document
+		explicit JsonDocument(const JsonValue &value);
+
+		/// \brief Parses a JSON string
+		static JsonDocument parse(const std::string &json);
+		static JsonDocument parse(const void *data, size_t size);
+
+		/// \brief Builds a document from the value starting at the reader's current token
+		static JsonDocument read(JsonReader &reader);
+
+		/// \brief Returns the root node
+		JsonNode root() const;
+
+		/// \brief Returns the number of bytes reserved by the document's arena
+		size_t get_memory_usage() const;
+
+		JsonNode prop(const std::string &name) const { return root().prop(name); }
+		JsonNode prop(const char *name) const { return root().prop(name); }
+		JsonNode operator[](const std::string &name) const { return root().prop(name); }
+		JsonNode operator[](const char *name) const { return root().prop(name); }
+
+	private:
+		std::shared_ptr<JsonDocument_Impl> impl;
+	};
+
+	/// \}
+}
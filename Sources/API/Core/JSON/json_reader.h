@@ -0,0 +1,130 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include "json_value.h"
+
+namespace clan
+{
+	/// \addtogroup clanCore_JSON clanCore JSON
+	/// \{
+
+	class IODevice;
+	class JsonReader_Impl;
+
+	enum class JsonToken
+	{
+		none,
+		object_begin,
+		object_end,
+		array_begin,
+		array_end,
+		key,
+		string,
+		number,
+		boolean,
+		null,
+		end_of_document,
+		need_more_input
+	};
+
+	/// \brief Pull parser for JSON documents
+	///
+	/// Reads one token at a time without building a tree. Keys and strings are returned as views into the input where
+	/// possible; only strings containing escape sequences are copied. A view stays valid until the next call to next() or feed().
+	///
+	/// Several documents may follow each other in the input (JSON Lines and similar streams). end_of_document is returned once the input ends.
+	class JsonReader
+	{
+	public:
+		/// \brief Constructs a reader for data passed in with feed()
+		JsonReader();
+
+		/// \brief Constructs a reader for a buffer in memory
+		///
+		/// The buffer is not copied and must stay valid while the reader is used.
+		JsonReader(const void *data, size_t size);
+
+		/// \brief Constructs a reader that reads from a device as needed
+		JsonReader(IODevice &device, int buffer_size = 64 * 1024);
+
+		/// \brief Appends input data
+		///
+		/// Only valid for readers constructed without input.
+		void feed(const void *data, size_t size);
+
+		/// \brief Tells the reader that no more data will be fed
+		void feed_end();
+
+		/// \brief Advances to the next token
+		///
+		/// \return The token, or need_more_input if the fed data ends in the middle of a token
+		JsonToken next();
+
+		/// \brief Returns the current token
+		JsonToken get_token() const;
+
+		/// \brief Returns the number of objects and arrays the current token is nested in
+		int get_depth() const;
+
+		/// \brief Returns the key or string of the current token
+		const char *get_string_data() const;
+		size_t get_string_length() const;
+		std::string get_string() const;
+
+		/// \brief Returns true if the key or string of the current token equals str
+		bool string_equals(const char *str) const;
+
+		/// \brief Returns the value of a number token
+		double get_number() const;
+
+		/// \brief Returns the source text of a number token
+		std::string get_number_text() const;
+
+		/// \brief Returns the value of a boolean token
+		bool get_boolean() const;
+
+		/// \brief Skips past the value starting at the current token
+		///
+		/// For object_begin and array_begin this reads up to and including the matching end token. Other tokens are left as is.
+		void skip_value();
+
+		/// \brief Builds a JsonValue from the value starting at the current token
+		///
+		/// Reads up to and including the last token of the value. Throws if the fed input ends before the value does.
+		JsonValue read_value();
+
+	private:
+		std::shared_ptr<JsonReader_Impl> impl;
+	};
+
+	/// \}
+}
@@ -36,6 +36,9 @@ namespace clan
 	/// \addtogroup clanCore_JSON clanCore JSON
 	/// \{
 
+	class DataBuffer;
+	class IODevice;
+
 	/// \brief Exception class thrown for JSON exceptions.
 	class JsonException : public Exception
 	{
@@ -73,6 +76,20 @@ namespace clan
 		static JsonValue string(const std::string &value) { JsonValue v; v._type = JsonType::string; v._string = value; return v; }
 
 		static JsonValue parse(const std::string &json);
+
+		/// \brief Encodes the value as CBOR (RFC 8949)
+		///
+		/// Integral numbers are written as CBOR integers, other numbers as single or double precision floats.
+		DataBuffer to_cbor() const;
+		void to_cbor(IODevice &device) const;
+
+		/// \brief Decodes one CBOR data item
+		///
+		/// Byte strings become strings holding the raw bytes, integer map keys become decimal strings and tags are ignored.
+		/// The device version reads exactly the bytes of the item; use IODevice::set_buffer_size to make the many small reads cheap.
+		static JsonValue from_cbor(const DataBuffer &cbor);
+		static JsonValue from_cbor(const void *data, size_t size);
+		static JsonValue from_cbor(IODevice &device);
 		std::string to_json() const;
 
 		const JsonValue &prop(const std::string &name) const { auto it = _properties.find(name); if (it != _properties.end()) return it->second; static JsonValue undef; return undef; }
@@ -63,67 +63,122 @@ namespace clan
 		virtual ~SlotImpl() { }
 	};
 
-	template<typename SlotImplType>
+	template<typename FuncType>
 	class SignalImpl
 	{
 	public:
-		std::vector<std::weak_ptr<SlotImplType>> slots;
+		SignalImpl() { }
+		SignalImpl(const SignalImpl &) = delete;
+		SignalImpl &operator=(const SignalImpl &) = delete;
+
+		~SignalImpl()
+		{
+			for (SlotNode *node : slots)
+				delete node;
+		}
+
+		/// \brief Callback storage owned by the signal, so that it stays alive while an emit is in progress
+		struct SlotNode
+		{
+			SlotNode(const std::function<FuncType> &callback) : callback(callback) { }
+
+			std::function<FuncType> callback;
+			bool connected = true;
+		};
+
+		void disconnect(SlotNode *node)
+		{
+			node->connected = false;
+			if (emit_depth > 0)
+			{
+				// Emit is iterating over the vector. Defer removal until the outermost emit finishes
+				needs_compact = true;
+			}
+			else
+			{
+				for (size_t i = 0; i < slots.size(); i++)
+				{
+					if (slots[i] == node)
+					{
+						slots.erase(slots.begin() + i);
+						break;
+					}
+				}
+				delete node;
+			}
+		}
+
+		void compact()
+		{
+			size_t count = 0;
+			for (size_t i = 0; i < slots.size(); i++)
+			{
+				if (slots[i]->connected)
+					slots[count++] = slots[i];
+				else
+					delete slots[i];
+			}
+			slots.resize(count);
+			needs_compact = false;
+		}
+
+		std::vector<SlotNode *> slots;
+		int emit_depth = 0;
+		bool needs_compact = false;
 	};
 
 	template<typename FuncType>
 	class SlotImplT : public SlotImpl
 	{
 	public:
-		SlotImplT(const std::weak_ptr<SignalImpl<SlotImplT>> &signal, const std::function<FuncType> &callback) : signal(signal), callback(callback)
+		typedef typename SignalImpl<FuncType>::SlotNode SlotNode;
+
+		SlotImplT(const std::weak_ptr<SignalImpl<FuncType>> &signal, SlotNode *node) : signal(signal), node(node)
 		{
 		}
 
 		~SlotImplT()
 		{
-			std::shared_ptr<SignalImpl<SlotImplT>> sig = signal.lock();
+			std::shared_ptr<SignalImpl<FuncType>> sig = signal.lock();
 			if (sig)
-			{
-				for (auto it = sig->slots.begin(); it != sig->slots.end(); ++it)
-				{
-					// todo: investigate if "it->lock().get() == this" is required
-					if (it->expired() || it->lock().get() == this)
-					{
-						it = sig->slots.erase(it);
-						if (it == sig->slots.end())
-							break;
-					}
-				}
-			}
+				sig->disconnect(node);
 		}
 
-		std::weak_ptr<SignalImpl<SlotImplT>> signal;
-		std::function<FuncType> callback;
+		std::weak_ptr<SignalImpl<FuncType>> signal;
+		SlotNode *node;
 	};
 
 	template<typename FuncType>
 	class Signal
 	{
 	public:
-		Signal() : impl(std::make_shared<SignalImpl<SlotImplT<FuncType>>>()) { }
+		Signal() : impl(std::make_shared<SignalImpl<FuncType>>()) { }
 
+		/// \brief Invokes all connected callbacks
+		///
+		/// Dispatch does not allocate or copy the slot list. Slots connected during the emit are not called until the next emit.
+		/// Slots disconnected during the emit are skipped and removed once the outermost emit returns.
 		template<typename... Args>
 		void operator()(Args&&... args)
 		{
-			std::vector<std::weak_ptr<SlotImplT<FuncType>>> slots = impl->slots;
-			for (std::weak_ptr<SlotImplT<FuncType>> &weak_slot : slots)
+			// Keep the signal alive in case a callback destroys the object owning it
+			std::shared_ptr<SignalImpl<FuncType>> sig = impl;
+			EmitScope scope(sig.get());
+
+			size_t count = sig->slots.size();
+			for (size_t i = 0; i < count; i++)
 			{
-				std::shared_ptr<SlotImplT<FuncType>> slot = weak_slot.lock();
-				if (slot)
-				{
-					slot->callback(std::forward<Args>(args)...);
-				}
+				typename SignalImpl<FuncType>::SlotNode *node = sig->slots[i];
+				if (node->connected)
+					node->callback(args...);
 			}
 		}
 
 		Slot connect(const std::function<FuncType> &func)
 		{
-			auto slot_impl = std::make_shared<SlotImplT<FuncType>>(impl, func);
-			impl->slots.push_back(slot_impl);
+			std::unique_ptr<typename SignalImpl<FuncType>::SlotNode> node(new typename SignalImpl<FuncType>::SlotNode(func));
+			auto slot_impl = std::make_shared<SlotImplT<FuncType>>(impl, node.get());
+			impl->slots.push_back(node.release()); // if this throws, ~SlotImplT deletes the node
 			return Slot(slot_impl);
 		}
 
@@ -134,7 +189,22 @@ namespace clan
 		}
 
 	private:
-		std::shared_ptr<SignalImpl<SlotImplT<FuncType>>> impl;
+		class EmitScope
+		{
+		public:
+			EmitScope(SignalImpl<FuncType> *sig) : sig(sig) { sig->emit_depth++; }
+			~EmitScope()
+			{
+				sig->emit_depth--;
+				if (sig->emit_depth == 0 && sig->needs_compact)
+					sig->compact();
+			}
+
+		private:
+			SignalImpl<FuncType> *sig;
+		};
+
+		std::shared_ptr<SignalImpl<FuncType>> impl;
 	};
 
 	class SlotContainer
@@ -0,0 +1,62 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <cstddef>
+
+namespace clan
+{
+	/// \addtogroup clanCore_System clanCore System
+	/// \{
+
+	/// \brief Memory usage counters kept by ArenaAllocator and PoolAllocator when statistics are enabled
+	class AllocatorStatistics
+	{
+	public:
+		/// \brief Bytes currently handed out to the application
+		size_t live_bytes = 0;
+
+		/// \brief Highest value live_bytes has reached
+		size_t peak_live_bytes = 0;
+
+		/// \brief Bytes currently obtained from the system heap
+		size_t reserved_bytes = 0;
+
+		/// \brief Number of allocate calls
+		size_t num_allocations = 0;
+
+		/// \brief Number of individual frees
+		size_t num_frees = 0;
+
+		/// \brief Fraction of the reserved memory not currently handed out (0 to 1)
+		float get_fragmentation() const { return reserved_bytes ? 1.0f - (float)live_bytes / (float)reserved_bytes : 0.0f; }
+	};
+
+	/// \}
+}
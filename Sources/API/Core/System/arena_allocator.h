@@ -0,0 +1,109 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "allocator_statistics.h"
+#include <memory>
+
+namespace clan
+{
+	/// \addtogroup clanCore_System clanCore System
+	/// \{
+
+	class ArenaAllocator_Impl;
+
+	/// \brief Position in an ArenaAllocator that it can be reset back to
+	class ArenaMarker
+	{
+	public:
+		size_t block = 0;
+		size_t pos = 0;
+		size_t live_bytes = 0;
+	};
+
+	/// \brief Bump allocator for short-lived allocations that are released together
+	///
+	/// <p>Unlike BlockAllocator the memory blocks are kept when the arena is reset, so an arena reset every
+	///    frame stops touching the system heap once it has grown to the frame's working set.
+	///    Destructors are never called; only place trivially destructible data in an arena or destroy objects manually.</p>
+	/// <p>An arena is not thread safe. Use one arena per thread, for example the one returned by get_thread_arena().</p>
+	class ArenaAllocator
+	{
+	public:
+		/// \brief Constructs an arena
+		/// \param block_size Size of the first block. Later blocks double in size up to 4 MB
+		/// \param collect_statistics If true, keeps count of allocations in get_statistics()
+		ArenaAllocator(size_t block_size = 64 * 1024, bool collect_statistics = false);
+
+		/// \brief Allocates memory from the arena
+		void *allocate(size_t size, size_t alignment = 16);
+
+		/// \brief Returns the current position, for use with reset(const ArenaMarker &)
+		ArenaMarker get_marker() const;
+
+		/// \brief Releases everything allocated after the marker was taken
+		void reset(const ArenaMarker &marker);
+
+		/// \brief Releases all allocations but keeps the memory blocks for reuse
+		void reset();
+
+		/// \brief Releases all allocations and returns the memory blocks to the system heap
+		void free();
+
+		/// \brief Returns the allocation statistics
+		///
+		/// reserved_bytes is always maintained. The other counters are only maintained if enabled in the constructor.
+		AllocatorStatistics get_statistics() const;
+
+		/// \brief Returns an arena owned by the calling thread
+		///
+		/// The arena is not freed when the thread exits. It is reset and handed to the next thread that gets the same thread id.
+		static ArenaAllocator &get_thread_arena();
+
+	private:
+		std::shared_ptr<ArenaAllocator_Impl> impl;
+	};
+
+	/// \brief Resets an arena to where it was when the scope was entered
+	class ArenaScope
+	{
+	public:
+		ArenaScope(ArenaAllocator &arena = ArenaAllocator::get_thread_arena()) : arena(arena), marker(arena.get_marker()) { }
+		~ArenaScope() { arena.reset(marker); }
+
+	private:
+		ArenaScope(const ArenaScope &) = delete;
+		ArenaScope &operator=(const ArenaScope &) = delete;
+
+		ArenaAllocator &arena;
+		ArenaMarker marker;
+	};
+
+	/// \}
+}
@@ -38,6 +38,10 @@ namespace clan
 	class DataBuffer_Impl;
 
 	/// \brief General purpose data buffer.
+	///
+	/// Copies of a DataBuffer object refer to the same buffer. Buffers of up to 32 bytes are stored inside the
+	/// buffer object itself, so they do not need a separate heap allocation for the data. An empty buffer
+	/// has a null data pointer and a capacity of 0, but once data is added the capacity is at least 32 bytes.
 	class DataBuffer
 	{
 	public:
@@ -45,7 +49,16 @@ namespace clan
 		DataBuffer();
 		DataBuffer(unsigned int size);
 		DataBuffer(const void *data, unsigned int size);
+
+		/// \brief Constructs a slice of another buffer without copying the data
+		///
+		/// The slice references the memory of the source buffer and keeps it alive. Writes to the shared
+		/// bytes are visible through both buffers, so treat slices as read-only views. Resizing either
+		/// buffer beyond its capacity moves that buffer to its own memory without affecting the other.
 		DataBuffer(const DataBuffer &data, unsigned int pos, unsigned int size);
+
+		DataBuffer(const DataBuffer &copy);
+		DataBuffer(DataBuffer &&move);
 		~DataBuffer();
 
 		/// \brief Returns a pointer to the data.
@@ -75,6 +88,7 @@ namespace clan
 		bool is_null() const;
 
 		DataBuffer &operator =(const DataBuffer &copy);
+		DataBuffer &operator =(DataBuffer &&move);
 
 		/// \brief Resize the buffer.
 		void set_size(unsigned int size);
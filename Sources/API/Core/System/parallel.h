@@ -0,0 +1,82 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "task.h"
+#include <vector>
+
+namespace clan
+{
+	/// \addtogroup clanCore_System clanCore System
+	/// \{
+
+	class WorkQueue;
+
+	/// \brief Returns the number of indices per chunk used when splitting a range across a work queue
+	///
+	/// \param count Number of indices in the range
+	/// \param grain_size Requested grain size, or 0 to pick one that gives each worker thread several chunks
+	int parallel_grain_size(const WorkQueue &queue, int count, int grain_size = 0);
+
+	/// \brief Calls func for every chunk of [begin, end) in parallel and waits for all of them to finish
+	///
+	/// The calling thread processes chunks too, so it is safe to call this from a worker thread of the same queue.
+	/// If func throws, the remaining chunks are skipped and the first exception is rethrown.
+	void parallel_for(WorkQueue &queue, int begin, int end, const std::function<void(int chunk_begin, int chunk_end)> &func, int grain_size = 0);
+
+	/// \brief Calls func for every chunk of [begin, end) on worker threads without blocking the caller
+	///
+	/// \return Task that completes when all chunks have been processed
+	Task parallel_for_async(WorkQueue &queue, int begin, int end, const std::function<void(int chunk_begin, int chunk_end)> &func, int grain_size = 0);
+
+	/// \brief Maps every chunk of [begin, end) to a partial result in parallel and reduces them in chunk order
+	///
+	/// \param map Called as map(chunk_begin, chunk_end, identity) and returns the partial result for the chunk
+	/// \param reduce Called as reduce(a, b) to combine two partial results
+	template<typename T, typename MapFunc, typename ReduceFunc>
+	T parallel_reduce(WorkQueue &queue, int begin, int end, const T &identity, MapFunc map, ReduceFunc reduce, int grain_size = 0)
+	{
+		if (end <= begin)
+			return identity;
+
+		grain_size = parallel_grain_size(queue, end - begin, grain_size);
+		std::vector<T> partials((end - begin + grain_size - 1) / grain_size, identity);
+		parallel_for(queue, begin, end, [&](int chunk_begin, int chunk_end)
+		{
+			partials[(chunk_begin - begin) / grain_size] = map(chunk_begin, chunk_end, identity);
+		}, grain_size);
+
+		T result = identity;
+		for (const auto &partial : partials)
+			result = reduce(result, partial);
+		return result;
+	}
+
+	/// \}
+}
@@ -0,0 +1,103 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "allocator_statistics.h"
+#include <memory>
+
+namespace clan
+{
+	/// \addtogroup clanCore_System clanCore System
+	/// \{
+
+	class PoolAllocator_Impl;
+
+	/// \brief Allocator with per size class free lists
+	///
+	/// <p>Requests up to max_pooled_size bytes are rounded up to a size class. Each size class carves its
+	///    objects out of 64 KB pages and keeps a free list, so individual frees are cheap and the memory is reused
+	///    by later allocations of the same class. Larger requests get their own block from the system heap.</p>
+	/// <p>A pool is not thread safe. Memory must be freed on the thread that owns the pool.</p>
+	class PoolAllocator
+	{
+	public:
+		/// \brief Constructs a pool
+		/// \param collect_statistics If true, keeps count of allocations in get_statistics()
+		PoolAllocator(bool collect_statistics = false);
+
+		/// \brief Largest request served from a size class
+		static const size_t max_pooled_size = 2048;
+
+		/// \brief Allocates memory. The returned memory is 16 byte aligned
+		void *allocate(size_t size);
+
+		/// \brief Frees memory previously returned by allocate()
+		void deallocate(void *data);
+
+		/// \brief Frees memory allocated by any PoolAllocator
+		static void deallocate_any(void *data);
+
+		/// \brief Releases all allocations and returns the pages to the system heap
+		///
+		/// If required, destroy pool allocated objects before using this function
+		void free();
+
+		/// \brief Returns the allocation statistics
+		///
+		/// reserved_bytes is always maintained. The other counters are only maintained if enabled in the constructor.
+		AllocatorStatistics get_statistics() const;
+
+		/// \brief Returns a pool owned by the calling thread
+		///
+		/// The pool is not freed when the thread exits, so objects allocated from it stay valid. It is handed to the
+		/// next thread that gets the same thread id.
+		static PoolAllocator &get_thread_pool();
+
+	private:
+		std::shared_ptr<PoolAllocator_Impl> impl;
+	};
+
+	/// \brief Class with operator new/delete overloads for PoolAllocator.
+	///
+	///    <p>Derive your class from PoolAllocated and allocate it with:</p>
+	///    <pre>
+	///      MyObject *obj = new(&PoolAllocator::get_thread_pool()) MyObject(..);
+	///      delete obj;
+	///    </pre>
+	///    <p>The object must be deleted on the thread owning the pool and before the pool is freed.</p>
+	class PoolAllocated
+	{
+	public:
+		void *operator new(size_t size, PoolAllocator *allocator);
+		void operator delete(void *data);
+		void operator delete(void *data, PoolAllocator *allocator);
+	};
+
+	/// \}
+}
@@ -0,0 +1,120 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#pragma once
+
+#include <atomic>
+#include <string>
+
+namespace clan
+{
+	/// \addtogroup clanCore_System clanCore System
+	/// \{
+
+	/// \brief Hierarchical zone profiler
+	///
+	/// <p>Zones are recorded per thread into ring buffers holding the most recent events, so the profiler can stay
+	///    enabled in production builds and be exported when a frame hitch is noticed.
+	///    While disabled, a ProfileZone costs a single relaxed atomic load.</p>
+	/// <p>Zone names are stored as pointers and must stay valid until the data is exported. Use string literals.</p>
+	class Profiler
+	{
+	public:
+		/// \brief Starts recording zones
+		///
+		/// \param events_per_thread = Number of zones each thread keeps. Applies to threads that record their first zone after the call
+		static void enable(int events_per_thread = 65536);
+
+		/// \brief Stops recording zones. Recorded data is kept until clear() is called
+		static void disable();
+
+		/// \brief Returns true if zones are being recorded
+		static bool is_enabled() { return enabled.load(std::memory_order_relaxed); }
+
+		/// \brief Opens a zone on the calling thread. Prefer ProfileZone
+		static void begin_zone(const char *name);
+
+		/// \brief Closes the most recently opened zone on the calling thread
+		static void end_zone();
+
+		/// \brief Records the start of a new frame on the calling thread
+		static void mark_frame();
+
+		/// \brief Sets the name of the calling thread in exported data
+		static void set_thread_name(const std::string &name);
+
+		/// \brief Discards all recorded data
+		static void clear();
+
+		/// \brief Returns the recorded data in the Chrome trace event format (chrome://tracing)
+		static std::string get_chrome_trace();
+
+		/// \brief Saves the recorded data in the Chrome trace event format
+		static void save_chrome_trace(const std::string &filename);
+
+		/// \brief Returns a text report with call counts and timings for each zone name and frame
+		static std::string get_report();
+
+	private:
+		static std::atomic_bool enabled;
+	};
+
+	/// \brief Profiles the lifetime of the object as a zone
+	///
+	/// \code{.cpp}
+	/// void Canvas_Impl::flush()
+	/// {
+	///     ProfileZone zone("Canvas::flush");
+	///     ...
+	/// }
+	/// \endcode
+	class ProfileZone
+	{
+	public:
+		ProfileZone(const char *name) : active(Profiler::is_enabled())
+		{
+			if (active)
+				Profiler::begin_zone(name);
+		}
+
+		~ProfileZone()
+		{
+			if (active)
+				Profiler::end_zone();
+		}
+
+	private:
+		ProfileZone(const ProfileZone &) = delete;
+		ProfileZone &operator=(const ProfileZone &) = delete;
+
+		bool active;
+	};
+
+	/// \}
+}
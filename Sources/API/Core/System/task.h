@@ -0,0 +1,106 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <memory>
+#include <functional>
+#include <vector>
+
+namespace clan
+{
+	/// \addtogroup clanCore_System clanCore System
+	/// \{
+
+	class WorkQueue;
+	class Task_Impl;
+
+	/// \brief Unit of work executed on a WorkQueue once all its dependencies have completed
+	///
+	/// A task is not queued until run() is called. Dependencies must be added before that.
+	/// Task objects are handles and can be copied freely; all copies refer to the same task.
+	class Task
+	{
+	public:
+		/// \brief Constructs a null instance
+		Task();
+
+		/// \brief Constructs a task
+		/// \param queue Work queue the task is executed on
+		/// \param func Function executed on a worker thread
+		Task(WorkQueue &queue, const std::function<void()> &func);
+
+		/// \brief Returns true if this object is invalid
+		bool is_null() const { return !impl; }
+
+		/// \brief Throw an exception if this object is invalid
+		void throw_if_null() const;
+
+		/// \brief Returns true when the task function has finished executing
+		bool is_completed() const;
+
+		/// \brief Makes this task wait for another task to complete before it starts
+		///
+		/// Must be called before run().
+		void add_dependency(const Task &task);
+
+		/// \brief Schedules the task
+		///
+		/// The task is queued on the work queue as soon as all its dependencies have completed.
+		void run();
+
+		/// \brief Creates and schedules a task that starts when this task has completed
+		Task then(WorkQueue &queue, const std::function<void()> &func) const;
+
+		/// \brief Blocks until the task has completed
+		///
+		/// If the task is queued but no worker has picked it up yet, it is executed on the calling thread instead.
+		/// Any exception thrown by the task function is rethrown here.
+		void wait() const;
+
+		/// \brief Blocks until the task has completed or the timeout expires
+		///
+		/// \return true if the task completed
+		bool wait(int timeout_ms) const;
+
+		/// \brief Creates a task that has already been scheduled
+		static Task run_async(WorkQueue &queue, const std::function<void()> &func);
+
+		/// \brief Creates and schedules a task that starts when all the specified tasks have completed
+		static Task when_all(WorkQueue &queue, const std::vector<Task> &tasks, const std::function<void()> &func);
+
+	private:
+		Task(const std::shared_ptr<Task_Impl> &impl) : impl(impl) { }
+
+		std::shared_ptr<Task_Impl> impl;
+
+		friend class Task_Impl;
+	};
+
+	/// \}
+}
@@ -57,7 +57,12 @@ namespace clan
 	public:
 		/// \brief Constructs a work queue
 		/// \param serial_queue If true, executes items in the order they are queued, one at a time
-		WorkQueue(bool serial_queue = false);
+		/// \param work_stealing If true, each worker thread gets its own deque and idle workers steal from the others. Ignored for serial queues.
+		/// \param num_threads Number of worker threads, or 0 to use one less than the number of cores
+		///
+		/// In work stealing mode, items queued from a worker thread are pushed to that worker's deque without locking and are
+		/// not guaranteed to execute in the order they were queued. Use it when items fan out into many smaller items.
+		WorkQueue(bool serial_queue = false, bool work_stealing = false, int num_threads = 0);
 		~WorkQueue();
 
 		/// \brief Queue some work to be executed on a worker thread
@@ -74,6 +79,9 @@ namespace clan
 		/// \brief Returns the number of items currently queued
 		int get_items_queued() const;
 
+		/// \brief Returns the number of worker threads used by this queue
+		int get_num_threads() const;
+
 		/// \brief Process work completed queue
 		///
 		/// Needs to be called on the main WorkQueue thread periodically to finish queued work
@@ -38,6 +38,8 @@ namespace clan
 	class File;
 
 	/// \brief File logger.
+	///
+	/// Log lines are collected in a memory buffer and appended to the file by flush.
 	class FileLogger : public Logger
 	{
 	public:
@@ -48,8 +50,12 @@ namespace clan
 		/// \brief Log text to file.
 		void log(const std::string &type, const std::string &text) override;
 
+		/// \brief Writes the buffered log lines to the file.
+		void flush() override;
+
 	private:
 		File *file;
+		std::string buffer;
 	};
 
 	/// \}
@@ -31,13 +31,85 @@
 #include "string_format.h"
 #include "string_help.h"
 #include <mutex>
+#include <initializer_list>
 
 namespace clan
 {
 	/// \addtogroup clanCore_Text clanCore Text
 	/// \{
 
+	/// \brief Action taken when an asynchronous log buffer is full.
+	enum class LogOverflowPolicy
+	{
+		/// \brief Discard the event. The number of dropped events is logged by the writer thread.
+		drop,
+
+		/// \brief Wait until the writer thread has made room in the buffer.
+		block
+	};
+
+	/// \brief Log event argument.
+	///
+	/// References the value passed to log_event, so that the formatting can be deferred to the asynchronous writer thread.
+	class LogArg
+	{
+	public:
+		enum class Type
+		{
+			text,
+			int_value,
+			uint_value,
+			ulong_value,
+			longlong_value,
+			ulonglong_value,
+			float_value,
+			double_value
+		};
+
+		LogArg(const std::string &value) : type(Type::text) { text = &value; }
+		LogArg(int value) : type(Type::int_value) { int_value = value; }
+		LogArg(unsigned int value) : type(Type::uint_value) { uint_value = value; }
+		LogArg(long unsigned int value) : type(Type::ulong_value) { ulong_value = value; }
+		LogArg(long long value) : type(Type::longlong_value) { longlong_value = value; }
+		LogArg(unsigned long long value) : type(Type::ulonglong_value) { ulonglong_value = value; }
+		LogArg(float value) : type(Type::float_value) { float_value = value; }
+		LogArg(double value) : type(Type::double_value) { double_value = value; }
+
+		/// \brief Sets the argument on a StringFormat.
+		void set_arg(StringFormat &format, int index) const
+		{
+			switch (type)
+			{
+			case Type::text: format.set_arg(index, *text); break;
+			case Type::int_value: format.set_arg(index, int_value); break;
+			case Type::uint_value: format.set_arg(index, uint_value); break;
+			case Type::ulong_value: format.set_arg(index, ulong_value); break;
+			case Type::longlong_value: format.set_arg(index, longlong_value); break;
+			case Type::ulonglong_value: format.set_arg(index, ulonglong_value); break;
+			case Type::float_value: format.set_arg(index, float_value); break;
+			case Type::double_value: format.set_arg(index, double_value); break;
+			}
+		}
+
+		Type type;
+		union
+		{
+			const std::string *text;
+			int int_value;
+			unsigned int uint_value;
+			long unsigned int ulong_value;
+			long long longlong_value;
+			unsigned long long ulonglong_value;
+			float float_value;
+			double double_value;
+		};
+	};
+
 	/// \brief Logger interface.
+	///
+	/// By default log_event calls the enabled loggers directly on the calling thread. After start_async has been called,
+	/// log_event copies the event into a lock-free ring buffer owned by the calling thread and returns. A single background
+	/// thread then formats the events, passes them to the loggers in batches and calls flush once per batch.
 	class Logger
 	{
 	public:
@@ -60,6 +132,26 @@ namespace clan
 		/// \brief Log text.
 		virtual void log(const std::string &type, const std::string &text) = 0;
 
+		/// \brief Writes any text buffered by log.
+		virtual void flush() { }
+
+		/// \brief Switches log_event to asynchronous mode.
+		///
+		/// \param buffer_size = Number of events each logging thread can have pending (rounded up to a power of two)
+		/// \param policy = Action taken when the buffer of a logging thread is full
+		static void start_async(int buffer_size = 1024, LogOverflowPolicy policy = LogOverflowPolicy::block);
+
+		/// \brief Writes all pending events, stops the writer thread and switches log_event back to synchronous mode.
+		///
+		/// Call this before the application exits, or pending events are lost.
+		static void stop_async();
+
+		/// \brief Blocks until all events logged before the call have been passed to the loggers and flushed.
+		static void flush_async();
+
+		/// \brief Returns true if log_event is in asynchronous mode.
+		static bool is_async();
+
 	protected:
 		static StringFormat get_log_string(const std::string &type, const std::string &text);
 	};
@@ -68,46 +160,51 @@ namespace clan
 	///
 	void log_event(const std::string &type, const std::string &text);
 
+	/// \brief Log formatted text to logger.
+	///
+	/// In asynchronous mode the arguments are copied and formatted on the writer thread.
+	void log_event(const std::string &type, const std::string &format, std::initializer_list<LogArg> args);
+
 	template <class Arg1>
 	void log_event(const std::string &type, const std::string &format, Arg1 arg1)
 	{
-		StringFormat f(format); f.set_arg(1, arg1); log_event(type, f.get_result());
+		log_event(type, format, { LogArg(arg1) });
 	}
 
 	template <class Arg1, class Arg2>
 	void log_event(const std::string &type, const std::string &format, Arg1 arg1, Arg2 arg2)
 	{
-		StringFormat f(format); f.set_arg(1, arg1); f.set_arg(2, arg2); log_event(type, f.get_result());
+		log_event(type, format, { LogArg(arg1), LogArg(arg2) });
 	}
 
 	template <class Arg1, class Arg2, class Arg3>
 	void log_event(const std::string &type, const std::string &format, Arg1 arg1, Arg2 arg2, Arg3 arg3)
 	{
-		StringFormat f(format); f.set_arg(1, arg1); f.set_arg(2, arg2); f.set_arg(3, arg3); log_event(type, f.get_result());
+		log_event(type, format, { LogArg(arg1), LogArg(arg2), LogArg(arg3) });
 	}
 
 	template <class Arg1, class Arg2, class Arg3, class Arg4>
 	void log_event(const std::string &type, const std::string &format, Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4)
 	{
-		StringFormat f(format); f.set_arg(1, arg1); f.set_arg(2, arg2); f.set_arg(3, arg3); f.set_arg(4, arg4); log_event(type, f.get_result());
+		log_event(type, format, { LogArg(arg1), LogArg(arg2), LogArg(arg3), LogArg(arg4) });
 	}
 
 	template <class Arg1, class Arg2, class Arg3, class Arg4, class Arg5>
 	void log_event(const std::string &type, const std::string &format, Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4, Arg5 arg5)
 	{
-		StringFormat f(format); f.set_arg(1, arg1); f.set_arg(2, arg2); f.set_arg(3, arg3); f.set_arg(4, arg4); f.set_arg(5, arg5); log_event(type, f.get_result());
+		log_event(type, format, { LogArg(arg1), LogArg(arg2), LogArg(arg3), LogArg(arg4), LogArg(arg5) });
 	}
 
 	template <class Arg1, class Arg2, class Arg3, class Arg4, class Arg5, class Arg6>
 	void log_event(const std::string &type, const std::string &format, Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4, Arg5 arg5, Arg6 arg6)
 	{
-		StringFormat f(format); f.set_arg(1, arg1); f.set_arg(2, arg2); f.set_arg(3, arg3); f.set_arg(4, arg4); f.set_arg(5, arg5); f.set_arg(6, arg6); log_event(type, f.get_result());
+		log_event(type, format, { LogArg(arg1), LogArg(arg2), LogArg(arg3), LogArg(arg4), LogArg(arg5), LogArg(arg6) });
 	}
 
 	template <class Arg1, class Arg2, class Arg3, class Arg4, class Arg5, class Arg6, class Arg7>
 	void log_event(const std::string &type, const std::string &format, Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4, Arg5 arg5, Arg6 arg6, Arg7 arg7)
 	{
-		StringFormat f(format); f.set_arg(1, arg1); f.set_arg(2, arg2); f.set_arg(3, arg3); f.set_arg(4, arg4); f.set_arg(5, arg5); f.set_arg(6, arg6); f.set_arg(7, arg7); log_event(type, f.get_result());
+		log_event(type, format, { LogArg(arg1), LogArg(arg2), LogArg(arg3), LogArg(arg4), LogArg(arg5), LogArg(arg6), LogArg(arg7) });
 	}
 
 	/// \}
@@ -139,7 +139,7 @@ namespace clan
 		/// \brief Float to text
 		///
 		/// \param value = value
-		/// \param num_decimal_places = value
+		/// \param num_decimal_places = Number of decimals. A negative number gives the shortest text that converts back to the same value
 		///
 		/// \return Temp String
 		static std::string float_to_text(float value, int num_decimal_places = 6, bool remove_trailing_zeros = true);
@@ -147,7 +147,7 @@ namespace clan
 		/// \brief Float to local8
 		///
 		/// \param value = value
-		/// \param num_decimal_places = value
+		/// \param num_decimal_places = Number of decimals. A negative number gives the shortest text that converts back to the same value
 		///
 		/// \return Temp String8
 		static std::string float_to_local8(float value, int num_decimal_places = 6, bool remove_trailing_zeros = true);
@@ -155,7 +155,7 @@ namespace clan
 		/// \brief Float to ucs2
 		///
 		/// \param value = value
-		/// \param num_decimal_places = value
+		/// \param num_decimal_places = Number of decimals. A negative number gives the shortest text that converts back to the same value
 		///
 		/// \return Temp String16
 		static std::wstring float_to_ucs2(float value, int num_decimal_places = 6, bool remove_trailing_zeros = true);
@@ -184,7 +184,7 @@ namespace clan
 		/// \brief Double to text
 		///
 		/// \param value = value
-		/// \param num_decimal_places = value
+		/// \param num_decimal_places = Number of decimals. A negative number gives the shortest text that converts back to the same value
 		///
 		/// \return Temp String
 		static std::string double_to_text(double value, int num_decimal_places = 6);
@@ -192,7 +192,7 @@ namespace clan
 		/// \brief Double to local8
 		///
 		/// \param value = value
-		/// \param num_decimal_places = value
+		/// \param num_decimal_places = Number of decimals. A negative number gives the shortest text that converts back to the same value
 		///
 		/// \return Temp String8
 		static std::string double_to_local8(double value, int num_decimal_places = 6);
@@ -200,7 +200,7 @@ namespace clan
 		/// \brief Double to ucs2
 		///
 		/// \param value = value
-		/// \param num_decimal_places = value
+		/// \param num_decimal_places = Number of decimals. A negative number gives the shortest text that converts back to the same value
 		///
 		/// \return Temp String16
 		static std::wstring double_to_ucs2(double value, int num_decimal_places = 6);
@@ -551,6 +551,12 @@ namespace clan
 
 		static std::string::size_type utf8_length(const std::string &str);
 
+		/// \brief Returns true if the text is well-formed UTF-8
+		///
+		/// Overlong forms, surrogates and code points above U+10FFFF are rejected (RFC 3629).
+		static bool is_valid_utf8(const std::string &text);
+		static bool is_valid_utf8(const char *data, std::string::size_type length);
+
 		enum BOMType
 		{
 			bom_none,
@@ -59,6 +59,11 @@ namespace clan
 		/// \brief Moves position to the next character
 		void next();
 
+		/// \brief Moves position past the run of ASCII characters at the current position
+		///
+		/// \return The number of characters skipped
+		std::string::size_type skip_ascii();
+
 		/// \brief Moves position to the lead byte of the character
 		void move_to_leadbyte();
 
@@ -38,20 +38,59 @@ namespace clan
 	/// \{
 
 	class IODevice;
+	class DataBuffer;
+	class WorkQueue;
 	class ZipWriter_Impl;
 
 	/// \brief Zip file writer.
 	class ZipWriter
 	{
 	public:
+		/// \brief Compression method of a file entry
+		enum CompressionMethod
+		{
+			/// \brief No compression
+			compress_store,
+
+			/// \brief Deflate, readable by any zip tool
+			compress_deflate,
+
+			/// \brief LZ4 frame. Decompresses several times faster than deflate at a somewhat lower ratio, but only ClanLib can read it
+			compress_lz4
+		};
+
 		/// \brief Constructs a ZipWriter
 		///
 		/// \param output = IODevice
 		/// \param storeFilenamesAsUTF8 = bool
 		ZipWriter(IODevice &output, bool storeFilenamesAsUTF8 = false);
 
+		/// \brief Constructs a ZipWriter that compresses entries in parallel
+		///
+		/// File data is buffered until end_file() and then deflated in independent chunks on the work queue.
+		/// Entries are written to the output in the order they were added, at the latest by write_toc().
+		///
+		/// \param output = IODevice
+		/// \param queue = Work queue the compression tasks are executed on
+		/// \param storeFilenamesAsUTF8 = bool
+		ZipWriter(IODevice &output, WorkQueue &queue, bool storeFilenamesAsUTF8 = false);
+
+		/// \brief Sets the deflate compression level used for the following file entries
+		///
+		/// \param level = 0 (store) to 9 (best compression). The default is 6. LZ4 entries only distinguish between 0 and the rest.
+		void set_compression_level(int level);
+
+		/// \brief Returns the deflate compression level
+		int get_compression_level() const;
+
+		/// \brief Sets if buffered entries that do not shrink when compressed are stored instead
+		///
+		/// Only applies when the entry data is known before it is written, in parallel mode or with add_file(). The default is true.
+		void set_store_incompressible(bool enable);
+
 		/// \brief Begins file entry in the zip file.
 		void begin_file(const std::string &filename, bool compress);
+		void begin_file(const std::string &filename, CompressionMethod compression_method);
 
 		/// \brief Writes some file data to the zip file.
 		void write_file_data(const void *data, int64_t size);
@@ -59,6 +98,10 @@ namespace clan
 		/// \brief Ends the file entry.
 		void end_file();
 
+		/// \brief Adds a complete file entry to the zip file.
+		void add_file(const std::string &filename, const DataBuffer &data, bool compress);
+		void add_file(const std::string &filename, const DataBuffer &data, CompressionMethod compression_method);
+
 		/// \brief Writes the table of contents part of the zip file.
 		void write_toc();
 
@@ -71,7 +71,8 @@ namespace clan
 		///
 		/// \param input = IODevice
 		/// \param eat_whitespace = bool
-		DomDocument(IODevice &input, bool eat_whitespace = true);
+		/// \param element_index Enables the element ID and tag name indexes before loading (see set_element_index_enabled)
+		DomDocument(IODevice &input, bool eat_whitespace = true, bool element_index = false);
 
 		DomDocument(
 			const DomString &namespace_uri,
@@ -166,8 +167,21 @@ namespace clan
 			const DomString &qualified_name);
 
 		/// \brief Returns the Element whose ID is given by element_id.
+		/** <p>Attributes named "id", "ID" or "xml:id" are treated as ID attributes.
+			If several elements share an ID the first one in document order is returned.
+			Returns a null element if no element has the ID.</p>*/
 		DomElement get_element_by_id(const DomString &element_id);
 
+		/// \brief Enables or disables the element ID and tag name indexes.
+		/** <p>When enabled, get_element_by_id, get_elements_by_tag_name and the
+			XPath id() function and //name steps use per-document lookup tables
+			instead of walking the tree. The tables are rebuilt on the first lookup
+			after the document has been modified.</p>*/
+		void set_element_index_enabled(bool enable);
+
+		/// \brief Returns true if the element ID and tag name indexes are enabled.
+		bool is_element_index_enabled() const;
+
 		/// \brief Imports a node from another document to this document.
 		/** <p>The returned node has no parent. The source node is not
 			altered or removed from the original document; this method
@@ -112,11 +112,14 @@ namespace clan
 			<li>DocumentType: document type name</li>
 			<li>DocumentFragment: "#document-fragment"</li>
 			<li>Notation: notation name</li>
-			</ul>*/
-		DomString get_node_name() const;
+			</ul>
+			<p>The returned string is owned by the document and stays valid as long as the document exists.</p>*/
+		const DomString &get_node_name() const;
 
 		/// \brief Returns the namespace URI of this node.
-		DomString get_namespace_uri() const;
+		///
+		/// The returned string is owned by the document and stays valid as long as the document exists.
+		const DomString &get_namespace_uri() const;
 
 		/// \brief Returns the namespace prefix of the node.
 		/** <p>For nodes of any type other than ELEMENT_NODE and ATTRIBUTE_NODE and
@@ -397,6 +400,7 @@ namespace clan
 
 		friend class DomDocument;
 		friend class DomNamedNodeMap;
+		friend class XPathEvaluator_Impl;
 	};
 
 	/// \}
@@ -0,0 +1,169 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <cstring>
+#include "xml_token.h"
+
+namespace clan
+{
+	/// \addtogroup clanXML_XML clanXML XML
+	/// \{
+
+	class IODevice;
+	class XMLReader;
+	class XMLReader_Impl;
+
+	/// \brief Characters of a name, value or text owned by a XMLReader
+	///
+	/// The view is only valid until the reader moves to the next node.
+	class XMLStringView
+	{
+	public:
+		XMLStringView() : data(nullptr), length(0) { }
+		XMLStringView(const char *data, size_t length) : data(data), length(length) { }
+
+		const char *get_data() const { return data; }
+		size_t get_length() const { return length; }
+		bool empty() const { return length == 0; }
+
+		/// \brief Copies the characters to a string
+		std::string to_string() const { return std::string(data, length); }
+
+		bool operator==(const XMLStringView &other) const { return length == other.length && (length == 0 || memcmp(data, other.data, length) == 0); }
+		bool operator!=(const XMLStringView &other) const { return !(*this == other); }
+		bool operator==(const char *str) const { return *this == XMLStringView(str, strlen(str)); }
+		bool operator!=(const char *str) const { return !(*this == str); }
+		bool operator==(const std::string &str) const { return *this == XMLStringView(str.data(), str.length()); }
+		bool operator!=(const std::string &str) const { return !(*this == str); }
+
+	private:
+		const char *data;
+		size_t length;
+	};
+
+	/// \brief Receives the nodes found by XMLReader::parse
+	///
+	/// An empty element tag (<tag/>) is reported as a start_element followed by an end_element.
+	class XMLHandler
+	{
+	public:
+		virtual ~XMLHandler() { }
+
+		/// \brief Called for a start tag. The name and attributes are available through the reader
+		virtual void start_element(const XMLReader &reader) { }
+		virtual void end_element(const XMLStringView &name) { }
+		virtual void text(const XMLStringView &text) { }
+		virtual void cdata_section(const XMLStringView &data) { }
+		virtual void comment(const XMLStringView &text) { }
+		virtual void processing_instruction(const XMLStringView &target, const XMLStringView &data) { }
+	};
+
+	/// \brief Pull parser for XML documents
+	///
+	/// Reads one node at a time without building a DOM. Names, values and text are returned as views into the
+	/// reader's buffer; only values containing entity references are copied.
+	class XMLReader
+	{
+	public:
+		/// \brief Constructs a null instance
+		XMLReader();
+
+		/// \brief Constructs a reader that reads from a device as needed
+		XMLReader(IODevice &input);
+
+		~XMLReader();
+
+		/// \brief Returns true if text containing only whitespace is skipped and other text is trimmed
+		bool get_eat_whitespace() const;
+
+		/// \brief If enabled, text containing only whitespace is skipped and other text is trimmed
+		void set_eat_whitespace(bool enable);
+
+		/// \brief Advances to the next node
+		///
+		/// \return false at the end of the input
+		bool next();
+
+		/// \brief Returns the type of the current node
+		///
+		/// ELEMENT_TOKEN, TEXT_TOKEN, CDATA_SECTION_TOKEN, COMMENT_TOKEN, PROCESSING_INSTRUCTION_TOKEN, DOCUMENT_TYPE_TOKEN or NULL_TOKEN
+		XMLToken::TokenType get_type() const;
+
+		/// \brief Returns BEGIN, END or SINGLE for elements
+		XMLToken::TokenVariant get_variant() const;
+
+		/// \brief Returns true if the current node is a start tag or an empty element tag
+		bool is_start_element() const;
+
+		/// \brief Returns true if the current node is a start tag or an empty element tag with the given name
+		bool is_start_element(const char *name) const;
+
+		/// \brief Returns true if the current node is an end tag
+		bool is_end_element() const;
+
+		/// \brief Returns the number of elements the current node is nested in
+		///
+		/// Start and end tags of an element have the same depth.
+		int get_depth() const;
+
+		/// \brief Returns the element name or processing instruction target
+		XMLStringView get_name() const;
+
+		/// \brief Returns the text, comment, CDATA section or processing instruction data
+		XMLStringView get_value() const;
+
+		/// \brief Returns the number of attributes of the current element
+		int get_attribute_count() const;
+		XMLStringView get_attribute_name(int index) const;
+		XMLStringView get_attribute_value(int index) const;
+
+		/// \brief Returns true if the current element has the attribute
+		bool has_attribute(const char *name) const;
+
+		/// \brief Returns the value of an attribute, or an empty view if the element does not have it
+		XMLStringView get_attribute(const char *name) const;
+
+		/// \brief Moves to the end tag of the current element, skipping its content
+		///
+		/// Does nothing unless the current node is a start tag.
+		void skip_element();
+
+		/// \brief Reads the remaining input and reports every node to the handler
+		void parse(XMLHandler &handler);
+
+	private:
+		std::shared_ptr<XMLReader_Impl> impl;
+	};
+
+	/// \}
+}
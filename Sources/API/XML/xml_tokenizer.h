@@ -53,6 +53,8 @@ namespace clan
 
 		/// \brief Constructs a XMLTokenizer
 		///
+		/// The input is read in chunks as tokens are requested. UTF-8, UTF-16 and UTF-32 are recognized by byte order mark or XML declaration.
+		///
 		/// \param input = IODevice
 		XMLTokenizer(IODevice &input);
 
@@ -31,6 +31,7 @@
 
 #include <memory>
 #include "xpath_object.h"
+#include "xpath_expression.h"
 
 namespace clan
 {
@@ -41,6 +42,9 @@ namespace clan
 	class XPathEvaluator_Impl;
 
 	/// \brief XPath evaluator.
+	///
+	/// Expressions passed as strings are compiled on first use and kept in a small
+	/// least recently used cache, so evaluating the same string again skips parsing it.
 	class XPathEvaluator
 	{
 	public:
@@ -54,6 +58,14 @@ namespace clan
 		/// \return XPath Object
 		XPathObject evaluate(const std::string &expression, const DomNode &context_node) const;
 
+		/// \brief Evaluate a compiled expression
+		///
+		/// \param expression = XPath Expression
+		/// \param context_node = Dom Node
+		///
+		/// \return XPath Object
+		XPathObject evaluate(const XPathExpression &expression, const DomNode &context_node) const;
+
 	private:
 		std::shared_ptr<XPathEvaluator_Impl> impl;
 	};
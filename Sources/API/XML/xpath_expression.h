@@ -0,0 +1,72 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+namespace clan
+{
+	/// \addtogroup clanXML_XML clanXML XML
+	/// \{
+
+	class XPathExpression_Impl;
+
+	/// \brief Compiled XPath expression.
+	///
+	/// The expression is tokenized and its location paths are parsed once, when it is constructed.
+	/// Evaluating it with XPathEvaluator repeatedly, and from several threads, does not parse it again.
+	class XPathExpression
+	{
+	public:
+		/// \brief Constructs a null instance
+		XPathExpression();
+
+		/// \brief Compiles an expression
+		///
+		/// Throws XPathException if the expression contains an invalid token.
+		///
+		/// \param expression = XPath expression
+		XPathExpression(const std::string &expression);
+
+		/// \brief Returns true if this object is invalid.
+		bool is_null() const { return !impl; }
+
+		/// \brief Returns the text of the expression
+		const std::string &get_expression() const;
+
+	private:
+		std::shared_ptr<XPathExpression_Impl> impl;
+
+		friend class XPathEvaluator;
+	};
+
+	/// \}
+}
@@ -62,6 +62,9 @@
 #include "Core/Text/utf8_reader.h"
 #include "Core/System/databuffer.h"
 #include "Core/System/block_allocator.h"
+#include "Core/System/allocator_statistics.h"
+#include "Core/System/arena_allocator.h"
+#include "Core/System/pool_allocator.h"
 #include "Core/System/console_window.h"
 #include "Core/System/datetime.h"
 #include "Core/System/disposable_object.h"
@@ -73,6 +76,9 @@
 #include "Core/System/userdata.h"
 #include "Core/System/game_time.h"
 #include "Core/System/work_queue.h"
+#include "Core/System/task.h"
+#include "Core/System/parallel.h"
+#include "Core/System/profiler.h"
 #include "Core/ErrorReporting/crash_reporter.h"
 #include "Core/ErrorReporting/exception_dialog.h"
 #include "Core/Signals/signal.h"
@@ -82,6 +88,9 @@
 #include "Core/Resources/resource_manager.h"
 #include "Core/Resources/file_resource_document.h"
 #include "Core/Resources/file_resource_manager.h"
+#include "Core/JSON/cbor_writer.h"
+#include "Core/JSON/json_document.h"
+#include "Core/JSON/json_reader.h"
 #include "Core/JSON/json_value.h"
 #include "Core/IOData/file.h"
 #include "Core/IOData/file_help.h"
@@ -96,6 +105,7 @@
 #include "Core/IOData/directory_listing.h"
 #include "Core/IOData/memory_device.h"
 #include "Core/IOData/html_url.h"
+#include "Core/IOData/async_file_loader.h"
 #include "Core/Zip/zip_archive.h"
 #include "Core/Zip/zip_writer.h"
 #include "Core/Zip/zip_reader.h"
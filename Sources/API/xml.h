@@ -59,9 +59,12 @@
 #include "XML/dom_element.h"
 #include "XML/dom_string.h"
 #include "XML/xml_tokenizer.h"
+#include "XML/xml_reader.h"
 #include "XML/xml_writer.h"
 #include "XML/xml_token.h"
 #include "XML/xpath_evaluator.h"
+#include "XML/xpath_expression.h"
+#include "XML/xpath_exception.h"
 #include "XML/xpath_object.h"
 #include "XML/Resources/resource_factory.h"
 #include "XML/Resources/xml_resource_node.h"
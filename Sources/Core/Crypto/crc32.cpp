@@ -0,0 +1,289 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+*/
+
+
+#include "Core/precomp.h"
+#include "crc32.h"
+#include "API/Core/System/system.h"
+
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(CL_DISABLE_SSE2)
+#define CL_CRC32_PCLMUL
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+#if defined(CL_CRC32_PCLMUL) && defined(__GNUC__)
+#define CL_CRC32_PCLMUL_TARGET __attribute__((target("pclmul,sse4.1")))
+#else
+#define CL_CRC32_PCLMUL_TARGET
+#endif
+
+namespace clan
+{
+	namespace
+	{
+		class CRC32Tables
+		{
+		public:
+			CRC32Tables()
+			{
+				for (uint32_t i = 0; i < 256; i++)
+				{
+					uint32_t crc = i;
+					for (int bit = 0; bit < 8; bit++)
+						crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+					table[0][i] = crc;
+				}
+
+				// table[n][i] is the register after feeding byte i followed by n zero bytes
+				for (uint32_t i = 0; i < 256; i++)
+				{
+					for (int n = 1; n < 8; n++)
+						table[n][i] = (table[n - 1][i] >> 8) ^ table[0][table[n - 1][i] & 0xff];
+				}
+			}
+
+			uint32_t table[8][256];
+		};
+
+		// Namespace scope, so the tables are complete before any thread can call CRC32::update
+		const CRC32Tables crc32_tables;
+
+#ifdef CL_CRC32_PCLMUL
+		// Folds 64 byte blocks with carry-less multiplication, then Barrett reduces to 32 bits.
+		// Based on "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction" (Gopal et al, Intel 2009), as found in the Linux kernel and Chromium's zlib.
+		// size must be at least 64 and a multiple of 16.
+		CL_CRC32_PCLMUL_TARGET uint32_t crc32_pclmul(uint32_t crc, const unsigned char *buf, size_t size)
+		{
+			__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+			x1 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+			x2 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+			x3 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+			x4 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+			x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+			x0 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4); // k2, k1
+			buf += 64;
+			size -= 64;
+
+			// Fold four 128 bit lanes in parallel
+			while (size >= 64)
+			{
+				x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+				x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+				x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+				x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+				x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+				x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+				x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+				x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+				y5 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+				y6 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+				y7 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+				y8 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+
+				x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+				x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+				x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+				x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+
+				buf += 64;
+				size -= 64;
+			}
+
+			// Fold the four lanes into one
+			x0 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0); // k4, k3
+
+			x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+			x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+			x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+			x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+			x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+			x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+			x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+			x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+			x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+			// Remaining 16 byte blocks
+			while (size >= 16)
+			{
+				x2 = _mm_loadu_si128((const __m128i *)buf);
+
+				x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+				x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+				x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+				buf += 16;
+				size -= 16;
+			}
+
+			// Fold 128 bits to 64 bits
+			x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+			x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+			x1 = _mm_srli_si128(x1, 8);
+			x1 = _mm_xor_si128(x1, x2);
+
+			x0 = _mm_set_epi64x(0, 0x0163cd6124); // k5
+
+			x2 = _mm_srli_si128(x1, 4);
+			x1 = _mm_and_si128(x1, x3);
+			x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+			x1 = _mm_xor_si128(x1, x2);
+
+			// Barrett reduction to 32 bits
+			x0 = _mm_set_epi64x(0x01f7011641, 0x01db710641); // mu, P(x)
+
+			x2 = _mm_and_si128(x1, x3);
+			x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+			x2 = _mm_and_si128(x2, x3);
+			x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+			x1 = _mm_xor_si128(x1, x2);
+
+			return (uint32_t)_mm_extract_epi32(x1, 1);
+		}
+
+		bool detect_pclmul()
+		{
+			return System::detect_cpu_extension(System::pclmul) && System::detect_cpu_extension(System::sse4_1);
+		}
+
+		const bool use_pclmul = detect_pclmul();
+#endif
+	}
+
+	uint32_t CRC32::update(uint32_t state, const void *data, size_t size)
+	{
+		const unsigned char *d = (const unsigned char *)data;
+#ifdef CL_CRC32_PCLMUL
+		if (use_pclmul && size >= 64)
+		{
+			size_t block_size = size & ~(size_t)15;
+			state = crc32_pclmul(state, d, block_size);
+			d += block_size;
+			size -= block_size;
+		}
+#endif
+		return update_slice_by_8(state, d, size);
+	}
+
+	bool CRC32::is_hardware_accelerated()
+	{
+#ifdef CL_CRC32_PCLMUL
+		return use_pclmul;
+#else
+		return false;
+#endif
+	}
+
+	uint32_t CRC32::update_slice_by_8(uint32_t crc, const unsigned char *d, size_t size)
+	{
+		const uint32_t (*table)[256] = crc32_tables.table;
+
+		while (size >= 8)
+		{
+			uint32_t one = (d[0] | (d[1] << 8) | (d[2] << 16) | ((uint32_t)d[3] << 24)) ^ crc;
+			uint32_t two = d[4] | (d[5] << 8) | (d[6] << 16) | ((uint32_t)d[7] << 24);
+			crc =
+				table[7][one & 0xff] ^ table[6][(one >> 8) & 0xff] ^ table[5][(one >> 16) & 0xff] ^ table[4][one >> 24] ^
+				table[3][two & 0xff] ^ table[2][(two >> 8) & 0xff] ^ table[1][(two >> 16) & 0xff] ^ table[0][two >> 24];
+			d += 8;
+			size -= 8;
+		}
+
+		while (size > 0)
+		{
+			crc = (crc >> 8) ^ table[0][(crc ^ *d) & 0xff];
+			d++;
+			size--;
+		}
+
+		return crc;
+	}
+
+	uint32_t CRC32::combine(uint32_t crc1, uint32_t crc2, int64_t size2)
+	{
+		// Appending size2 zero bytes to the first block is a linear operation in GF(2). Apply it by repeated squaring of the one bit shift operator.
+		if (size2 <= 0)
+			return crc1;
+
+		uint32_t even[32];
+		uint32_t odd[32];
+
+		odd[0] = 0xedb88320; // reflected CRC-32 polynomial
+		uint32_t row = 1;
+		for (int n = 1; n < 32; n++)
+		{
+			odd[n] = row;
+			row <<= 1;
+		}
+
+		gf2_matrix_square(even, odd); // two zero bits
+		gf2_matrix_square(odd, even); // four zero bits
+
+		do
+		{
+			gf2_matrix_square(even, odd);
+			if (size2 & 1)
+				crc1 = gf2_matrix_times(even, crc1);
+			size2 >>= 1;
+			if (size2 == 0)
+				break;
+
+			gf2_matrix_square(odd, even);
+			if (size2 & 1)
+				crc1 = gf2_matrix_times(odd, crc1);
+			size2 >>= 1;
+		} while (size2 != 0);
+
+		return crc1 ^ crc2;
+	}
+
+	uint32_t CRC32::gf2_matrix_times(const uint32_t *mat, uint32_t vec)
+	{
+		uint32_t sum = 0;
+		while (vec)
+		{
+			if (vec & 1)
+				sum ^= *mat;
+			vec >>= 1;
+			mat++;
+		}
+		return sum;
+	}
+
+	void CRC32::gf2_matrix_square(uint32_t *square, const uint32_t *mat)
+	{
+		for (int n = 0; n < 32; n++)
+			square[n] = gf2_matrix_times(mat, mat[n]);
+	}
+}
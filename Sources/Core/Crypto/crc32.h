@@ -0,0 +1,60 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace clan
+{
+	/// \brief CRC-32 as used by zip, zlib and PNG (reflected polynomial 0xedb88320)
+	///
+	/// The state passed to update() is the raw register: start with 0xffffffff and invert the final state to get the checksum.
+	/// PCLMULQDQ folding is used on x86-64 processors that support it, otherwise a slice-by-8 table loop.
+	class CRC32
+	{
+	public:
+		/// \brief Feeds data through the CRC register
+		static uint32_t update(uint32_t state, const void *data, size_t size);
+
+		/// \brief Returns the checksum of two concatenated blocks given the final checksum of each block and the length of the second
+		static uint32_t combine(uint32_t crc1, uint32_t crc2, int64_t size2);
+
+		/// \brief Portable slice-by-8 implementation
+		static uint32_t update_slice_by_8(uint32_t state, const unsigned char *data, size_t size);
+
+		/// \brief Returns true if update() uses carry-less multiplication on this processor
+		static bool is_hardware_accelerated();
+
+	private:
+		static uint32_t gf2_matrix_times(const uint32_t *mat, uint32_t vec);
+		static void gf2_matrix_square(uint32_t *square, const uint32_t *mat);
+	};
+}
@@ -30,16 +30,18 @@
 #include "API/Core/Crypto/hash_functions.h"
 #include "API/Core/System/databuffer.h"
 #include "Core/Zip/miniz.h"
+#include "crc32.h"
 
 namespace clan
 {
 	uint32_t HashFunctions::crc32(const void *data, int size, uint32_t running_crc/*=0*/)
 	{
-		uint32_t crc = running_crc;
-		if (crc == 0)
-			crc = mz_crc32(0L, nullptr, 0);
+		return ~CRC32::update(~running_crc, data, size);
+	}
 
-		return mz_crc32(running_crc, (const unsigned char*)data, size);;
+	uint32_t HashFunctions::crc32_combine(uint32_t crc1, uint32_t crc2, int64_t size2)
+	{
+		return CRC32::combine(crc1, crc2, size2);
 	}
 
 	uint32_t HashFunctions::adler32(const void *data, int size, uint32_t running_adler32/*=0*/)
@@ -0,0 +1,463 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#include "Core/precomp.h"
+#include "API/Core/IOData/async_file_loader.h"
+#include "API/Core/IOData/file.h"
+#include "API/Core/System/exception.h"
+#include "API/Core/System/profiler.h"
+#include "API/Core/Text/string_format.h"
+#include "API/Core/Math/cl_math.h"
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <queue>
+#include <vector>
+#include <algorithm>
+
+namespace clan
+{
+	class AsyncFileRequest_Impl
+	{
+	public:
+		AsyncFileRequest_Impl(const FileSystem &fs, const std::string &filename, int priority, uint64_t sequence, const AsyncFileLoader::Callback &callback)
+			: fs(fs), filename(filename), priority(priority), sequence(sequence), callback(callback), cancel_requested(false)
+		{
+		}
+
+		bool begin_read();
+		AsyncFileRequest::Status finish(AsyncFileRequest::Status status, const DataBuffer &data, const std::string &error);
+		void signal_done();
+		void cancel();
+		bool is_done();
+		bool wait(int timeout_ms);
+
+		bool is_cancel_requested() const { return cancel_requested.load(std::memory_order_relaxed); }
+
+		const FileSystem fs;
+		const std::string filename;
+		const int priority;
+		const uint64_t sequence;
+		const AsyncFileLoader::Callback callback;
+
+		std::mutex mutex;
+		std::condition_variable done_event;
+		AsyncFileRequest::Status status = AsyncFileRequest::status_pending;
+		bool done = false;
+		DataBuffer data;
+		std::string error;
+
+	private:
+		std::atomic_bool cancel_requested;
+	};
+
+	class AsyncFileLoader_Impl
+	{
+	public:
+		AsyncFileLoader_Impl(int num_threads, const AsyncFileLoader::Dispatcher &dispatcher);
+		~AsyncFileLoader_Impl();
+
+		AsyncFileRequest queue(const FileSystem &fs, const std::string &filename, int priority, const AsyncFileLoader::Callback &callback);
+		void cancel_all();
+		void process_completed();
+
+		int get_requests_pending() const { return requests_pending; }
+		int get_num_threads() const { return (int)threads.size(); }
+
+	private:
+		typedef std::shared_ptr<AsyncFileRequest_Impl> RequestPtr;
+
+		struct LowerPriority
+		{
+			bool operator()(const RequestPtr &a, const RequestPtr &b) const
+			{
+				if (a->priority != b->priority)
+					return a->priority < b->priority;
+				return a->sequence > b->sequence;
+			}
+		};
+
+		void worker_main();
+		void read_file(const RequestPtr &request);
+		void post_completion(const RequestPtr &request);
+
+		static const int chunk_size = 256 * 1024;
+
+		AsyncFileLoader::Dispatcher dispatcher;
+		std::vector<std::thread> threads;
+		std::mutex mutex;
+		std::condition_variable worker_event;
+		bool stop_flag = false;
+		uint64_t next_sequence = 0;
+		std::priority_queue<RequestPtr, std::vector<RequestPtr>, LowerPriority> queued_requests;
+		std::vector<RequestPtr> active_requests;
+		std::atomic_int requests_pending;
+
+		std::mutex completed_mutex;
+		std::vector<std::function<void()>> completed_callbacks;
+	};
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	AsyncFileRequest::AsyncFileRequest()
+	{
+	}
+
+	void AsyncFileRequest::throw_if_null() const
+	{
+		if (!impl)
+			throw Exception("AsyncFileRequest is null");
+	}
+
+	std::string AsyncFileRequest::get_filename() const
+	{
+		throw_if_null();
+		return impl->filename;
+	}
+
+	int AsyncFileRequest::get_priority() const
+	{
+		throw_if_null();
+		return impl->priority;
+	}
+
+	AsyncFileRequest::Status AsyncFileRequest::get_status() const
+	{
+		throw_if_null();
+		std::unique_lock<std::mutex> lock(impl->mutex);
+		return impl->status;
+	}
+
+	bool AsyncFileRequest::is_done() const
+	{
+		throw_if_null();
+		return impl->is_done();
+	}
+
+	void AsyncFileRequest::cancel()
+	{
+		throw_if_null();
+		impl->cancel();
+	}
+
+	void AsyncFileRequest::wait() const
+	{
+		throw_if_null();
+		impl->wait(-1);
+	}
+
+	bool AsyncFileRequest::wait(int timeout_ms) const
+	{
+		throw_if_null();
+		return impl->wait(timeout_ms);
+	}
+
+	DataBuffer AsyncFileRequest::get_data() const
+	{
+		throw_if_null();
+		impl->wait(-1);
+		std::unique_lock<std::mutex> lock(impl->mutex);
+		switch (impl->status)
+		{
+		case status_completed:
+			return impl->data;
+		case status_cancelled:
+			throw Exception(string_format("Reading %1 was cancelled", impl->filename));
+		default:
+			throw Exception(impl->error);
+		}
+	}
+
+	std::string AsyncFileRequest::get_error() const
+	{
+		throw_if_null();
+		std::unique_lock<std::mutex> lock(impl->mutex);
+		return impl->error;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	AsyncFileLoader::AsyncFileLoader(int num_threads, const Dispatcher &dispatcher)
+		: impl(std::make_shared<AsyncFileLoader_Impl>(num_threads, dispatcher))
+	{
+	}
+
+	AsyncFileLoader::~AsyncFileLoader()
+	{
+	}
+
+	AsyncFileRequest AsyncFileLoader::read_bytes(const std::string &filename, int priority, const Callback &callback)
+	{
+		return impl->queue(FileSystem(), filename, priority, callback);
+	}
+
+	AsyncFileRequest AsyncFileLoader::read_bytes(const FileSystem &fs, const std::string &filename, int priority, const Callback &callback)
+	{
+		if (fs.is_null())
+			throw Exception("FileSystem is null");
+		return impl->queue(fs, filename, priority, callback);
+	}
+
+	int AsyncFileLoader::get_requests_pending() const
+	{
+		return impl->get_requests_pending();
+	}
+
+	int AsyncFileLoader::get_num_threads() const
+	{
+		return impl->get_num_threads();
+	}
+
+	void AsyncFileLoader::cancel_all()
+	{
+		impl->cancel_all();
+	}
+
+	void AsyncFileLoader::process_completed()
+	{
+		impl->process_completed();
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	bool AsyncFileRequest_Impl::begin_read()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (status != AsyncFileRequest::status_pending)
+			return false;
+		status = AsyncFileRequest::status_reading;
+		return true;
+	}
+
+	AsyncFileRequest::Status AsyncFileRequest_Impl::finish(AsyncFileRequest::Status new_status, const DataBuffer &new_data, const std::string &new_error)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		status = is_cancel_requested() ? AsyncFileRequest::status_cancelled : new_status;
+		if (status == AsyncFileRequest::status_completed)
+			data = new_data;
+		error = new_error;
+		return status;
+	}
+
+	void AsyncFileRequest_Impl::signal_done()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		done = true;
+		done_event.notify_all();
+	}
+
+	void AsyncFileRequest_Impl::cancel()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (status == AsyncFileRequest::status_pending)
+		{
+			status = AsyncFileRequest::status_cancelled;
+			done = true;
+			done_event.notify_all();
+		}
+		else if (status == AsyncFileRequest::status_reading)
+		{
+			cancel_requested = true;
+		}
+	}
+
+	bool AsyncFileRequest_Impl::is_done()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return done;
+	}
+
+	bool AsyncFileRequest_Impl::wait(int timeout_ms)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (timeout_ms < 0)
+		{
+			done_event.wait(lock, [&]() { return done; });
+			return true;
+		}
+		return done_event.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&]() { return done; });
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	AsyncFileLoader_Impl::AsyncFileLoader_Impl(int num_threads, const AsyncFileLoader::Dispatcher &dispatcher)
+		: dispatcher(dispatcher), requests_pending(0)
+	{
+		num_threads = clamp(num_threads, 1, 16);
+		for (int i = 0; i < num_threads; i++)
+			threads.push_back(std::thread(&AsyncFileLoader_Impl::worker_main, this));
+	}
+
+	AsyncFileLoader_Impl::~AsyncFileLoader_Impl()
+	{
+		cancel_all();
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			stop_flag = true;
+		}
+		worker_event.notify_all();
+		for (auto &thread : threads)
+			thread.join();
+	}
+
+	AsyncFileRequest AsyncFileLoader_Impl::queue(const FileSystem &fs, const std::string &filename, int priority, const AsyncFileLoader::Callback &callback)
+	{
+		RequestPtr request;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			request = std::make_shared<AsyncFileRequest_Impl>(fs, filename, priority, next_sequence++, callback);
+			queued_requests.push(request);
+			requests_pending++;
+		}
+		worker_event.notify_one();
+		return AsyncFileRequest(request);
+	}
+
+	void AsyncFileLoader_Impl::cancel_all()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (!queued_requests.empty())
+		{
+			queued_requests.top()->cancel();
+			queued_requests.pop();
+			requests_pending--;
+		}
+		for (auto &request : active_requests)
+			request->cancel();
+	}
+
+	void AsyncFileLoader_Impl::process_completed()
+	{
+		std::vector<std::function<void()>> callbacks;
+		{
+			std::unique_lock<std::mutex> lock(completed_mutex);
+			callbacks.swap(completed_callbacks);
+		}
+		for (auto &callback : callbacks)
+			callback();
+	}
+
+	void AsyncFileLoader_Impl::worker_main()
+	{
+		Profiler::set_thread_name("File I/O");
+		while (true)
+		{
+			RequestPtr request;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				worker_event.wait(lock, [&]() { return stop_flag || !queued_requests.empty(); });
+				if (stop_flag)
+					break;
+				request = queued_requests.top();
+				queued_requests.pop();
+				active_requests.push_back(request);
+			}
+
+			if (request->begin_read())
+				read_file(request);
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				active_requests.erase(std::find(active_requests.begin(), active_requests.end(), request));
+				requests_pending--;
+			}
+		}
+	}
+
+	void AsyncFileLoader_Impl::read_file(const RequestPtr &request)
+	{
+		ProfileZone zone("AsyncFileLoader::read_file");
+
+		AsyncFileRequest::Status status = AsyncFileRequest::status_completed;
+		DataBuffer data;
+		std::string error;
+		try
+		{
+			IODevice device = request->fs.is_null() ? File(request->filename) : request->fs.open_file(request->filename);
+			device.set_buffer_size(0);
+
+			int size = device.get_size();
+			if (size >= 0)
+			{
+				data.set_size(size);
+				int pos = 0;
+				while (pos < size && !request->is_cancel_requested())
+				{
+					int received = device.read(data.get_data() + pos, min(chunk_size, size - pos));
+					if (received <= 0)
+						throw Exception(string_format("Unexpected end of file reading %1", request->filename));
+					pos += received;
+				}
+			}
+			else
+			{
+				// Size is unknown. Read until the end of the stream
+				int pos = 0;
+				while (!request->is_cancel_requested())
+				{
+					data.set_size(pos + chunk_size);
+					int received = device.read(data.get_data() + pos, chunk_size);
+					if (received > 0)
+						pos += received;
+					if (received < chunk_size)
+						break;
+				}
+				data.set_size(pos);
+			}
+		}
+		catch (const std::exception &e)
+		{
+			status = AsyncFileRequest::status_failed;
+			error = string_format("Unable to read %1: %2", request->filename, e.what());
+			data = DataBuffer();
+		}
+
+		// Waiters are released after the completion is posted, so process_completed() called after wait() sees it
+		status = request->finish(status, data, error);
+		if (status != AsyncFileRequest::status_cancelled && request->callback)
+			post_completion(request);
+		request->signal_done();
+	}
+
+	void AsyncFileLoader_Impl::post_completion(const RequestPtr &request)
+	{
+		std::function<void()> completion = [request]() { request->callback(AsyncFileRequest(request)); };
+		if (dispatcher)
+		{
+			dispatcher(completion);
+		}
+		else
+		{
+			std::unique_lock<std::mutex> lock(completed_mutex);
+			completed_callbacks.push_back(completion);
+		}
+	}
+}
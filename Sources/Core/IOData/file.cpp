@@ -33,9 +33,34 @@
 #include "API/Core/Text/string_help.h"
 #include "iodevice_impl.h"
 #include "iodevice_provider_file.h"
+#include "iodevice_provider_memory_mapped.h"
 
 namespace clan
 {
+	namespace
+	{
+		const int default_read_ahead_size = 4096;
+
+		int read_ahead_size_for_flags(unsigned int flags)
+		{
+			// Unbuffered files need sector aligned reads and mapped files are already in memory
+			if (flags & (File::flag_no_buffering | File::flag_memory_mapped))
+				return 0;
+			return default_read_ahead_size;
+		}
+
+		IODeviceProvider *create_file_provider(const std::string &filename, File::OpenMode open_mode, unsigned int access, unsigned int share, unsigned int flags)
+		{
+			if (flags & File::flag_memory_mapped)
+			{
+				if (open_mode != File::open_existing || access != File::access_read)
+					throw Exception("Memory mapped files must be opened with File::open_existing and File::access_read");
+				return new IODeviceProvider_MemoryMapped(filename, share, flags);
+			}
+			return new IODeviceProvider_File(filename, open_mode, access, share, flags);
+		}
+	}
+
 	std::string File::read_text(const std::string &filename)
 	{
 		File file(filename);
@@ -83,12 +108,14 @@ namespace clan
 	File::File()
 		: IODevice(new IODeviceProvider_File())
 	{
+		impl->set_buffer_size(default_read_ahead_size, 0);
 	}
 
 	File::File(
 		const std::string &filename)
 		: IODevice(new IODeviceProvider_File(PathHelp::normalize(filename, PathHelp::path_type_file), open_existing, access_read, share_all, 0))
 	{
+		impl->set_buffer_size(default_read_ahead_size, 0);
 	}
 
 	File::File(
@@ -97,16 +124,28 @@ namespace clan
 		unsigned int access,
 		unsigned int share,
 		unsigned int flags)
-		: IODevice(new IODeviceProvider_File(PathHelp::normalize(filename, PathHelp::path_type_file), open_mode, access, share, flags))
+		: IODevice(create_file_provider(PathHelp::normalize(filename, PathHelp::path_type_file), open_mode, access, share, flags))
 	{
+		impl->set_buffer_size(read_ahead_size_for_flags(flags), 0);
 	}
 	File::~File()
 	{
 	}
 
+	File File::open_mapped(const std::string &filename)
+	{
+		return File(filename, open_existing, access_read, share_read, flag_memory_mapped);
+	}
+
 	bool File::open(
 		const std::string &filename)
 	{
+		impl->set_buffer_size(impl->read_ahead_size, impl->write_behind_size);
+
+		IODeviceProvider_MemoryMapped *mapped_provider = dynamic_cast<IODeviceProvider_MemoryMapped*>(impl->provider);
+		if (mapped_provider)
+			return mapped_provider->open(PathHelp::normalize(filename, PathHelp::path_type_file), share_all, flag_memory_mapped);
+
 		IODeviceProvider_File *provider = dynamic_cast<IODeviceProvider_File*>(impl->provider);
 		return provider->open(PathHelp::normalize(filename, PathHelp::path_type_file), open_existing, access_read, share_all, 0);
 	}
@@ -118,12 +157,31 @@ namespace clan
 		unsigned int share,
 		unsigned int flags)
 	{
+		impl->set_buffer_size(read_ahead_size_for_flags(flags) ? impl->read_ahead_size : 0, impl->write_behind_size);
+
+		IODeviceProvider_MemoryMapped *mapped_provider = dynamic_cast<IODeviceProvider_MemoryMapped*>(impl->provider);
+		if (mapped_provider)
+		{
+			if (open_mode != open_existing || access != access_read)
+				throw Exception("Memory mapped files must be opened with File::open_existing and File::access_read");
+			return mapped_provider->open(PathHelp::normalize(filename, PathHelp::path_type_file), share, flags | flag_memory_mapped);
+		}
+
 		IODeviceProvider_File *provider = dynamic_cast<IODeviceProvider_File*>(impl->provider);
 		return provider->open(PathHelp::normalize(filename, PathHelp::path_type_file), open_mode, access, share, flags);
 	}
 
 	void File::close()
 	{
+		impl->set_buffer_size(impl->read_ahead_size, impl->write_behind_size);
+
+		IODeviceProvider_MemoryMapped *mapped_provider = dynamic_cast<IODeviceProvider_MemoryMapped*>(impl->provider);
+		if (mapped_provider)
+		{
+			mapped_provider->close();
+			return;
+		}
+
 		IODeviceProvider_File *provider = dynamic_cast<IODeviceProvider_File*>(impl->provider);
 		provider->close();
 	}
@@ -31,10 +31,200 @@
 #include "API/Core/IOData/iodevice.h"
 #include "API/Core/IOData/iodevice_provider.h"
 #include "API/Core/IOData/cl_endian.h"
+#include "API/Core/Math/cl_math.h"
 #include "iodevice_impl.h"
 
 namespace clan
 {
+	IODevice_Impl::~IODevice_Impl()
+	{
+		try
+		{
+			flush_write_buffer();
+		}
+		catch (...)
+		{
+		}
+		delete provider;
+	}
+
+	void IODevice_Impl::set_buffer_size(int new_read_ahead_size, int new_write_behind_size)
+	{
+		sync_provider();
+		read_ahead_size = max(new_read_ahead_size, 0);
+		write_behind_size = max(new_write_behind_size, 0);
+		std::vector<char>().swap(read_buffer);
+		std::vector<char>(write_behind_size).swap(write_buffer);
+	}
+
+	int IODevice_Impl::receive_slow(void *data, int len, bool receive_all)
+	{
+		flush_write_buffer();
+		if (read_ahead_size == 0 || len <= 0)
+			return provider->receive(data, len, receive_all);
+
+		char *dest = static_cast<char*>(data);
+		int received = 0;
+		while (received < len)
+		{
+			int available = read_end - read_pos;
+			if (available == 0)
+			{
+				if (received > 0 && !receive_all)
+					break;
+
+				// Large requests bypass the buffer to avoid an extra copy
+				if (len - received >= read_ahead_size)
+				{
+					int result = provider->receive(dest + received, len - received, receive_all);
+					if (result > 0)
+						received += result;
+					else if (received == 0)
+						return result;
+					break;
+				}
+
+				available = fill_read_buffer(1);
+				if (available == 0)
+					break;
+			}
+
+			int copy_size = min(available, len - received);
+			memcpy(dest + received, read_buffer.data() + read_pos, copy_size);
+			read_pos += copy_size;
+			received += copy_size;
+		}
+		return received;
+	}
+
+	int IODevice_Impl::send_slow(const void *data, int len, bool send_all)
+	{
+		discard_read_buffer();
+		if (write_behind_size == 0 || len <= 0)
+			return provider->send(data, len, send_all);
+
+		if (len > write_behind_size - write_len)
+			flush_write_buffer();
+
+		if (len >= write_behind_size)
+			return provider->send(data, len, send_all);
+
+		memcpy(write_buffer.data() + write_len, data, len);
+		write_len += len;
+		return len;
+	}
+
+	int IODevice_Impl::peek(void *data, int len)
+	{
+		flush_write_buffer();
+		if (read_ahead_size == 0)
+			return provider->peek(data, len);
+
+		int available = read_end - read_pos;
+		if (available < len)
+			available = fill_read_buffer(len);
+
+		int copy_size = max(min(available, len), 0);
+		if (copy_size > 0)
+			memcpy(data, read_buffer.data() + read_pos, copy_size);
+		return copy_size;
+	}
+
+	bool IODevice_Impl::seek(int position, IODevice::SeekMode mode)
+	{
+		flush_write_buffer();
+		if (read_end > 0 && mode != IODevice::seek_end)
+		{
+			// Position relative to the start of the read buffer
+			int64_t target;
+			if (mode == IODevice::seek_cur)
+			{
+				target = (int64_t)read_pos + position;
+			}
+			else
+			{
+				int provider_position = provider->get_position();
+				target = provider_position >= 0 ? (int64_t)position - (provider_position - read_end) : -1;
+			}
+
+			if (target >= 0 && target <= read_end)
+			{
+				read_pos = (int)target;
+				return true;
+			}
+		}
+
+		if (mode == IODevice::seek_cur)
+			position -= read_end - read_pos;
+		read_pos = 0;
+		read_end = 0;
+		return provider->seek(position, mode);
+	}
+
+	int IODevice_Impl::get_position()
+	{
+		int position = provider->get_position();
+		if (position < 0)
+			return position;
+		return position - (read_end - read_pos) + write_len;
+	}
+
+	int IODevice_Impl::get_size()
+	{
+		flush_write_buffer();
+		return provider->get_size();
+	}
+
+	void IODevice_Impl::flush_write_buffer()
+	{
+		if (write_len == 0)
+			return;
+
+		int len = write_len;
+		write_len = 0;
+		if (provider->send(write_buffer.data(), len, true) != len)
+			throw Exception("IODevice: Unable to write buffered data");
+	}
+
+	void IODevice_Impl::sync_provider()
+	{
+		flush_write_buffer();
+		discard_read_buffer();
+	}
+
+	int IODevice_Impl::fill_read_buffer(int min_available)
+	{
+		int available = read_end - read_pos;
+		if (read_pos > 0)
+		{
+			memmove(read_buffer.data(), read_buffer.data() + read_pos, available);
+			read_pos = 0;
+			read_end = available;
+		}
+
+		int capacity = max(read_ahead_size, min_available);
+		if ((int)read_buffer.size() < capacity)
+			read_buffer.resize(capacity);
+
+		while (read_end < min_available)
+		{
+			int result = provider->receive(read_buffer.data() + read_end, (int)read_buffer.size() - read_end, false);
+			if (result <= 0)
+				break;
+			read_end += result;
+		}
+		return read_end - read_pos;
+	}
+
+	void IODevice_Impl::discard_read_buffer()
+	{
+		int unread = read_end - read_pos;
+		read_pos = 0;
+		read_end = 0;
+		if (unread > 0)
+			provider->seek(-unread, IODevice::seek_cur);
+	}
+
 	IODevice::IODevice()
 	{
 	}
@@ -58,17 +248,24 @@ namespace clan
 	int IODevice::get_size() const
 	{
 		if (impl)
-			return impl->provider->get_size();
+			return impl->get_size();
 		return -1;
 	}
 
 	int IODevice::get_position() const
 	{
 		if (impl)
-			return impl->provider->get_position();
+			return impl->get_position();
 		return -1;
 	}
 
+	const void *IODevice::get_mapped_data() const
+	{
+		if (impl)
+			return impl->provider->get_mapped_data();
+		return nullptr;
+	}
+
 	bool IODevice::is_little_endian() const
 	{
 		return impl->little_endian_mode;
@@ -77,40 +274,64 @@ namespace clan
 	const IODeviceProvider *IODevice::get_provider() const
 	{
 		throw_if_null();
+		impl->sync_provider();
 		return impl->provider;
 	}
 
 	IODeviceProvider *IODevice::get_provider()
 	{
 		throw_if_null();
+		impl->sync_provider();
 		return impl->provider;
 	}
 
+	void IODevice::set_buffer_size(int read_ahead_size, int write_behind_size)
+	{
+		throw_if_null();
+		impl->set_buffer_size(read_ahead_size, write_behind_size);
+	}
+
+	int IODevice::get_read_ahead_size() const
+	{
+		return impl ? impl->read_ahead_size : 0;
+	}
+
+	int IODevice::get_write_behind_size() const
+	{
+		return impl ? impl->write_behind_size : 0;
+	}
+
+	void IODevice::flush()
+	{
+		if (impl)
+			impl->flush_write_buffer();
+	}
+
 	int IODevice::send(const void *data, int len, bool send_all)
 	{
 		if (impl)
-			return impl->provider->send(data, len, send_all);
+			return impl->send(data, len, send_all);
 		return -1;
 	}
 
 	int IODevice::receive(void *data, int len, bool receive_all)
 	{
 		if (impl)
-			return impl->provider->receive(data, len, receive_all);
+			return impl->receive(data, len, receive_all);
 		return -1;
 	}
 
 	int IODevice::peek(void *data, int len)
 	{
 		if (impl)
-			return impl->provider->peek(data, len);
+			return impl->peek(data, len);
 		return -1;
 	}
 
 	bool IODevice::seek(int position, SeekMode mode)
 	{
 		if (impl)
-			return impl->provider->seek(position, mode);
+			return impl->seek(position, mode);
 		return false;
 	}
 
@@ -554,6 +775,9 @@ namespace clan
 
 	IODevice IODevice::duplicate()
 	{
-		return IODevice(impl->provider->duplicate());
+		impl->flush_write_buffer();
+		IODevice copy(impl->provider->duplicate());
+		copy.impl->set_buffer_size(impl->read_ahead_size, impl->write_behind_size);
+		return copy;
 	}
 }
@@ -29,18 +29,69 @@
 #pragma once
 
 #include "API/Core/IOData/iodevice_provider.h"
+#include <vector>
+#include <cstring>
 
 namespace clan
 {
 	class IODevice_Impl
 	{
 	public:
-		~IODevice_Impl()
+		~IODevice_Impl();
+
+		void set_buffer_size(int read_ahead_size, int write_behind_size);
+
+		int receive(void *data, int len, bool receive_all)
+		{
+			if (len <= read_end - read_pos && len >= 0)
+			{
+				memcpy(data, read_buffer.data() + read_pos, len);
+				read_pos += len;
+				return len;
+			}
+			return receive_slow(data, len, receive_all);
+		}
+
+		int send(const void *data, int len, bool send_all)
 		{
-			delete provider;
+			if (read_end == 0 && len <= write_behind_size - write_len && len >= 0)
+			{
+				memcpy(write_buffer.data() + write_len, data, len);
+				write_len += len;
+				return len;
+			}
+			return send_slow(data, len, send_all);
 		}
 
+		int peek(void *data, int len);
+		bool seek(int position, IODevice::SeekMode mode);
+		int get_position();
+		int get_size();
+
+		/// \brief Writes pending data to the provider
+		void flush_write_buffer();
+
+		/// \brief Flushes pending writes and moves the provider back to the logical position so it can be used directly
+		void sync_provider();
+
 		bool little_endian_mode = true;
 		IODeviceProvider *provider = nullptr;
+
+		int read_ahead_size = 0;
+		int write_behind_size = 0;
+
+	private:
+		int receive_slow(void *data, int len, bool receive_all);
+		int send_slow(const void *data, int len, bool send_all);
+		int fill_read_buffer(int min_available);
+		void discard_read_buffer();
+
+		// read_buffer holds read_end bytes from the provider; read_pos of those have been consumed
+		std::vector<char> read_buffer;
+		int read_pos = 0;
+		int read_end = 0;
+
+		std::vector<char> write_buffer;
+		int write_len = 0;
 	};
 }
@@ -64,6 +64,11 @@ namespace clan
 		return data;
 	}
 
+	const void *IODeviceProvider_Memory::get_mapped_data() const
+	{
+		return data.get_data();
+	}
+
 	int IODeviceProvider_Memory::send(const void *send_data, int len, bool send_all)
 	{
 		validate_position();
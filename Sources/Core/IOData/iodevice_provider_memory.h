@@ -50,6 +50,7 @@ namespace clan
 		virtual int peek(void *data, int len) override;
 		virtual bool seek(int position, IODevice::SeekMode mode) override;
 		IODeviceProvider *duplicate() override;
+		const void *get_mapped_data() const override;
 
 	private:
 		void validate_position() const;
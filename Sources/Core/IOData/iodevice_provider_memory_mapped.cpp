@@ -0,0 +1,242 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#include "Core/precomp.h"
+#include "API/Core/System/exception.h"
+#include "API/Core/Text/string_help.h"
+#include "API/Core/Text/string_format.h"
+#include "API/Core/Math/cl_math.h"
+#include "iodevice_provider_memory_mapped.h"
+#ifndef WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace clan
+{
+	MemoryMappedFile::MemoryMappedFile(const std::string &filename, unsigned int share, unsigned int flags)
+	{
+#ifdef WIN32
+		DWORD win32_share_mode = 0;
+		if (share & File::share_read)
+			win32_share_mode |= FILE_SHARE_READ;
+		if (share & File::share_write)
+			win32_share_mode |= FILE_SHARE_WRITE;
+		if (share & File::share_delete)
+			win32_share_mode |= FILE_SHARE_DELETE;
+
+		DWORD win32_flags = 0;
+		if (flags & File::flag_random_access)
+			win32_flags |= FILE_FLAG_RANDOM_ACCESS;
+		if (flags & File::flag_sequential_scan)
+			win32_flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+
+		file_handle = CreateFile(StringHelp::utf8_to_ucs2(filename).c_str(), GENERIC_READ, win32_share_mode, 0, OPEN_EXISTING, win32_flags, 0);
+		if (file_handle == INVALID_HANDLE_VALUE)
+			throw Exception(string_format("Unable to open file '%1'", filename));
+
+		LARGE_INTEGER file_size;
+		if (GetFileSizeEx(file_handle, &file_size) == FALSE || file_size.QuadPart > 0x7fffffff)
+		{
+			CloseHandle(file_handle);
+			throw Exception(string_format("Unable to memory map file '%1'", filename));
+		}
+		size = (int)file_size.QuadPart;
+
+		// Empty files cannot be mapped
+		if (size > 0)
+		{
+			mapping_handle = CreateFileMapping(file_handle, 0, PAGE_READONLY, 0, 0, 0);
+			if (mapping_handle)
+				data = (const char *)MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+			if (data == nullptr)
+			{
+				if (mapping_handle)
+					CloseHandle(mapping_handle);
+				CloseHandle(file_handle);
+				throw Exception(string_format("Unable to memory map file '%1'", filename));
+			}
+		}
+#else
+		std::string filename_a = StringHelp::text_to_local8(filename);
+		int handle = ::open(filename_a.c_str(), O_RDONLY);
+		if (handle == -1)
+			throw Exception(string_format("Unable to open file '%1'", filename));
+
+		struct stat file_stat;
+		if (fstat(handle, &file_stat) == -1 || file_stat.st_size > 0x7fffffff)
+		{
+			::close(handle);
+			throw Exception(string_format("Unable to memory map file '%1'", filename));
+		}
+		size = (int)file_stat.st_size;
+
+		// Empty files cannot be mapped
+		if (size > 0)
+		{
+			void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, handle, 0);
+			if (mapping == MAP_FAILED)
+			{
+				::close(handle);
+				throw Exception(string_format("Unable to memory map file '%1'", filename));
+			}
+			data = (const char *)mapping;
+
+			if (flags & File::flag_sequential_scan)
+				madvise(mapping, size, MADV_SEQUENTIAL);
+			else if (flags & File::flag_random_access)
+				madvise(mapping, size, MADV_RANDOM);
+		}
+
+		// The mapping keeps its own reference to the file
+		::close(handle);
+#endif
+	}
+
+	MemoryMappedFile::~MemoryMappedFile()
+	{
+#ifdef WIN32
+		if (data)
+			UnmapViewOfFile(data);
+		if (mapping_handle)
+			CloseHandle(mapping_handle);
+		CloseHandle(file_handle);
+#else
+		if (data)
+			munmap((void *)data, size);
+#endif
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	IODeviceProvider_MemoryMapped::IODeviceProvider_MemoryMapped(const std::string &filename, unsigned int share, unsigned int flags)
+	{
+		if (!open(filename, share, flags))
+			throw Exception(string_format("IODeviceProvider_MemoryMapped::IODeviceProvider_MemoryMapped(): Unable to open file '%1'", filename));
+	}
+
+	IODeviceProvider_MemoryMapped::IODeviceProvider_MemoryMapped(const std::shared_ptr<MemoryMappedFile> &file, const std::string &filename, unsigned int share, unsigned int flags)
+		: file(file), filename(filename), share(share), flags(flags)
+	{
+	}
+
+	int IODeviceProvider_MemoryMapped::get_size() const
+	{
+		throw_if_closed("get_size");
+		return file->size;
+	}
+
+	int IODeviceProvider_MemoryMapped::get_position() const
+	{
+		throw_if_closed("get_position");
+		return position;
+	}
+
+	bool IODeviceProvider_MemoryMapped::open(const std::string &new_filename, unsigned int new_share, unsigned int new_flags)
+	{
+		close();
+		try
+		{
+			file = std::make_shared<MemoryMappedFile>(new_filename, new_share, new_flags);
+		}
+		catch (const Exception &)
+		{
+			return false;
+		}
+		filename = new_filename;
+		share = new_share;
+		flags = new_flags;
+		return true;
+	}
+
+	void IODeviceProvider_MemoryMapped::close()
+	{
+		file.reset();
+		position = 0;
+	}
+
+	int IODeviceProvider_MemoryMapped::send(const void * /*data*/, int /*len*/, bool /*send_all*/)
+	{
+		throw Exception("IODeviceProvider_MemoryMapped::send(): Memory mapped files are read only");
+	}
+
+	int IODeviceProvider_MemoryMapped::receive(void *data, int len, bool receive_all)
+	{
+		int bytes = peek(data, len);
+		position += bytes;
+		return bytes;
+	}
+
+	int IODeviceProvider_MemoryMapped::peek(void *data, int len)
+	{
+		throw_if_closed("peek");
+		int bytes = clan::max(clan::min(len, file->size - position), 0);
+		if (bytes > 0)
+			memcpy(data, file->data + position, bytes);
+		return bytes;
+	}
+
+	bool IODeviceProvider_MemoryMapped::seek(int new_position, IODevice::SeekMode mode)
+	{
+		throw_if_closed("seek");
+
+		int base = 0;
+		switch (mode)
+		{
+		case IODevice::seek_set: base = 0; break;
+		case IODevice::seek_cur: base = position; break;
+		case IODevice::seek_end: base = file->size; break;
+		}
+
+		if (base + new_position < 0 || base + new_position > file->size)
+			return false;
+		position = base + new_position;
+		return true;
+	}
+
+	const void *IODeviceProvider_MemoryMapped::get_mapped_data() const
+	{
+		return file ? file->data : nullptr;
+	}
+
+	IODeviceProvider *IODeviceProvider_MemoryMapped::duplicate()
+	{
+		throw_if_closed("duplicate");
+		return new IODeviceProvider_MemoryMapped(file, filename, share, flags);
+	}
+
+	void IODeviceProvider_MemoryMapped::throw_if_closed(const char *function) const
+	{
+		if (!file)
+			throw Exception(string_format("IODeviceProvider_MemoryMapped::%1(): No file open", function));
+	}
+}
@@ -0,0 +1,87 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#pragma once
+
+#include "API/Core/IOData/iodevice_provider.h"
+#include "API/Core/IOData/file.h"
+#include <memory>
+
+namespace clan
+{
+	/// \brief Read only view of a file mapped into memory. Shared between duplicated providers
+	class MemoryMappedFile
+	{
+	public:
+		MemoryMappedFile(const std::string &filename, unsigned int share, unsigned int flags);
+		~MemoryMappedFile();
+
+		const char *data = nullptr;
+		int size = 0;
+
+	private:
+#ifdef WIN32
+		HANDLE file_handle = INVALID_HANDLE_VALUE;
+		HANDLE mapping_handle = 0;
+#endif
+
+		MemoryMappedFile(const MemoryMappedFile &) = delete;
+		MemoryMappedFile &operator=(const MemoryMappedFile &) = delete;
+	};
+
+	class IODeviceProvider_MemoryMapped : public IODeviceProvider
+	{
+	public:
+		IODeviceProvider_MemoryMapped(const std::string &filename, unsigned int share, unsigned int flags);
+		IODeviceProvider_MemoryMapped(const std::shared_ptr<MemoryMappedFile> &file, const std::string &filename, unsigned int share, unsigned int flags);
+
+		int get_size() const override;
+		int get_position() const override;
+
+		bool open(const std::string &filename, unsigned int share, unsigned int flags);
+		void close();
+
+		int send(const void *data, int len, bool send_all) override;
+		int receive(void *data, int len, bool receive_all) override;
+		int peek(void *data, int len) override;
+		bool seek(int position, IODevice::SeekMode mode) override;
+		const void *get_mapped_data() const override;
+
+		IODeviceProvider *duplicate() override;
+
+	private:
+		void throw_if_closed(const char *function) const;
+
+		std::shared_ptr<MemoryMappedFile> file;
+		std::string filename;
+		unsigned int share = 0;
+		unsigned int flags = 0;
+		int position = 0;
+	};
+}
@@ -45,12 +45,14 @@ namespace clan
 
 	const DataBuffer &MemoryDevice::get_data() const
 	{
+		impl->sync_provider();
 		const IODeviceProvider_Memory *provider = dynamic_cast<const IODeviceProvider_Memory*>(impl->provider);
 		return provider->get_data();
 	}
 
 	DataBuffer &MemoryDevice::get_data()
 	{
+		impl->sync_provider();
 		IODeviceProvider_Memory *provider = dynamic_cast<IODeviceProvider_Memory*>(impl->provider);
 		return provider->get_data();
 	}
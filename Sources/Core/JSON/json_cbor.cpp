@@ -0,0 +1,695 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/JSON/json_value.h"
+#include "API/Core/JSON/cbor_writer.h"
+#include "API/Core/System/databuffer.h"
+#include "API/Core/IOData/iodevice.h"
+#include "API/Core/Text/string_help.h"
+#include <cmath>
+#include <cstdint>
+
+namespace clan
+{
+	enum CborMajorType
+	{
+		cbor_unsigned = 0,
+		cbor_negative = 1,
+		cbor_bytes = 2,
+		cbor_text = 3,
+		cbor_array = 4,
+		cbor_map = 5,
+		cbor_tag = 6,
+		cbor_simple = 7
+	};
+
+	class CborEncoder
+	{
+	public:
+		const uint8_t *data() const { return buffer.data(); }
+		size_t size() const { return length; }
+		void clear() { length = 0; }
+
+		void write_byte(uint8_t value)
+		{
+			reserve(1);
+			buffer[length++] = value;
+		}
+
+		void write_head(int major, uint64_t value)
+		{
+			reserve(9);
+			uint8_t *out = buffer.data() + length;
+			uint8_t major_bits = (uint8_t)(major << 5);
+			if (value < 24)
+			{
+				out[0] = major_bits | (uint8_t)value;
+				length += 1;
+			}
+			else if (value <= 0xff)
+			{
+				out[0] = major_bits | 24;
+				out[1] = (uint8_t)value;
+				length += 2;
+			}
+			else if (value <= 0xffff)
+			{
+				out[0] = major_bits | 25;
+				write_big_endian(out + 1, value, 2);
+				length += 3;
+			}
+			else if (value <= 0xffffffff)
+			{
+				out[0] = major_bits | 26;
+				write_big_endian(out + 1, value, 4);
+				length += 5;
+			}
+			else
+			{
+				out[0] = major_bits | 27;
+				write_big_endian(out + 1, value, 8);
+				length += 9;
+			}
+		}
+
+		void write_string(const std::string &value)
+		{
+			write_head(cbor_text, value.size());
+			if (!value.empty())
+			{
+				reserve(value.size());
+				memcpy(buffer.data() + length, value.data(), value.size());
+				length += value.size();
+			}
+		}
+
+		void write_number(double value)
+		{
+			const double two_pow_64 = 18446744073709551616.0;
+			if (value == std::floor(value) && std::fabs(value) < two_pow_64 && !(value == 0.0 && std::signbit(value)))
+			{
+				if (value >= 0.0)
+					write_head(cbor_unsigned, (uint64_t)value);
+				else
+					write_head(cbor_negative, (uint64_t)(-value) - 1);
+			}
+			else if ((double)(float)value == value || value != value)
+			{
+				float single = (float)value;
+				uint32_t bits;
+				memcpy(&bits, &single, sizeof(float));
+				reserve(5);
+				buffer[length] = 0xfa;
+				write_big_endian(buffer.data() + length + 1, bits, 4);
+				length += 5;
+			}
+			else
+			{
+				uint64_t bits;
+				memcpy(&bits, &value, sizeof(double));
+				reserve(9);
+				buffer[length] = 0xfb;
+				write_big_endian(buffer.data() + length + 1, bits, 8);
+				length += 9;
+			}
+		}
+
+		void write_value(const JsonValue &value)
+		{
+			switch (value.type())
+			{
+			case JsonType::undefined:
+				write_byte(0xf7);
+				break;
+			case JsonType::null:
+				write_byte(0xf6);
+				break;
+			case JsonType::boolean:
+				write_byte(value.to_boolean() ? 0xf5 : 0xf4);
+				break;
+			case JsonType::number:
+				write_number(value.to_number());
+				break;
+			case JsonType::string:
+				write_string(value.to_string());
+				break;
+			case JsonType::array:
+				write_head(cbor_array, value.items().size());
+				for (const auto &item : value.items())
+					write_value(item);
+				break;
+			case JsonType::object:
+				write_head(cbor_map, value.properties().size());
+				for (const auto &it : value.properties())
+				{
+					write_string(it.first);
+					write_value(it.second);
+				}
+				break;
+			}
+		}
+
+	private:
+		void reserve(size_t bytes)
+		{
+			// Grows without push_back so that each value costs one capacity check rather than one per byte
+			if (length + bytes > buffer.size())
+				buffer.resize(std::max(buffer.size() * 2, std::max(length + bytes, (size_t)256)));
+		}
+
+		static void write_big_endian(uint8_t *out, uint64_t value, int bytes)
+		{
+			for (int i = 0; i < bytes; i++)
+				out[i] = (uint8_t)(value >> ((bytes - 1 - i) * 8));
+		}
+
+		std::vector<uint8_t> buffer;
+		size_t length = 0;
+	};
+
+	class CborDecoder
+	{
+	public:
+		CborDecoder(const void *data, size_t size) : data(static_cast<const uint8_t *>(data)), size(size) { }
+		CborDecoder(IODevice &device) : device(device), has_device(true) { }
+
+		JsonValue read_value()
+		{
+			JsonValue result;
+			read_value(result, 0);
+			return result;
+		}
+
+	private:
+		static const int max_depth = 1000;
+
+		// Decodes into a value owned by its parent container, so nested values are never copied or moved
+		void read_value(JsonValue &result, int depth)
+		{
+			if (depth > max_depth)
+				throw JsonException("CBOR data nested too deeply");
+
+			uint8_t initial = read_byte();
+			int major = initial >> 5;
+			int additional = initial & 0x1f;
+
+			switch (major)
+			{
+			case cbor_unsigned:
+				result = JsonValue::number((double)read_argument(additional));
+				break;
+			case cbor_negative:
+				result = JsonValue::number(-1.0 - (double)read_argument(additional));
+				break;
+			case cbor_bytes:
+			case cbor_text:
+				read_string(major, additional, text);
+				result = JsonValue::string(text);
+				break;
+			case cbor_array:
+			{
+				result = JsonValue::array();
+				std::vector<JsonValue> &items = result.items();
+				if (additional == 31)
+				{
+					while (!read_break())
+					{
+						items.emplace_back();
+						read_value(items.back(), depth + 1);
+					}
+				}
+				else
+				{
+					uint64_t count = read_argument(additional);
+					items.reserve((size_t)std::min(count, has_device ? (uint64_t)4096 : (uint64_t)(size - pos)));
+					for (uint64_t i = 0; i < count; i++)
+					{
+						items.emplace_back();
+						read_value(items.back(), depth + 1);
+					}
+				}
+				break;
+			}
+			case cbor_map:
+			{
+				result = JsonValue::object();
+				bool indefinite = (additional == 31);
+				uint64_t count = indefinite ? 0 : read_argument(additional);
+				for (uint64_t i = 0; indefinite ? !read_break() : i < count; i++)
+					read_member(result.properties(), depth + 1);
+				break;
+			}
+			case cbor_tag:
+				read_argument(additional);
+				read_value(result, depth + 1);
+				break;
+			case cbor_simple:
+			default:
+				result = read_simple(additional);
+				break;
+			}
+		}
+
+		void read_member(std::map<std::string, JsonValue> &properties, int depth)
+		{
+			read_key(key);
+
+			// Keys written by to_cbor are sorted, so appending at the end is the common case
+			size_t old_size = properties.size();
+			auto it = properties.emplace_hint(properties.end(), key, JsonValue());
+			if (properties.size() == old_size)
+				it->second = JsonValue(); // Duplicate key: the last value wins, as with JsonValue::parse
+			read_value(it->second, depth);
+		}
+
+		uint8_t read_byte()
+		{
+			if (!has_device && !peeked)
+			{
+				if (pos == size)
+					throw JsonException("Unexpected end of CBOR data");
+				return data[pos++];
+			}
+
+			uint8_t value;
+			read_data(&value, 1);
+			return value;
+		}
+
+		void read_data(void *dest, size_t length)
+		{
+			if (peeked && length > 0)
+			{
+				*static_cast<uint8_t *>(dest) = peeked_byte;
+				peeked = false;
+				dest = static_cast<uint8_t *>(dest) + 1;
+				length--;
+			}
+
+			if (has_device)
+			{
+				while (length > 0)
+				{
+					int chunk = (int)std::min(length, (size_t)0x40000000);
+					if (device.read(dest, chunk) != chunk)
+						throw JsonException("Unexpected end of CBOR data");
+					dest = static_cast<uint8_t *>(dest) + chunk;
+					length -= chunk;
+				}
+			}
+			else
+			{
+				if (length > size - pos)
+					throw JsonException("Unexpected end of CBOR data");
+				memcpy(dest, data + pos, length);
+				pos += length;
+			}
+		}
+
+		bool read_break()
+		{
+			if (!has_device)
+			{
+				if (pos == size)
+					throw JsonException("Unexpected end of CBOR data");
+				if (data[pos] != 0xff)
+					return false;
+				pos++;
+				return true;
+			}
+
+			if (!peeked)
+			{
+				read_data(&peeked_byte, 1);
+				peeked = true;
+			}
+			if (peeked_byte == 0xff)
+			{
+				peeked = false;
+				return true;
+			}
+			return false;
+		}
+
+		uint64_t read_argument(int additional)
+		{
+			if (additional < 24)
+				return additional;
+			if (additional > 27)
+				throw JsonException("Invalid CBOR data item");
+
+			uint8_t bytes[8];
+			int count = 1 << (additional - 24);
+			read_data(bytes, count);
+			uint64_t value = 0;
+			for (int i = 0; i < count; i++)
+				value = (value << 8) | bytes[i];
+			return value;
+		}
+
+		void read_string(int major, int additional, std::string &result)
+		{
+			result.clear();
+			if (additional == 31)
+			{
+				// Indefinite length: a series of definite length chunks of the same type
+				while (!read_break())
+				{
+					uint8_t initial = read_byte();
+					if ((initial >> 5) != major || (initial & 0x1f) == 31)
+						throw JsonException("Invalid CBOR string chunk");
+					append_string(result, read_argument(initial & 0x1f));
+				}
+			}
+			else
+			{
+				append_string(result, read_argument(additional));
+			}
+		}
+
+		void append_string(std::string &result, uint64_t length)
+		{
+			if (!has_device)
+			{
+				if (length > size - pos)
+					throw JsonException("Unexpected end of CBOR data");
+				result.append(reinterpret_cast<const char *>(data + pos), (size_t)length);
+				pos += (size_t)length;
+				return;
+			}
+
+			// Grows in steps so a corrupt length cannot allocate more than the data that arrives
+			const uint64_t step = 1024 * 1024;
+			while (length > 0)
+			{
+				size_t chunk = (size_t)std::min(length, step);
+				size_t offset = result.size();
+				result.resize(offset + chunk);
+				read_data(&result[offset], chunk);
+				length -= chunk;
+			}
+		}
+
+		void read_key(std::string &result)
+		{
+			uint8_t initial = read_byte();
+			int major = initial >> 5;
+			int additional = initial & 0x1f;
+			switch (major)
+			{
+			case cbor_bytes:
+			case cbor_text:
+				read_string(major, additional, result);
+				break;
+			case cbor_unsigned:
+				result = StringHelp::ull_to_text(read_argument(additional));
+				break;
+			case cbor_negative:
+			{
+				uint64_t value = read_argument(additional);
+				if (value < 0x7fffffffffffffffULL)
+					result = StringHelp::ll_to_text(-1 - (long long)value);
+				else if (value != 0xffffffffffffffffULL)
+					result = "-" + StringHelp::ull_to_text(value + 1);
+				else
+					result = "-18446744073709551616";
+				break;
+			}
+			default:
+				throw JsonException("Unsupported CBOR map key");
+			}
+		}
+
+		JsonValue read_simple(int additional)
+		{
+			switch (additional)
+			{
+			case 20:
+				return JsonValue::boolean(false);
+			case 21:
+				return JsonValue::boolean(true);
+			case 23:
+				return JsonValue::undefined();
+			case 24:
+				read_byte();
+				return JsonValue::null();
+			case 25:
+			{
+				uint16_t bits = (uint16_t)read_argument(25);
+				int exponent = (bits >> 10) & 0x1f;
+				int mantissa = bits & 0x3ff;
+				double value;
+				if (exponent == 0)
+					value = std::ldexp((double)mantissa, -24);
+				else if (exponent != 31)
+					value = std::ldexp((double)(mantissa + 1024), exponent - 25);
+				else
+					value = mantissa == 0 ? INFINITY : NAN;
+				return JsonValue::number((bits & 0x8000) ? -value : value);
+			}
+			case 26:
+			{
+				uint32_t bits = (uint32_t)read_argument(26);
+				float value;
+				memcpy(&value, &bits, sizeof(float));
+				return JsonValue::number((double)value);
+			}
+			case 27:
+			{
+				uint64_t bits = read_argument(27);
+				double value;
+				memcpy(&value, &bits, sizeof(double));
+				return JsonValue::number(value);
+			}
+			case 31:
+				throw JsonException("Unexpected CBOR break");
+			default:
+				if (additional > 24)
+					throw JsonException("Invalid CBOR data item");
+				return JsonValue::null(); // null (22) and unassigned simple values
+			}
+		}
+
+		const uint8_t *data = nullptr;
+		size_t size = 0;
+		size_t pos = 0;
+
+		IODevice device;
+		bool has_device = false;
+
+		bool peeked = false;
+		uint8_t peeked_byte = 0;
+
+		// Reused for every string and map key, so only the final copy allocates
+		std::string text;
+		std::string key;
+	};
+
+	/////////////////////////////////////////////////////////////////////////
+
+	DataBuffer JsonValue::to_cbor() const
+	{
+		CborEncoder encoder;
+		encoder.write_value(*this);
+		return DataBuffer(encoder.data(), (unsigned int)encoder.size());
+	}
+
+	void JsonValue::to_cbor(IODevice &device) const
+	{
+		CborWriter writer(device);
+		writer.write_value(*this);
+		writer.flush();
+	}
+
+	JsonValue JsonValue::from_cbor(const DataBuffer &cbor)
+	{
+		return from_cbor(cbor.get_data(), cbor.get_size());
+	}
+
+	JsonValue JsonValue::from_cbor(const void *data, size_t size)
+	{
+		CborDecoder decoder(data, size);
+		return decoder.read_value();
+	}
+
+	JsonValue JsonValue::from_cbor(IODevice &device)
+	{
+		CborDecoder decoder(device);
+		return decoder.read_value();
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	class CborWriter_Impl
+	{
+	public:
+		CborWriter_Impl(IODevice &device) : device(device) { }
+
+		struct Container
+		{
+			bool object;
+			bool indefinite;
+			uint64_t remaining;
+		};
+
+		void item_written()
+		{
+			if (!containers.empty() && !containers.back().indefinite)
+			{
+				if (containers.back().remaining == 0)
+					throw JsonException("Too many values written to CBOR container");
+				containers.back().remaining--;
+			}
+			if (encoder.size() >= flush_size)
+				flush();
+		}
+
+		void begin(bool object, bool indefinite, uint64_t count)
+		{
+			if (indefinite)
+				encoder.write_byte(object ? 0xbf : 0x9f);
+			else
+				encoder.write_head(object ? cbor_map : cbor_array, count);
+			item_written();
+			containers.push_back({ object, indefinite, object ? count * 2 : count });
+		}
+
+		void end(bool object)
+		{
+			if (containers.empty() || containers.back().object != object)
+				throw JsonException("Mismatched end of CBOR container");
+			if (containers.back().indefinite)
+				encoder.write_byte(0xff);
+			else if (containers.back().remaining != 0)
+				throw JsonException("Too few values written to CBOR container");
+			containers.pop_back();
+		}
+
+		void flush()
+		{
+			if (encoder.size() > 0)
+			{
+				device.write(encoder.data(), (int)encoder.size());
+				encoder.clear();
+			}
+		}
+
+		static const size_t flush_size = 64 * 1024;
+
+		IODevice device;
+		CborEncoder encoder;
+		std::vector<Container> containers;
+	};
+
+	CborWriter::CborWriter(IODevice &device) : impl(std::make_shared<CborWriter_Impl>(device))
+	{
+	}
+
+	CborWriter::~CborWriter()
+	{
+		try
+		{
+			impl->flush();
+		}
+		catch (...)
+		{
+		}
+	}
+
+	void CborWriter::begin_array()
+	{
+		impl->begin(false, true, 0);
+	}
+
+	void CborWriter::begin_array(size_t count)
+	{
+		impl->begin(false, false, count);
+	}
+
+	void CborWriter::end_array()
+	{
+		impl->end(false);
+	}
+
+	void CborWriter::begin_object()
+	{
+		impl->begin(true, true, 0);
+	}
+
+	void CborWriter::begin_object(size_t count)
+	{
+		impl->begin(true, false, count);
+	}
+
+	void CborWriter::end_object()
+	{
+		impl->end(true);
+	}
+
+	void CborWriter::write_key(const std::string &key)
+	{
+		impl->encoder.write_string(key);
+		impl->item_written();
+	}
+
+	void CborWriter::write_value(const JsonValue &value)
+	{
+		impl->encoder.write_value(value);
+		impl->item_written();
+	}
+
+	void CborWriter::write_string(const std::string &value)
+	{
+		impl->encoder.write_string(value);
+		impl->item_written();
+	}
+
+	void CborWriter::write_number(double value)
+	{
+		impl->encoder.write_number(value);
+		impl->item_written();
+	}
+
+	void CborWriter::write_boolean(bool value)
+	{
+		impl->encoder.write_byte(value ? 0xf5 : 0xf4);
+		impl->item_written();
+	}
+
+	void CborWriter::write_null()
+	{
+		impl->encoder.write_byte(0xf6);
+		impl->item_written();
+	}
+
+	void CborWriter::flush()
+	{
+		impl->flush();
+	}
+}
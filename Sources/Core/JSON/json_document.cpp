@@ -0,0 +1,605 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/JSON/json_document.h"
+#include "API/Core/JSON/json_reader.h"
+#include "API/Core/System/arena_allocator.h"
+#include "json_writer.h"
+#include <cstdint>
+#include <type_traits>
+
+namespace clan
+{
+	struct JsonKeyData
+	{
+		uint32_t hash;
+		uint32_t length;
+		const char *name;
+	};
+
+	struct JsonNodeData
+	{
+		JsonNodeData() : type(JsonType::undefined), size(0), number(0.0) { }
+
+		JsonType type;
+		uint32_t size; // String length, item count or member count
+		union
+		{
+			double number;
+			bool boolean;
+			const char *string;
+			const JsonNodeData *items;
+			const JsonMemberData *members;
+		};
+	};
+
+	struct JsonMemberData
+	{
+		const JsonKeyData *key;
+		JsonNodeData value;
+	};
+
+	class JsonDocument_Impl
+	{
+	public:
+		// Objects with more members than this get a hash index stored after the member array
+		static const uint32_t max_linear_members = 8;
+
+		static uint32_t hash_name(const char *name, size_t length);
+		static uint32_t get_index_size(uint32_t member_count);
+
+		const JsonKeyData *intern(const char *name, size_t length);
+		const char *copy_string(const char *str, size_t length);
+		JsonNodeData create_array(const JsonNodeData *items, size_t count);
+		JsonNodeData create_object(const JsonMemberData *members, size_t count);
+		JsonNodeData copy_value(const JsonValue &value);
+
+		ArenaAllocator arena = ArenaAllocator(16 * 1024);
+		JsonNodeData root;
+
+		// Open-addressed table of the interned member names
+		std::vector<const JsonKeyData *> keys;
+		size_t key_count = 0;
+	};
+
+	/////////////////////////////////////////////////////////////////////////
+
+	JsonType JsonNode::type() const
+	{
+		return data ? data->type : JsonType::undefined;
+	}
+
+	JsonNode JsonNode::prop(const char *name) const
+	{
+		return prop(name, strlen(name));
+	}
+
+	JsonNode JsonNode::prop(const char *name, size_t length) const
+	{
+		if (!data || data->type != JsonType::object)
+			return JsonNode();
+
+		const JsonMemberData *members = data->members;
+		uint32_t count = data->size;
+		uint32_t hash = JsonDocument_Impl::hash_name(name, length);
+
+		// Searched backwards so the last of several members with the same name wins, like in JsonValue
+		if (count <= JsonDocument_Impl::max_linear_members)
+		{
+			for (uint32_t i = count; i > 0; i--)
+			{
+				const JsonKeyData *key = members[i - 1].key;
+				if (key->hash == hash && key->length == length && memcmp(key->name, name, length) == 0)
+					return JsonNode(&members[i - 1].value);
+			}
+			return JsonNode();
+		}
+
+		const uint32_t *index = reinterpret_cast<const uint32_t *>(members + count);
+		uint32_t mask = JsonDocument_Impl::get_index_size(count) - 1;
+		for (uint32_t slot = hash & mask; index[slot] != 0; slot = (slot + 1) & mask)
+		{
+			const JsonMemberData &member = members[index[slot] - 1];
+			if (member.key->hash == hash && member.key->length == length && memcmp(member.key->name, name, length) == 0)
+				return JsonNode(&member.value);
+		}
+		return JsonNode();
+	}
+
+	size_t JsonNode::size() const
+	{
+		return data && (data->type == JsonType::array || data->type == JsonType::object) ? data->size : 0;
+	}
+
+	JsonNode JsonNode::at(size_t index) const
+	{
+		if (!data || data->type != JsonType::array || index >= data->size)
+			throw JsonException("JSON array index out of range");
+		return JsonNode(data->items + index);
+	}
+
+	JsonNodeItems JsonNode::items() const
+	{
+		if (!data || data->type != JsonType::array)
+			return JsonNodeItems(nullptr, 0);
+		return JsonNodeItems(data->items, data->size);
+	}
+
+	JsonNodeProperties JsonNode::properties() const
+	{
+		if (!data || data->type != JsonType::object)
+			return JsonNodeProperties(nullptr, 0);
+		return JsonNodeProperties(data->members, data->size);
+	}
+
+	double JsonNode::to_number() const
+	{
+		return data && data->type == JsonType::number ? data->number : 0.0;
+	}
+
+	bool JsonNode::to_boolean() const
+	{
+		return data && data->type == JsonType::boolean ? data->boolean : false;
+	}
+
+	std::string JsonNode::to_string() const
+	{
+		return std::string(get_string_data(), get_string_length());
+	}
+
+	const char *JsonNode::get_string_data() const
+	{
+		return data && data->type == JsonType::string ? data->string : "";
+	}
+
+	size_t JsonNode::get_string_length() const
+	{
+		return data && data->type == JsonType::string ? data->size : 0;
+	}
+
+	JsonValue JsonNode::to_value() const
+	{
+		switch (type())
+		{
+		default:
+		case JsonType::undefined:
+			return JsonValue::undefined();
+		case JsonType::null:
+			return JsonValue::null();
+		case JsonType::object:
+		{
+			JsonValue result = JsonValue::object();
+			for (auto member : properties())
+				result.prop(member.name()) = member.value().to_value();
+			return result;
+		}
+		case JsonType::array:
+		{
+			JsonValue result = JsonValue::array();
+			result.items().reserve(data->size);
+			for (auto item : items())
+				result.items().push_back(item.to_value());
+			return result;
+		}
+		case JsonType::number:
+			return JsonValue::number(data->number);
+		case JsonType::boolean:
+			return JsonValue::boolean(data->boolean);
+		case JsonType::string:
+			return JsonValue::string(to_string());
+		}
+	}
+
+	std::string JsonNode::to_json() const
+	{
+		std::string json;
+		switch (type())
+		{
+		case JsonType::undefined:
+			break;
+		case JsonType::null:
+			json += "null";
+			break;
+		case JsonType::object:
+			json += "{";
+			for (auto member : properties())
+			{
+				if (json.size() > 1)
+					json += ",";
+				JsonWriter::write_string(member.get_name_data(), member.get_name_length(), json);
+				json += ":";
+				json += member.value().to_json();
+			}
+			json += "}";
+			break;
+		case JsonType::array:
+			json += "[";
+			for (auto item : items())
+			{
+				if (json.size() > 1)
+					json += ",";
+				json += item.to_json();
+			}
+			json += "]";
+			break;
+		case JsonType::number:
+			JsonWriter::write_number(data->number, json);
+			break;
+		case JsonType::boolean:
+			json += data->boolean ? "true" : "false";
+			break;
+		case JsonType::string:
+			JsonWriter::write_string(data->string, data->size, json);
+			break;
+		}
+		return json;
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	std::string JsonNodeMember::name() const
+	{
+		return std::string(data->key->name, data->key->length);
+	}
+
+	const char *JsonNodeMember::get_name_data() const
+	{
+		return data->key->name;
+	}
+
+	size_t JsonNodeMember::get_name_length() const
+	{
+		return data->key->length;
+	}
+
+	JsonNode JsonNodeMember::value() const
+	{
+		return JsonNode(&data->value);
+	}
+
+	JsonNodeItems::iterator JsonNodeItems::end() const
+	{
+		return iterator(first + count);
+	}
+
+	JsonNode JsonNodeItems::operator[](size_t index) const
+	{
+		return JsonNode(first + index);
+	}
+
+	JsonNodeItems::iterator &JsonNodeItems::iterator::operator++()
+	{
+		item++;
+		return *this;
+	}
+
+	JsonNodeProperties::iterator JsonNodeProperties::end() const
+	{
+		return iterator(first + count);
+	}
+
+	JsonNodeProperties::iterator &JsonNodeProperties::iterator::operator++()
+	{
+		member++;
+		return *this;
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	JsonDocument::JsonDocument() : impl(std::make_shared<JsonDocument_Impl>())
+	{
+	}
+
+	JsonDocument::JsonDocument(const JsonValue &value) : impl(std::make_shared<JsonDocument_Impl>())
+	{
+		impl->root = impl->copy_value(value);
+	}
+
+	JsonDocument JsonDocument::parse(const std::string &json)
+	{
+		return parse(json.data(), json.size());
+	}
+
+	JsonDocument JsonDocument::parse(const void *data, size_t size)
+	{
+		JsonReader reader(data, size);
+		reader.next();
+		JsonDocument document = read(reader);
+		if (reader.next() != JsonToken::end_of_document)
+			throw JsonException("Unexpected data after JSON document");
+		return document;
+	}
+
+	JsonDocument JsonDocument::read(JsonReader &reader)
+	{
+		struct Container
+		{
+			bool object;
+			size_t start;
+			const JsonKeyData *key;
+		};
+
+		JsonDocument document;
+		JsonDocument_Impl *impl = document.impl.get();
+
+		// Children are collected here until their container ends and they can be moved into the arena as one block
+		std::vector<JsonNodeData> items;
+		std::vector<JsonMemberData> members;
+		std::vector<Container> containers;
+		const JsonKeyData *key = nullptr;
+
+		JsonToken token = reader.get_token();
+		while (true)
+		{
+			JsonNodeData node;
+			switch (token)
+			{
+			case JsonToken::key:
+				key = impl->intern(reader.get_string_data(), reader.get_string_length());
+				token = reader.next();
+				continue;
+			case JsonToken::object_begin:
+				containers.push_back({ true, members.size(), key });
+				token = reader.next();
+				continue;
+			case JsonToken::array_begin:
+				containers.push_back({ false, items.size(), key });
+				token = reader.next();
+				continue;
+			case JsonToken::object_end:
+			{
+				Container container = containers.back();
+				containers.pop_back();
+				node = impl->create_object(members.data() + container.start, members.size() - container.start);
+				members.resize(container.start);
+				key = container.key;
+				break;
+			}
+			case JsonToken::array_end:
+			{
+				Container container = containers.back();
+				containers.pop_back();
+				node = impl->create_array(items.data() + container.start, items.size() - container.start);
+				items.resize(container.start);
+				key = container.key;
+				break;
+			}
+			case JsonToken::string:
+				node.type = JsonType::string;
+				node.size = (uint32_t)reader.get_string_length();
+				node.string = impl->copy_string(reader.get_string_data(), reader.get_string_length());
+				break;
+			case JsonToken::number:
+				node.type = JsonType::number;
+				node.number = reader.get_number();
+				break;
+			case JsonToken::boolean:
+				node.type = JsonType::boolean;
+				node.boolean = reader.get_boolean();
+				break;
+			case JsonToken::null:
+				node.type = JsonType::null;
+				break;
+			default:
+				throw JsonException("Unexpected end of JSON data");
+			}
+
+			if (containers.empty())
+			{
+				impl->root = node;
+				return document;
+			}
+			else if (containers.back().object)
+			{
+				members.push_back({ key, node });
+			}
+			else
+			{
+				items.push_back(node);
+			}
+			token = reader.next();
+		}
+	}
+
+	JsonNode JsonDocument::root() const
+	{
+		return JsonNode(&impl->root);
+	}
+
+	size_t JsonDocument::get_memory_usage() const
+	{
+		return impl->arena.get_statistics().reserved_bytes + impl->keys.capacity() * sizeof(const JsonKeyData *);
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	uint32_t JsonDocument_Impl::hash_name(const char *name, size_t length)
+	{
+		// FNV-1a
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < length; i++)
+		{
+			hash ^= (unsigned char)name[i];
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	uint32_t JsonDocument_Impl::get_index_size(uint32_t member_count)
+	{
+		uint32_t size = 16;
+		while (size < member_count * 2)
+			size *= 2;
+		return size;
+	}
+
+	const JsonKeyData *JsonDocument_Impl::intern(const char *name, size_t length)
+	{
+		if ((key_count + 1) * 2 > keys.size())
+		{
+			std::vector<const JsonKeyData *> old_keys(std::max(keys.size() * 2, (size_t)64), nullptr);
+			old_keys.swap(keys);
+			size_t mask = keys.size() - 1;
+			for (const JsonKeyData *key : old_keys)
+			{
+				if (key)
+				{
+					size_t slot = key->hash & mask;
+					while (keys[slot])
+						slot = (slot + 1) & mask;
+					keys[slot] = key;
+				}
+			}
+		}
+
+		uint32_t hash = hash_name(name, length);
+		size_t mask = keys.size() - 1;
+		size_t slot = hash & mask;
+		while (keys[slot])
+		{
+			const JsonKeyData *key = keys[slot];
+			if (key->hash == hash && key->length == length && memcmp(key->name, name, length) == 0)
+				return key;
+			slot = (slot + 1) & mask;
+		}
+
+		JsonKeyData *key = static_cast<JsonKeyData *>(arena.allocate(sizeof(JsonKeyData), std::alignment_of<JsonKeyData>::value));
+		key->hash = hash;
+		key->length = (uint32_t)length;
+		key->name = copy_string(name, length);
+		keys[slot] = key;
+		key_count++;
+		return key;
+	}
+
+	const char *JsonDocument_Impl::copy_string(const char *str, size_t length)
+	{
+		char *copy = static_cast<char *>(arena.allocate(length + 1, 1));
+		memcpy(copy, str, length);
+		copy[length] = 0;
+		return copy;
+	}
+
+	JsonNodeData JsonDocument_Impl::create_array(const JsonNodeData *items, size_t count)
+	{
+		JsonNodeData node;
+		node.type = JsonType::array;
+		node.size = (uint32_t)count;
+		if (count > 0)
+		{
+			JsonNodeData *copy = static_cast<JsonNodeData *>(arena.allocate(sizeof(JsonNodeData) * count, std::alignment_of<JsonNodeData>::value));
+			memcpy(copy, items, sizeof(JsonNodeData) * count);
+			node.items = copy;
+		}
+		else
+		{
+			node.items = nullptr;
+		}
+		return node;
+	}
+
+	JsonNodeData JsonDocument_Impl::create_object(const JsonMemberData *members, size_t count)
+	{
+		JsonNodeData node;
+		node.type = JsonType::object;
+		node.size = (uint32_t)count;
+		if (count == 0)
+		{
+			node.members = nullptr;
+			return node;
+		}
+
+		uint32_t index_size = count > max_linear_members ? get_index_size((uint32_t)count) : 0;
+		size_t members_bytes = sizeof(JsonMemberData) * count;
+		char *block = static_cast<char *>(arena.allocate(members_bytes + sizeof(uint32_t) * index_size, std::alignment_of<JsonMemberData>::value));
+		memcpy(block, members, members_bytes);
+		node.members = reinterpret_cast<const JsonMemberData *>(block);
+
+		if (index_size > 0)
+		{
+			uint32_t *index = reinterpret_cast<uint32_t *>(block + members_bytes);
+			memset(index, 0, sizeof(uint32_t) * index_size);
+			uint32_t mask = index_size - 1;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const JsonKeyData *key = members[i].key;
+				uint32_t slot = key->hash & mask;
+				while (index[slot] != 0 && members[index[slot] - 1].key != key)
+					slot = (slot + 1) & mask;
+				index[slot] = i + 1;
+			}
+		}
+		return node;
+	}
+
+	JsonNodeData JsonDocument_Impl::copy_value(const JsonValue &value)
+	{
+		JsonNodeData node;
+		switch (value.type())
+		{
+		case JsonType::undefined:
+			break;
+		case JsonType::null:
+			node.type = JsonType::null;
+			break;
+		case JsonType::object:
+		{
+			std::vector<JsonMemberData> members;
+			members.reserve(value.properties().size());
+			for (const auto &it : value.properties())
+				members.push_back({ intern(it.first.data(), it.first.size()), copy_value(it.second) });
+			node = create_object(members.data(), members.size());
+			break;
+		}
+		case JsonType::array:
+		{
+			std::vector<JsonNodeData> items;
+			items.reserve(value.items().size());
+			for (const auto &item : value.items())
+				items.push_back(copy_value(item));
+			node = create_array(items.data(), items.size());
+			break;
+		}
+		case JsonType::number:
+			node.type = JsonType::number;
+			node.number = value.to_number();
+			break;
+		case JsonType::boolean:
+			node.type = JsonType::boolean;
+			node.boolean = value.to_boolean();
+			break;
+		case JsonType::string:
+			node.type = JsonType::string;
+			node.size = (uint32_t)value.to_string().size();
+			node.string = copy_string(value.to_string().data(), value.to_string().size());
+			break;
+		}
+		return node;
+	}
+}
@@ -0,0 +1,598 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/JSON/json_reader.h"
+#include "API/Core/IOData/iodevice.h"
+#include "json_scanner.h"
+#include "Core/Text/number_conversion.h"
+#include <algorithm>
+
+namespace clan
+{
+	class JsonReader_Impl
+	{
+	public:
+		enum State
+		{
+			state_value,
+			state_first_value,
+			state_first_key,
+			state_key,
+			state_colon,
+			state_comma,
+			state_done
+		};
+
+		JsonToken next();
+		JsonToken next_complete();
+		JsonToken parse_token();
+		JsonToken read_value_token(size_t p);
+		JsonToken read_string_token(size_t p, JsonToken type);
+		JsonToken read_number_token(size_t p);
+		JsonToken read_literal_token(size_t p, const char *literal, size_t length, JsonToken type);
+		JsonToken end_container(size_t p);
+		JsonToken incomplete();
+		bool unescape(const char *p, const char *end, size_t &out_pos);
+		void value_completed();
+		void compact();
+		void refill();
+		JsonValue build_value();
+
+		const char *data = nullptr;
+		size_t size = 0;
+		size_t pos = 0;
+
+		std::vector<char> buffer;
+		IODevice device;
+		bool has_device = false;
+		bool owns_buffer = false;
+		bool input_ended = false;
+
+		State state = state_done; // Empty input contains no documents
+		std::vector<char> stack;
+		JsonToken token = JsonToken::none;
+
+		const char *string_data = nullptr;
+		size_t string_length = 0;
+		std::string unescaped;
+		const char *number_text = nullptr;
+		size_t number_length = 0;
+		double number = 0.0;
+		bool boolean = false;
+	};
+
+	JsonReader::JsonReader() : impl(std::make_shared<JsonReader_Impl>())
+	{
+		impl->owns_buffer = true;
+	}
+
+	JsonReader::JsonReader(const void *data, size_t size) : impl(std::make_shared<JsonReader_Impl>())
+	{
+		impl->data = static_cast<const char *>(data);
+		impl->size = size;
+		impl->input_ended = true;
+	}
+
+	JsonReader::JsonReader(IODevice &device, int buffer_size) : impl(std::make_shared<JsonReader_Impl>())
+	{
+		impl->device = device;
+		impl->has_device = true;
+		impl->owns_buffer = true;
+		impl->buffer.resize(std::max(buffer_size, 16));
+		impl->data = impl->buffer.data();
+	}
+
+	void JsonReader::feed(const void *data, size_t size)
+	{
+		if (!impl->owns_buffer || impl->has_device || impl->input_ended)
+			throw JsonException("JsonReader does not accept fed data");
+
+		impl->compact();
+		if (impl->size + size > impl->buffer.size())
+			impl->buffer.resize(std::max(impl->size + size, impl->buffer.size() * 2));
+		memcpy(impl->buffer.data() + impl->size, data, size);
+		impl->size += size;
+		impl->data = impl->buffer.data();
+	}
+
+	void JsonReader::feed_end()
+	{
+		impl->input_ended = true;
+	}
+
+	JsonToken JsonReader::next()
+	{
+		return impl->next();
+	}
+
+	JsonToken JsonReader::get_token() const
+	{
+		return impl->token;
+	}
+
+	int JsonReader::get_depth() const
+	{
+		return (int)impl->stack.size();
+	}
+
+	const char *JsonReader::get_string_data() const
+	{
+		return impl->string_data;
+	}
+
+	size_t JsonReader::get_string_length() const
+	{
+		return impl->string_length;
+	}
+
+	std::string JsonReader::get_string() const
+	{
+		return std::string(impl->string_data, impl->string_length);
+	}
+
+	bool JsonReader::string_equals(const char *str) const
+	{
+		size_t length = strlen(str);
+		return length == impl->string_length && memcmp(str, impl->string_data, length) == 0;
+	}
+
+	double JsonReader::get_number() const
+	{
+		return impl->number;
+	}
+
+	std::string JsonReader::get_number_text() const
+	{
+		return std::string(impl->number_text, impl->number_length);
+	}
+
+	bool JsonReader::get_boolean() const
+	{
+		return impl->boolean;
+	}
+
+	void JsonReader::skip_value()
+	{
+		if (impl->token != JsonToken::object_begin && impl->token != JsonToken::array_begin)
+			return;
+
+		size_t depth = impl->stack.size();
+		while (impl->stack.size() >= depth)
+			impl->next_complete();
+	}
+
+	JsonValue JsonReader::read_value()
+	{
+		return impl->build_value();
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	JsonToken JsonReader_Impl::next()
+	{
+		while (true)
+		{
+			JsonToken result = parse_token();
+			if (result == JsonToken::need_more_input && has_device && !input_ended)
+			{
+				refill();
+				continue;
+			}
+			token = result;
+			return result;
+		}
+	}
+
+	JsonToken JsonReader_Impl::next_complete()
+	{
+		if (next() == JsonToken::need_more_input)
+			throw JsonException("Unexpected end of JSON data");
+		return token;
+	}
+
+	JsonToken JsonReader_Impl::parse_token()
+	{
+		while (true)
+		{
+			size_t p = JsonScanner::skip_whitespace(data + pos, data + size) - data;
+			pos = p;
+			if (p == size)
+			{
+				if (!input_ended)
+					return JsonToken::need_more_input;
+				if (state == state_done)
+					return JsonToken::end_of_document;
+				throw JsonException("Unexpected end of JSON data");
+			}
+
+			char c = data[p];
+			switch (state)
+			{
+			case state_done: // A document begins
+				state = state_value;
+				break;
+
+			case state_colon:
+				if (c != ':')
+					throw JsonException("Unexpected character in JSON data");
+				pos = p + 1;
+				state = state_value;
+				break;
+
+			case state_comma:
+				if (c == ',')
+				{
+					pos = p + 1;
+					state = stack.back() == '{' ? state_key : state_value;
+					break;
+				}
+				else if (c == (stack.back() == '{' ? '}' : ']'))
+				{
+					return end_container(p);
+				}
+				throw JsonException("Unexpected character in JSON data");
+
+			case state_first_key:
+				if (c == '}')
+					return end_container(p);
+				// fall through
+			case state_key:
+				if (c != '"')
+					throw JsonException("Unexpected character in JSON data");
+				return read_string_token(p, JsonToken::key);
+
+			case state_first_value:
+				if (c == ']')
+					return end_container(p);
+				// fall through
+			case state_value:
+				return read_value_token(p);
+			}
+		}
+	}
+
+	JsonToken JsonReader_Impl::read_value_token(size_t p)
+	{
+		switch (data[p])
+		{
+		case '{':
+			stack.push_back('{');
+			pos = p + 1;
+			state = state_first_key;
+			return JsonToken::object_begin;
+		case '[':
+			stack.push_back('[');
+			pos = p + 1;
+			state = state_first_value;
+			return JsonToken::array_begin;
+		case '"':
+			return read_string_token(p, JsonToken::string);
+		case '-':
+		case '0':
+		case '1':
+		case '2':
+		case '3':
+		case '4':
+		case '5':
+		case '6':
+		case '7':
+		case '8':
+		case '9':
+			return read_number_token(p);
+		case 't':
+			boolean = true;
+			return read_literal_token(p, "true", 4, JsonToken::boolean);
+		case 'f':
+			boolean = false;
+			return read_literal_token(p, "false", 5, JsonToken::boolean);
+		case 'n':
+			return read_literal_token(p, "null", 4, JsonToken::null);
+		default:
+			throw JsonException("Unexpected character in JSON data");
+		}
+	}
+
+	JsonToken JsonReader_Impl::read_string_token(size_t p, JsonToken type)
+	{
+		const char *start = data + p + 1;
+		const char *end = data + size;
+		const char *q = JsonScanner::find_quote_or_backslash(start, end);
+		if (q == end)
+			return incomplete();
+
+		if (*q == '"')
+		{
+			string_data = start;
+			string_length = q - start;
+			pos = q + 1 - data;
+		}
+		else
+		{
+			size_t next_pos = 0;
+			if (!unescape(start, end, next_pos))
+				return incomplete();
+			string_data = unescaped.data();
+			string_length = unescaped.size();
+			pos = next_pos;
+		}
+
+		if (type == JsonToken::key)
+			state = state_colon;
+		else
+			value_completed();
+		return type;
+	}
+
+	bool JsonReader_Impl::unescape(const char *p, const char *end, size_t &out_pos)
+	{
+		unescaped.clear();
+		while (true)
+		{
+			const char *q = JsonScanner::find_quote_or_backslash(p, end);
+			if (q == end)
+				return false;
+			unescaped.append(p, q);
+			if (*q == '"')
+			{
+				out_pos = q + 1 - data;
+				return true;
+			}
+
+			if (end - q < 2)
+				return false;
+			switch (q[1])
+			{
+			case '"': unescaped.push_back('"'); break;
+			case '\\': unescaped.push_back('\\'); break;
+			case '/': unescaped.push_back('/'); break;
+			case 'b': unescaped.push_back('\b'); break;
+			case 'f': unescaped.push_back('\f'); break;
+			case 'n': unescaped.push_back('\n'); break;
+			case 'r': unescaped.push_back('\r'); break;
+			case 't': unescaped.push_back('\t'); break;
+			case 'u':
+			{
+				auto read_hex = [&](const char *hex, unsigned int &out_value)
+				{
+					out_value = 0;
+					for (int i = 0; i < 4; i++)
+					{
+						char c = hex[i];
+						out_value <<= 4;
+						if (c >= '0' && c <= '9')
+							out_value |= c - '0';
+						else if (c >= 'a' && c <= 'f')
+							out_value |= c - 'a' + 10;
+						else if (c >= 'A' && c <= 'F')
+							out_value |= c - 'A' + 10;
+						else
+							throw JsonException("Invalid unicode escape");
+					}
+				};
+
+				if (end - q < 6)
+					return false;
+				unsigned int codepoint;
+				read_hex(q + 2, codepoint);
+
+				// UTF-16 surrogate pair
+				if (codepoint >= 0xd800 && codepoint <= 0xdbff)
+				{
+					if (end - q < 12)
+						return false;
+					unsigned int low;
+					if (q[6] == '\\' && q[7] == 'u')
+					{
+						read_hex(q + 8, low);
+						if (low >= 0xdc00 && low <= 0xdfff)
+						{
+							codepoint = 0x10000 + ((codepoint - 0xd800) << 10) + (low - 0xdc00);
+							q += 6;
+						}
+					}
+				}
+
+				if (codepoint < 0x80)
+				{
+					unescaped.push_back((char)codepoint);
+				}
+				else if (codepoint < 0x800)
+				{
+					unescaped.push_back((char)(0xc0 | (codepoint >> 6)));
+					unescaped.push_back((char)(0x80 | (codepoint & 0x3f)));
+				}
+				else if (codepoint < 0x10000)
+				{
+					unescaped.push_back((char)(0xe0 | (codepoint >> 12)));
+					unescaped.push_back((char)(0x80 | ((codepoint >> 6) & 0x3f)));
+					unescaped.push_back((char)(0x80 | (codepoint & 0x3f)));
+				}
+				else
+				{
+					unescaped.push_back((char)(0xf0 | (codepoint >> 18)));
+					unescaped.push_back((char)(0x80 | ((codepoint >> 12) & 0x3f)));
+					unescaped.push_back((char)(0x80 | ((codepoint >> 6) & 0x3f)));
+					unescaped.push_back((char)(0x80 | (codepoint & 0x3f)));
+				}
+				q += 4;
+				break;
+			}
+			default:
+				throw JsonException("Invalid escape sequence in JSON string");
+			}
+			p = q + 2;
+		}
+	}
+
+	JsonToken JsonReader_Impl::read_number_token(size_t p)
+	{
+		size_t q = p;
+		while (q < size)
+		{
+			char c = data[q];
+			if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E')
+				q++;
+			else
+				break;
+		}
+		if (q == size && !input_ended)
+			return JsonToken::need_more_input;
+
+		// -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+		const char *s = data + p;
+		const char *end = data + q;
+		if (s != end && *s == '-')
+			s++;
+		const char *int_start = s;
+		while (s != end && *s >= '0' && *s <= '9')
+			s++;
+		bool valid = s != int_start && (*int_start != '0' || s - int_start == 1);
+		if (valid && s != end && *s == '.')
+		{
+			const char *frac_start = ++s;
+			while (s != end && *s >= '0' && *s <= '9')
+				s++;
+			valid = s != frac_start;
+		}
+		if (valid && s != end && (*s == 'e' || *s == 'E'))
+		{
+			s++;
+			if (s != end && (*s == '+' || *s == '-'))
+				s++;
+			const char *exp_start = s;
+			while (s != end && *s >= '0' && *s <= '9')
+				s++;
+			valid = s != exp_start;
+		}
+		if (!valid || s != end)
+			throw JsonException("Invalid number in JSON data");
+
+		number_text = data + p;
+		number_length = q - p;
+
+		NumberConversion::parse(number_text, number_text + number_length, number);
+
+		pos = q;
+		value_completed();
+		return JsonToken::number;
+	}
+
+	JsonToken JsonReader_Impl::read_literal_token(size_t p, const char *literal, size_t length, JsonToken type)
+	{
+		size_t available = std::min(length, size - p);
+		if (memcmp(data + p, literal, available) != 0)
+			throw JsonException("Unexpected character in JSON data");
+		if (available < length)
+			return incomplete();
+
+		pos = p + length;
+		value_completed();
+		return type;
+	}
+
+	JsonToken JsonReader_Impl::end_container(size_t p)
+	{
+		JsonToken result = stack.back() == '{' ? JsonToken::object_end : JsonToken::array_end;
+		stack.pop_back();
+		pos = p + 1;
+		value_completed();
+		return result;
+	}
+
+	JsonToken JsonReader_Impl::incomplete()
+	{
+		if (input_ended)
+			throw JsonException("Unexpected end of JSON data");
+		return JsonToken::need_more_input;
+	}
+
+	void JsonReader_Impl::value_completed()
+	{
+		state = stack.empty() ? state_done : state_comma;
+	}
+
+	void JsonReader_Impl::compact()
+	{
+		if (pos > 0)
+		{
+			memmove(buffer.data(), buffer.data() + pos, size - pos);
+			size -= pos;
+			pos = 0;
+		}
+	}
+
+	void JsonReader_Impl::refill()
+	{
+		compact();
+		if (size == buffer.size()) // A single token fills the whole buffer
+			buffer.resize(buffer.size() * 2);
+		data = buffer.data();
+
+		int received = device.read(buffer.data() + size, (int)std::min(buffer.size() - size, (size_t)0x7fffffff), false);
+		if (received <= 0)
+			input_ended = true;
+		else
+			size += received;
+	}
+
+	JsonValue JsonReader_Impl::build_value()
+	{
+		switch (token)
+		{
+		case JsonToken::object_begin:
+		{
+			JsonValue result = JsonValue::object();
+			while (next_complete() != JsonToken::object_end)
+			{
+				std::string key(string_data, string_length);
+				next_complete();
+				result.prop(key) = build_value();
+			}
+			return result;
+		}
+		case JsonToken::array_begin:
+		{
+			JsonValue result = JsonValue::array();
+			while (next_complete() != JsonToken::array_end)
+				result.items().push_back(build_value());
+			return result;
+		}
+		case JsonToken::string:
+			return JsonValue::string(std::string(string_data, string_length));
+		case JsonToken::number:
+			return JsonValue::number(number);
+		case JsonToken::boolean:
+			return JsonValue::boolean(boolean);
+		case JsonToken::null:
+			return JsonValue::null();
+		default:
+			throw JsonException("JsonReader::read_value called without a value token");
+		}
+	}
+}
@@ -0,0 +1,123 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#ifndef CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace clan
+{
+	/// \brief Character classification for JSON tokenizing, 16 bytes at a time where SSE2 is available
+	class JsonScanner
+	{
+	public:
+		static bool is_whitespace(char c)
+		{
+			return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f';
+		}
+
+		/// \brief Returns the first character at or after p that is not whitespace, or end
+		static const char *skip_whitespace(const char *p, const char *end)
+		{
+			// Most tokens are separated by a single space or none at all
+			if (p == end || !is_whitespace(*p))
+				return p;
+			p++;
+			if (p == end || !is_whitespace(*p))
+				return p;
+
+#ifndef CL_DISABLE_SSE2
+			// Indentation runs
+			const __m128i space = _mm_set1_epi8(' ');
+			const __m128i newline = _mm_set1_epi8('\n');
+			const __m128i carriage_return = _mm_set1_epi8('\r');
+			const __m128i tab = _mm_set1_epi8('\t');
+			while (end - p >= 16)
+			{
+				__m128i chars = _mm_loadu_si128((const __m128i *)p);
+				__m128i ws = _mm_or_si128(
+					_mm_or_si128(_mm_cmpeq_epi8(chars, space), _mm_cmpeq_epi8(chars, newline)),
+					_mm_or_si128(_mm_cmpeq_epi8(chars, carriage_return), _mm_cmpeq_epi8(chars, tab)));
+				unsigned int mask = ~_mm_movemask_epi8(ws) & 0xffff;
+				if (mask != 0)
+				{
+					const char *result = p + count_trailing_zeros(mask);
+					return is_whitespace(*result) ? skip_whitespace_bytes(result, end) : result; // '\f' is not in the vector test
+				}
+				p += 16;
+			}
+#endif
+			return skip_whitespace_bytes(p, end);
+		}
+
+		/// \brief Returns the first '"' or '\\' at or after p, or end
+		static const char *find_quote_or_backslash(const char *p, const char *end)
+		{
+#ifndef CL_DISABLE_SSE2
+			const __m128i quote = _mm_set1_epi8('"');
+			const __m128i backslash = _mm_set1_epi8('\\');
+			while (end - p >= 16)
+			{
+				__m128i chars = _mm_loadu_si128((const __m128i *)p);
+				unsigned int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chars, quote), _mm_cmpeq_epi8(chars, backslash)));
+				if (mask != 0)
+					return p + count_trailing_zeros(mask);
+				p += 16;
+			}
+#endif
+			while (p != end && *p != '"' && *p != '\\')
+				p++;
+			return p;
+		}
+
+	private:
+		static const char *skip_whitespace_bytes(const char *p, const char *end)
+		{
+			while (p != end && is_whitespace(*p))
+				p++;
+			return p;
+		}
+
+		static int count_trailing_zeros(unsigned int mask)
+		{
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward(&index, mask);
+			return (int)index;
+#else
+			return __builtin_ctz(mask);
+#endif
+		}
+	};
+}
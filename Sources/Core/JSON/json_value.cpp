@@ -29,6 +29,8 @@
 #include "Core/precomp.h"
 #include "API/Core/JSON/json_value.h"
 #include "API/Core/Text/string_help.h"
+#include "json_writer.h"
+#include "Core/Text/number_conversion.h"
 
 namespace clan
 {
@@ -38,8 +40,6 @@ namespace clan
 		static void write(const JsonValue &value, std::string &json);
 		static void write_array(const JsonValue &value, std::string &json);
 		static void write_object(const JsonValue &value, std::string &json);
-		static void write_string(const std::string &str, std::string &json);
-		static void write_number(const JsonValue &value, std::string &json);
 
 		static JsonValue read(const std::string &json, size_t &pos);
 		static JsonValue read_object(const std::string &json, size_t &pos);
@@ -79,10 +79,10 @@ namespace clan
 			write_array(value, json);
 			break;
 		case JsonType::string:
-			write_string(value.to_string(), json);
+			JsonWriter::write_string(value.to_string(), json);
 			break;
 		case JsonType::number:
-			write_number(value, json);
+			JsonWriter::write_number(value.to_number(), json);
 			break;
 		case JsonType::boolean:
 			json += value.to_boolean() ? "true" : "false";
@@ -112,108 +112,13 @@ namespace clan
 		{
 			if (it != value.properties().begin())
 				json += ",";
-			write_string(it->first, json);
+			JsonWriter::write_string(it->first, json);
 			json += ":";
 			write(it->second, json);
 		}
 		json += "}";
 	}
 
-	void JsonValueImpl::write_string(const std::string &str, std::string &json)
-	{
-		json.push_back('"');
-
-		for (auto c : str)
-		{
-			if (c == '"' || c == '\\')
-			{
-				json.push_back('\\');
-				json.push_back(c);
-			}
-			else if (c == '\b')
-			{
-				json.push_back('\\');
-				json.push_back('b');
-			}
-			else if (c == '\f')
-			{
-				json.push_back('\\');
-				json.push_back('f');
-			}
-			else if (c == '\n')
-			{
-				json.push_back('\\');
-				json.push_back('n');
-			}
-			else if (c == '\r')
-			{
-				json.push_back('\\');
-				json.push_back('r');
-			}
-			else if (c == '\t')
-			{
-				json.push_back('\\');
-				json.push_back('t');
-			}
-			else if (c < 32)
-			{
-				json.push_back('\\');
-				json.push_back('u');
-				json.push_back('0');
-				json.push_back('0');
-
-				if (c >= 16)
-				{
-					json.push_back('1');
-					c -= 16;
-				}
-				else
-				{
-					json.push_back('0');
-				}
-
-				if (c < 10)
-				{
-					json.push_back('0' + c);
-				}
-				else
-				{
-					json.push_back('a' + (c - 10));
-				}
-				}
-			else
-			{
-				json.push_back(c);
-			}
-			}
-
-		json.push_back('"');
-		}
-
-	void JsonValueImpl::write_number(const JsonValue &value, std::string &json)
-	{
-		char buf[64];
-		buf[0] = 0;
-		if (static_cast<double>(static_cast<int>(value.to_number())) == value.to_number())
-		{
-#ifdef WIN32
-			_snprintf(buf, 63, "%d", (int)value.to_number());
-#else
-			snprintf(buf, 63, "%d", (int)value.to_number());
-#endif
-		}
-		else
-		{
-#ifdef WIN32
-			_snprintf(buf, 63, "%f", value.to_number());
-#else
-			snprintf(buf, 63, "%f", value.to_number());
-#endif
-		}
-		buf[63] = 0;
-		json += buf;
-	}
-
 	JsonValue JsonValueImpl::read(const std::string &json, size_t &pos)
 	{
 		read_whitespace(json, pos);
@@ -244,6 +149,11 @@ namespace clan
 		case 'f':
 		case 't':
 			return read_boolean(json, pos);
+		case 'n':
+			if (json.compare(pos, 4, "null") != 0)
+				throw JsonException("Unexpected character in JSON data");
+			pos += 4;
+			return JsonValue::null();
 		default:
 			throw JsonException("Unexpected character in JSON data");
 		}
@@ -458,12 +368,9 @@ namespace clan
 		}
 		int end_pos = pos;
 
-		std::string number_string = json.substr(start_pos, end_pos - start_pos);
-		if (number_string.empty())
-			throw JsonException("Unexpected character in JSON data");
-
 		double result = 0.0;
-		sscanf(number_string.c_str(), "%lf", &result);
+		if (NumberConversion::parse(json.data() + start_pos, json.data() + end_pos, result) == json.data() + start_pos)
+			throw JsonException("Unexpected character in JSON data");
 		return JsonValue::number(result);
 	}
 
@@ -0,0 +1,119 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "json_writer.h"
+#include "Core/Text/number_conversion.h"
+
+namespace clan
+{
+	void JsonWriter::write_string(const char *str, size_t length, std::string &json)
+	{
+		json.push_back('"');
+
+		for (size_t i = 0; i < length; i++)
+		{
+			unsigned char c = str[i];
+			if (c == '"' || c == '\\')
+			{
+				json.push_back('\\');
+				json.push_back(c);
+			}
+			else if (c == '\b')
+			{
+				json.push_back('\\');
+				json.push_back('b');
+			}
+			else if (c == '\f')
+			{
+				json.push_back('\\');
+				json.push_back('f');
+			}
+			else if (c == '\n')
+			{
+				json.push_back('\\');
+				json.push_back('n');
+			}
+			else if (c == '\r')
+			{
+				json.push_back('\\');
+				json.push_back('r');
+			}
+			else if (c == '\t')
+			{
+				json.push_back('\\');
+				json.push_back('t');
+			}
+			else if (c < 32)
+			{
+				json.push_back('\\');
+				json.push_back('u');
+				json.push_back('0');
+				json.push_back('0');
+
+				if (c >= 16)
+				{
+					json.push_back('1');
+					c -= 16;
+				}
+				else
+				{
+					json.push_back('0');
+				}
+
+				if (c < 10)
+				{
+					json.push_back('0' + c);
+				}
+				else
+				{
+					json.push_back('a' + (c - 10));
+				}
+			}
+			else
+			{
+				json.push_back(c);
+			}
+		}
+
+		json.push_back('"');
+	}
+
+	void JsonWriter::write_number(double value, std::string &json)
+	{
+		if (value != value || value - value != 0.0) // NaN and infinity have no JSON representation
+		{
+			json += "null";
+			return;
+		}
+
+		char buffer[NumberConversion::shortest_buffer_size];
+		int length = NumberConversion::format_shortest(value, buffer);
+		json.append(buffer, length);
+	}
+}
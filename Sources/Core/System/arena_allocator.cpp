@@ -0,0 +1,193 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/System/arena_allocator.h"
+#include "API/Core/System/system.h"
+#include "API/Core/System/thread_local_storage.h"
+#include "API/Core/Math/cl_math.h"
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#if defined(__APPLE__)
+#define cl_arena_tls thread_local
+#else
+#define cl_arena_tls cl_tls_variable
+#endif
+
+namespace clan
+{
+	namespace
+	{
+		// Thread arenas are kept until exit. A thread id reused by a new thread also reuses the arena
+		std::mutex thread_arenas_mutex;
+		std::unordered_map<std::thread::id, std::unique_ptr<ArenaAllocator>> thread_arenas;
+		cl_arena_tls ArenaAllocator *thread_arena = nullptr;
+	}
+
+	class ArenaAllocator_Impl
+	{
+	public:
+		ArenaAllocator_Impl(size_t block_size, bool collect_statistics) : next_block_size(max(block_size, (size_t)256)), collect_statistics(collect_statistics) { }
+		~ArenaAllocator_Impl() { free(); }
+
+		void *allocate(size_t size, size_t alignment);
+		void free();
+
+		struct Block
+		{
+			char *data;
+			size_t size;
+		};
+
+		std::vector<Block> blocks;
+		size_t current_block = 0;
+		size_t block_pos = 0;
+		size_t next_block_size;
+
+		bool collect_statistics;
+		AllocatorStatistics stats;
+
+		static const size_t max_block_size = 4 * 1024 * 1024;
+	};
+
+	ArenaAllocator::ArenaAllocator(size_t block_size, bool collect_statistics)
+		: impl(std::make_shared<ArenaAllocator_Impl>(block_size, collect_statistics))
+	{
+	}
+
+	void *ArenaAllocator::allocate(size_t size, size_t alignment)
+	{
+		return impl->allocate(size, alignment);
+	}
+
+	ArenaMarker ArenaAllocator::get_marker() const
+	{
+		ArenaMarker marker;
+		marker.block = impl->current_block;
+		marker.pos = impl->block_pos;
+		marker.live_bytes = impl->stats.live_bytes;
+		return marker;
+	}
+
+	void ArenaAllocator::reset(const ArenaMarker &marker)
+	{
+		impl->current_block = marker.block;
+		impl->block_pos = marker.pos;
+		impl->stats.live_bytes = marker.live_bytes;
+	}
+
+	void ArenaAllocator::reset()
+	{
+		reset(ArenaMarker());
+	}
+
+	void ArenaAllocator::free()
+	{
+		impl->free();
+	}
+
+	AllocatorStatistics ArenaAllocator::get_statistics() const
+	{
+		return impl->stats;
+	}
+
+	ArenaAllocator &ArenaAllocator::get_thread_arena()
+	{
+		if (!thread_arena)
+		{
+			std::unique_lock<std::mutex> lock(thread_arenas_mutex);
+			std::unique_ptr<ArenaAllocator> &arena = thread_arenas[std::this_thread::get_id()];
+			if (arena)
+				arena->reset(); // The previous owner has exited, so its allocations are dead
+			else
+				arena.reset(new ArenaAllocator());
+			thread_arena = arena.get();
+		}
+		return *thread_arena;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	void *ArenaAllocator_Impl::allocate(size_t size, size_t alignment)
+	{
+		if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+			throw Exception("Alignment must be a power of two");
+
+		while (true)
+		{
+			if (current_block < blocks.size())
+			{
+				Block &block = blocks[current_block];
+				size_t aligned_pos = ((size_t)(block.data + block_pos) + alignment - 1) & ~(alignment - 1);
+				aligned_pos -= (size_t)block.data;
+				if (aligned_pos + size <= block.size)
+				{
+					block_pos = aligned_pos + size;
+					if (collect_statistics)
+					{
+						stats.live_bytes += size;
+						stats.peak_live_bytes = max(stats.peak_live_bytes, stats.live_bytes);
+						stats.num_allocations++;
+					}
+					return block.data + aligned_pos;
+				}
+
+				// Blocks kept from before a reset are reused before new ones are allocated
+				if (current_block + 1 < blocks.size())
+				{
+					current_block++;
+					block_pos = 0;
+					continue;
+				}
+			}
+
+			Block block;
+			block.size = max(next_block_size, size + alignment);
+			block.data = static_cast<char*>(System::aligned_alloc(block.size, 16));
+			blocks.push_back(block);
+			current_block = blocks.size() - 1;
+			block_pos = 0;
+			next_block_size = min(next_block_size * 2, max_block_size);
+			stats.reserved_bytes += block.size;
+		}
+	}
+
+	void ArenaAllocator_Impl::free()
+	{
+		for (auto &block : blocks)
+			System::aligned_free(block.data);
+		blocks.clear();
+		current_block = 0;
+		block_pos = 0;
+		stats.live_bytes = 0;
+		stats.reserved_bytes = 0;
+	}
+}
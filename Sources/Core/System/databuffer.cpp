@@ -29,9 +29,43 @@
 #include "Core/precomp.h"
 #include "API/Core/System/databuffer.h"
 #include <string.h>
+#include <atomic>
+#include <new>
 
 namespace clan
 {
+	// Reference counted heap block holding the data of one or more buffers
+	class DataBufferStorage
+	{
+	public:
+		static DataBufferStorage *create(unsigned int capacity)
+		{
+			char *memory = new char[header_size + capacity];
+			return new (memory) DataBufferStorage();
+		}
+
+		char *get_data() { return reinterpret_cast<char*>(this) + header_size; }
+
+		void add_reference() { ref_count.fetch_add(1, std::memory_order_relaxed); }
+
+		void release_reference()
+		{
+			if (ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				this->~DataBufferStorage();
+				delete[] reinterpret_cast<char*>(this);
+			}
+		}
+
+	private:
+		DataBufferStorage() : ref_count(1) { }
+
+		// Keeps the data 16 byte aligned
+		static const unsigned int header_size = 16;
+
+		std::atomic_int ref_count;
+	};
+
 	class DataBuffer_Impl
 	{
 	public:
@@ -41,13 +75,50 @@ namespace clan
 
 		~DataBuffer_Impl()
 		{
-			delete[] data;
+			if (storage)
+				storage->release_reference();
+		}
+
+		void reallocate(unsigned int new_capacity)
+		{
+			// Small buffers live in the inline bytes until they outgrow them. An empty buffer
+			// allocates nothing, so it keeps reporting a null pointer and a capacity of zero.
+			if (!storage && new_capacity <= inline_capacity)
+			{
+				if (data != inline_data.bytes)
+				{
+					memset(inline_data.bytes, 0, inline_capacity);
+					data = inline_data.bytes;
+					allocated_size = inline_capacity;
+				}
+				return;
+			}
+
+			DataBufferStorage *new_storage = DataBufferStorage::create(new_capacity);
+			char *new_data = new_storage->get_data();
+			if (size)
+				memcpy(new_data, data, size);
+			memset(new_data + size, 0, new_capacity - size);
+			if (storage)
+				storage->release_reference();
+			storage = new_storage;
+			data = new_data;
+			allocated_size = new_capacity;
 		}
 
+		static const unsigned int inline_capacity = 32;
+
 	public:
 		char *data;
 		unsigned int size;
 		unsigned int allocated_size;
+		DataBufferStorage *storage = nullptr;
+
+		union
+		{
+			char bytes[inline_capacity];
+			double alignment;
+		} inline_data;
 	};
 
 	DataBuffer::DataBuffer()
@@ -65,14 +136,41 @@ namespace clan
 		: impl(std::make_shared<DataBuffer_Impl>())
 	{
 		set_size(new_size);
-		memcpy(impl->data, new_data, new_size);
+		if (new_size)
+			memcpy(impl->data, new_data, new_size);
 	}
 
 	DataBuffer::DataBuffer(const DataBuffer &new_data, unsigned int pos, unsigned int size)
 		: impl(std::make_shared<DataBuffer_Impl>())
 	{
-		set_size(size);
-		memcpy(impl->data, new_data.get_data() + pos, size);
+		if (pos > new_data.get_size() || size > new_data.get_size() - pos)
+			throw Exception("DataBuffer slice out of bounds");
+
+		DataBufferStorage *storage = new_data.impl ? new_data.impl->storage : nullptr;
+		if (storage && size > DataBuffer_Impl::inline_capacity)
+		{
+			storage->add_reference();
+			impl->storage = storage;
+			impl->data = new_data.impl->data + pos;
+			impl->size = size;
+			impl->allocated_size = size;
+		}
+		else
+		{
+			set_size(size);
+			if (size)
+				memcpy(impl->data, new_data.get_data() + pos, size);
+		}
+	}
+
+	DataBuffer::DataBuffer(const DataBuffer &copy)
+		: impl(copy.impl)
+	{
+	}
+
+	DataBuffer::DataBuffer(DataBuffer &&move)
+		: impl(std::move(move.impl))
+	{
 	}
 
 	DataBuffer::~DataBuffer()
@@ -81,22 +179,22 @@ namespace clan
 
 	char *DataBuffer::get_data()
 	{
-		return impl->data;
+		return impl ? impl->data : nullptr;
 	}
 
 	const char *DataBuffer::get_data() const
 	{
-		return impl->data;
+		return impl ? impl->data : nullptr;
 	}
 
 	unsigned int DataBuffer::get_size() const
 	{
-		return impl->size;
+		return impl ? impl->size : 0;
 	}
 
 	unsigned int DataBuffer::get_capacity() const
 	{
-		return impl->allocated_size;
+		return impl ? impl->allocated_size : 0;
 	}
 
 	char &DataBuffer::operator[](int i)
@@ -125,39 +223,33 @@ namespace clan
 		return *this;
 	}
 
+	DataBuffer &DataBuffer::operator =(DataBuffer &&move)
+	{
+		impl = std::move(move.impl);
+		return *this;
+	}
+
 	void DataBuffer::set_size(unsigned int new_size)
 	{
+		if (!impl)
+			impl = std::make_shared<DataBuffer_Impl>();
+
 		if (new_size > impl->allocated_size)
-		{
-			char *old_data = impl->data;
-			impl->data = new char[new_size];
-			memcpy(impl->data, old_data, impl->size);
-			delete[] old_data;
-			memset(impl->data + impl->size, 0, new_size - impl->size);
-			impl->size = new_size;
-			impl->allocated_size = new_size;
-		}
-		else
-		{
-			impl->size = new_size;
-		}
+			impl->reallocate(new_size);
+		impl->size = new_size;
 	}
 
 	void DataBuffer::set_capacity(unsigned int new_capacity)
 	{
+		if (!impl)
+			impl = std::make_shared<DataBuffer_Impl>();
+
 		if (new_capacity > impl->allocated_size)
-		{
-			char *old_data = impl->data;
-			impl->data = new char[new_capacity];
-			memcpy(impl->data, old_data, impl->size);
-			delete[] old_data;
-			memset(impl->data + impl->size, 0, new_capacity - impl->size);
-			impl->allocated_size = new_capacity;
-		}
+			impl->reallocate(new_capacity);
 	}
 
 	bool DataBuffer::is_null() const
 	{
-		return impl->size == 0;
+		return !impl || impl->size == 0;
 	}
 }
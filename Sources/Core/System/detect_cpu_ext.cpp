@@ -46,6 +46,7 @@ namespace clan
 
 #if (defined(WIN32) || defined(_WIN32) || defined(_WIN64)) && !defined __MINGW32__
 #include <intrin.h>
+#define cl_xgetbv _xgetbv
 #endif
 #ifdef __GNUC__
 
@@ -54,6 +55,8 @@ namespace clan
 
 #define __cpuid(out, infoType)\
 	asm("cpuid": "=a" ((out)[0]), "=b" ((out)[1]), "=c" ((out)[2]), "=d" ((out)[3]): "a" (infoType));
+#define __cpuidex(out, infoType, subType)\
+	asm("cpuid": "=a" ((out)[0]), "=b" ((out)[1]), "=c" ((out)[2]), "=d" ((out)[3]): "a" (infoType), "c" (subType));
 #else
 
 #define __cpuid(out, infoType) \
@@ -63,8 +66,22 @@ namespace clan
 			"popl %%ebx" \
 		: "=a" ((out)[0]), "=r" ((out)[1]), "=c" ((out)[2]), "=d" ((out)[3]): "a" (infoType));
 
+#define __cpuidex(out, infoType, subType) \
+	asm volatile(	"pushl %%ebx \n" \
+			"cpuid \n" \
+			"movl %%ebx, %1 \n" \
+			"popl %%ebx" \
+		: "=a" ((out)[0]), "=r" ((out)[1]), "=c" ((out)[2]), "=d" ((out)[3]): "a" (infoType), "c" (subType));
+
 #endif
 
+	static unsigned long long cl_xgetbv(unsigned int index)
+	{
+		unsigned int eax, edx;
+		asm volatile("xgetbv" : "=a" (eax), "=d" (edx) : "c" (index));
+		return ((unsigned long long)edx << 32) | eax;
+	}
+
 #endif
 
 	bool System::detect_cpu_extension(CPU_ExtensionPPC ext)
@@ -167,6 +184,25 @@ namespace clan
 			__cpuid((int*)cpuinfo, 0x1);
 			return ((cpuinfo[2] & (1 << 25)) != 0);
 		}
+		else if (ext == pclmul)
+		{
+			__cpuid((int*)cpuinfo, 0x1);
+			return ((cpuinfo[2] & (1 << 1)) != 0);
+		}
+		else if (ext == avx2)
+		{
+			// The OS must also save the AVX registers on context switches (OSXSAVE and XCR0 bits 1 and 2)
+			__cpuid((int*)cpuinfo, 0x1);
+			if ((cpuinfo[2] & (1 << 27)) == 0 || (cpuinfo[2] & (1 << 28)) == 0 || (cl_xgetbv(0) & 6) != 6)
+				return false;
+
+			__cpuid((int*)cpuinfo, 0x0);
+			if (cpuinfo[0] < 7)
+				return false;
+
+			__cpuidex((int*)cpuinfo, 0x7, 0);
+			return ((cpuinfo[1] & (1 << 5)) != 0);
+		}
 		else if (ext == fma3)
 		{
 			__cpuid((int*)cpuinfo, 0x1);
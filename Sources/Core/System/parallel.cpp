@@ -0,0 +1,183 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/System/parallel.h"
+#include "API/Core/System/work_queue.h"
+#include "API/Core/Math/cl_math.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+namespace clan
+{
+	class ParallelForRange
+	{
+	public:
+		ParallelForRange(int begin, int end, int grain_size, const std::function<void(int, int)> &func)
+			: begin(begin), end(end), grain_size(grain_size), num_chunks((end - begin + grain_size - 1) / grain_size), func(func),
+			next_chunk(0), chunks_done(0), cancelled(false)
+		{
+		}
+
+		/// \brief Processes chunks until none are left to claim
+		void process_chunks();
+
+		/// \brief Blocks until every chunk has been processed
+		void wait();
+
+		void rethrow_exception();
+
+		const int begin;
+		const int end;
+		const int grain_size;
+		const int num_chunks;
+
+		// Scheduled when the last chunk finishes
+		Task completed_task;
+
+	private:
+		void chunks_finished();
+
+		std::function<void(int, int)> func;
+		std::atomic_int next_chunk;
+		std::atomic_int chunks_done;
+		std::atomic_bool cancelled;
+
+		std::mutex mutex;
+		std::condition_variable done_event;
+		std::exception_ptr exception;
+	};
+
+	int parallel_grain_size(const WorkQueue &queue, int count, int grain_size)
+	{
+		if (grain_size > 0)
+			return grain_size;
+
+		// Four chunks per thread (including the calling thread) evens out chunks that take longer than others
+		int num_chunks = (queue.get_num_threads() + 1) * 4;
+		return clan::max((count + num_chunks - 1) / num_chunks, 1);
+	}
+
+	void parallel_for(WorkQueue &queue, int begin, int end, const std::function<void(int chunk_begin, int chunk_end)> &func, int grain_size)
+	{
+		if (end <= begin)
+			return;
+
+		grain_size = parallel_grain_size(queue, end - begin, grain_size);
+		if (end - begin <= grain_size)
+		{
+			func(begin, end);
+			return;
+		}
+
+		auto range = std::make_shared<ParallelForRange>(begin, end, grain_size, func);
+		int num_helpers = clan::min(range->num_chunks - 1, queue.get_num_threads());
+		for (int i = 0; i < num_helpers; i++)
+			queue.queue([range]() { range->process_chunks(); });
+
+		range->process_chunks();
+		range->wait();
+		range->rethrow_exception();
+	}
+
+	Task parallel_for_async(WorkQueue &queue, int begin, int end, const std::function<void(int chunk_begin, int chunk_end)> &func, int grain_size)
+	{
+		if (end <= begin)
+			return Task::run_async(queue, []() { });
+
+		grain_size = parallel_grain_size(queue, end - begin, grain_size);
+		auto range = std::make_shared<ParallelForRange>(begin, end, grain_size, func);
+
+		Task task(queue, [range]() { range->rethrow_exception(); });
+		range->completed_task = task;
+
+		int num_helpers = clan::min(range->num_chunks, queue.get_num_threads());
+		for (int i = 0; i < num_helpers; i++)
+			queue.queue([range]() { range->process_chunks(); });
+
+		return task;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	void ParallelForRange::process_chunks()
+	{
+		while (true)
+		{
+			int chunk = next_chunk++;
+			if (chunk >= num_chunks)
+				break;
+
+			if (!cancelled)
+			{
+				int chunk_begin = begin + chunk * grain_size;
+				int chunk_end = clan::min(chunk_begin + grain_size, end);
+				try
+				{
+					func(chunk_begin, chunk_end);
+				}
+				catch (...)
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					if (!exception)
+						exception = std::current_exception();
+					cancelled = true;
+				}
+			}
+
+			if (++chunks_done == num_chunks)
+				chunks_finished();
+		}
+	}
+
+	void ParallelForRange::chunks_finished()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		Task task = completed_task;
+		completed_task = Task();
+		lock.unlock();
+		done_event.notify_all();
+
+		if (!task.is_null())
+			task.run();
+	}
+
+	void ParallelForRange::wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		done_event.wait(lock, [&]() { return chunks_done == num_chunks; });
+	}
+
+	void ParallelForRange::rethrow_exception()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (exception)
+			std::rethrow_exception(exception);
+	}
+}
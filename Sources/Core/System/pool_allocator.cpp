@@ -0,0 +1,328 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/System/pool_allocator.h"
+#include "API/Core/System/system.h"
+#include "API/Core/System/thread_local_storage.h"
+#include "API/Core/Math/cl_math.h"
+#include <vector>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#if defined(__APPLE__)
+#define cl_pool_tls thread_local
+#else
+#define cl_pool_tls cl_tls_variable
+#endif
+
+namespace clan
+{
+	namespace
+	{
+		// Thread pools are kept until exit, as objects allocated from them may outlive the thread.
+		// A thread id reused by a new thread also reuses the pool
+		std::mutex thread_pools_mutex;
+		std::unordered_map<std::thread::id, std::unique_ptr<PoolAllocator>> thread_pools;
+		cl_pool_tls PoolAllocator *thread_pool = nullptr;
+	}
+
+	class PoolAllocator_Impl
+	{
+	public:
+		PoolAllocator_Impl(bool collect_statistics);
+		~PoolAllocator_Impl() { free(); }
+
+		void *allocate(size_t size);
+		void deallocate(void *data);
+		void free();
+
+		static const size_t page_size = 64 * 1024;
+		static const int num_size_classes = 24;
+		static const int large_size_class = -1;
+
+		// Located at the start of every page, so the owner of a pointer is found by masking off the low bits
+		struct PageHeader
+		{
+			PoolAllocator_Impl *pool;
+			int size_class;
+			size_t large_size;
+			PageHeader *prev_large;
+			PageHeader *next_large;
+		};
+
+		static const size_t page_header_size = (sizeof(PageHeader) + 15) & ~(size_t)15;
+
+		static PageHeader *get_page_header(void *data) { return reinterpret_cast<PageHeader*>(reinterpret_cast<uintptr_t>(data) & ~(uintptr_t)(page_size - 1)); }
+
+		bool collect_statistics;
+		AllocatorStatistics stats;
+
+	private:
+		struct FreeNode
+		{
+			FreeNode *next;
+		};
+
+		struct SizeClass
+		{
+			size_t size = 0;
+			FreeNode *free_list = nullptr;
+			char *bump_pos = nullptr;
+			char *bump_end = nullptr;
+		};
+
+		void *allocate_large(size_t size);
+		void add_page(int size_class);
+
+		SizeClass size_classes[num_size_classes];
+		unsigned char size_class_lookup[PoolAllocator::max_pooled_size / 16 + 1];
+		std::vector<PageHeader *> pages;
+		PageHeader *large_blocks = nullptr;
+	};
+
+	PoolAllocator::PoolAllocator(bool collect_statistics)
+		: impl(std::make_shared<PoolAllocator_Impl>(collect_statistics))
+	{
+	}
+
+	void *PoolAllocator::allocate(size_t size)
+	{
+		return impl->allocate(size);
+	}
+
+	void PoolAllocator::deallocate(void *data)
+	{
+		if (data)
+		{
+			if (PoolAllocator_Impl::get_page_header(data)->pool != impl.get())
+				throw Exception("Memory was not allocated by this PoolAllocator");
+			impl->deallocate(data);
+		}
+	}
+
+	void PoolAllocator::deallocate_any(void *data)
+	{
+		if (data)
+			PoolAllocator_Impl::get_page_header(data)->pool->deallocate(data);
+	}
+
+	void PoolAllocator::free()
+	{
+		impl->free();
+	}
+
+	AllocatorStatistics PoolAllocator::get_statistics() const
+	{
+		return impl->stats;
+	}
+
+	PoolAllocator &PoolAllocator::get_thread_pool()
+	{
+		if (!thread_pool)
+		{
+			std::unique_lock<std::mutex> lock(thread_pools_mutex);
+			std::unique_ptr<PoolAllocator> &pool = thread_pools[std::this_thread::get_id()];
+			if (!pool)
+				pool.reset(new PoolAllocator());
+			thread_pool = pool.get();
+		}
+		return *thread_pool;
+	}
+
+	void *PoolAllocated::operator new(size_t size, PoolAllocator *allocator)
+	{
+		return allocator->allocate(size);
+	}
+
+	void PoolAllocated::operator delete(void *data)
+	{
+		PoolAllocator::deallocate_any(data);
+	}
+
+	void PoolAllocated::operator delete(void *data, PoolAllocator *allocator)
+	{
+		allocator->deallocate(data);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	PoolAllocator_Impl::PoolAllocator_Impl(bool collect_statistics) : collect_statistics(collect_statistics)
+	{
+		// 16 byte steps up to 128, then four classes per doubling up to 2048
+		static const size_t class_sizes[num_size_classes] =
+		{
+			16, 32, 48, 64, 80, 96, 112, 128,
+			160, 192, 224, 256, 320, 384, 448, 512,
+			640, 768, 896, 1024, 1280, 1536, 1792, 2048
+		};
+
+		int size_class = 0;
+		for (int i = 0; i < num_size_classes; i++)
+			size_classes[i].size = class_sizes[i];
+		for (size_t i = 0; i <= PoolAllocator::max_pooled_size / 16; i++)
+		{
+			while (class_sizes[size_class] < i * 16)
+				size_class++;
+			size_class_lookup[i] = (unsigned char)size_class;
+		}
+	}
+
+	void *PoolAllocator_Impl::allocate(size_t size)
+	{
+		if (size > PoolAllocator::max_pooled_size)
+			return allocate_large(size);
+
+		int index = size_class_lookup[(max(size, (size_t)1) + 15) / 16];
+		SizeClass &size_class = size_classes[index];
+
+		void *data;
+		if (size_class.free_list)
+		{
+			data = size_class.free_list;
+			size_class.free_list = size_class.free_list->next;
+		}
+		else
+		{
+			if (size_class.bump_end - size_class.bump_pos < (ptrdiff_t)size_class.size)
+				add_page(index);
+			data = size_class.bump_pos;
+			size_class.bump_pos += size_class.size;
+		}
+
+		if (collect_statistics)
+		{
+			stats.live_bytes += size_class.size;
+			stats.peak_live_bytes = max(stats.peak_live_bytes, stats.live_bytes);
+			stats.num_allocations++;
+		}
+		return data;
+	}
+
+	void PoolAllocator_Impl::deallocate(void *data)
+	{
+		PageHeader *header = get_page_header(data);
+		if (header->size_class == large_size_class)
+		{
+			if (header->prev_large)
+				header->prev_large->next_large = header->next_large;
+			else
+				large_blocks = header->next_large;
+			if (header->next_large)
+				header->next_large->prev_large = header->prev_large;
+
+			size_t block_size = header->large_size + page_header_size;
+			stats.reserved_bytes -= block_size;
+			if (collect_statistics)
+			{
+				stats.live_bytes -= header->large_size;
+				stats.num_frees++;
+			}
+			System::aligned_free(header);
+		}
+		else
+		{
+			SizeClass &size_class = size_classes[header->size_class];
+			FreeNode *node = static_cast<FreeNode*>(data);
+			node->next = size_class.free_list;
+			size_class.free_list = node;
+
+			if (collect_statistics)
+			{
+				stats.live_bytes -= size_class.size;
+				stats.num_frees++;
+			}
+		}
+	}
+
+	void *PoolAllocator_Impl::allocate_large(size_t size)
+	{
+		size_t block_size = size + page_header_size;
+		PageHeader *header = static_cast<PageHeader*>(System::aligned_alloc(block_size, page_size));
+		header->pool = this;
+		header->size_class = large_size_class;
+		header->large_size = size;
+		header->prev_large = nullptr;
+		header->next_large = large_blocks;
+		if (large_blocks)
+			large_blocks->prev_large = header;
+		large_blocks = header;
+
+		stats.reserved_bytes += block_size;
+		if (collect_statistics)
+		{
+			stats.live_bytes += size;
+			stats.peak_live_bytes = max(stats.peak_live_bytes, stats.live_bytes);
+			stats.num_allocations++;
+		}
+		return reinterpret_cast<char*>(header) + page_header_size;
+	}
+
+	void PoolAllocator_Impl::add_page(int size_class)
+	{
+		PageHeader *header = static_cast<PageHeader*>(System::aligned_alloc(page_size, page_size));
+		header->pool = this;
+		header->size_class = size_class;
+		header->large_size = 0;
+		header->prev_large = nullptr;
+		header->next_large = nullptr;
+		pages.push_back(header);
+
+		// The unused tail of the previous page is abandoned. It is at most one object in size
+		char *data = reinterpret_cast<char*>(header);
+		size_classes[size_class].bump_pos = data + page_header_size;
+		size_classes[size_class].bump_end = data + page_size;
+		stats.reserved_bytes += page_size;
+	}
+
+	void PoolAllocator_Impl::free()
+	{
+		for (auto &page : pages)
+			System::aligned_free(page);
+		pages.clear();
+
+		while (large_blocks)
+		{
+			PageHeader *next = large_blocks->next_large;
+			System::aligned_free(large_blocks);
+			large_blocks = next;
+		}
+
+		for (auto &size_class : size_classes)
+		{
+			size_class.free_list = nullptr;
+			size_class.bump_pos = nullptr;
+			size_class.bump_end = nullptr;
+		}
+
+		stats.live_bytes = 0;
+		stats.reserved_bytes = 0;
+	}
+}
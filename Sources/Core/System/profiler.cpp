@@ -0,0 +1,362 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#include "Core/precomp.h"
+#include "API/Core/System/profiler.h"
+#include "API/Core/System/exception.h"
+#include "API/Core/System/thread_local_storage.h"
+#include "API/Core/IOData/file.h"
+#include "API/Core/JSON/json_value.h"
+#include "API/Core/Text/string_format.h"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__APPLE__)
+#define cl_profiler_tls thread_local
+#else
+#define cl_profiler_tls cl_tls_variable
+#endif
+
+namespace clan
+{
+	namespace
+	{
+		struct ProfileEvent
+		{
+			const char *name;
+			uint64_t start;
+			uint64_t duration;
+			int depth;
+			bool frame;
+		};
+
+		/// \brief Ring buffer of the most recent events recorded by one thread
+		///
+		/// The mutex is only contended while the data is exported or cleared.
+		class ProfileThreadBuffer
+		{
+		public:
+			ProfileThreadBuffer(int size, int thread_index, const std::string &thread_name) : events(std::max(size, 1)), thread_index(thread_index), thread_name(thread_name) { }
+
+			void add(const ProfileEvent &e)
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				events[next % events.size()] = e;
+				next++;
+			}
+
+			template<typename Func>
+			void for_each(Func func)
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				uint64_t first = next > events.size() ? next - events.size() : 0;
+				for (uint64_t i = first; i < next; i++)
+					func(events[i % events.size()]);
+			}
+
+			std::mutex mutex;
+			std::vector<ProfileEvent> events;
+			uint64_t next = 0;
+			int thread_index;
+			std::string thread_name;
+		};
+
+		struct ProfileZoneEntry
+		{
+			const char *name;
+			uint64_t start;
+		};
+
+		class ProfileThreadState
+		{
+		public:
+			enum { max_depth = 64 };
+
+			std::shared_ptr<ProfileThreadBuffer> buffer;
+			ProfileZoneEntry zones[max_depth];
+			int depth = 0;
+			std::string thread_name;
+		};
+
+		// Zones measure durations, so use a monotonic clock rather than System::get_microseconds
+		uint64_t get_timestamp()
+		{
+			return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		std::mutex profiler_mutex;
+		std::vector<std::shared_ptr<ProfileThreadBuffer>> profiler_buffers;
+		int profiler_events_per_thread = 65536;
+		int profiler_next_thread_index = 1;
+
+		// Thread states are kept until exit. A thread id reused by a new thread also reuses the state
+		std::unordered_map<std::thread::id, std::unique_ptr<ProfileThreadState>> profiler_thread_states;
+		cl_profiler_tls ProfileThreadState *thread_state = nullptr;
+
+		ProfileThreadState &get_thread_state()
+		{
+			if (!thread_state)
+			{
+				std::unique_lock<std::mutex> lock(profiler_mutex);
+				std::unique_ptr<ProfileThreadState> &state = profiler_thread_states[std::this_thread::get_id()];
+				if (state)
+				{
+					// The events of the thread that exited stay in its buffer. Start a new one for this thread
+					state->buffer.reset();
+					state->depth = 0;
+					state->thread_name.clear();
+				}
+				else
+				{
+					state.reset(new ProfileThreadState());
+				}
+				thread_state = state.get();
+			}
+			return *thread_state;
+		}
+
+		ProfileThreadBuffer *get_thread_buffer(ProfileThreadState &state)
+		{
+			if (!state.buffer)
+			{
+				std::unique_lock<std::mutex> lock(profiler_mutex);
+				std::string name = state.thread_name.empty() ? string_format("Thread %1", profiler_next_thread_index) : state.thread_name;
+				state.buffer = std::make_shared<ProfileThreadBuffer>(profiler_events_per_thread, profiler_next_thread_index++, name);
+				profiler_buffers.push_back(state.buffer);
+			}
+			return state.buffer.get();
+		}
+
+		std::vector<std::shared_ptr<ProfileThreadBuffer>> get_buffers()
+		{
+			std::unique_lock<std::mutex> lock(profiler_mutex);
+			return profiler_buffers;
+		}
+
+		std::string to_json_string(const std::string &text)
+		{
+			return JsonValue::string(text).to_json();
+		}
+	}
+
+	std::atomic_bool Profiler::enabled(false);
+
+	void Profiler::enable(int events_per_thread)
+	{
+		std::unique_lock<std::mutex> lock(profiler_mutex);
+		profiler_events_per_thread = events_per_thread;
+		enabled.store(true);
+	}
+
+	void Profiler::disable()
+	{
+		enabled.store(false);
+	}
+
+	void Profiler::begin_zone(const char *name)
+	{
+		ProfileThreadState &state = get_thread_state();
+		if (state.depth < ProfileThreadState::max_depth)
+		{
+			state.zones[state.depth].name = name;
+			state.zones[state.depth].start = get_timestamp();
+		}
+		state.depth++;
+	}
+
+	void Profiler::end_zone()
+	{
+		ProfileThreadState &state = get_thread_state();
+		if (state.depth == 0)
+			return;
+
+		state.depth--;
+		if (state.depth < ProfileThreadState::max_depth)
+		{
+			const ProfileZoneEntry &zone = state.zones[state.depth];
+			ProfileEvent e;
+			e.name = zone.name;
+			e.start = zone.start;
+			e.duration = get_timestamp() - zone.start;
+			e.depth = state.depth;
+			e.frame = false;
+			get_thread_buffer(state)->add(e);
+		}
+	}
+
+	void Profiler::mark_frame()
+	{
+		if (!is_enabled())
+			return;
+
+		ProfileThreadState &state = get_thread_state();
+		ProfileEvent e;
+		e.name = "Frame";
+		e.start = get_timestamp();
+		e.duration = 0;
+		e.depth = 0;
+		e.frame = true;
+		get_thread_buffer(state)->add(e);
+	}
+
+	void Profiler::set_thread_name(const std::string &name)
+	{
+		ProfileThreadState &state = get_thread_state();
+		state.thread_name = name;
+		if (state.buffer)
+		{
+			std::unique_lock<std::mutex> lock(state.buffer->mutex);
+			state.buffer->thread_name = name;
+		}
+	}
+
+	void Profiler::clear()
+	{
+		for (auto &buffer : get_buffers())
+		{
+			std::unique_lock<std::mutex> lock(buffer->mutex);
+			buffer->next = 0;
+		}
+	}
+
+	std::string Profiler::get_chrome_trace()
+	{
+		std::string json = "{\"traceEvents\":[";
+		bool first = true;
+
+		for (auto &buffer : get_buffers())
+		{
+			std::string thread_name;
+			{
+				std::unique_lock<std::mutex> lock(buffer->mutex);
+				thread_name = buffer->thread_name;
+			}
+
+			if (!first)
+				json += ",";
+			first = false;
+			json += string_format("\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%1,\"args\":{\"name\":%2}}", buffer->thread_index, to_json_string(thread_name));
+
+			// Most zones use the same few names. Escape each of them once
+			std::map<const char *, std::string> names;
+			buffer->for_each([&](const ProfileEvent &e)
+			{
+				auto it = names.find(e.name);
+				if (it == names.end())
+					it = names.insert(std::make_pair(e.name, to_json_string(e.name))).first;
+
+				if (e.frame)
+					json += string_format(",\n{\"name\":%1,\"ph\":\"i\",\"s\":\"t\",\"ts\":%2,\"pid\":1,\"tid\":%3}", it->second, (unsigned long long)e.start, buffer->thread_index);
+				else
+					json += string_format(",\n{\"name\":%1,\"ph\":\"X\",\"ts\":%2,\"dur\":%3,\"pid\":1,\"tid\":%4}", it->second, (unsigned long long)e.start, (unsigned long long)e.duration, buffer->thread_index);
+			});
+		}
+
+		json += "\n]}\n";
+		return json;
+	}
+
+	void Profiler::save_chrome_trace(const std::string &filename)
+	{
+		std::string json = get_chrome_trace();
+		File file(filename, File::create_always, File::access_write);
+		file.write(json.data(), (int)json.length());
+	}
+
+	std::string Profiler::get_report()
+	{
+		struct ZoneSummary
+		{
+			uint64_t calls = 0;
+			uint64_t total = 0;
+			uint64_t max = 0;
+		};
+
+		std::map<std::string, ZoneSummary> zones;
+		std::string frames;
+
+		for (auto &buffer : get_buffers())
+		{
+			ZoneSummary frame_summary;
+			uint64_t last_frame = 0;
+			std::string thread_name;
+
+			buffer->for_each([&](const ProfileEvent &e)
+			{
+				if (e.frame)
+				{
+					if (last_frame != 0)
+					{
+						uint64_t frame_time = e.start - last_frame;
+						frame_summary.calls++;
+						frame_summary.total += frame_time;
+						frame_summary.max = std::max(frame_summary.max, frame_time);
+					}
+					last_frame = e.start;
+				}
+				else
+				{
+					ZoneSummary &summary = zones[e.name];
+					summary.calls++;
+					summary.total += e.duration;
+					summary.max = std::max(summary.max, e.duration);
+				}
+			});
+
+			if (frame_summary.calls > 0)
+			{
+				{
+					std::unique_lock<std::mutex> lock(buffer->mutex);
+					thread_name = buffer->thread_name;
+				}
+				frames += string_format("%1: %2 frames, average %3 ms, max %4 ms\n", thread_name, (unsigned long long)frame_summary.calls,
+					frame_summary.total / (double)frame_summary.calls / 1000.0, frame_summary.max / 1000.0);
+			}
+		}
+
+		std::vector<std::pair<std::string, ZoneSummary>> sorted(zones.begin(), zones.end());
+		std::sort(sorted.begin(), sorted.end(), [](const std::pair<std::string, ZoneSummary> &a, const std::pair<std::string, ZoneSummary> &b) { return a.second.total > b.second.total; });
+
+		std::string report = "Zone: calls, total ms, average us, max us\n";
+		for (auto &zone : sorted)
+		{
+			const ZoneSummary &s = zone.second;
+			report += string_format("%1: %2, %3, %4, %5\n", zone.first, (unsigned long long)s.calls, s.total / 1000.0, s.total / (double)s.calls, (unsigned long long)s.max);
+		}
+		if (!frames.empty())
+			report += "\n" + frames;
+		return report;
+	}
+}
@@ -0,0 +1,238 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/System/task.h"
+#include "API/Core/System/work_queue.h"
+#include "API/Core/System/exception.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+namespace clan
+{
+	class Task_Impl : public std::enable_shared_from_this<Task_Impl>
+	{
+	public:
+		Task_Impl(WorkQueue &queue, const std::function<void()> &func)
+			: queue(new WorkQueue(queue)), func(func), state(state_waiting), unfinished_dependencies(1)
+		{
+		}
+
+		void add_dependency(const std::shared_ptr<Task_Impl> &task);
+		void run();
+		void execute();
+		bool wait(int timeout_ms);
+
+		bool is_completed() const { return state == state_completed; }
+
+	private:
+		enum State
+		{
+			state_waiting,
+			state_queued,
+			state_running,
+			state_completed
+		};
+
+		void dependency_completed();
+		void invoke();
+
+		// The queue reference is dropped when the task is queued, so queued work never keeps its own queue alive
+		std::unique_ptr<WorkQueue> queue;
+		std::function<void()> func;
+		std::atomic_int state;
+		std::atomic_int unfinished_dependencies;
+		bool scheduled = false;
+
+		std::mutex mutex;
+		std::condition_variable completed_event;
+		std::vector<std::shared_ptr<Task_Impl>> continuations;
+		std::exception_ptr exception;
+	};
+
+	Task::Task()
+	{
+	}
+
+	Task::Task(WorkQueue &queue, const std::function<void()> &func)
+		: impl(std::make_shared<Task_Impl>(queue, func))
+	{
+	}
+
+	void Task::throw_if_null() const
+	{
+		if (!impl)
+			throw Exception("Task is null");
+	}
+
+	bool Task::is_completed() const
+	{
+		throw_if_null();
+		return impl->is_completed();
+	}
+
+	void Task::add_dependency(const Task &task)
+	{
+		throw_if_null();
+		task.throw_if_null();
+		impl->add_dependency(task.impl);
+	}
+
+	void Task::run()
+	{
+		throw_if_null();
+		impl->run();
+	}
+
+	Task Task::then(WorkQueue &queue, const std::function<void()> &func) const
+	{
+		throw_if_null();
+		Task task(queue, func);
+		task.add_dependency(*this);
+		task.run();
+		return task;
+	}
+
+	void Task::wait() const
+	{
+		throw_if_null();
+		impl->wait(-1);
+	}
+
+	bool Task::wait(int timeout_ms) const
+	{
+		throw_if_null();
+		return impl->wait(timeout_ms);
+	}
+
+	Task Task::run_async(WorkQueue &queue, const std::function<void()> &func)
+	{
+		Task task(queue, func);
+		task.run();
+		return task;
+	}
+
+	Task Task::when_all(WorkQueue &queue, const std::vector<Task> &tasks, const std::function<void()> &func)
+	{
+		Task task(queue, func);
+		for (const auto &dependency : tasks)
+			task.add_dependency(dependency);
+		task.run();
+		return task;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	void Task_Impl::add_dependency(const std::shared_ptr<Task_Impl> &task)
+	{
+		if (scheduled)
+			throw Exception("Dependencies must be added before the task is scheduled");
+		if (task.get() == this)
+			throw Exception("A task cannot depend on itself");
+
+		std::unique_lock<std::mutex> lock(task->mutex);
+		if (task->state != state_completed)
+		{
+			++unfinished_dependencies;
+			task->continuations.push_back(shared_from_this());
+		}
+	}
+
+	void Task_Impl::run()
+	{
+		if (scheduled)
+			throw Exception("Task has already been scheduled");
+		scheduled = true;
+		dependency_completed();
+	}
+
+	void Task_Impl::dependency_completed()
+	{
+		if (--unfinished_dependencies != 0)
+			return;
+
+		std::unique_ptr<WorkQueue> task_queue = std::move(queue);
+		state = state_queued;
+		std::shared_ptr<Task_Impl> self = shared_from_this();
+		task_queue->queue([self]() { self->execute(); });
+	}
+
+	void Task_Impl::execute()
+	{
+		// wait() may already have claimed the task and executed it on the waiting thread
+		int expected = state_queued;
+		if (state.compare_exchange_strong(expected, state_running))
+			invoke();
+	}
+
+	void Task_Impl::invoke()
+	{
+		try
+		{
+			func();
+		}
+		catch (...)
+		{
+			exception = std::current_exception();
+		}
+
+		std::vector<std::shared_ptr<Task_Impl>> ready;
+		std::unique_lock<std::mutex> lock(mutex);
+		func = std::function<void()>();
+		state = state_completed;
+		ready.swap(continuations);
+		lock.unlock();
+		completed_event.notify_all();
+
+		for (auto &continuation : ready)
+			continuation->dependency_completed();
+	}
+
+	bool Task_Impl::wait(int timeout_ms)
+	{
+		int expected = state_queued;
+		if (state.compare_exchange_strong(expected, state_running))
+			invoke();
+
+		std::unique_lock<std::mutex> lock(mutex);
+		if (timeout_ms < 0)
+		{
+			completed_event.wait(lock, [&]() { return state == state_completed; });
+		}
+		else if (!completed_event.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&]() { return state == state_completed; }))
+		{
+			return false;
+		}
+
+		if (exception)
+			std::rethrow_exception(exception);
+		return true;
+	}
+}
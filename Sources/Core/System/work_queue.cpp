@@ -29,11 +29,18 @@
 #include "Core/precomp.h"
 #include "API/Core/System/work_queue.h"
 #include "API/Core/System/system.h"
+#include "API/Core/System/thread_local_storage.h"
+#include "API/Core/System/profiler.h"
+#include "API/Core/Text/string_format.h"
 #include <algorithm>
 #include "API/Core/Math/cl_math.h"
-#include <atomic>
-#include <thread>
-#include <condition_variable>
+#include "work_queue_impl.h"
+
+#if defined(__APPLE__)
+#define cl_work_queue_tls thread_local
+#else
+#define cl_work_queue_tls cl_tls_variable
+#endif
 
 namespace clan
 {
@@ -60,34 +67,12 @@ namespace clan
 		std::function<void()> func;
 	};
 
-	class WorkQueue_Impl
-	{
-	public:
-		WorkQueue_Impl(bool serial_queue);
-		~WorkQueue_Impl();
-
-		void queue(WorkItem *item); // transfers ownership
-		void work_completed(WorkItem *item); // transfers ownership
-
-		int get_items_queued() const { return items_queued; }
-
-		void process_work_completed();
+	// Identifies the worker running on the current thread. The index is only used in work stealing mode
+	static cl_work_queue_tls WorkQueue_Impl *current_work_queue = nullptr;
+	static cl_work_queue_tls int current_worker_index = -1;
 
-	private:
-		void worker_main();
-
-		bool serial_queue = false;
-		std::vector<std::thread> threads;
-		std::mutex mutex;
-		std::condition_variable worker_event;
-		bool stop_flag = false;
-		std::vector<WorkItem *> queued_items;
-		std::vector<WorkItem *> finished_items;
-		std::atomic_int items_queued;
-	};
-
-	WorkQueue::WorkQueue(bool serial_queue)
-		: impl(std::make_shared<WorkQueue_Impl>(serial_queue))
+	WorkQueue::WorkQueue(bool serial_queue, bool work_stealing, int num_threads)
+		: impl(new WorkQueue_Impl(serial_queue, work_stealing, num_threads), &WorkQueue_Impl::destroy)
 	{
 	}
 
@@ -115,6 +100,11 @@ namespace clan
 		return impl->get_items_queued();
 	}
 
+	int WorkQueue::get_num_threads() const
+	{
+		return impl->get_num_threads();
+	}
+
 	void WorkQueue::process_work_completed()
 	{
 		impl->process_work_completed();
@@ -122,9 +112,20 @@ namespace clan
 
 	/////////////////////////////////////////////////////////////////////////////
 
-	WorkQueue_Impl::WorkQueue_Impl(bool serial_queue)
-		: serial_queue(serial_queue)
+	WorkQueue_Impl::WorkQueue_Impl(bool serial_queue, bool work_stealing, int num_threads)
+		: serial_queue(serial_queue), work_stealing(work_stealing && !serial_queue), num_threads(num_threads),
+		stop_flag(false), items_queued(0), items_injected(0), items_pending(0), workers_sleeping(0)
+	{
+	}
+
+	void WorkQueue_Impl::destroy(WorkQueue_Impl *impl)
 	{
+		// Work running on one of the queue's own workers, such as a task continuation, may release the last
+		// reference. A worker cannot join itself, so the queue is shut down from a separate thread instead.
+		if (current_work_queue == impl)
+			std::thread([impl]() { delete impl; }).detach();
+		else
+			delete impl;
 	}
 
 	WorkQueue_Impl::~WorkQueue_Impl()
@@ -138,38 +139,88 @@ namespace clan
 			elem.join();
 		for (auto & elem : queued_items)
 			delete elem;
+		for (auto & elem : worker_deques)
+		{
+			while (!elem->empty())
+				delete elem->steal();
+		}
 		for (auto & elem : finished_items)
 			delete elem;
 	}
 
+	int WorkQueue_Impl::get_num_threads() const
+	{
+		if (serial_queue)
+			return 1;
+		return num_threads > 0 ? num_threads : clan::max(System::get_num_cores() - 1, 1);
+	}
+
+	void WorkQueue_Impl::start_threads()
+	{
+		int count = get_num_threads();
+
+		if (work_stealing)
+		{
+			for (int i = 0; i < count; i++)
+				worker_deques.push_back(std::unique_ptr<WorkStealingDeque<WorkItem>>(new WorkStealingDeque<WorkItem>()));
+			for (int i = 0; i < count; i++)
+				threads.push_back(std::thread(&WorkQueue_Impl::stealing_worker_main, this, i));
+		}
+		else
+		{
+			for (int i = 0; i < count; i++)
+				threads.push_back(std::thread(&WorkQueue_Impl::worker_main, this));
+		}
+	}
+
 	void WorkQueue_Impl::queue(WorkItem *item) // transfers ownership
 	{
 		if (threads.empty())
+			start_threads();
+
+		if (!work_stealing)
 		{
-			int num_cores = serial_queue ? 1 : clan::max(System::get_num_cores() - 1, 1);
-			for (int i = 0; i < num_cores; i++)
-			{
-				threads.push_back(std::thread(&WorkQueue_Impl::worker_main, this));
-			}
+			std::unique_lock<std::mutex> mutex_lock(mutex);
+			queued_items.push_back(item);
+			++items_queued;
+			mutex_lock.unlock();
+			worker_event.notify_one();
+			return;
 		}
 
-		std::unique_lock<std::mutex> mutex_lock(mutex);
-		queued_items.push_back(item);
+		// Count the item before publishing it, or it could be processed and completed before it was counted
 		++items_queued;
-		mutex_lock.unlock();
-		worker_event.notify_one();
+		if (current_work_queue == this)
+		{
+			worker_deques[current_worker_index]->push(item);
+		}
+		else
+		{
+			std::unique_lock<std::mutex> mutex_lock(mutex);
+			queued_items.push_back(item);
+			++items_injected;
+		}
+
+		// Only pay for the lock and the signal if a worker is actually waiting for work
+		items_pending.fetch_add(1, std::memory_order_seq_cst);
+		if (workers_sleeping.load(std::memory_order_seq_cst) > 0)
+		{
+			std::unique_lock<std::mutex> mutex_lock(mutex);
+			mutex_lock.unlock();
+			worker_event.notify_one();
+		}
 	}
 
 	void WorkQueue_Impl::work_completed(WorkItem *item) // transfers ownership
 	{
-		std::unique_lock<std::mutex> mutex_lock(mutex);
+		std::unique_lock<std::mutex> mutex_lock(finished_mutex);
 		finished_items.push_back(item);
 		++items_queued;
 	}
 
 	void WorkQueue_Impl::process_work_completed()
 	{
-		std::unique_lock<std::mutex> mutex_lock(mutex);
+		std::unique_lock<std::mutex> mutex_lock(finished_mutex);
 		std::vector<WorkItem *> items;
 		items.swap(finished_items);
 		mutex_lock.unlock();
@@ -190,8 +241,17 @@ namespace clan
 		}
 	}
 
+	void WorkQueue_Impl::item_processed(WorkItem *item)
+	{
+		std::unique_lock<std::mutex> mutex_lock(finished_mutex);
+		finished_items.push_back(item);
+	}
+
 	void WorkQueue_Impl::worker_main()
 	{
+		current_work_queue = this;
+		Profiler::set_thread_name("WorkQueue worker");
+
 		while (true)
 		{
 			std::unique_lock<std::mutex> mutex_lock(mutex);
@@ -201,14 +261,91 @@ namespace clan
 				break;
 
 			WorkItem *item = queued_items.front();
-			queued_items.erase(queued_items.begin());
+			queued_items.pop_front();
 			mutex_lock.unlock();
 
-			item->process_work();
+			{
+				ProfileZone zone("WorkQueue item");
+				item->process_work();
+			}
+			item_processed(item);
+		}
 
-			mutex_lock.lock();
-			finished_items.push_back(item);
-			mutex_lock.unlock();
+		current_work_queue = nullptr;
+	}
+
+	void WorkQueue_Impl::stealing_worker_main(int worker_index)
+	{
+		current_work_queue = this;
+		current_worker_index = worker_index;
+		Profiler::set_thread_name(string_format("WorkQueue worker %1", worker_index));
+
+		while (!stop_flag)
+		{
+			WorkItem *item = find_work(worker_index);
+			if (item)
+			{
+				items_pending.fetch_sub(1, std::memory_order_seq_cst);
+				{
+					ProfileZone zone("WorkQueue item");
+					item->process_work();
+				}
+				item_processed(item);
+				continue;
+			}
+
+			// Another worker took the item between it being published and the pending counter decreasing, or a steal lost a race
+			if (items_pending.load(std::memory_order_seq_cst) > 0)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> mutex_lock(mutex);
+			workers_sleeping.fetch_add(1, std::memory_order_seq_cst);
+			worker_event.wait(mutex_lock, [&]() { return stop_flag || items_pending.load(std::memory_order_seq_cst) > 0; });
+			workers_sleeping.fetch_sub(1, std::memory_order_seq_cst);
 		}
+
+		current_work_queue = nullptr;
+		current_worker_index = -1;
+	}
+
+	WorkItem *WorkQueue_Impl::find_work(int worker_index)
+	{
+		WorkStealingDeque<WorkItem> &local_deque = *worker_deques[worker_index];
+
+		WorkItem *item = local_deque.pop();
+		if (item)
+			return item;
+
+		// Grab a batch from the injection queue so that the other workers can steal from us instead of contending for the lock
+		if (items_injected.load(std::memory_order_relaxed) > 0)
+		{
+			std::unique_lock<std::mutex> mutex_lock(mutex);
+			if (!queued_items.empty())
+			{
+				size_t batch_size = clan::min(clan::max(queued_items.size() / worker_deques.size(), (size_t)1), (size_t)64);
+				item = queued_items.front();
+				queued_items.pop_front();
+				for (size_t i = 1; i < batch_size; i++)
+				{
+					local_deque.push(queued_items.front());
+					queued_items.pop_front();
+				}
+				items_injected -= (int)batch_size;
+				return item;
+			}
+		}
+
+		int num_workers = (int)worker_deques.size();
+		for (int i = 1; i < num_workers; i++)
+		{
+			item = worker_deques[(worker_index + i) % num_workers]->steal();
+			if (item)
+				return item;
+		}
+
+		return nullptr;
 	}
 }
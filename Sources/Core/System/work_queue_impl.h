@@ -0,0 +1,86 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/System/work_queue.h"
+#include "work_stealing_deque.h"
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <memory>
+
+namespace clan
+{
+	class WorkQueue_Impl
+	{
+	public:
+		WorkQueue_Impl(bool serial_queue, bool work_stealing, int num_threads);
+		~WorkQueue_Impl();
+
+		/// \brief Deleter for the shared impl. Never joins the worker threads from one of the workers
+		static void destroy(WorkQueue_Impl *impl);
+
+		void queue(WorkItem *item); // transfers ownership
+		void work_completed(WorkItem *item); // transfers ownership
+
+		int get_items_queued() const { return items_queued; }
+		int get_num_threads() const;
+
+		void process_work_completed();
+
+	private:
+		void start_threads();
+		void worker_main();
+		void stealing_worker_main(int worker_index);
+		WorkItem *find_work(int worker_index);
+		void item_processed(WorkItem *item);
+
+		bool serial_queue = false;
+		bool work_stealing = false;
+		int num_threads = 0;
+		std::vector<std::thread> threads;
+		std::mutex mutex;
+		std::condition_variable worker_event;
+		std::atomic_bool stop_flag;
+		std::deque<WorkItem *> queued_items;
+		std::atomic_int items_queued;
+
+		std::mutex finished_mutex;
+		std::vector<WorkItem *> finished_items;
+
+		// Work stealing mode. queued_items acts as the injection queue for items queued from non-worker threads
+		std::vector<std::unique_ptr<WorkStealingDeque<WorkItem>>> worker_deques;
+		std::atomic_int items_injected;
+		std::atomic_int items_pending;
+		std::atomic_int workers_sleeping;
+	};
+}
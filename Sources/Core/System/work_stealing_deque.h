@@ -0,0 +1,158 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+namespace clan
+{
+	/// \brief Chase-Lev work stealing deque
+	///
+	/// The owning thread pushes and pops at the bottom end without locking. Any other thread may steal from the top end.
+	/// Memory orderings follow "Correct and Efficient Work-Stealing for Weak Memory Models" (Le, Pop, Cohen, Zappa Nardelli 2013).
+	template<typename T>
+	class WorkStealingDeque
+	{
+	public:
+		WorkStealingDeque(int initial_log_size = 8) : top(0), bottom(0), array(new Array(initial_log_size)) { }
+
+		~WorkStealingDeque()
+		{
+			delete array.load(std::memory_order_relaxed);
+			for (auto &elem : retired_arrays)
+				delete elem;
+		}
+
+		/// \brief Pushes an item to the bottom of the deque (owner thread only)
+		void push(T *item)
+		{
+			int64_t b = bottom.load(std::memory_order_relaxed);
+			int64_t t = top.load(std::memory_order_acquire);
+			Array *a = array.load(std::memory_order_relaxed);
+			if (b - t > a->size - 1)
+				a = grow(a, t, b);
+			a->put(b, item);
+			bottom.store(b + 1, std::memory_order_release);
+		}
+
+		/// \brief Pops the most recently pushed item (owner thread only)
+		///
+		/// \return The item or nullptr if the deque is empty
+		T *pop()
+		{
+			int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+			Array *a = array.load(std::memory_order_relaxed);
+			bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t t = top.load(std::memory_order_relaxed);
+
+			T *item = nullptr;
+			if (t <= b)
+			{
+				item = a->get(b);
+				if (t == b)
+				{
+					// Last item. Race against thieves for it
+					if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+						item = nullptr;
+					bottom.store(b + 1, std::memory_order_relaxed);
+				}
+			}
+			else
+			{
+				bottom.store(b + 1, std::memory_order_relaxed);
+			}
+			return item;
+		}
+
+		/// \brief Steals the oldest item (any thread)
+		///
+		/// \return The item or nullptr if the deque was empty or another thread won the race
+		T *steal()
+		{
+			int64_t t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t b = bottom.load(std::memory_order_acquire);
+			if (t < b)
+			{
+				Array *a = array.load(std::memory_order_acquire);
+				T *item = a->get(t);
+				if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+					return nullptr;
+				return item;
+			}
+			return nullptr;
+		}
+
+		/// \brief Returns true if the deque appears empty (any thread)
+		bool empty() const
+		{
+			int64_t b = bottom.load(std::memory_order_relaxed);
+			int64_t t = top.load(std::memory_order_relaxed);
+			return b <= t;
+		}
+
+	private:
+		struct Array
+		{
+			Array(int log_size) : size(int64_t(1) << log_size), mask(size - 1), log_size(log_size), items(new std::atomic<T*>[size]) { }
+			~Array() { delete[] items; }
+
+			T *get(int64_t index) const { return items[index & mask].load(std::memory_order_relaxed); }
+			void put(int64_t index, T *item) { items[index & mask].store(item, std::memory_order_relaxed); }
+
+			int64_t size;
+			int64_t mask;
+			int log_size;
+			std::atomic<T*> *items;
+		};
+
+		Array *grow(Array *a, int64_t t, int64_t b)
+		{
+			Array *new_array = new Array(a->log_size + 1);
+			for (int64_t i = t; i < b; i++)
+				new_array->put(i, a->get(i));
+
+			// Thieves may still be reading the old array. Keep it alive until the deque is destroyed.
+			retired_arrays.push_back(a);
+			array.store(new_array, std::memory_order_release);
+			return new_array;
+		}
+
+		std::atomic<int64_t> top;
+		std::atomic<int64_t> bottom;
+		std::atomic<Array*> array;
+		std::vector<Array*> retired_arrays;
+
+		WorkStealingDeque(const WorkStealingDeque &) = delete;
+		WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+	};
+}
@@ -0,0 +1,423 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#include "Core/precomp.h"
+#include "async_log_writer.h"
+#include "API/Core/System/datetime.h"
+#include "API/Core/System/system.h"
+#include "API/Core/System/thread_local_storage.h"
+#include <algorithm>
+
+#if defined(__APPLE__)
+#define cl_async_log_tls thread_local
+#else
+#define cl_async_log_tls cl_tls_variable
+#endif
+
+namespace clan
+{
+	namespace
+	{
+		// Ring of the current thread. Only valid while thread_ring_session matches AsyncLogWriter::session
+		cl_async_log_tls AsyncLogRing *thread_ring = nullptr;
+		cl_async_log_tls unsigned int thread_ring_session = 0;
+		cl_async_log_tls bool writer_thread = false;
+		cl_async_log_tls int64_t event_utc_ticks = 0;
+
+		// Intentionally never destroyed. Logging threads may still reference their rings during static destruction
+		std::atomic<AsyncLogWriter *> async_log_writer(nullptr);
+
+		uint64_t get_ring_capacity(int size)
+		{
+			uint64_t capacity = 1;
+			while (capacity < (uint64_t)std::max(size, 1))
+				capacity <<= 1;
+			return capacity;
+		}
+
+		void copy_arg(AsyncLogRecord::Arg &dest, const LogArg &src)
+		{
+			dest.type = src.type;
+			switch (src.type)
+			{
+			case LogArg::Type::text: dest.text.assign(*src.text); break;
+			case LogArg::Type::int_value: dest.int_value = src.int_value; break;
+			case LogArg::Type::uint_value: dest.uint_value = src.uint_value; break;
+			case LogArg::Type::ulong_value: dest.ulong_value = src.ulong_value; break;
+			case LogArg::Type::longlong_value: dest.longlong_value = src.longlong_value; break;
+			case LogArg::Type::ulonglong_value: dest.ulonglong_value = src.ulonglong_value; break;
+			case LogArg::Type::float_value: dest.float_value = src.float_value; break;
+			case LogArg::Type::double_value: dest.double_value = src.double_value; break;
+			}
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	void AsyncLogRecord::set(const std::string &new_type, const std::string &new_format, std::initializer_list<LogArg> new_args)
+	{
+		type.assign(new_type);
+		if (new_args.size() > max_args)
+		{
+			StringFormat f(new_format);
+			int index = 1;
+			for (const LogArg &arg : new_args)
+				arg.set_arg(f, index++);
+			format.assign(f.get_result());
+			preformatted = true;
+			num_args = 0;
+		}
+		else
+		{
+			format.assign(new_format);
+			preformatted = false;
+			num_args = 0;
+			for (const LogArg &arg : new_args)
+				copy_arg(args[num_args++], arg);
+		}
+	}
+
+	void AsyncLogRecord::set(const std::string &new_type, const std::string &text)
+	{
+		type.assign(new_type);
+		format.assign(text);
+		preformatted = true;
+		num_args = 0;
+	}
+
+	std::string AsyncLogRecord::get_text() const
+	{
+		if (preformatted)
+			return format;
+
+		StringFormat f(format);
+		for (int i = 0; i < num_args; i++)
+		{
+			const Arg &arg = args[i];
+			switch (arg.type)
+			{
+			case LogArg::Type::text: f.set_arg(i + 1, arg.text); break;
+			case LogArg::Type::int_value: f.set_arg(i + 1, arg.int_value); break;
+			case LogArg::Type::uint_value: f.set_arg(i + 1, arg.uint_value); break;
+			case LogArg::Type::ulong_value: f.set_arg(i + 1, arg.ulong_value); break;
+			case LogArg::Type::longlong_value: f.set_arg(i + 1, arg.longlong_value); break;
+			case LogArg::Type::ulonglong_value: f.set_arg(i + 1, arg.ulonglong_value); break;
+			case LogArg::Type::float_value: f.set_arg(i + 1, arg.float_value); break;
+			case LogArg::Type::double_value: f.set_arg(i + 1, arg.double_value); break;
+			}
+		}
+		return f.get_result();
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	AsyncLogRing::AsyncLogRing(int size) : head(0), tail(0), writing(false)
+	{
+		resize(size);
+	}
+
+	void AsyncLogRing::resize(int size)
+	{
+		// The writer only reads records between tail and head, so an empty ring can be resized while it is registered
+		uint64_t capacity = get_ring_capacity(size);
+		if (capacity != records.size())
+		{
+			records.clear();
+			records.resize((size_t)capacity);
+			mask = capacity - 1;
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	AsyncLogWriter *AsyncLogWriter::instance()
+	{
+		// Not a function-local static, as their initialization is not thread safe on all supported compilers.
+		// Threads logging for the first time at once may each construct a writer, but only one is published
+		AsyncLogWriter *writer = async_log_writer.load(std::memory_order_acquire);
+		if (!writer)
+		{
+			AsyncLogWriter *new_writer = new AsyncLogWriter();
+			if (async_log_writer.compare_exchange_strong(writer, new_writer, std::memory_order_acq_rel))
+				writer = new_writer;
+			else
+				delete new_writer;
+		}
+		return writer;
+	}
+
+	bool AsyncLogWriter::is_writer_thread()
+	{
+		return writer_thread;
+	}
+
+	int64_t AsyncLogWriter::get_event_utc_ticks()
+	{
+		return event_utc_ticks;
+	}
+
+	void AsyncLogWriter::start(int new_buffer_size, LogOverflowPolicy new_policy)
+	{
+		if (running.load())
+			throw Exception("Asynchronous logging is already started");
+
+		buffer_size.store(new_buffer_size);
+		policy = new_policy;
+		start_microseconds = System::get_microseconds();
+		start_utc_ticks = DateTime::get_current_utc_time().to_ticks();
+
+		stop_flag = false;
+		session.fetch_add(1);
+		thread = std::thread(&AsyncLogWriter::writer_main, this);
+		running.store(true);
+	}
+
+	void AsyncLogWriter::stop()
+	{
+		if (!running.load())
+			return;
+
+		running.store(false);
+
+		// Release producers blocked on a full ring. They log synchronously instead
+		std::unique_lock<std::mutex> lock(mutex);
+		lock.unlock();
+		space_event.notify_all();
+
+		// A producer that saw running == true before it was cleared may still be publishing an event.
+		// Wait for it so that the final batch below includes the event.
+		std::unique_lock<std::mutex> rings_lock(rings_mutex);
+		std::vector<AsyncLogRing *> active_rings;
+		for (auto &ring : rings)
+			active_rings.push_back(ring.get());
+		rings_lock.unlock();
+		for (AsyncLogRing *ring : active_rings)
+		{
+			while (ring->writing.load())
+				std::this_thread::yield();
+		}
+
+		lock.lock();
+		stop_flag = true;
+		lock.unlock();
+		writer_event.notify_one();
+		thread.join();
+	}
+
+	void AsyncLogWriter::flush()
+	{
+		if (!running.load(std::memory_order_acquire) || writer_thread)
+			return;
+
+		std::unique_lock<std::mutex> lock(mutex);
+		uint64_t request = ++flush_requested;
+		wakeup_flag = true;
+		writer_event.notify_one();
+		flushed_event.wait(lock, [&]() { return flush_completed >= request || stop_flag; });
+	}
+
+	bool AsyncLogWriter::log(const std::string &type, const std::string &text)
+	{
+		AsyncLogRing *ring = get_thread_ring();
+		if (!begin_log(ring))
+			return false;
+
+		bool stopped = false;
+		AsyncLogRecord *record = begin_write(ring, stopped);
+		if (record)
+		{
+			record->microseconds = System::get_microseconds();
+			record->set(type, text);
+			ring->end_write();
+		}
+		ring->writing.store(false, std::memory_order_release);
+		return !stopped;
+	}
+
+	bool AsyncLogWriter::log(const std::string &type, const std::string &format, std::initializer_list<LogArg> args)
+	{
+		AsyncLogRing *ring = get_thread_ring();
+		if (!begin_log(ring))
+			return false;
+
+		bool stopped = false;
+		AsyncLogRecord *record = begin_write(ring, stopped);
+		if (record)
+		{
+			record->microseconds = System::get_microseconds();
+			record->set(type, format, args);
+			ring->end_write();
+		}
+		ring->writing.store(false, std::memory_order_release);
+		return !stopped;
+	}
+
+	AsyncLogRing *AsyncLogWriter::get_thread_ring()
+	{
+		unsigned int current_session = session.load(std::memory_order_relaxed);
+		if (!thread_ring || thread_ring_session != current_session)
+		{
+			// Once per logging thread and session. Rings are kept, so a thread id reused by a new thread also reuses the ring
+			std::unique_lock<std::mutex> lock(rings_mutex);
+			AsyncLogRing *&ring = thread_rings[std::this_thread::get_id()];
+			if (!ring)
+			{
+				rings.push_back(std::unique_ptr<AsyncLogRing>(new AsyncLogRing(buffer_size.load())));
+				ring = rings.back().get();
+			}
+			else if (ring->head.load(std::memory_order_relaxed) == ring->tail.load(std::memory_order_acquire))
+			{
+				ring->resize(buffer_size.load());
+			}
+			thread_ring = ring;
+			thread_ring_session = current_session;
+		}
+		return thread_ring;
+	}
+
+	bool AsyncLogWriter::begin_log(AsyncLogRing *ring)
+	{
+		// Pairs with stop(): either stop sees the writing flag and waits for the event, or this sees running == false
+		ring->writing.store(true);
+		if (!running.load())
+		{
+			ring->writing.store(false, std::memory_order_release);
+			return false;
+		}
+		return true;
+	}
+
+	AsyncLogRecord *AsyncLogWriter::begin_write(AsyncLogRing *ring, bool &stopped)
+	{
+		AsyncLogRecord *record = ring->begin_write();
+		if (record)
+			return record;
+
+		if (policy == LogOverflowPolicy::drop)
+		{
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		// Wake the writer and wait until it has drained the ring
+		std::unique_lock<std::mutex> lock(mutex);
+		wakeup_flag = true;
+		writer_event.notify_one();
+		space_event.wait(lock, [&]()
+		{
+			record = ring->begin_write();
+			return record || !running.load();
+		});
+		stopped = (record == nullptr);
+		return record;
+	}
+
+	void AsyncLogWriter::writer_main()
+	{
+		writer_thread = true;
+
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true)
+		{
+			// Events are written in batches. A full ring or flush_async wakes the thread early
+			writer_event.wait_for(lock, std::chrono::milliseconds(10), [&]() { return stop_flag || wakeup_flag; });
+			bool stop = stop_flag;
+			wakeup_flag = false;
+			uint64_t request = flush_requested;
+			lock.unlock();
+
+			process_batch();
+
+			lock.lock();
+			flush_completed = request;
+			flushed_event.notify_all();
+			space_event.notify_all();
+
+			if (stop)
+				break;
+		}
+	}
+
+	void AsyncLogWriter::process_batch()
+	{
+		std::unique_lock<std::mutex> rings_lock(rings_mutex);
+		batch_rings.clear();
+		for (auto &ring : rings)
+			batch_rings.push_back(ring.get());
+		rings_lock.unlock();
+
+		batch.clear();
+		batch_heads.resize(batch_rings.size());
+		for (size_t i = 0; i < batch_rings.size(); i++)
+		{
+			AsyncLogRing *ring = batch_rings[i];
+			uint64_t head = ring->head.load(std::memory_order_acquire);
+			for (uint64_t pos = ring->tail.load(std::memory_order_relaxed); pos != head; pos++)
+			{
+				AsyncLogRecord *record = &ring->records[pos & ring->mask];
+				batch.push_back({ record->microseconds, record });
+			}
+			batch_heads[i] = head;
+		}
+
+		// Merge the threads in the order the events were logged
+		std::stable_sort(batch.begin(), batch.end());
+
+		int num_dropped = dropped.exchange(0, std::memory_order_relaxed);
+
+		if (!batch.empty() || num_dropped > 0)
+		{
+			std::unique_lock<std::recursive_mutex> logger_lock(Logger::mutex);
+
+			for (const BatchEntry &entry : batch)
+			{
+				std::string text = entry.record->get_text();
+				event_utc_ticks = start_utc_ticks + (int64_t)(entry.microseconds - start_microseconds) * 10;
+				for (auto &instance : Logger::instances)
+					instance->log(entry.record->type, text);
+			}
+			event_utc_ticks = 0;
+
+			if (num_dropped > 0)
+			{
+				std::string text = string_format("%1 events dropped because a log buffer was full", num_dropped);
+				for (auto &instance : Logger::instances)
+					instance->log("log", text);
+			}
+
+			for (auto &instance : Logger::instances)
+				instance->flush();
+		}
+
+		for (size_t i = 0; i < batch_rings.size(); i++)
+			batch_rings[i]->tail.store(batch_heads[i], std::memory_order_release);
+
+		batch_rings.clear();
+	}
+}
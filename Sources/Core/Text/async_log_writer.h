@@ -0,0 +1,182 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#pragma once
+
+#include "API/Core/Text/logger.h"
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+
+namespace clan
+{
+	/// \brief Log event waiting in an AsyncLogRing
+	///
+	/// Records are reused, so the strings keep their capacity and copying an event normally does not allocate.
+	class AsyncLogRecord
+	{
+	public:
+		enum { max_args = 7 };
+
+		struct Arg
+		{
+			LogArg::Type type = LogArg::Type::int_value;
+			union
+			{
+				int int_value;
+				unsigned int uint_value;
+				long unsigned int ulong_value;
+				long long longlong_value;
+				unsigned long long ulonglong_value;
+				float float_value;
+				double double_value;
+			};
+			std::string text;
+		};
+
+		void set(const std::string &type, const std::string &format, std::initializer_list<LogArg> args);
+		void set(const std::string &type, const std::string &text);
+
+		std::string get_text() const;
+
+		uint64_t microseconds = 0;
+		std::string type;
+		std::string format;
+		bool preformatted = true;
+		int num_args = 0;
+		Arg args[max_args];
+	};
+
+	/// \brief Single producer, single consumer ring buffer owned by one logging thread
+	///
+	/// Rings are never freed. A ring is reused by the next thread that gets the same thread id once its owner has exited.
+	class AsyncLogRing
+	{
+	public:
+		AsyncLogRing(int size);
+
+		/// \brief Changes the number of records. Only valid while the ring is empty (producer only)
+		void resize(int size);
+
+		/// \brief Returns the record to fill in, or nullptr if the ring is full (producer only)
+		AsyncLogRecord *begin_write()
+		{
+			uint64_t h = head.load(std::memory_order_relaxed);
+			if (h - tail.load(std::memory_order_acquire) > mask)
+				return nullptr;
+			return &records[h & mask];
+		}
+
+		/// \brief Publishes the record returned by begin_write (producer only)
+		void end_write()
+		{
+			head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		std::vector<AsyncLogRecord> records;
+		uint64_t mask;
+		std::atomic<uint64_t> head;
+		std::atomic<uint64_t> tail;
+
+		/// \brief Set by the producer while it checks that the writer is running and publishes an event
+		std::atomic_bool writing;
+	};
+
+	/// \brief Background thread passing events from the per-thread rings to the loggers
+	class AsyncLogWriter
+	{
+	public:
+		static AsyncLogWriter *instance();
+
+		void start(int buffer_size, LogOverflowPolicy policy);
+		void stop();
+		void flush();
+		bool is_running() const { return running.load(std::memory_order_acquire); }
+
+		/// \brief Queues an event for the writer thread
+		///
+		/// \return False if the writer has stopped. The caller must then log the event synchronously
+		bool log(const std::string &type, const std::string &text);
+		bool log(const std::string &type, const std::string &format, std::initializer_list<LogArg> args);
+
+		/// \brief True on the writer thread itself. Events logged by loggers are then dispatched synchronously
+		static bool is_writer_thread();
+
+		/// \brief Time of the event currently being dispatched by the writer thread, or 0 on other threads
+		static int64_t get_event_utc_ticks();
+
+	private:
+		AsyncLogWriter() { }
+
+		AsyncLogRing *get_thread_ring();
+		bool begin_log(AsyncLogRing *ring);
+		AsyncLogRecord *begin_write(AsyncLogRing *ring, bool &stopped);
+		void writer_main();
+		void process_batch();
+
+		struct BatchEntry
+		{
+			uint64_t microseconds;
+			AsyncLogRecord *record;
+			bool operator<(const BatchEntry &other) const { return microseconds < other.microseconds; }
+		};
+
+		std::atomic_bool running{ false };
+		std::thread thread;
+		std::atomic_int buffer_size{ 0 };
+		std::atomic_uint session{ 0 };
+		LogOverflowPolicy policy = LogOverflowPolicy::block;
+		int64_t start_utc_ticks = 0;
+		uint64_t start_microseconds = 0;
+		std::atomic_int dropped{ 0 };
+
+		std::mutex rings_mutex;
+		std::vector<std::unique_ptr<AsyncLogRing>> rings;
+		std::unordered_map<std::thread::id, AsyncLogRing *> thread_rings;
+
+		std::mutex mutex;
+		std::condition_variable writer_event;
+		std::condition_variable flushed_event;
+		std::condition_variable space_event;
+		bool stop_flag = false;
+		bool wakeup_flag = false;
+		uint64_t flush_requested = 0;
+		uint64_t flush_completed = 0;
+
+		// Only used by the writer thread
+		std::vector<AsyncLogRing *> batch_rings;
+		std::vector<uint64_t> batch_heads;
+		std::vector<BatchEntry> batch;
+	};
+}
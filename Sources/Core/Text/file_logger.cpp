@@ -41,15 +41,29 @@ namespace clan
 
 	FileLogger::~FileLogger()
 	{
+		// Make sure the asynchronous writer thread is not using this logger while it is destroyed
+		disable();
+		flush();
 		delete file;
 	}
 
 	void FileLogger::log(const std::string &type, const std::string &text)
 	{
 		StringFormat format = get_log_string(type, text);
-		std::string log_line = StringHelp::text_to_local8(format.get_result());
+		buffer += StringHelp::text_to_local8(format.get_result());
+
+		const size_t max_buffer_size = 64 * 1024;
+		if (buffer.size() >= max_buffer_size)
+			flush();
+	}
+
+	void FileLogger::flush()
+	{
+		if (buffer.empty())
+			return;
 
 		file->seek(0, File::seek_end);
-		file->write(log_line.data(), (int)log_line.length());
+		file->write(buffer.data(), (int)buffer.length());
+		buffer.clear();
 	}
 }
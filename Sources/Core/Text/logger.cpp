@@ -30,6 +30,7 @@
 #include "API/Core/System/datetime.h"
 #include "API/Core/Text/logger.h"
 #include "API/Core/Text/string_format.h"
+#include "async_log_writer.h"
 #include <algorithm>
 #include <mutex>
 
@@ -93,7 +94,9 @@ namespace clan
 		};
 
 		// Tue Nov 16 11:34:15 CET 2004
-		DateTime cur_time = DateTime::get_current_utc_time();
+		// Events dispatched by the asynchronous writer use the time they were logged
+		int64_t event_ticks = AsyncLogWriter::get_event_utc_ticks();
+		DateTime cur_time = event_ticks != 0 ? DateTime::get_utc_time_from_ticks(event_ticks) : DateTime::get_current_utc_time();
 
 #ifdef WIN32
 		StringFormat format("%1 %2 %3 %4:%5:%6 %7 UTC [%8] %9\r\n");
@@ -113,12 +116,52 @@ namespace clan
 		return format;
 	}
 
+	void Logger::start_async(int buffer_size, LogOverflowPolicy policy)
+	{
+		AsyncLogWriter::instance()->start(buffer_size, policy);
+	}
+
+	void Logger::stop_async()
+	{
+		AsyncLogWriter::instance()->stop();
+	}
+
+	void Logger::flush_async()
+	{
+		AsyncLogWriter::instance()->flush();
+	}
+
+	bool Logger::is_async()
+	{
+		return AsyncLogWriter::instance()->is_running();
+	}
+
 	void log_event(const std::string &type, const std::string &text)
 	{
+		AsyncLogWriter *writer = AsyncLogWriter::instance();
+		if (writer->is_running() && !AsyncLogWriter::is_writer_thread() && writer->log(type, text))
+			return;
+
 		std::unique_lock<std::recursive_mutex> mutex_lock(Logger::mutex);
 		if (Logger::instances.empty())
 			return;
 		for (auto & instance : Logger::instances)
+		{
 			(instance)->log(type, text);
+			(instance)->flush();
+		}
+	}
+
+	void log_event(const std::string &type, const std::string &format, std::initializer_list<LogArg> args)
+	{
+		AsyncLogWriter *writer = AsyncLogWriter::instance();
+		if (writer->is_running() && !AsyncLogWriter::is_writer_thread() && writer->log(type, format, args))
+			return;
+
+		StringFormat f(format);
+		int index = 1;
+		for (const LogArg &arg : args)
+			arg.set_arg(f, index++);
+		log_event(type, f.get_result());
 	}
 }
@@ -0,0 +1,898 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "number_conversion.h"
+#include <cstdint>
+#include <cfloat>
+#include <clocale>
+#include <cmath>
+#include <type_traits>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace clan
+{
+	namespace
+	{
+		struct UInt128
+		{
+			uint64_t hi;
+			uint64_t lo;
+		};
+
+		inline UInt128 multiply_64x64(uint64_t a, uint64_t b)
+		{
+#if defined(__SIZEOF_INT128__)
+			unsigned __int128 r = (unsigned __int128)a * b;
+			return { (uint64_t)(r >> 64), (uint64_t)r };
+#elif defined(_MSC_VER) && defined(_M_X64)
+			uint64_t hi;
+			uint64_t lo = _umul128(a, b, &hi);
+			return { hi, lo };
+#else
+			uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+			uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+			uint64_t lo_lo = a_lo * b_lo;
+			uint64_t hi_lo = a_hi * b_lo;
+			uint64_t lo_hi = a_lo * b_hi;
+			uint64_t hi_hi = a_hi * b_hi;
+			uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+			return { hi_hi + (hi_lo >> 32) + (cross >> 32), (cross << 32) | (uint32_t)lo_lo };
+#endif
+		}
+
+		inline uint64_t shift_right_128(const UInt128 &value, int shift)
+		{
+			if (shift == 0)
+				return value.lo;
+			else if (shift < 64)
+				return (value.hi << (64 - shift)) | (value.lo >> shift);
+			else
+				return value.hi >> (shift - 64);
+		}
+
+		inline int count_leading_zeros(uint64_t value)
+		{
+#if defined(__GNUC__)
+			return __builtin_clzll(value);
+#elif defined(_MSC_VER) && defined(_M_X64)
+			unsigned long index;
+			_BitScanReverse64(&index, value);
+			return 63 - (int)index;
+#else
+			int count = 0;
+			while (!(value & 0x8000000000000000ULL))
+			{
+				value <<= 1;
+				count++;
+			}
+			return count;
+#endif
+		}
+
+		// Powers of five with 128 bits of precision, generated once with exact integer arithmetic
+		class PowerTables
+		{
+		public:
+			static const int lemire_min_q = -342;
+			static const int lemire_max_q = 308;
+			static const int ryu_pow5_size = 326;
+			static const int ryu_inv_pow5_size = 342;
+			static const int ryu_pow5_bits = 125;
+
+			static int pow5_bits(int e) { return (int)(((uint32_t)e * 1217359) >> 19) + 1; }
+
+			// Lemire: 5^q normalized so bit 127 is set. Truncated for q >= 0, rounded up and then truncated for q < 0
+			UInt128 lemire[lemire_max_q - lemire_min_q + 1];
+
+			// Ryu: 5^i truncated to 125 bits, and floor(2^(pow5_bits(i) - 1 + 125) / 5^i) + 1
+			UInt128 ryu_pow5[ryu_pow5_size];
+			UInt128 ryu_inv_pow5[ryu_inv_pow5_size];
+
+		private:
+			struct Big
+			{
+				static const int max_words = 56;
+				uint32_t words[max_words]; // Little endian
+
+				Big() { memset(words, 0, sizeof(words)); }
+
+				int bit_length() const
+				{
+					for (int i = max_words - 1; i >= 0; i--)
+					{
+						if (words[i])
+						{
+							int bits = 32;
+							while (!(words[i] & (1u << (bits - 1))))
+								bits--;
+							return i * 32 + bits;
+						}
+					}
+					return 0;
+				}
+
+				bool get_bit(int index) const
+				{
+					return index >= 0 && index < max_words * 32 && (words[index / 32] & (1u << (index % 32))) != 0;
+				}
+
+				void multiply(uint32_t factor)
+				{
+					uint64_t carry = 0;
+					for (int i = 0; i < max_words; i++)
+					{
+						carry += (uint64_t)words[i] * factor;
+						words[i] = (uint32_t)carry;
+						carry >>= 32;
+					}
+				}
+
+				void divide(uint32_t divisor)
+				{
+					uint64_t remainder = 0;
+					for (int i = max_words - 1; i >= 0; i--)
+					{
+						uint64_t current = (remainder << 32) | words[i];
+						words[i] = (uint32_t)(current / divisor);
+						remainder = current % divisor;
+					}
+				}
+
+				Big shifted_right(int shift) const
+				{
+					Big result;
+					for (int i = 0; i < max_words * 32; i++)
+					{
+						if (get_bit(i + shift))
+							result.words[i / 32] |= 1u << (i % 32);
+					}
+					return result;
+				}
+
+				void add_one()
+				{
+					for (int i = 0; i < max_words && ++words[i] == 0; i++)
+					{
+					}
+				}
+
+				// Returns the bits of floor(value / 2^shift); shift may be negative
+				UInt128 extract(int shift) const
+				{
+					UInt128 result = { 0, 0 };
+					for (int i = 0; i < 128; i++)
+					{
+						if (get_bit(i + shift))
+						{
+							if (i < 64)
+								result.lo |= uint64_t(1) << i;
+							else
+								result.hi |= uint64_t(1) << (i - 64);
+						}
+					}
+					return result;
+				}
+
+				// Truncates to the given number of significant bits
+				UInt128 normalized(int bits) const
+				{
+					return extract(bit_length() - bits);
+				}
+			};
+
+		public:
+			PowerTables()
+			{
+				Big pow5;
+				pow5.words[0] = 1;
+				for (int q = 0; q <= lemire_max_q || q < ryu_pow5_size; q++)
+				{
+					if (q <= lemire_max_q)
+						lemire[q - lemire_min_q] = pow5.normalized(128);
+					if (q < ryu_pow5_size)
+						ryu_pow5[q] = pow5.normalized(ryu_pow5_bits);
+					pow5.multiply(5);
+				}
+
+				// inverse = floor(2^B / 5^j). Then floor(2^b / 5^j) = inverse >> (B - b) for any b <= B
+				const int B = Big::max_words * 32 - 64;
+				Big inverse;
+				inverse.words[B / 32] = 1u << (B % 32);
+				for (int j = 0; j <= -lemire_min_q || j < ryu_inv_pow5_size; j++)
+				{
+					if (j > 0 && j <= -lemire_min_q)
+					{
+						int z = pow5_bits(j);
+						int b = j <= 27 ? z + 127 : 2 * z + 128;
+						Big c = inverse.shifted_right(B - b);
+						c.add_one();
+						lemire[-j - lemire_min_q] = c.bit_length() > 128 ? c.normalized(128) : c.extract(0);
+					}
+					if (j < ryu_inv_pow5_size)
+					{
+						Big c = inverse.shifted_right(B - (pow5_bits(j) - 1 + ryu_pow5_bits));
+						c.add_one();
+						ryu_inv_pow5[j] = c.extract(0);
+					}
+					inverse.divide(5);
+				}
+			}
+		};
+
+		// Built during static initialization. A function-local static is not thread safe on all supported compilers
+		const PowerTables power_tables;
+
+		/////////////////////////////////////////////////////////////////////
+
+		struct FloatFormat
+		{
+			int mantissa_bits;
+			int exponent_bits;
+			int bias;
+		};
+
+		const FloatFormat double_format = { 52, 11, 1023 };
+		const FloatFormat float_format = { 23, 8, 127 };
+
+		inline int log10_pow2(int e) { return (int)(((uint32_t)e * 78913) >> 18); }
+		inline int log10_pow5(int e) { return (int)(((uint32_t)e * 732923) >> 20); }
+
+		inline bool multiple_of_power_of_5(uint64_t value, int p)
+		{
+			int count = 0;
+			while (value % 5 == 0 && count < p)
+			{
+				value /= 5;
+				count++;
+			}
+			return count >= p;
+		}
+
+		inline bool multiple_of_power_of_2(uint64_t value, int p)
+		{
+			return (value & ((uint64_t(1) << p) - 1)) == 0;
+		}
+
+		inline uint64_t mul_shift(uint64_t m, const UInt128 &factor, int shift)
+		{
+			UInt128 b0 = multiply_64x64(m, factor.lo);
+			UInt128 b2 = multiply_64x64(m, factor.hi);
+			UInt128 sum = { b2.hi, b2.lo + b0.hi };
+			if (sum.lo < b0.hi)
+				sum.hi++;
+			return shift_right_128(sum, shift - 64);
+		}
+
+		// Ryu: finds the shortest decimal digits (output * 10^exponent) inside the rounding interval of a finite, positive value
+		void shortest_decimal(uint64_t ieee_mantissa, uint32_t ieee_exponent, const FloatFormat &format, uint64_t &output, int &exponent)
+		{
+			const PowerTables &tables = power_tables;
+
+			int e2;
+			uint64_t m2;
+			if (ieee_exponent == 0)
+			{
+				e2 = 1 - format.bias - format.mantissa_bits - 2;
+				m2 = ieee_mantissa;
+			}
+			else
+			{
+				e2 = (int)ieee_exponent - format.bias - format.mantissa_bits - 2;
+				m2 = (uint64_t(1) << format.mantissa_bits) | ieee_mantissa;
+			}
+			bool accept_bounds = (m2 & 1) == 0;
+
+			uint64_t mv = 4 * m2;
+			uint32_t mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+
+			uint64_t vr, vp, vm;
+			int e10;
+			bool vm_is_trailing_zeros = false;
+			bool vr_is_trailing_zeros = false;
+			if (e2 >= 0)
+			{
+				int q = log10_pow2(e2) - (e2 > 3);
+				e10 = q;
+				int k = PowerTables::ryu_pow5_bits + PowerTables::pow5_bits(q) - 1;
+				int i = -e2 + q + k;
+				vr = mul_shift(4 * m2, tables.ryu_inv_pow5[q], i);
+				vp = mul_shift(4 * m2 + 2, tables.ryu_inv_pow5[q], i);
+				vm = mul_shift(4 * m2 - 1 - mm_shift, tables.ryu_inv_pow5[q], i);
+				if (q <= 21)
+				{
+					if (mv % 5 == 0)
+						vr_is_trailing_zeros = multiple_of_power_of_5(mv, q);
+					else if (accept_bounds)
+						vm_is_trailing_zeros = multiple_of_power_of_5(mv - 1 - mm_shift, q);
+					else
+						vp -= multiple_of_power_of_5(mv + 2, q);
+				}
+			}
+			else
+			{
+				int q = log10_pow5(-e2) - (-e2 > 1);
+				e10 = q + e2;
+				int i = -e2 - q;
+				int k = PowerTables::pow5_bits(i) - PowerTables::ryu_pow5_bits;
+				int j = q - k;
+				vr = mul_shift(4 * m2, tables.ryu_pow5[i], j);
+				vp = mul_shift(4 * m2 + 2, tables.ryu_pow5[i], j);
+				vm = mul_shift(4 * m2 - 1 - mm_shift, tables.ryu_pow5[i], j);
+				if (q <= 1)
+				{
+					vr_is_trailing_zeros = true;
+					if (accept_bounds)
+						vm_is_trailing_zeros = mm_shift == 1;
+					else
+						vp--;
+				}
+				else if (q < 63)
+				{
+					vr_is_trailing_zeros = multiple_of_power_of_2(mv, q);
+				}
+			}
+
+			int removed = 0;
+			int last_removed_digit = 0;
+			if (vm_is_trailing_zeros || vr_is_trailing_zeros)
+			{
+				while (vp / 10 > vm / 10)
+				{
+					vm_is_trailing_zeros &= vm % 10 == 0;
+					vr_is_trailing_zeros &= last_removed_digit == 0;
+					last_removed_digit = (int)(vr % 10);
+					vr /= 10;
+					vp /= 10;
+					vm /= 10;
+					removed++;
+				}
+				if (vm_is_trailing_zeros)
+				{
+					while (vm % 10 == 0)
+					{
+						vr_is_trailing_zeros &= last_removed_digit == 0;
+						last_removed_digit = (int)(vr % 10);
+						vr /= 10;
+						vp /= 10;
+						vm /= 10;
+						removed++;
+					}
+				}
+				if (vr_is_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0)
+					last_removed_digit = 4; // Round half to even
+				output = vr + ((vr == vm && (!accept_bounds || !vm_is_trailing_zeros)) || last_removed_digit >= 5);
+			}
+			else
+			{
+				bool round_up = false;
+				if (vp / 100 > vm / 100)
+				{
+					round_up = vr % 100 >= 50;
+					vr /= 100;
+					vp /= 100;
+					vm /= 100;
+					removed += 2;
+				}
+				while (vp / 10 > vm / 10)
+				{
+					round_up = vr % 10 >= 5;
+					vr /= 10;
+					vp /= 10;
+					vm /= 10;
+					removed++;
+				}
+				output = vr + (vr == vm || round_up);
+			}
+			exponent = e10 + removed;
+		}
+
+		int write_special(bool negative, bool nan, char *buffer)
+		{
+			const char *text = nan ? "nan" : (negative ? "-inf" : "inf");
+			int length = (int)strlen(text);
+			memcpy(buffer, text, length + 1);
+			return length;
+		}
+
+		int format_decimal(bool negative, uint64_t output, int exponent, char *buffer)
+		{
+			char digits[20];
+			int count = 0;
+			do
+			{
+				digits[19 - count++] = (char)('0' + output % 10);
+				output /= 10;
+			} while (output != 0);
+			const char *first = digits + 20 - count;
+
+			char *p = buffer;
+			if (negative)
+				*p++ = '-';
+
+			int point = count + exponent; // Position of the decimal point relative to the first digit
+			if (point > 0 && point <= 21)
+			{
+				if (point >= count)
+				{
+					memcpy(p, first, count);
+					p += count;
+					for (int i = count; i < point; i++)
+						*p++ = '0';
+				}
+				else
+				{
+					memcpy(p, first, point);
+					p += point;
+					*p++ = '.';
+					memcpy(p, first + point, count - point);
+					p += count - point;
+				}
+			}
+			else if (point <= 0 && point > -6)
+			{
+				*p++ = '0';
+				*p++ = '.';
+				for (int i = point; i < 0; i++)
+					*p++ = '0';
+				memcpy(p, first, count);
+				p += count;
+			}
+			else
+			{
+				*p++ = first[0];
+				if (count > 1)
+				{
+					*p++ = '.';
+					memcpy(p, first + 1, count - 1);
+					p += count - 1;
+				}
+				int e = point - 1;
+				*p++ = 'e';
+				*p++ = e < 0 ? '-' : '+';
+				if (e < 0)
+					e = -e;
+				if (e >= 100)
+					*p++ = (char)('0' + e / 100);
+				if (e >= 10)
+					*p++ = (char)('0' + e / 10 % 10);
+				*p++ = (char)('0' + e % 10);
+			}
+			*p = 0;
+			return (int)(p - buffer);
+		}
+
+		int format_shortest(uint64_t bits, const FloatFormat &format, char *buffer)
+		{
+			uint64_t mantissa = bits & ((uint64_t(1) << format.mantissa_bits) - 1);
+			uint32_t exponent = (uint32_t)((bits >> format.mantissa_bits) & ((1u << format.exponent_bits) - 1));
+			bool negative = ((bits >> (format.mantissa_bits + format.exponent_bits)) & 1) != 0;
+
+			if (exponent == (1u << format.exponent_bits) - 1)
+				return write_special(negative, mantissa != 0, buffer);
+
+			if (exponent == 0 && mantissa == 0)
+				return format_decimal(negative, 0, 0, buffer);
+
+			uint64_t output;
+			int decimal_exponent;
+			shortest_decimal(mantissa, exponent, format, output, decimal_exponent);
+			return format_decimal(negative, output, decimal_exponent, buffer);
+		}
+
+		/////////////////////////////////////////////////////////////////////
+
+		struct ParseFormat
+		{
+			int mantissa_bits;
+			int min_exponent;
+			int infinite_power;
+			int smallest_power_of_ten;
+			int largest_power_of_ten;
+			int min_round_to_even_q;
+			int max_round_to_even_q;
+			int max_exact_q; // Clinger fast path limits
+			uint64_t max_exact_mantissa;
+		};
+
+		const ParseFormat double_parse_format = { 52, -1023, 0x7ff, -342, 308, -4, 23, 22, uint64_t(1) << 53 };
+		const ParseFormat float_parse_format = { 23, -127, 0xff, -65, 38, -17, 10, 10, uint64_t(1) << 24 };
+
+		// Eisel-Lemire: returns the IEEE bits (without sign) of the value closest to w * 10^q
+		uint64_t decimal_to_binary(uint64_t w, int64_t q, const ParseFormat &format)
+		{
+			if (w == 0 || q < format.smallest_power_of_ten)
+				return 0;
+			if (q > format.largest_power_of_ten)
+				return uint64_t(format.infinite_power) << format.mantissa_bits;
+
+			const PowerTables &tables = power_tables;
+			const UInt128 &factor = tables.lemire[q - PowerTables::lemire_min_q];
+
+			int lz = count_leading_zeros(w);
+			w <<= lz;
+
+			UInt128 product = multiply_64x64(w, factor.hi);
+			uint64_t precision_mask = ~uint64_t(0) >> (format.mantissa_bits + 3);
+			if ((product.hi & precision_mask) == precision_mask)
+			{
+				UInt128 second = multiply_64x64(w, factor.lo);
+				product.lo += second.hi;
+				if (second.hi > product.lo)
+					product.hi++;
+			}
+
+			int upperbit = (int)(product.hi >> 63);
+			int shift = upperbit + 64 - format.mantissa_bits - 3;
+			uint64_t mantissa = product.hi >> shift;
+			int power2 = (int)((((152170 + 65536) * (int)q) >> 16) + 63) + upperbit - lz - format.min_exponent;
+
+			if (power2 <= 0) // Subnormal
+			{
+				if (-power2 + 1 >= 64)
+					return 0;
+				mantissa >>= -power2 + 1;
+				mantissa += mantissa & 1;
+				mantissa >>= 1;
+				power2 = mantissa < (uint64_t(1) << format.mantissa_bits) ? 0 : 1;
+				return (mantissa & ((uint64_t(1) << format.mantissa_bits) - 1)) | (uint64_t(power2) << format.mantissa_bits);
+			}
+
+			// Exactly halfway between two values: round to even
+			if (product.lo <= 1 && q >= format.min_round_to_even_q && q <= format.max_round_to_even_q && (mantissa & 3) == 1)
+			{
+				if ((mantissa << shift) == product.hi)
+					mantissa &= ~uint64_t(1);
+			}
+
+			mantissa += mantissa & 1;
+			mantissa >>= 1;
+			if (mantissa >= (uint64_t(2) << format.mantissa_bits))
+			{
+				mantissa = uint64_t(1) << format.mantissa_bits;
+				power2++;
+			}
+			mantissa &= ~(uint64_t(1) << format.mantissa_bits);
+
+			if (power2 >= format.infinite_power)
+				return uint64_t(format.infinite_power) << format.mantissa_bits;
+			return mantissa | (uint64_t(power2) << format.mantissa_bits);
+		}
+
+		struct DecimalText
+		{
+			const char *end = nullptr;
+			bool negative = false;
+			uint64_t mantissa = 0; // The first 19 significant digits
+			int64_t exponent = 0;
+			bool truncated = false; // More non-zero digits followed
+		};
+
+		bool scan_decimal(const char *p, const char *end, DecimalText &text)
+		{
+			if (p != end && (*p == '-' || *p == '+'))
+			{
+				text.negative = *p == '-';
+				p++;
+			}
+
+			int significant_digits = 0;
+			int digit_count = 0;
+			while (p != end && *p >= '0' && *p <= '9')
+			{
+				if (significant_digits < 19)
+				{
+					text.mantissa = text.mantissa * 10 + (*p - '0');
+					if (text.mantissa != 0)
+						significant_digits++;
+				}
+				else
+				{
+					text.exponent++;
+					text.truncated |= *p != '0';
+				}
+				p++;
+				digit_count++;
+			}
+
+			if (p != end && *p == '.')
+			{
+				const char *fraction = p + 1;
+				while (fraction != end && *fraction >= '0' && *fraction <= '9')
+				{
+					if (significant_digits < 19)
+					{
+						text.mantissa = text.mantissa * 10 + (*fraction - '0');
+						text.exponent--;
+						if (text.mantissa != 0)
+							significant_digits++;
+					}
+					else
+					{
+						text.truncated |= *fraction != '0';
+					}
+					fraction++;
+					digit_count++;
+				}
+				if (digit_count > 0)
+					p = fraction;
+			}
+
+			if (digit_count == 0)
+				return false;
+
+			if (p != end && (*p == 'e' || *p == 'E'))
+			{
+				const char *e = p + 1;
+				bool negative_exponent = false;
+				if (e != end && (*e == '-' || *e == '+'))
+				{
+					negative_exponent = *e == '-';
+					e++;
+				}
+				if (e != end && *e >= '0' && *e <= '9')
+				{
+					int64_t exponent = 0;
+					while (e != end && *e >= '0' && *e <= '9')
+					{
+						if (exponent < 100000)
+							exponent = exponent * 10 + (*e - '0');
+						e++;
+					}
+					text.exponent += negative_exponent ? -exponent : exponent;
+					p = e;
+				}
+			}
+
+			text.end = p;
+			return true;
+		}
+
+		// Only reached for more than 19 significant digits close to a rounding boundary
+		std::string to_c_locale(const char *begin, const char *end)
+		{
+			std::string copy(begin, end);
+			const char *decimal_point = localeconv()->decimal_point;
+			if (decimal_point && decimal_point[0] != '.' && decimal_point[0] != 0)
+			{
+				for (auto &c : copy)
+				{
+					if (c == '.')
+						c = decimal_point[0];
+				}
+			}
+			return copy;
+		}
+
+		void parse_slow(const char *begin, const char *end, double &value)
+		{
+			value = strtod(to_c_locale(begin, end).c_str(), nullptr);
+		}
+
+		void parse_slow(const char *begin, const char *end, float &value)
+		{
+			value = strtof(to_c_locale(begin, end).c_str(), nullptr);
+		}
+
+		template<typename T, typename Bits>
+		T bits_to_float(Bits bits)
+		{
+			T value;
+			memcpy(&value, &bits, sizeof(T));
+			return value;
+		}
+
+		// Returns false if more than 19 digits were given and they are too close to a rounding boundary
+		template<typename T>
+		bool to_float(const DecimalText &text, const ParseFormat &format, T &value)
+		{
+#if FLT_EVAL_METHOD == 0
+			if (!text.truncated && text.mantissa <= format.max_exact_mantissa && text.exponent >= -format.max_exact_q && text.exponent <= format.max_exact_q)
+			{
+				static const T powers[] = { T(1e0), T(1e1), T(1e2), T(1e3), T(1e4), T(1e5), T(1e6), T(1e7), T(1e8), T(1e9), T(1e10), T(1e11), T(1e12), T(1e13), T(1e14), T(1e15), T(1e16), T(1e17), T(1e18), T(1e19), T(1e20), T(1e21), T(1e22) };
+				value = T(text.mantissa);
+				value = text.exponent < 0 ? value / powers[-text.exponent] : value * powers[text.exponent];
+				if (text.negative)
+					value = -value;
+				return true;
+			}
+#endif
+			typedef typename std::conditional<sizeof(T) == 8, uint64_t, uint32_t>::type Bits;
+			uint64_t bits = decimal_to_binary(text.mantissa, text.exponent, format);
+			if (text.truncated && bits != decimal_to_binary(text.mantissa + 1, text.exponent, format))
+				return false;
+			value = bits_to_float<T>(Bits(bits));
+			if (text.negative)
+				value = -value;
+			return true;
+		}
+
+		template<typename T>
+		const char *parse_number(const char *begin, const char *end, const ParseFormat &format, T &value)
+		{
+			DecimalText text;
+			if (!scan_decimal(begin, end, text))
+				return begin;
+			if (!to_float(text, format, value))
+				parse_slow(begin, text.end, value);
+			return text.end;
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	int NumberConversion::format_shortest(double value, char *buffer)
+	{
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(double));
+		return clan::format_shortest(bits, double_format, buffer);
+	}
+
+	int NumberConversion::format_shortest(float value, char *buffer)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(float));
+		return clan::format_shortest(bits, float_format, buffer);
+	}
+
+	std::string NumberConversion::format_fixed(double value, int decimals)
+	{
+		if (decimals < 0)
+			decimals = 0;
+
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(double));
+		bool negative = (bits >> 63) != 0;
+		uint64_t mantissa = bits & ((uint64_t(1) << 52) - 1);
+		int exponent = (int)((bits >> 52) & 0x7ff);
+
+		if (exponent == 0x7ff)
+		{
+			char buffer[8];
+			write_special(negative, mantissa != 0, buffer);
+			return buffer;
+		}
+
+		// value = mantissa * 2^e2 exactly. Scale by 10^decimals and round half to even in 128 bit integers
+		int e2 = exponent == 0 ? -1074 : exponent - 1075;
+		if (exponent != 0)
+			mantissa |= uint64_t(1) << 52;
+
+		static const uint64_t powers_of_ten[] =
+		{
+			1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+			10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL, 1000000000000000ULL,
+			10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+		};
+
+		bool exact = decimals <= 19;
+		uint64_t scaled = 0;
+		if (exact && e2 >= 0)
+		{
+			// Integer value; fits if mantissa * 2^e2 * 10^decimals < 2^64
+			if (e2 <= 11 && decimals <= 19)
+			{
+				UInt128 product = multiply_64x64(mantissa << e2, powers_of_ten[decimals]);
+				exact = product.hi == 0;
+				scaled = product.lo;
+			}
+			else
+			{
+				exact = false;
+			}
+		}
+		else if (exact)
+		{
+			UInt128 product = multiply_64x64(mantissa, powers_of_ten[decimals]);
+			int shift = -e2;
+			if (shift >= 128)
+			{
+				scaled = 0; // Less than half of the last decimal
+			}
+			else
+			{
+				UInt128 quotient;
+				UInt128 remainder;
+				if (shift >= 64)
+				{
+					quotient = { 0, product.hi >> (shift - 64) };
+					remainder = { shift == 64 ? 0 : product.hi & ((uint64_t(1) << (shift - 64)) - 1), product.lo };
+				}
+				else
+				{
+					quotient = { product.hi >> shift, shift_right_128(product, shift) };
+					remainder = { 0, product.lo & ((uint64_t(1) << shift) - 1) };
+				}
+				UInt128 half = shift > 64 ? UInt128{ uint64_t(1) << (shift - 65), 0 } : UInt128{ 0, uint64_t(1) << (shift - 1) };
+
+				exact = quotient.hi == 0;
+				scaled = quotient.lo;
+				bool above_half = remainder.hi > half.hi || (remainder.hi == half.hi && remainder.lo > half.lo);
+				bool at_half = remainder.hi == half.hi && remainder.lo == half.lo;
+				if (above_half || (at_half && (scaled & 1)))
+				{
+					scaled++;
+					exact = exact && scaled != 0;
+				}
+			}
+		}
+
+		if (!exact)
+		{
+			// Very large values or more than 19 decimals
+			int length = snprintf(nullptr, 0, "%.*f", decimals, value);
+			std::string result(length, 0);
+			snprintf(&result[0], length + 1, "%.*f", decimals, value);
+			const char *decimal_point = localeconv()->decimal_point;
+			if (decimal_point && decimal_point[0] != '.' && decimal_point[0] != 0)
+			{
+				size_t pos = result.find(decimal_point[0]);
+				if (pos != std::string::npos)
+					result[pos] = '.';
+			}
+			return result;
+		}
+
+		char digits[24];
+		int count = 0;
+		do
+		{
+			digits[23 - count++] = (char)('0' + scaled % 10);
+			scaled /= 10;
+		} while (scaled != 0);
+		while (count <= decimals)
+			digits[23 - count++] = '0';
+		const char *first = digits + 24 - count;
+
+		char buffer[48];
+		char *p = buffer;
+		if (negative)
+			*p++ = '-';
+		memcpy(p, first, count - decimals);
+		p += count - decimals;
+		if (decimals > 0)
+		{
+			*p++ = '.';
+			memcpy(p, first + count - decimals, decimals);
+			p += decimals;
+		}
+		return std::string(buffer, p);
+	}
+
+	const char *NumberConversion::parse(const char *begin, const char *end, double &value)
+	{
+		return parse_number(begin, end, double_parse_format, value);
+	}
+
+	const char *NumberConversion::parse(const char *begin, const char *end, float &value)
+	{
+		return parse_number(begin, end, float_parse_format, value);
+	}
+}
@@ -0,0 +1,64 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <string>
+
+namespace clan
+{
+	/// \brief Locale independent conversion between floating point numbers and text
+	///
+	/// Formatting produces the shortest text that reads back as the same value (Ryu, Ulf Adams 2018).
+	/// Parsing is correctly rounded (Eisel-Lemire, Daniel Lemire 2021) with a Clinger fast path for short inputs.
+	/// Neither allocates memory.
+	class NumberConversion
+	{
+	public:
+		/// \brief Buffer size that fits any output of format_shortest
+		static const int shortest_buffer_size = 32;
+
+		/// \brief Writes the shortest text for value, null terminated
+		///
+		/// Uses fixed notation for decimal exponents from -6 to 20 and exponent notation otherwise, like JavaScript.
+		/// Infinity and NaN are written as inf, -inf and nan.
+		/// \return Length of the text
+		static int format_shortest(double value, char *buffer);
+		static int format_shortest(float value, char *buffer);
+
+		/// \brief Writes value with a fixed number of decimals, like printf("%.*f")
+		static std::string format_fixed(double value, int decimals);
+
+		/// \brief Parses a decimal number of the form [+-]digits[.digits][(e|E)[+-]digits]
+		///
+		/// Either the integer or the fraction digits may be left out, but not both.
+		/// \return Pointer past the parsed text, or begin if it does not start with a number
+		static const char *parse(const char *begin, const char *end, double &value);
+		static const char *parse(const char *begin, const char *end, float &value);
+	};
+}
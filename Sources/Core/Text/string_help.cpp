@@ -32,6 +32,9 @@
 #include "API/Core/Text/utf8_reader.h"
 #include "API/Core/System/exception.h"
 #include "API/Core/System/databuffer.h"
+#include "number_conversion.h"
+#include "utf8_codec.h"
+#include <cctype>
 #ifndef WIN32
 #include <wchar.h>
 #include <wctype.h>
@@ -48,6 +51,7 @@
 #endif
 
 #include <sstream>
+#include <algorithm>
 
 #ifdef __MINGW32__
 #include <cstdio>
@@ -210,11 +214,15 @@ namespace clan
 	std::string StringHelp::local8_to_upper(const std::string &s)
 	{
 		std::string result = s;
-		std::string::size_type index, size;
-		size = result.length();
-		for (index = 0; index < size; index++)
+		std::string::size_type index = 0, size = result.length();
+		while (index < size)
 		{
-			result[index] = (unsigned char) toupper((unsigned char) result[index]);
+			index += UTF8Codec::ascii_to_upper(&result[index], size - index);
+			if (index < size)
+			{
+				result[index] = (unsigned char) toupper((unsigned char) result[index]);
+				index++;
+			}
 		}
 		return result;
 	}
@@ -222,11 +230,15 @@ namespace clan
 	std::wstring StringHelp::ucs2_to_upper(const std::wstring &s)
 	{
 		std::wstring result = s;
-		std::wstring::size_type index, size;
-		size = result.length();
-		for (index = 0; index < size; index++)
+		std::wstring::size_type index = 0, size = result.length();
+		while (index < size)
 		{
-			result[index] = towupper(result[index]);
+			index += UTF8Codec::ascii_to_upper(&result[index], size - index);
+			if (index < size)
+			{
+				result[index] = towupper(result[index]);
+				index++;
+			}
 		}
 		return result;
 	}
@@ -239,11 +251,15 @@ namespace clan
 	std::string StringHelp::local8_to_lower(const std::string &s)
 	{
 		std::string result = s;
-		std::string::size_type index, size;
-		size = result.length();
-		for (index = 0; index < size; index++)
+		std::string::size_type index = 0, size = result.length();
+		while (index < size)
 		{
-			result[index] = (unsigned char) tolower((unsigned char) result[index]);
+			index += UTF8Codec::ascii_to_lower(&result[index], size - index);
+			if (index < size)
+			{
+				result[index] = (unsigned char) tolower((unsigned char) result[index]);
+				index++;
+			}
 		}
 		return result;
 	}
@@ -251,11 +267,15 @@ namespace clan
 	std::wstring StringHelp::ucs2_to_lower(const std::wstring &s)
 	{
 		std::wstring result = s;
-		std::wstring::size_type index, size;
-		size = result.length();
-		for (index = 0; index < size; index++)
+		std::wstring::size_type index = 0, size = result.length();
+		while (index < size)
 		{
-			result[index] = towlower(result[index]);
+			index += UTF8Codec::ascii_to_lower(&result[index], size - index);
+			if (index < size)
+			{
+				result[index] = towlower(result[index]);
+				index++;
+			}
 		}
 		return result;
 	}
@@ -280,118 +300,124 @@ namespace clan
 		return text;
 	}
 
+	namespace
+	{
+		std::string format_float(float value, int num_decimals, bool remove_zeros)
+		{
+			if (num_decimals < 0)
+			{
+				char buffer[NumberConversion::shortest_buffer_size];
+				return std::string(buffer, NumberConversion::format_shortest(value, buffer));
+			}
+			std::string text = NumberConversion::format_fixed(value, num_decimals);
+			return remove_zeros ? StringHelp::remove_trailing_zeros(text) : text;
+		}
+
+		std::string format_double(double value, int num_decimals)
+		{
+			if (num_decimals < 0)
+			{
+				char buffer[NumberConversion::shortest_buffer_size];
+				return std::string(buffer, NumberConversion::format_shortest(value, buffer));
+			}
+			return NumberConversion::format_fixed(value, num_decimals);
+		}
+
+		std::wstring widen_number(const std::string &text)
+		{
+			return std::wstring(text.begin(), text.end());
+		}
+
+		std::string narrow_number(const std::wstring &text)
+		{
+			std::string result;
+			result.reserve(text.size());
+			for (wchar_t c : text)
+				result.push_back(c < 128 ? (char)c : '?');
+			return result;
+		}
+
+		// Accepts what sscanf("%f") accepts. Decimal numbers are parsed directly, the rest (inf, nan, hex) by the C library
+		template<typename T>
+		T parse_float(const std::string &text)
+		{
+			const char *begin = text.data();
+			const char *end = begin + text.size();
+			while (begin != end && isspace((unsigned char)*begin))
+				begin++;
+
+			const char *digits = (begin != end && (*begin == '-' || *begin == '+')) ? begin + 1 : begin;
+			bool hex = end - digits >= 2 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X');
+
+			T result = 0;
+			if (hex || NumberConversion::parse(begin, end, result) == begin)
+			{
+				double value = 0.0;
+				sscanf(text.c_str(), "%lf", &value);
+				result = (T)value;
+			}
+			return result;
+		}
+	}
+
 	std::string StringHelp::float_to_text(float value, int num_decimal_places, bool remove_zeros)
 	{
-		if (remove_zeros)
-			return remove_trailing_zeros(float_to_local8(value, num_decimal_places));
-		else
-			return float_to_local8(value, num_decimal_places);
+		return format_float(value, num_decimal_places, remove_zeros);
 	}
 
 	std::string StringHelp::float_to_local8(float value, int num_decimals, bool remove_zeros)
 	{
-		char buf[64];
-		memset(buf, 0, 64);
-	#ifdef WIN32
-		_snprintf(buf, 63, ("%." + StringHelp::int_to_local8(num_decimals) + "f").c_str(), value);
-	#else
-		snprintf(buf, 63, ("%." + StringHelp::int_to_local8(num_decimals) + "f").c_str(), value);
-	#endif
-		if (remove_zeros)
-			return remove_trailing_zeros(std::string(buf));
-		else
-			return std::string(buf);
+		return format_float(value, num_decimals, remove_zeros);
 	}
-	
+
 	std::wstring StringHelp::float_to_ucs2(float value, int num_decimals, bool remove_zeros)
 	{
-	#ifdef WIN32
-		WCHAR buf[64];
-		memset(buf, 0, 64 * sizeof(WCHAR));
-		swprintf(buf, (L"%." + StringHelp::int_to_ucs2(num_decimals) + L"f").c_str(), value);
-		if (remove_zeros)
-			return remove_trailing_zeros(std::wstring(buf));
-		else
-			return std::wstring(buf);
-	#else
-		wchar_t buf[64];
-		memset(buf, 0, 64 * sizeof(wchar_t));
-		swprintf(buf, 63, (L"%." + StringHelp::int_to_ucs2(num_decimals) + L"f").c_str(), value);
-		if (remove_zeros)
-			return remove_trailing_zeros(std::wstring(buf));
-		else
-			return std::wstring(buf);
-	#endif
+		return widen_number(format_float(value, num_decimals, remove_zeros));
 	}
 
 	float StringHelp::text_to_float(const std::string &value)
 	{
-		return local8_to_float(value);
+		return parse_float<float>(value);
 	}
-	
+
 	float StringHelp::local8_to_float(const std::string &value)
 	{
-		float result = 0.0;
-		sscanf(value.c_str(), "%f", &result);
-		return result;
+		return parse_float<float>(value);
 	}
-	
+
 	float StringHelp::ucs2_to_float(const std::wstring &value)
 	{
-		float result = 0.0;
-		swscanf(value.c_str(), L"%f", &result);
-		return result;
+		return parse_float<float>(narrow_number(value));
 	}
 
 	std::string StringHelp::double_to_text(double value, int num_decimals)
 	{
-		return double_to_local8(value, num_decimals);
+		return format_double(value, num_decimals);
 	}
 
 	std::string StringHelp::double_to_local8(double value, int num_decimals)
 	{
-		char buf[64];
-		memset(buf, 0, 64);
-	#ifdef WIN32
-		_snprintf(buf, 63, ("%." + StringHelp::int_to_local8(num_decimals) + "f").c_str(), value);
-	#else
-		snprintf(buf, 63, ("%." + StringHelp::int_to_local8(num_decimals) + "f").c_str(), value);
-	#endif
-		return std::string(buf);
+		return format_double(value, num_decimals);
 	}
-	
+
 	std::wstring StringHelp::double_to_ucs2(double value, int num_decimals)
 	{
-	#ifdef WIN32
-		WCHAR buf[64];
-		memset(buf, 0, 64 * sizeof(WCHAR));
-		swprintf(buf, (L"%." + StringHelp::int_to_ucs2(num_decimals) + L"f").c_str(), value);
-		return std::wstring(buf);
-	#else
-		wchar_t buf[64];
-		memset(buf, 0, 64 * sizeof(wchar_t));
-		swprintf(buf, 63, (L"%." + StringHelp::int_to_ucs2(num_decimals) + L"f").c_str(), value);
-		return std::wstring(buf);
-	#endif
+		return widen_number(format_double(value, num_decimals));
 	}
-	
+
 	double StringHelp::text_to_double(const std::string &value)
 	{
-		return local8_to_double(value);
+		return parse_float<double>(value);
 	}
-	
+
 	double StringHelp::local8_to_double(const std::string &value)
 	{
-		double result = 0.0;
-		sscanf(value.c_str(), "%lf", &result);
-		return result;
+		return parse_float<double>(value);
 	}
-	
+
 	double StringHelp::ucs2_to_double(const std::wstring &value)
 	{
-		double result = 0.0;
-		swscanf(value.c_str(), L"%lf", &result);
-		return result;
+		return parse_float<double>(narrow_number(value));
 	}
 
 	std::string StringHelp::int_to_text(int value)
@@ -929,27 +955,23 @@ namespace clan
 
 	std::string StringHelp::ucs2_to_utf8(const std::wstring &ucs2)
 	{
-		// Calculate length:
-
+		// Sized for pure ASCII and grown when multi-byte characters need more room
 		std::wstring::size_type length_ucs2 = ucs2.length();
-		std::string::size_type length_utf8 = 0;
-		std::wstring::size_type pos;
-		for (pos = 0; pos < length_ucs2; pos++)
-		{
-			if (ucs2[pos] < 0x0080)
-				length_utf8++;
-			else if (ucs2[pos] < 0x0800)
-				length_utf8 += 2;
-			else
-				length_utf8 += 3;
-		}
-	
-		// Perform conversion:
-	
-		std::string utf8(length_utf8, ' ');
+		std::string utf8(length_ucs2, ' ');
 		std::string::size_type pos_utf8 = 0;
-		for (pos = 0; pos < length_ucs2; pos++)
+		std::wstring::size_type pos = 0;
+		while (pos < length_ucs2)
 		{
+			std::wstring::size_type ascii = UTF8Codec::narrow_ascii(ucs2.data() + pos, length_ucs2 - pos, &utf8[pos_utf8]);
+			pos += ascii;
+			pos_utf8 += ascii;
+			if (pos == length_ucs2)
+				break;
+
+			std::string::size_type needed = pos_utf8 + 3 + (length_ucs2 - pos - 1);
+			if (needed > utf8.length())
+				utf8.resize(std::max(needed, utf8.length() + utf8.length() / 2));
+
 			if (ucs2[pos] < 0x0080)
 			{
 				utf8[pos_utf8++] = (char) ucs2[pos];
@@ -965,8 +987,9 @@ namespace clan
 				utf8[pos_utf8++] = 0x80 + ((ucs2[pos] >> 6) & 0x3f);
 				utf8[pos_utf8++] = 0x80 + (ucs2[pos] & 0x3f);
 			}
+			pos++;
 		}
-
+		utf8.resize(pos_utf8);
 		return utf8;
 	}
 
@@ -1005,35 +1028,27 @@ namespace clan
 
 	std::wstring StringHelp::utf8_to_ucs2(const std::string &utf8)
 	{
-		// Calculate length:
-
-		std::wstring::size_type length_ucs2 = 0;
+		// There is at most one character per byte
 		std::string::size_type length_utf8 = utf8.length();
+		std::wstring ucs2(length_utf8, L'?');
 		std::string::size_type pos = 0;
+		std::wstring::size_type ucs2_pos = 0;
 		while (pos < length_utf8)
 		{
-			unsigned char c = utf8[pos++];
-			int trailing_bytes = trailing_bytes_for_utf8[c];
-			length_ucs2++;
-			pos += trailing_bytes;
-		}
-		if (pos != length_utf8)
-		{
-			// error in utf8 string
-			length_ucs2--;
-		}
-		if (pos <= 0)
-			return std::wstring();
+			std::string::size_type ascii = UTF8Codec::widen_ascii(utf8.data() + pos, length_utf8 - pos, &ucs2[ucs2_pos]);
+			pos += ascii;
+			ucs2_pos += ascii;
+			if (pos == length_utf8)
+				break;
 
-		// Perform conversion:
-	
-		std::wstring ucs2(length_ucs2, L'?');
-		pos = 0;
-		std::wstring::size_type ucs2_pos = 0;
-		while (pos < length_utf8 && ucs2_pos < length_ucs2)
-		{
 			unsigned char c = utf8[pos++];
 			int trailing_bytes = trailing_bytes_for_utf8[c];
+			if (pos + trailing_bytes > length_utf8)
+			{
+				// error in utf8 string: last character is cut short
+				break;
+			}
+
 			unsigned int ucs4 = (c & bitmask_leadbyte_for_utf8[trailing_bytes]);
 			for (int i=0; i<trailing_bytes; i++)
 			{
@@ -1057,6 +1072,7 @@ namespace clan
 			ucs2_pos++;
 			pos += trailing_bytes;
 		}
+		ucs2.resize(ucs2_pos);
 		return ucs2;
 	}
 
@@ -1280,26 +1296,40 @@ namespace clan
 		const unsigned char utf16_le[] = { 0xff, 0xfe };
 		const unsigned char utf8[] = { 0xef, 0xbb, 0xbf };
 
+		// UTF-32 first as the UTF-32LE mark starts with the UTF-16LE mark
 		if (length >= 3 && memcmp(data, utf8, 3) == 0)
 			return bom_utf8;
-		else if (length >= 2 && memcmp(data, utf16_le, 2) == 0)
-			return bom_utf16_le;
-		else if (length >= 2 && memcmp(data, utf16_be, 2) == 0)
-			return bom_utf16_be;
 		else if (length >= 4 && memcmp(data, utf32_le, 4) == 0)
 			return bom_utf32_le;
 		else if (length >= 4 && memcmp(data, utf32_be, 4) == 0)
 			return bom_utf32_be;
+		else if (length >= 2 && memcmp(data, utf16_le, 2) == 0)
+			return bom_utf16_le;
+		else if (length >= 2 && memcmp(data, utf16_be, 2) == 0)
+			return bom_utf16_be;
 		else
 			return bom_none;
 	}
 
+	bool StringHelp::is_valid_utf8(const std::string &text)
+	{
+		return UTF8Codec::validate(text.data(), text.length());
+	}
+
+	bool StringHelp::is_valid_utf8(const char *data, std::string::size_type length)
+	{
+		return UTF8Codec::validate(data, length);
+	}
+
 	std::string::size_type StringHelp::utf8_length(const std::string &str)
 	{
 		std::string::size_type len = 0;
 		UTF8_Reader utf8_reader(str.data(), str.length());
 		while(!utf8_reader.is_end())
 		{
+			len += utf8_reader.skip_ascii();
+			if (utf8_reader.is_end())
+				break;
 			len++;
 			utf8_reader.next();
 		}
@@ -0,0 +1,522 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "utf8_codec.h"
+#include "API/Core/System/system.h"
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(CL_DISABLE_SSE2)
+#define CL_UTF8_SIMD
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <immintrin.h>
+#endif
+
+#if defined(CL_UTF8_SIMD) && defined(__GNUC__)
+#define CL_UTF8_SSSE3_TARGET __attribute__((target("ssse3")))
+#define CL_UTF8_AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define CL_UTF8_SSSE3_TARGET
+#define CL_UTF8_AVX2_TARGET
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace clan
+{
+	namespace
+	{
+#ifdef CL_UTF8_SIMD
+		int count_trailing_zeros(unsigned int mask)
+		{
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward(&index, mask);
+			return (int)index;
+#else
+			return __builtin_ctz(mask);
+#endif
+		}
+
+		// Error classes of the lookup table validation. Each table lists the errors a byte can take part in,
+		// indexed by a nibble of the previous or current byte. An error is present where all three lookups agree.
+		enum : uint8_t
+		{
+			too_short = 1 << 0, // Lead byte not followed by a continuation byte
+			too_long = 1 << 1, // ASCII byte followed by a continuation byte
+			overlong_3 = 1 << 2,
+			too_large = 1 << 3,
+			surrogate = 1 << 4,
+			overlong_2 = 1 << 5,
+			too_large_1000 = 1 << 6,
+			overlong_4 = 1 << 6,
+			two_conts = 1 << 7, // Only valid as the third or fourth byte of a sequence
+			carry = too_short | too_long | two_conts
+		};
+
+		// Lookup tables for _mm_shuffle_epi8, built in registers
+		inline __m128i byte_1_high_table()
+		{
+			return _mm_setr_epi8(
+				too_long, too_long, too_long, too_long, too_long, too_long, too_long, too_long,
+				(char)two_conts, (char)two_conts, (char)two_conts, (char)two_conts,
+				too_short | overlong_2,
+				too_short,
+				too_short | overlong_3 | surrogate,
+				too_short | too_large | too_large_1000 | overlong_4);
+		}
+
+		inline __m128i byte_1_low_table()
+		{
+			return _mm_setr_epi8(
+				(char)(carry | overlong_3 | overlong_2 | overlong_4),
+				(char)(carry | overlong_2),
+				(char)carry,
+				(char)carry,
+				(char)(carry | too_large),
+				(char)(carry | too_large | too_large_1000), (char)(carry | too_large | too_large_1000), (char)(carry | too_large | too_large_1000), (char)(carry | too_large | too_large_1000),
+				(char)(carry | too_large | too_large_1000), (char)(carry | too_large | too_large_1000), (char)(carry | too_large | too_large_1000), (char)(carry | too_large | too_large_1000),
+				(char)(carry | too_large | too_large_1000 | surrogate),
+				(char)(carry | too_large | too_large_1000),
+				(char)(carry | too_large | too_large_1000));
+		}
+
+		inline __m128i byte_2_high_table()
+		{
+			return _mm_setr_epi8(
+				too_short, too_short, too_short, too_short, too_short, too_short, too_short, too_short,
+				(char)(too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4),
+				(char)(too_long | overlong_2 | two_conts | overlong_3 | too_large),
+				(char)(too_long | overlong_2 | two_conts | surrogate | too_large),
+				(char)(too_long | overlong_2 | two_conts | surrogate | too_large),
+				too_short, too_short, too_short, too_short);
+		}
+
+		// Largest byte values that do not start a sequence running past the end of a 16 byte block
+		inline __m128i incomplete_max()
+		{
+			return _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, (char)0xef, (char)0xdf, (char)0xbf);
+		}
+
+		CL_UTF8_SSSE3_TARGET inline void validate_block_ssse3(__m128i input, __m128i &prev_input, __m128i &prev_incomplete, __m128i &error)
+		{
+			if (_mm_movemask_epi8(input) == 0)
+			{
+				// An unfinished sequence from the previous block cannot continue with ASCII
+				error = _mm_or_si128(error, prev_incomplete);
+				prev_incomplete = _mm_setzero_si128();
+			}
+			else
+			{
+				const __m128i low_nibble = _mm_set1_epi8(0x0f);
+				__m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+				__m128i byte_1_high = _mm_shuffle_epi8(byte_1_high_table(), _mm_and_si128(_mm_srli_epi16(prev1, 4), low_nibble));
+				__m128i byte_1_low = _mm_shuffle_epi8(byte_1_low_table(), _mm_and_si128(prev1, low_nibble));
+				__m128i byte_2_high = _mm_shuffle_epi8(byte_2_high_table(), _mm_and_si128(_mm_srli_epi16(input, 4), low_nibble));
+				__m128i special_cases = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+				// Continuation bytes two or three positions after a three or four byte lead are expected
+				__m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+				__m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+				__m128i must23 = _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8(0xe0 - 0x80)), _mm_subs_epu8(prev3, _mm_set1_epi8(0xf0 - 0x80)));
+				__m128i must23_80 = _mm_and_si128(must23, _mm_set1_epi8((char)0x80));
+
+				error = _mm_or_si128(error, _mm_xor_si128(must23_80, special_cases));
+				prev_incomplete = _mm_subs_epu8(input, incomplete_max());
+			}
+			prev_input = input;
+		}
+
+		CL_UTF8_SSSE3_TARGET bool validate_ssse3(const unsigned char *data, size_t size)
+		{
+			__m128i prev_input = _mm_setzero_si128();
+			__m128i prev_incomplete = _mm_setzero_si128();
+			__m128i error = _mm_setzero_si128();
+
+			size_t pos = 0;
+			while (pos + 16 <= size)
+			{
+				validate_block_ssse3(_mm_loadu_si128((const __m128i*)(data + pos)), prev_input, prev_incomplete, error);
+				pos += 16;
+			}
+
+			if (pos < size)
+			{
+				unsigned char tail[16] = { 0 };
+				memcpy(tail, data + pos, size - pos);
+				validate_block_ssse3(_mm_loadu_si128((const __m128i*)tail), prev_input, prev_incomplete, error);
+			}
+
+			error = _mm_or_si128(error, prev_incomplete);
+			return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xffff;
+		}
+
+		CL_UTF8_AVX2_TARGET inline __m256i prev_bytes_avx2(__m256i input, __m256i prev_input, const int count)
+		{
+			// Bytes shifted in from the end of the previous block
+			__m256i shifted_in = _mm256_permute2x128_si256(prev_input, input, 0x21);
+			switch (count)
+			{
+			case 1: return _mm256_alignr_epi8(input, shifted_in, 15);
+			case 2: return _mm256_alignr_epi8(input, shifted_in, 14);
+			default: return _mm256_alignr_epi8(input, shifted_in, 13);
+			}
+		}
+
+		CL_UTF8_AVX2_TARGET inline void validate_block_avx2(__m256i input, __m256i &prev_input, __m256i &prev_incomplete, __m256i &error)
+		{
+			if (_mm256_movemask_epi8(input) == 0)
+			{
+				error = _mm256_or_si256(error, prev_incomplete);
+				prev_incomplete = _mm256_setzero_si256();
+			}
+			else
+			{
+				const __m256i low_nibble = _mm256_set1_epi8(0x0f);
+				__m256i prev1 = prev_bytes_avx2(input, prev_input, 1);
+				__m256i byte_1_high = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(byte_1_high_table()), _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low_nibble));
+				__m256i byte_1_low = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(byte_1_low_table()), _mm256_and_si256(prev1, low_nibble));
+				__m256i byte_2_high = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(byte_2_high_table()), _mm256_and_si256(_mm256_srli_epi16(input, 4), low_nibble));
+				__m256i special_cases = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+				__m256i prev2 = prev_bytes_avx2(input, prev_input, 2);
+				__m256i prev3 = prev_bytes_avx2(input, prev_input, 3);
+				__m256i must23 = _mm256_or_si256(_mm256_subs_epu8(prev2, _mm256_set1_epi8(0xe0 - 0x80)), _mm256_subs_epu8(prev3, _mm256_set1_epi8(0xf0 - 0x80)));
+				__m256i must23_80 = _mm256_and_si256(must23, _mm256_set1_epi8((char)0x80));
+
+				error = _mm256_or_si256(error, _mm256_xor_si256(must23_80, special_cases));
+				// Only the upper lane can start a sequence that runs past the end of the 32 byte block
+				prev_incomplete = _mm256_subs_epu8(input, _mm256_inserti128_si256(_mm256_set1_epi8(-1), incomplete_max(), 1));
+			}
+			prev_input = input;
+		}
+
+		CL_UTF8_AVX2_TARGET bool validate_avx2(const unsigned char *data, size_t size)
+		{
+			__m256i prev_input = _mm256_setzero_si256();
+			__m256i prev_incomplete = _mm256_setzero_si256();
+			__m256i error = _mm256_setzero_si256();
+
+			size_t pos = 0;
+			while (pos + 32 <= size)
+			{
+				validate_block_avx2(_mm256_loadu_si256((const __m256i*)(data + pos)), prev_input, prev_incomplete, error);
+				pos += 32;
+			}
+
+			if (pos < size)
+			{
+				unsigned char tail[32] = { 0 };
+				memcpy(tail, data + pos, size - pos);
+				validate_block_avx2(_mm256_loadu_si256((const __m256i*)tail), prev_input, prev_incomplete, error);
+			}
+
+			error = _mm256_or_si256(error, prev_incomplete);
+			return _mm256_testz_si256(error, error) != 0;
+		}
+
+		CL_UTF8_AVX2_TARGET size_t ascii_length_avx2(const unsigned char *data, size_t size)
+		{
+			size_t pos = 0;
+			while (pos + 32 <= size)
+			{
+				unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*)(data + pos)));
+				if (mask != 0)
+					return pos + count_trailing_zeros(mask);
+				pos += 32;
+			}
+			return pos;
+		}
+
+		bool detect_avx2()
+		{
+			return System::detect_cpu_extension(System::avx2);
+		}
+
+		bool detect_ssse3()
+		{
+			return System::detect_cpu_extension(System::ssse3);
+		}
+
+		// Set before main, so the first calls from several threads do not race to initialize them
+		const bool use_avx2 = detect_avx2();
+		const bool use_ssse3 = detect_ssse3();
+#endif
+
+		size_t convert_case(char *text, size_t size, char first, char last)
+		{
+			size_t pos = 0;
+#ifdef CL_UTF8_SIMD
+			const __m128i below_first = _mm_set1_epi8(first - 1);
+			const __m128i after_last = _mm_set1_epi8(last + 1);
+			const __m128i case_bit = _mm_set1_epi8(0x20);
+			while (pos + 16 <= size)
+			{
+				__m128i chars = _mm_loadu_si128((const __m128i*)(text + pos));
+				if (_mm_movemask_epi8(chars) != 0)
+					break;
+				__m128i in_range = _mm_and_si128(_mm_cmpgt_epi8(chars, below_first), _mm_cmplt_epi8(chars, after_last));
+				_mm_storeu_si128((__m128i*)(text + pos), _mm_xor_si128(chars, _mm_and_si128(in_range, case_bit)));
+				pos += 16;
+			}
+#endif
+			while (pos < size && (unsigned char)text[pos] < 0x80)
+			{
+				if (text[pos] >= first && text[pos] <= last)
+					text[pos] ^= 0x20;
+				pos++;
+			}
+			return pos;
+		}
+
+		size_t convert_case(wchar_t *text, size_t size, wchar_t first, wchar_t last)
+		{
+			size_t pos = 0;
+#ifdef CL_UTF8_SIMD
+			const size_t step = 16 / sizeof(wchar_t);
+			const __m128i zero = _mm_setzero_si128();
+			while (pos + step <= size)
+			{
+				__m128i chars = _mm_loadu_si128((const __m128i*)(text + pos));
+				__m128i in_range, case_bit;
+				if (sizeof(wchar_t) == 2)
+				{
+					if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(chars, _mm_set1_epi16((short)0xff80)), zero)) != 0xffff)
+						break;
+					in_range = _mm_and_si128(_mm_cmpgt_epi16(chars, _mm_set1_epi16(first - 1)), _mm_cmplt_epi16(chars, _mm_set1_epi16(last + 1)));
+					case_bit = _mm_set1_epi16(0x20);
+				}
+				else
+				{
+					if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(chars, _mm_set1_epi32((int)0xffffff80)), zero)) != 0xffff)
+						break;
+					in_range = _mm_and_si128(_mm_cmpgt_epi32(chars, _mm_set1_epi32(first - 1)), _mm_cmplt_epi32(chars, _mm_set1_epi32(last + 1)));
+					case_bit = _mm_set1_epi32(0x20);
+				}
+				_mm_storeu_si128((__m128i*)(text + pos), _mm_xor_si128(chars, _mm_and_si128(in_range, case_bit)));
+				pos += step;
+			}
+#endif
+			while (pos < size && (unsigned int)text[pos] < 0x80)
+			{
+				if (text[pos] >= first && text[pos] <= last)
+					text[pos] ^= 0x20;
+				pos++;
+			}
+			return pos;
+		}
+	}
+
+	size_t UTF8Codec::ascii_length(const char *data, size_t size)
+	{
+		const unsigned char *p = (const unsigned char *)data;
+		size_t pos = 0;
+#ifdef CL_UTF8_SIMD
+		if (use_avx2 && size >= 32)
+			pos = ascii_length_avx2(p, size);
+
+		while (pos + 16 <= size)
+		{
+			unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(p + pos)));
+			if (mask != 0)
+				return pos + count_trailing_zeros(mask);
+			pos += 16;
+		}
+#endif
+		while (pos < size && p[pos] < 0x80)
+			pos++;
+		return pos;
+	}
+
+	bool UTF8Codec::validate(const char *data, size_t size)
+	{
+#ifdef CL_UTF8_SIMD
+		if (use_avx2)
+			return validate_avx2((const unsigned char *)data, size);
+		else if (use_ssse3)
+			return validate_ssse3((const unsigned char *)data, size);
+#endif
+		return validate_scalar(data, size);
+	}
+
+	bool UTF8Codec::validate_scalar(const char *data, size_t size)
+	{
+		const unsigned char *p = (const unsigned char *)data;
+		const unsigned char *end = p + size;
+		while (p != end)
+		{
+			unsigned char c = *p;
+			size_t remaining = end - p;
+			if (c < 0x80)
+			{
+				p += ascii_length((const char *)p, remaining);
+			}
+			else if (c >= 0xc2 && c <= 0xdf)
+			{
+				if (remaining < 2 || (p[1] & 0xc0) != 0x80)
+					return false;
+				p += 2;
+			}
+			else if (c >= 0xe0 && c <= 0xef)
+			{
+				// E0 must not be overlong and ED must not encode a surrogate
+				unsigned char min = (c == 0xe0) ? 0xa0 : 0x80;
+				unsigned char max = (c == 0xed) ? 0x9f : 0xbf;
+				if (remaining < 3 || p[1] < min || p[1] > max || (p[2] & 0xc0) != 0x80)
+					return false;
+				p += 3;
+			}
+			else if (c >= 0xf0 && c <= 0xf4)
+			{
+				// F0 must not be overlong and F4 must not go past U+10FFFF
+				unsigned char min = (c == 0xf0) ? 0x90 : 0x80;
+				unsigned char max = (c == 0xf4) ? 0x8f : 0xbf;
+				if (remaining < 4 || p[1] < min || p[1] > max || (p[2] & 0xc0) != 0x80 || (p[3] & 0xc0) != 0x80)
+					return false;
+				p += 4;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	size_t UTF8Codec::widen_ascii(const char *data, size_t size, wchar_t *dest)
+	{
+		const unsigned char *p = (const unsigned char *)data;
+		size_t pos = 0;
+#ifdef CL_UTF8_SIMD
+		const __m128i zero = _mm_setzero_si128();
+		while (pos + 16 <= size)
+		{
+			__m128i bytes = _mm_loadu_si128((const __m128i*)(p + pos));
+			if (_mm_movemask_epi8(_mm_or_si128(bytes, _mm_cmpeq_epi8(bytes, zero))) != 0)
+				break;
+
+			__m128i low = _mm_unpacklo_epi8(bytes, zero);
+			__m128i high = _mm_unpackhi_epi8(bytes, zero);
+			__m128i *out = (__m128i*)(dest + pos);
+			if (sizeof(wchar_t) == 2)
+			{
+				_mm_storeu_si128(out, low);
+				_mm_storeu_si128(out + 1, high);
+			}
+			else
+			{
+				_mm_storeu_si128(out, _mm_unpacklo_epi16(low, zero));
+				_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(low, zero));
+				_mm_storeu_si128(out + 2, _mm_unpacklo_epi16(high, zero));
+				_mm_storeu_si128(out + 3, _mm_unpackhi_epi16(high, zero));
+			}
+			pos += 16;
+		}
+#endif
+		while (pos < size && p[pos] != 0 && p[pos] < 0x80)
+		{
+			dest[pos] = p[pos];
+			pos++;
+		}
+		return pos;
+	}
+
+	size_t UTF8Codec::narrow_ascii(const wchar_t *data, size_t size, char *dest)
+	{
+		size_t pos = 0;
+#ifdef CL_UTF8_SIMD
+		const __m128i zero = _mm_setzero_si128();
+		while (pos + 16 <= size)
+		{
+			const __m128i *in = (const __m128i*)(data + pos);
+			__m128i bytes;
+			if (sizeof(wchar_t) == 2)
+			{
+				__m128i a = _mm_loadu_si128(in);
+				__m128i b = _mm_loadu_si128(in + 1);
+				__m128i non_ascii = _mm_and_si128(_mm_or_si128(a, b), _mm_set1_epi16((short)0xff80));
+				if (_mm_movemask_epi8(_mm_cmpeq_epi16(non_ascii, zero)) != 0xffff)
+					break;
+				bytes = _mm_packus_epi16(a, b);
+			}
+			else
+			{
+				__m128i a = _mm_loadu_si128(in);
+				__m128i b = _mm_loadu_si128(in + 1);
+				__m128i c = _mm_loadu_si128(in + 2);
+				__m128i d = _mm_loadu_si128(in + 3);
+				__m128i non_ascii = _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), _mm_set1_epi32((int)0xffffff80));
+				if (_mm_movemask_epi8(_mm_cmpeq_epi32(non_ascii, zero)) != 0xffff)
+					break;
+				bytes = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+			}
+			_mm_storeu_si128((__m128i*)(dest + pos), bytes);
+			pos += 16;
+		}
+#endif
+		while (pos < size && (unsigned int)data[pos] < 0x80)
+		{
+			dest[pos] = (char)data[pos];
+			pos++;
+		}
+		return pos;
+	}
+
+	size_t UTF8Codec::ascii_to_upper(char *text, size_t size)
+	{
+		return convert_case(text, size, 'a', 'z');
+	}
+
+	size_t UTF8Codec::ascii_to_lower(char *text, size_t size)
+	{
+		return convert_case(text, size, 'A', 'Z');
+	}
+
+	size_t UTF8Codec::ascii_to_upper(wchar_t *text, size_t size)
+	{
+		return convert_case(text, size, L'a', L'z');
+	}
+
+	size_t UTF8Codec::ascii_to_lower(wchar_t *text, size_t size)
+	{
+		return convert_case(text, size, L'A', L'Z');
+	}
+
+	bool UTF8Codec::is_avx2_accelerated()
+	{
+#ifdef CL_UTF8_SIMD
+		return use_avx2;
+#else
+		return false;
+#endif
+	}
+}
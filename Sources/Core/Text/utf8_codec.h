@@ -0,0 +1,74 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <cstddef>
+
+namespace clan
+{
+	/// \brief Bulk UTF-8 primitives for StringHelp and UTF8_Reader
+	///
+	/// On x86-64 these work on 16 bytes at a time with SSE2, and validation and ASCII scanning use 32 bytes at a time
+	/// on processors with AVX2. Validation uses the lookup table algorithm by Keiser and Lemire (2020).
+	class UTF8Codec
+	{
+	public:
+		/// \brief Returns the number of leading bytes below 0x80
+		static size_t ascii_length(const char *data, size_t size);
+
+		/// \brief Returns true if data is well-formed UTF-8
+		///
+		/// Overlong forms, surrogates and code points above U+10FFFF are rejected (RFC 3629).
+		static bool validate(const char *data, size_t size);
+
+		/// \brief Portable implementation of validate()
+		static bool validate_scalar(const char *data, size_t size);
+
+		/// \brief Copies the leading bytes in the range 1-127 to dest as wide characters
+		///
+		/// \return Number of characters copied
+		static size_t widen_ascii(const char *data, size_t size, wchar_t *dest);
+
+		/// \brief Copies the leading wide characters below 128 to dest as bytes
+		///
+		/// \return Number of characters copied
+		static size_t narrow_ascii(const wchar_t *data, size_t size, char *dest);
+
+		/// \brief Converts the leading ASCII characters to upper or lower case in place
+		///
+		/// \return Number of characters converted. Processing stops at the first character that is not ASCII.
+		static size_t ascii_to_upper(char *text, size_t size);
+		static size_t ascii_to_lower(char *text, size_t size);
+		static size_t ascii_to_upper(wchar_t *text, size_t size);
+		static size_t ascii_to_lower(wchar_t *text, size_t size);
+
+		/// \brief Returns true if validate() and ascii_length() use AVX2 on this processor
+		static bool is_avx2_accelerated();
+	};
+}
@@ -28,6 +28,7 @@
 
 #include "Core/precomp.h"
 #include "API/Core/Text/utf8_reader.h"
+#include "utf8_codec.h"
 
 namespace clan
 {
@@ -52,6 +53,9 @@ namespace clan
 		if (current_position >= length)
 			return 0;
 
+		if (data[current_position] < 0x80)
+			return data[current_position];
+
 		int trailing_bytes = UTF8_Reader_Impl::trailing_bytes_for_utf8[data[current_position]];
 		if (trailing_bytes == 0 && (data[current_position] & 0x80) == 0x80)
 			return '?';
@@ -82,6 +86,9 @@ namespace clan
 	{
 		if (current_position < length)
 		{
+			if (data[current_position] < 0x80)
+				return 1;
+
 			int trailing_bytes = UTF8_Reader_Impl::trailing_bytes_for_utf8[data[current_position]];
 			if (current_position + 1 + trailing_bytes > length)
 				return 1;
@@ -118,6 +125,16 @@ namespace clan
 
 	}
 
+	std::string::size_type UTF8_Reader::skip_ascii()
+	{
+		if (current_position >= length)
+			return 0;
+
+		std::string::size_type count = UTF8Codec::ascii_length((const char *)data + current_position, length - current_position);
+		current_position += count;
+		return count;
+	}
+
 	void UTF8_Reader::move_to_leadbyte()
 	{
 		if (current_position < length)
@@ -31,20 +31,45 @@
 #include "API/Core/Zip/zip_file_entry.h"
 #include "API/Core/IOData/iodevice.h"
 #include "zip_flags.h"
+#include <unordered_map>
 
 namespace clan
 {
+	class ZipDirectoryChild
+	{
+	public:
+		ZipDirectoryChild(const std::string &name, bool is_directory) : name(name), is_directory(is_directory) { }
+
+		std::string name;
+		bool is_directory;
+	};
+
 	class ZipArchive_Impl
 	{
 	public:
+		/// \brief Adds files[file_index] to the path index and the directory tree
+		void add_to_index(size_t file_index);
+
+		/// \brief Returns the entry for a path relative to the archive root, or nullptr if there is none
+		ZipFileEntry *find_file(const std::string &filename);
+
+		/// \brief Returns the children of a directory in the form "/Folder/", or nullptr if the directory is unknown
+		const std::vector<ZipDirectoryChild> *find_directory(const std::string &path) const;
+
 		std::vector<ZipFileEntry> files;
 		IODevice input;
 
+		// Maps entry names without their leading slash to an index in files. Duplicates keep the first entry
+		std::unordered_map<std::string, size_t> file_index;
+
+		// Maps directory paths in the form "/Folder/" to their children, in the order they appear in the archive
+		std::unordered_map<std::string, std::vector<ZipDirectoryChild>> directories;
+
 		static uint32_t calc_crc32(const void *data, int64_t size, uint32_t crc = ZIP_CRC_START_VALUE, bool last_block = true);
-		static void calc_time_and_date(int16_t &out_date, int16_t &out_time);
 
-	private:
-		// crc32_table_quotient = 0xdebb20e3
-		static uint32_t crc32_table[256];
+		/// \brief Returns the CRC of two concatenated blocks given the final CRC of each block and the length of the second
+		static uint32_t crc32_combine(uint32_t crc1, uint32_t crc2, int64_t size2);
+
+		static void calc_time_and_date(int16_t &out_date, int16_t &out_time);
 	};
 }
@@ -42,6 +42,7 @@ namespace clan
 		zip_compress_tokenize,
 		zip_compress_deflate,
 		zip_compress_deflate64,
-		zip_compress_pkware_implode
+		zip_compress_pkware_implode,
+		zip_compress_lz4 = 0x4c34 // LZ4 frame. Not assigned by PKWARE; only ClanLib reads this method
 	};
 }
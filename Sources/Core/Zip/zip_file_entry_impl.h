@@ -31,9 +31,13 @@
 #include "API/Core/System/cl_platform.h"
 #include "API/Core/System/databuffer.h"
 #include "zip_file_header.h"
+#include <memory>
+#include <mutex>
 
 namespace clan
 {
+	class ZipInflateIndex;
+
 	class ZipFileEntry_Impl
 	{
 	public:
@@ -63,5 +67,11 @@ namespace clan
 
 		/// \brief True, if this entry is a directory.
 		bool is_directory;
+
+		/// \brief Access points into the deflated data, created on the first seek (type_file).
+		std::shared_ptr<ZipInflateIndex> inflate_index;
+
+		/// \brief Guards the creation of inflate_index by devices opened on the entry.
+		std::mutex inflate_index_mutex;
 	};
 }
@@ -0,0 +1,96 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#pragma once
+
+#include "API/Core/System/databuffer.h"
+#include "Core/Zip/miniz.h"
+#include <vector>
+#include <mutex>
+#include <algorithm>
+
+namespace clan
+{
+	/// \brief Snapshot of an inflate stream that decompression can resume from
+	class ZipInflateCheckpoint
+	{
+	public:
+		/// \brief Position in the uncompressed data
+		int64_t uncompressed_pos = 0;
+
+		/// \brief Number of compressed bytes consumed by the decompressor
+		int64_t compressed_pos = 0;
+
+		/// \brief Copy of the miniz inflate state, including the 32 KB window
+		DataBuffer state;
+	};
+
+	/// \brief Access points into a deflated zip entry
+	///
+	/// Built lazily while an entry is decompressed and shared by every device that opens the entry.
+	class ZipInflateIndex
+	{
+	public:
+		/// \brief Uncompressed distance between checkpoints
+		static const int64_t checkpoint_interval = 256 * 1024;
+
+		/// \brief Finds the last checkpoint at or before a position
+		bool find(int64_t position, ZipInflateCheckpoint &out_checkpoint)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), position, [](int64_t pos, const ZipInflateCheckpoint &checkpoint) { return pos < checkpoint.uncompressed_pos; });
+			if (it == checkpoints.begin())
+				return false;
+			out_checkpoint = *(it - 1);
+			return true;
+		}
+
+		/// \brief Adds a checkpoint unless one is already recorded at the same position
+		void add(const ZipInflateCheckpoint &checkpoint)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			auto it = std::lower_bound(checkpoints.begin(), checkpoints.end(), checkpoint.uncompressed_pos, [](const ZipInflateCheckpoint &existing, int64_t pos) { return existing.uncompressed_pos < pos; });
+			if (it == checkpoints.end() || it->uncompressed_pos != checkpoint.uncompressed_pos)
+				checkpoints.insert(it, checkpoint);
+		}
+
+	private:
+		std::mutex mutex;
+		std::vector<ZipInflateCheckpoint> checkpoints;
+	};
+
+	/// \brief Size of the state saved by zip_inflate_save_state
+	int zip_inflate_state_size();
+
+	/// \brief Copies the inflate state of a stream opened with mz_inflateInit2
+	void zip_inflate_save_state(const mz_stream *zs, void *state);
+
+	/// \brief Replaces the inflate state of a stream opened with mz_inflateInit2
+	void zip_inflate_restore_state(mz_stream *zs, const void *state);
+}
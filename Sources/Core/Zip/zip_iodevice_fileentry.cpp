@@ -131,19 +131,11 @@ namespace clan
 			break;
 
 		case zip_compress_deflate:
-			// if backward seeking, restart at beginning of stream.
-			if (absolute_pos < pos)
-			{
-				deinit();
-				init();
-			}
+			seek_deflate(absolute_pos);
+			break;
 
-			char buffer[1024];
-			while (absolute_pos > pos)
-			{
-				int received = receive(buffer, int(min(absolute_pos - pos, (int64_t)1024)), true);
-				if (received == 0) break;
-			}
+		case zip_compress_lz4:
+			seek_lz4(absolute_pos);
 			break;
 
 		case zip_compress_shrunk:
@@ -167,10 +159,101 @@ namespace clan
 	}
 
 
+	void ZipIODevice_FileEntry::seek_deflate(int64_t absolute_pos)
+	{
+		if (!inflate_index && file_header.uncompressed_size > ZipInflateIndex::checkpoint_interval)
+		{
+			// The index is shared by all devices opened on the entry
+			std::unique_lock<std::mutex> lock(file_entry.impl->inflate_index_mutex);
+			if (!file_entry.impl->inflate_index)
+				file_entry.impl->inflate_index = std::make_shared<ZipInflateIndex>();
+			inflate_index = file_entry.impl->inflate_index;
+			next_checkpoint_pos = 0;
+		}
+
+		// Resume from the closest access point if it is ahead of the current position or the seek goes backwards
+		ZipInflateCheckpoint checkpoint;
+		bool found_checkpoint = inflate_index && inflate_index->find(absolute_pos, checkpoint);
+		if (found_checkpoint && (checkpoint.uncompressed_pos > pos || absolute_pos < pos))
+		{
+			restore_checkpoint(checkpoint);
+		}
+		else if (absolute_pos < pos)
+		{
+			deinit();
+			init();
+		}
+
+		peeked_data.set_size(0);
+		char buffer[16 * 1024];
+		while (absolute_pos > pos)
+		{
+			int received = lowlevel_read(buffer, int(min(absolute_pos - pos, (int64_t)sizeof(buffer))), true);
+			if (received == 0) break;
+		}
+	}
+
+	void ZipIODevice_FileEntry::seek_lz4(int64_t absolute_pos)
+	{
+		// Independent blocks seen before can be decoded again without starting over
+		ZipLZ4Block block(0, 0);
+		if (lz4_decoder.find_block(absolute_pos, block) && (block.uncompressed_pos > pos || absolute_pos < pos))
+		{
+			lz4_decoder.restart_at(block);
+			pos = block.uncompressed_pos;
+			iodevice.seek(int(data_start + block.compressed_pos), IODevice::seek_set);
+		}
+		else if (absolute_pos < pos)
+		{
+			deinit();
+			init();
+		}
+
+		peeked_data.set_size(0);
+		char buffer[16 * 1024];
+		while (absolute_pos > pos)
+		{
+			int received = lowlevel_read(buffer, int(min(absolute_pos - pos, (int64_t)sizeof(buffer))), true);
+			if (received == 0) break;
+		}
+	}
+
+	void ZipIODevice_FileEntry::add_checkpoint(int64_t uncompressed_pos)
+	{
+		ZipInflateCheckpoint existing;
+		if (inflate_index->find(uncompressed_pos, existing) && uncompressed_pos - existing.uncompressed_pos < ZipInflateIndex::checkpoint_interval)
+		{
+			next_checkpoint_pos = existing.uncompressed_pos + ZipInflateIndex::checkpoint_interval;
+			return;
+		}
+
+		ZipInflateCheckpoint checkpoint;
+		checkpoint.uncompressed_pos = uncompressed_pos;
+		checkpoint.compressed_pos = compressed_pos - zs.avail_in;
+		checkpoint.state = DataBuffer(zip_inflate_state_size());
+		zip_inflate_save_state(&zs, checkpoint.state.get_data());
+		inflate_index->add(checkpoint);
+		next_checkpoint_pos = uncompressed_pos + ZipInflateIndex::checkpoint_interval;
+	}
+
+	void ZipIODevice_FileEntry::restore_checkpoint(const ZipInflateCheckpoint &checkpoint)
+	{
+		zip_inflate_restore_state(&zs, checkpoint.state.get_data());
+		zs.next_in = nullptr;
+		zs.avail_in = 0;
+		zs.total_in = (mz_ulong)checkpoint.compressed_pos;
+		zs.total_out = (mz_ulong)checkpoint.uncompressed_pos;
+		compressed_pos = checkpoint.compressed_pos;
+		pos = checkpoint.uncompressed_pos;
+		next_checkpoint_pos = pos + ZipInflateIndex::checkpoint_interval;
+		iodevice.seek(int(data_start + compressed_pos), IODevice::seek_set);
+	}
+
 	void ZipIODevice_FileEntry::init()
 	{
 		iodevice.seek(file_entry.impl->record.relative_offset_of_local_header, IODevice::seek_set);
 		file_header.load(iodevice);
+		data_start = iodevice.get_position();
 
 		//This fix allows OS X created .zips to be opened - SAR
 		if (file_header.general_purpose_bit_flag  & ZIP_CRC32_IN_FILE_DESCRIPTOR) //if this bit is set, it means the local header data for sizes was not
@@ -182,6 +265,7 @@ namespace clan
 
 		pos = 0;
 		compressed_pos = 0;
+		next_checkpoint_pos = 0;
 
 		// Initialize decompression:
 		int result = 0;
@@ -203,6 +287,10 @@ namespace clan
 			zstream_open = true;
 			break;
 
+		case zip_compress_lz4:
+			lz4_decoder.begin(iodevice, file_header.compressed_size);
+			break;
+
 		case zip_compress_shrunk:
 		case zip_compress_expand_factor_1:
 		case zip_compress_expand_factor_2:
@@ -231,6 +319,9 @@ namespace clan
 			zstream_open = false;
 			break;
 
+		case zip_compress_lz4:
+			break;
+
 		case zip_compress_shrunk:
 		case zip_compress_expand_factor_1:
 		case zip_compress_expand_factor_2:
@@ -287,10 +378,20 @@ namespace clan
 				if (result == MZ_MEM_ERROR) throw Exception("Zlib did not have enough memory to decompress file!");
 				if (result == MZ_BUF_ERROR) throw Exception("Not enough data in buffer when Z_FINISH was used");
 				if (result != MZ_OK) throw Exception("Zlib inflate failed while decompressing zip file!");
+
+				if (inflate_index && pos + size - zs.avail_out >= next_checkpoint_pos)
+					add_checkpoint(pos + size - zs.avail_out);
 			}
 			pos += size - zs.avail_out;
 			return size - zs.avail_out;
 
+		case zip_compress_lz4:
+		{
+			int received = lz4_decoder.read(iodevice, data, int(min((int64_t)size, file_header.uncompressed_size - pos)));
+			pos += received;
+			return received;
+		}
+
 		case zip_compress_shrunk:
 		case zip_compress_expand_factor_1:
 		case zip_compress_expand_factor_2:
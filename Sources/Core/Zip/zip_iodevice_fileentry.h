@@ -32,7 +32,10 @@
 #include "API/Core/Zip/zip_file_entry.h"
 #include "API/Core/System/databuffer.h"
 #include "zip_local_file_header.h"
+#include "zip_inflate_index.h"
+#include "zip_lz4.h"
 #include <stack>
+#include <memory>
 #include "Core/Zip/miniz.h"
 
 namespace clan
@@ -58,14 +61,24 @@ namespace clan
 		void init();
 		void deinit();
 		int lowlevel_read(void *buffer, int size, bool read_all);
+		void seek_deflate(int64_t absolute_pos);
+		void seek_lz4(int64_t absolute_pos);
+		void add_checkpoint(int64_t uncompressed_pos);
+		void restore_checkpoint(const ZipInflateCheckpoint &checkpoint);
 
 		IODevice iodevice;
 		ZipFileEntry file_entry;
 		ZipLocalFileHeader file_header;
 		int64_t pos, compressed_pos;
+		int64_t data_start = 0;
 		mz_stream zs;
 		char zbuffer[16 * 1024];
 		bool zstream_open;
 		DataBuffer peeked_data;
+		ZipLZ4Decoder lz4_decoder;
+
+		// Access points are recorded once the device has seeked, as plain sequential reads never use them
+		std::shared_ptr<ZipInflateIndex> inflate_index;
+		int64_t next_checkpoint_pos = 0;
 	};
 }
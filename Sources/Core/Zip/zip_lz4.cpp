@@ -0,0 +1,448 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#include "Core/precomp.h"
+#include "zip_lz4.h"
+#include "API/Core/Math/cl_math.h"
+#include <algorithm>
+
+namespace clan
+{
+	namespace
+	{
+		inline uint32_t read_uint32_le(const unsigned char *p)
+		{
+			return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+		}
+
+		inline void write_uint32_le(unsigned char *p, uint32_t value)
+		{
+			p[0] = (unsigned char)value;
+			p[1] = (unsigned char)(value >> 8);
+			p[2] = (unsigned char)(value >> 16);
+			p[3] = (unsigned char)(value >> 24);
+		}
+
+		inline uint32_t lz4_hash(uint32_t sequence)
+		{
+			return (sequence * 2654435761u) >> 19;
+		}
+
+		const uint32_t lz4_frame_magic = 0x184d2204;
+		const uint32_t lz4_uncompressed_block_flag = 0x80000000;
+		const int lz4_min_match = 4;
+		const int lz4_last_literals = 5; // The last 5 bytes of a block are always literals
+		const int lz4_match_start_limit = 12; // The last match must start at least 12 bytes before the end of the block
+		const int lz4_max_distance = 65535;
+	}
+
+	int64_t ZipLZ4::compress_bound(int64_t size)
+	{
+		return size + (size + block_size - 1) / block_size * 4;
+	}
+
+	void ZipLZ4::write_frame_header(void *out_header)
+	{
+		unsigned char *header = (unsigned char *)out_header;
+		write_uint32_le(header, lz4_frame_magic);
+		header[4] = 0x60; // FLG: version 1, independent blocks
+		header[5] = 0x40; // BD: 64 KB maximum block size
+		header[6] = 0x82; // HC: second byte of xxh32(FLG, BD)
+	}
+
+	int64_t ZipLZ4::compress_blocks(const void *data, int64_t size, void *dest)
+	{
+		const unsigned char *src = (const unsigned char *)data;
+		unsigned char *out = (unsigned char *)dest;
+		for (int64_t offset = 0; offset < size; offset += block_size)
+		{
+			int length = (int)std::min((int64_t)block_size, size - offset);
+			int compressed_size = compress_block(src + offset, length, out + 4, length - 1);
+			if (compressed_size > 0)
+			{
+				write_uint32_le(out, compressed_size);
+				out += 4 + compressed_size;
+			}
+			else
+			{
+				write_uint32_le(out, length | lz4_uncompressed_block_flag);
+				memcpy(out + 4, src + offset, length);
+				out += 4 + length;
+			}
+		}
+		return out - (unsigned char *)dest;
+	}
+
+	int ZipLZ4::compress_block(const unsigned char *src, int size, unsigned char *dest, int dest_capacity)
+	{
+		if (size > block_size)
+			throw Exception("LZ4 block too large");
+
+		// Positions fit in 16 bits as a block is at most 64 KB. Stale or empty entries are rejected by comparing the data.
+		uint16_t hash_table[8192];
+		memset(hash_table, 0, sizeof(hash_table));
+
+		unsigned char *op = dest;
+		unsigned char *oend = dest + dest_capacity;
+		int anchor = 0;
+
+		auto emit_sequence = [&](int literal_length, int offset, int match_length) -> bool
+		{
+			int64_t worst_size = 1 + literal_length / 255 + 1 + literal_length + 2 + match_length / 255 + 1;
+			if (oend - op < worst_size)
+				return false;
+
+			unsigned char *token = op++;
+			if (literal_length >= 15)
+			{
+				*token = 15 << 4;
+				int remaining = literal_length - 15;
+				for (; remaining >= 255; remaining -= 255)
+					*op++ = 255;
+				*op++ = (unsigned char)remaining;
+			}
+			else
+			{
+				*token = (unsigned char)(literal_length << 4);
+			}
+			memcpy(op, src + anchor, literal_length);
+			op += literal_length;
+
+			if (match_length == 0) // Last sequence has no match
+				return true;
+
+			*op++ = (unsigned char)offset;
+			*op++ = (unsigned char)(offset >> 8);
+
+			int length_code = match_length - lz4_min_match;
+			if (length_code >= 15)
+			{
+				*token |= 15;
+				int remaining = length_code - 15;
+				for (; remaining >= 255; remaining -= 255)
+					*op++ = 255;
+				*op++ = (unsigned char)remaining;
+			}
+			else
+			{
+				*token |= (unsigned char)length_code;
+			}
+			return true;
+		};
+
+		int ip = 0;
+		int search_count = 1 << 6;
+		int match_end_limit = size - lz4_last_literals;
+		while (ip < size - lz4_match_start_limit)
+		{
+			uint32_t sequence = read_uint32_le(src + ip);
+			uint32_t hash = lz4_hash(sequence);
+			int ref = hash_table[hash];
+			hash_table[hash] = (uint16_t)ip;
+
+			if (ref >= ip || ip - ref > lz4_max_distance || read_uint32_le(src + ref) != sequence)
+			{
+				// Skip faster through data that doesn't match
+				ip += search_count++ >> 6;
+				continue;
+			}
+			search_count = 1 << 6;
+
+			while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1])
+			{
+				ip--;
+				ref--;
+			}
+
+			int match_length = lz4_min_match;
+			while (ip + match_length < match_end_limit && src[ip + match_length] == src[ref + match_length])
+				match_length++;
+
+			if (!emit_sequence(ip - anchor, ip - ref, match_length))
+				return 0;
+
+			ip += match_length;
+			anchor = ip;
+
+			if (ip - 2 < size - lz4_match_start_limit)
+				hash_table[lz4_hash(read_uint32_le(src + ip - 2))] = (uint16_t)(ip - 2);
+		}
+
+		if (!emit_sequence(size - anchor, 0, 0))
+			return 0;
+		return (int)(op - dest);
+	}
+
+	int ZipLZ4::decompress_block(const unsigned char *src, int size, unsigned char *dest, int dest_pos, int dest_capacity)
+	{
+		const unsigned char *ip = src;
+		const unsigned char *iend = src + size;
+		unsigned char *op = dest + dest_pos;
+		unsigned char *oend = dest + dest_capacity;
+
+		while (true)
+		{
+			if (ip >= iend)
+				throw Exception("LZ4 block is truncated");
+
+			unsigned int token = *ip++;
+			size_t literal_length = token >> 4;
+			if (literal_length == 15)
+			{
+				unsigned int value;
+				do
+				{
+					if (ip >= iend)
+						throw Exception("LZ4 block is truncated");
+					value = *ip++;
+					literal_length += value;
+				} while (value == 255);
+			}
+
+			if ((size_t)(iend - ip) < literal_length || (size_t)(oend - op) < literal_length)
+				throw Exception("LZ4 block is corrupted");
+			memcpy(op, ip, literal_length);
+			op += literal_length;
+			ip += literal_length;
+
+			if (ip == iend) // The last sequence ends after its literals
+				break;
+
+			if (iend - ip < 2)
+				throw Exception("LZ4 block is truncated");
+			size_t offset = ip[0] | (ip[1] << 8);
+			ip += 2;
+			if (offset == 0 || offset > (size_t)(op - dest))
+				throw Exception("LZ4 block is corrupted");
+
+			size_t match_length = token & 15;
+			if (match_length == 15)
+			{
+				unsigned int value;
+				do
+				{
+					if (ip >= iend)
+						throw Exception("LZ4 block is truncated");
+					value = *ip++;
+					match_length += value;
+				} while (value == 255);
+			}
+			match_length += lz4_min_match;
+
+			if ((size_t)(oend - op) < match_length)
+				throw Exception("LZ4 block is corrupted");
+
+			const unsigned char *match = op - offset;
+			if (offset >= 8 && (size_t)(oend - op) >= match_length + 8)
+			{
+				// Copy 8 bytes at a time. May write up to 7 bytes past the match, which the check above leaves room for.
+				unsigned char *copy_end = op + match_length;
+				while (op < copy_end)
+				{
+					memcpy(op, match, 8);
+					op += 8;
+					match += 8;
+				}
+				op = copy_end;
+			}
+			else
+			{
+				// Overlapping match repeats the last offset bytes
+				for (size_t i = 0; i < match_length; i++)
+					op[i] = match[i];
+				op += match_length;
+			}
+		}
+
+		return (int)(op - (dest + dest_pos));
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	void ZipLZ4Decoder::begin(IODevice &input, int64_t new_compressed_size)
+	{
+		compressed_size = new_compressed_size;
+		compressed_pos = 0;
+		uncompressed_pos = 0;
+		finished = false;
+		block_start = 0;
+		block_end = 0;
+		read_pos = 0;
+		blocks.clear();
+
+		unsigned char header[6];
+		read_input(input, header, 6);
+		if (read_uint32_le(header) != lz4_frame_magic)
+			throw Exception("Zip file entry is not an LZ4 frame");
+
+		unsigned int flags = header[4];
+		unsigned int block_descriptor = header[5];
+		if ((flags >> 6) != 1)
+			throw Exception("Unsupported LZ4 frame version");
+		if (flags & 0x01)
+			throw Exception("LZ4 frames with dictionaries are not supported");
+
+		independent_blocks = (flags & 0x20) != 0;
+		block_checksums = (flags & 0x10) != 0;
+		content_checksum = (flags & 0x04) != 0;
+
+		int block_size_id = (block_descriptor >> 4) & 7;
+		if (block_size_id < 4)
+			throw Exception("Invalid LZ4 block size");
+		block_max_size = 1 << (8 + 2 * block_size_id);
+
+		unsigned char extra[9];
+		int extra_size = (flags & 0x08) ? 9 : 1; // Optional content size, then the header checksum
+		read_input(input, extra, extra_size);
+
+		int window_size = independent_blocks ? block_max_size : 64 * 1024 + block_max_size;
+		if ((int)window.get_size() != window_size)
+			window = DataBuffer(window_size);
+	}
+
+	int ZipLZ4Decoder::read(IODevice &input, void *data, int size)
+	{
+		char *out = (char *)data;
+		int total = 0;
+		while (total < size)
+		{
+			if (read_pos == block_end)
+			{
+				if (!read_block(input))
+					break;
+				continue;
+			}
+
+			int length = min(size - total, block_end - read_pos);
+			memcpy(out + total, window.get_data() + read_pos, length);
+			read_pos += length;
+			total += length;
+			uncompressed_pos += length;
+		}
+		return total;
+	}
+
+	void ZipLZ4Decoder::finish(IODevice &input)
+	{
+		while (read_block(input))
+			read_pos = block_end;
+	}
+
+	bool ZipLZ4Decoder::read_block(IODevice &input)
+	{
+		if (finished)
+			return false;
+
+		int64_t block_compressed_pos = compressed_pos;
+
+		unsigned char size_bytes[4];
+		read_input(input, size_bytes, 4);
+		uint32_t block_size = read_uint32_le(size_bytes);
+		if (block_size == 0) // End mark
+		{
+			if (content_checksum)
+				read_input(input, size_bytes, 4);
+			finished = true;
+			return false;
+		}
+
+		bool uncompressed = (block_size & lz4_uncompressed_block_flag) != 0;
+		block_size &= ~lz4_uncompressed_block_flag;
+		if (block_size > (uint32_t)block_max_size)
+			throw Exception("LZ4 block exceeds the frame block size");
+
+		int dest_pos = 0;
+		if (!independent_blocks)
+		{
+			// Keep the last 64 KB of output as history for matches in the next block
+			const int history_size = 64 * 1024;
+			if (block_end > history_size)
+			{
+				memmove(window.get_data(), window.get_data() + block_end - history_size, history_size);
+				block_end = history_size;
+			}
+			dest_pos = block_end;
+		}
+		else if (blocks.empty() || blocks.back().uncompressed_pos < uncompressed_pos)
+		{
+			blocks.push_back(ZipLZ4Block(uncompressed_pos, block_compressed_pos));
+		}
+
+		if (block_input.get_size() < block_size)
+			block_input = DataBuffer(block_size);
+		read_input(input, block_input.get_data(), block_size);
+
+		int length;
+		if (uncompressed)
+		{
+			memcpy(window.get_data() + dest_pos, block_input.get_data(), block_size);
+			length = block_size;
+		}
+		else
+		{
+			length = ZipLZ4::decompress_block((const unsigned char *)block_input.get_data(), block_size, (unsigned char *)window.get_data(), dest_pos, dest_pos + block_max_size);
+		}
+
+		if (block_checksums)
+			read_input(input, size_bytes, 4);
+
+		block_start = dest_pos;
+		block_end = dest_pos + length;
+		read_pos = block_start;
+		return true;
+	}
+
+	void ZipLZ4Decoder::read_input(IODevice &input, void *data, int size)
+	{
+		if (compressed_pos + size > compressed_size)
+			throw Exception("LZ4 frame is truncated");
+		if (input.receive(data, size, true) != size)
+			throw Exception("LZ4 frame is truncated");
+		compressed_pos += size;
+	}
+
+	bool ZipLZ4Decoder::find_block(int64_t position, ZipLZ4Block &out_block) const
+	{
+		auto it = std::upper_bound(blocks.begin(), blocks.end(), position, [](int64_t pos, const ZipLZ4Block &block) { return pos < block.uncompressed_pos; });
+		if (it == blocks.begin())
+			return false;
+		out_block = *(it - 1);
+		return true;
+	}
+
+	void ZipLZ4Decoder::restart_at(const ZipLZ4Block &block)
+	{
+		compressed_pos = block.compressed_pos;
+		uncompressed_pos = block.uncompressed_pos;
+		finished = false;
+		block_start = 0;
+		block_end = 0;
+		read_pos = 0;
+	}
+}
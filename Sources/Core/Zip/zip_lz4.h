@@ -0,0 +1,139 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#pragma once
+
+#include "API/Core/IOData/iodevice.h"
+#include "API/Core/System/databuffer.h"
+#include <vector>
+
+namespace clan
+{
+	/// \brief LZ4 frame format codec for zip entries
+	///
+	/// Entries are written as a standard LZ4 frame (version 1, independent 64 KB blocks, no checksums), so the
+	/// payload can be extracted with the lz4 command line tool.
+	class ZipLZ4
+	{
+	public:
+		static const int block_size = 64 * 1024;
+		static const int frame_header_size = 7;
+		static const int end_mark_size = 4;
+
+		/// \brief Returns the worst case size of compress_blocks output for size bytes
+		static int64_t compress_bound(int64_t size);
+
+		/// \brief Writes the frame header
+		static void write_frame_header(void *out_header);
+
+		/// \brief Compresses data into a sequence of frame blocks (without frame header and end mark)
+		///
+		/// \return Number of bytes written to dest
+		static int64_t compress_blocks(const void *data, int64_t size, void *dest);
+
+		/// \brief Compresses one block of at most block_size bytes
+		///
+		/// \return Compressed size, or 0 if the data did not fit in dest_capacity
+		static int compress_block(const unsigned char *src, int size, unsigned char *dest, int dest_capacity);
+
+		/// \brief Decompresses one block to dest + dest_pos
+		///
+		/// Matches may reference the dest_pos bytes before the output, which is how linked blocks refer to the previous block.
+		/// \return Decompressed size
+		static int decompress_block(const unsigned char *src, int size, unsigned char *dest, int dest_pos, int dest_capacity);
+	};
+
+	class ZipLZ4Block
+	{
+	public:
+		ZipLZ4Block(int64_t uncompressed_pos, int64_t compressed_pos) : uncompressed_pos(uncompressed_pos), compressed_pos(compressed_pos) { }
+
+		int64_t uncompressed_pos;
+		int64_t compressed_pos;
+	};
+
+	/// \brief Streaming LZ4 frame decoder reading from an IODevice
+	///
+	/// Never reads past the current block, so the device position always matches get_compressed_pos().
+	class ZipLZ4Decoder
+	{
+	public:
+		/// \brief Reads the frame header
+		void begin(IODevice &input, int64_t compressed_size);
+
+		/// \brief Decompresses up to size bytes
+		///
+		/// \return Bytes decompressed, less than size only at the end of the frame
+		int read(IODevice &input, void *data, int size);
+
+		/// \brief Skips the rest of the frame, including the end mark and content checksum
+		///
+		/// Leaves the input device positioned directly after the frame.
+		void finish(IODevice &input);
+
+		/// \brief Compressed bytes consumed since the start of the frame
+		int64_t get_compressed_pos() const { return compressed_pos; }
+
+		/// \brief Uncompressed bytes returned by read since the start of the frame
+		int64_t get_uncompressed_pos() const { return uncompressed_pos; }
+
+		/// \brief Returns true once the end mark has been read
+		bool is_finished() const { return finished; }
+
+		/// \brief Finds the last known block starting at or before uncompressed_pos
+		///
+		/// Blocks are only recorded for frames with independent blocks, as only those can be decoded in isolation.
+		bool find_block(int64_t uncompressed_pos, ZipLZ4Block &out_block) const;
+
+		/// \brief Continues decoding at a block returned by find_block. The input device must be positioned at the block.
+		void restart_at(const ZipLZ4Block &block);
+
+	private:
+		bool read_block(IODevice &input);
+		void read_input(IODevice &input, void *data, int size);
+
+		int64_t compressed_size = 0;
+		int64_t compressed_pos = 0;
+		int64_t uncompressed_pos = 0;
+		int block_max_size = 0;
+		bool independent_blocks = true;
+		bool block_checksums = false;
+		bool content_checksum = false;
+		bool finished = false;
+
+		// Decoded data. Linked blocks keep the previous 64 KB in front of the current block
+		DataBuffer window;
+		int block_start = 0;
+		int block_end = 0;
+		int read_pos = 0;
+		DataBuffer block_input;
+
+		std::vector<ZipLZ4Block> blocks;
+	};
+}
@@ -33,6 +33,8 @@
 #include "zip_compression_method.h"
 #include "API/Core/Math/cl_math.h"
 #include "Core/Zip/miniz.h"
+#include "zip_lz4.h"
+#include <limits>
 
 namespace clan
 {
@@ -40,7 +42,7 @@ namespace clan
 	{
 	public:
 		ZipReader_Impl(IODevice &input)
-			: input(input), zstream_open(false), compressed_pos(0)
+			: input(input), zstream_open(false), compressed_pos(0), lz4_open(false), lz4_begun(false)
 		{
 		}
 
@@ -51,6 +53,8 @@ namespace clan
 		}
 
 		int64_t deflate_read(void *data, int64_t size, bool read_all);
+		void begin_lz4();
+		void finish_lz4();
 
 		IODevice input;
 		ZipLocalFileHeader local_header;
@@ -58,6 +62,9 @@ namespace clan
 		char zbuffer[16 * 1024];
 		bool zstream_open;
 		int64_t compressed_pos;
+		bool lz4_open;
+		bool lz4_begun;
+		ZipLZ4Decoder lz4_decoder;
 	};
 
 	ZipReader::ZipReader(IODevice &input)
@@ -67,6 +74,10 @@ namespace clan
 
 	bool ZipReader::read_local_file_header(bool allow_data_descriptor)
 	{
+		// An LZ4 entry that was not read to the end still has its frame in front of the next header
+		if (impl->lz4_open)
+			impl->finish_lz4();
+
 		try
 		{
 			impl->local_header.load(impl->input);
@@ -85,6 +96,7 @@ namespace clan
 		if (impl->zstream_open)
 			mz_inflateEnd(&impl->zs);
 		impl->zstream_open = false;
+		impl->lz4_open = false;
 
 		if (impl->local_header.compression_method == zip_compress_deflate)
 		{
@@ -95,6 +107,12 @@ namespace clan
 			impl->zstream_open = true;
 			impl->compressed_pos = 0;
 		}
+		else if (impl->local_header.compression_method == zip_compress_lz4)
+		{
+			// The frame header is read with the first data, after set_data_descriptor_data has had a chance to supply the sizes
+			impl->lz4_open = true;
+			impl->lz4_begun = false;
+		}
 		else if (impl->local_header.compression_method != zip_compress_store)
 		{
 			throw Exception("Zip file entry is compressed with an unsupported compression method");
@@ -136,6 +154,18 @@ namespace clan
 		{
 			return impl->deflate_read(data, size, read_all);
 		}
+		else if (impl->lz4_open)
+		{
+			impl->begin_lz4();
+			int64_t received = impl->lz4_decoder.read(impl->input, data, (int)size);
+
+			// Consume the frame trailer as soon as the entry is complete, so the input is positioned at
+			// the data descriptor or next header
+			bool size_known = !has_data_descriptor() || impl->local_header.uncompressed_size != 0;
+			if (size_known && impl->lz4_decoder.get_uncompressed_pos() >= impl->local_header.uncompressed_size)
+				impl->finish_lz4();
+			return received;
+		}
 		else
 		{
 			return impl->input.read(data, size, read_all);
@@ -144,6 +174,24 @@ namespace clan
 
 	/////////////////////////////////////////////////////////////////////////////
 
+	void ZipReader_Impl::begin_lz4()
+	{
+		if (!lz4_begun)
+		{
+			// LZ4 frames end with an end mark, so the compressed size is only needed as a bound
+			bool size_known = !(local_header.general_purpose_bit_flag & ZIP_CRC32_IN_FILE_DESCRIPTOR) || local_header.compressed_size != 0;
+			lz4_decoder.begin(input, size_known ? local_header.compressed_size : std::numeric_limits<int64_t>::max());
+			lz4_begun = true;
+		}
+	}
+
+	void ZipReader_Impl::finish_lz4()
+	{
+		begin_lz4();
+		if (!lz4_decoder.is_finished())
+			lz4_decoder.finish(input);
+	}
+
 	int64_t ZipReader_Impl::deflate_read(void *data, int64_t size, bool read_all)
 	{
 		zs.next_out = (unsigned char *)data;
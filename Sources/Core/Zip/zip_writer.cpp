@@ -29,6 +29,8 @@
 #include "Core/precomp.h"
 #include "API/Core/Zip/zip_writer.h"
 #include "API/Core/Text/string_help.h"
+#include "API/Core/System/databuffer.h"
+#include "API/Core/System/task.h"
 #include "zip_archive_impl.h"
 #include "zip_local_file_header.h"
 #include "zip_compression_method.h"
@@ -36,21 +38,41 @@
 #include "zip_end_of_central_directory_record.h"
 #include "zip_flags.h"
 #include "Core/Zip/miniz.h"
+#include "zip_lz4.h"
+#include <deque>
 
 namespace clan
 {
+	class ZipWriterChunk
+	{
+	public:
+		DataBuffer compressed;
+		uint32_t crc32 = 0;
+		int64_t size = 0;
+	};
+
+	class ZipWriterPendingFile
+	{
+	public:
+		ZipLocalFileHeader local_header;
+		DataBuffer data;
+		ZipCompressionMethod method = zip_compress_store;
+		std::vector<ZipWriterChunk> chunks;
+		std::vector<Task> tasks;
+	};
+
 	class ZipWriter_Impl
 	{
 	public:
-		ZipWriter_Impl(IODevice &output, bool storeFilenamesAsUTF8)
-			: output(output), storeFilenamesAsUTF8(storeFilenamesAsUTF8), file_begun(false),
-			local_header_offset(0), uncompressed_length(0), compressed_length(0), compress(false)
+		ZipWriter_Impl(IODevice &output, WorkQueue *queue, bool storeFilenamesAsUTF8)
+			: output(output), queue(queue), storeFilenamesAsUTF8(storeFilenamesAsUTF8), file_begun(false),
+			local_header_offset(0), uncompressed_length(0), compressed_length(0), method(zip_compress_store)
 		{
 		}
 
 		~ZipWriter_Impl()
 		{
-			if (file_begun && compress)
+			if (file_begun && method == zip_compress_deflate && !queue)
 			{
 				mz_deflateEnd(&zs);
 			}
@@ -62,78 +84,114 @@ namespace clan
 			int64_t local_header_offset;
 		};
 
+		ZipCompressionMethod get_method(ZipWriter::CompressionMethod method) const;
+		void init_local_header(const std::string &filename, ZipCompressionMethod method);
+
+		void write_lz4_blocks(const void *data, int64_t size);
+
+		void queue_file(const DataBuffer &data, ZipCompressionMethod method);
+		void write_completed_files();
+		void write_pending_file();
+		void write_buffered_file(const ZipLocalFileHeader &header, const DataBuffer &data, ZipCompressionMethod method, const std::vector<ZipWriterChunk> &chunks);
+
+		static void compress_chunk(const char *data, int64_t size, bool last_chunk, int level, ZipCompressionMethod method, ZipWriterChunk &out_chunk);
+		static void throw_if_deflate_failed(int result);
+
+		// Parallel mode splits each entry into chunks of this size
+		static const int chunk_size = 256 * 1024;
+
+		// Parallel mode stops queueing new entries once the entries waiting to be written exceed this many bytes
+		static const int64_t max_pending_bytes = 64 * 1024 * 1024;
+
 		IODevice output;
+		WorkQueue *queue;
 		bool storeFilenamesAsUTF8;
+		int compression_level = MZ_DEFAULT_LEVEL;
+		bool store_incompressible = true;
 		bool file_begun;
 		ZipLocalFileHeader local_header;
 		int64_t local_header_offset;
 		int64_t uncompressed_length;
 		int64_t compressed_length;
 		uint32_t crc32;
-		bool compress;
+		ZipCompressionMethod method;
 		mz_stream zs;
 		char zbuffer[16 * 1024];
+		DataBuffer lz4_block;
+		DataBuffer lz4_output;
 		std::vector<FileEntry> written_files;
+
+		DataBuffer file_data;
+		std::deque<std::shared_ptr<ZipWriterPendingFile>> pending_files;
+		int64_t pending_bytes = 0;
 	};
 
 	ZipWriter::ZipWriter(IODevice &output, bool storeFilenamesAsUTF8)
-		: impl(std::make_shared<ZipWriter_Impl>(output, storeFilenamesAsUTF8))
+		: impl(std::make_shared<ZipWriter_Impl>(output, nullptr, storeFilenamesAsUTF8))
+	{
+	}
+
+	ZipWriter::ZipWriter(IODevice &output, WorkQueue &queue, bool storeFilenamesAsUTF8)
+		: impl(std::make_shared<ZipWriter_Impl>(output, &queue, storeFilenamesAsUTF8))
+	{
+	}
+
+	void ZipWriter::set_compression_level(int level)
+	{
+		if (level < 0 || level > 9)
+			throw Exception("Zip compression level must be between 0 and 9");
+		impl->compression_level = level;
+	}
+
+	int ZipWriter::get_compression_level() const
+	{
+		return impl->compression_level;
+	}
+
+	void ZipWriter::set_store_incompressible(bool enable)
 	{
+		impl->store_incompressible = enable;
 	}
 
 	void ZipWriter::begin_file(const std::string &filename, bool compress)
+	{
+		begin_file(filename, compress ? compress_deflate : compress_store);
+	}
+
+	void ZipWriter::begin_file(const std::string &filename, CompressionMethod compression_method)
 	{
 		if (impl->file_begun)
 			throw Exception("ZipWriter already writing a file");
-		impl->file_begun = true;
 
+		ZipCompressionMethod method = impl->get_method(compression_method);
+		impl->file_begun = true;
 		impl->uncompressed_length = 0;
 		impl->compressed_length = 0;
-		impl->compress = compress;
+		impl->method = method;
 		impl->crc32 = ZIP_CRC_START_VALUE;
+		impl->init_local_header(filename, method);
 
-		impl->local_header_offset = impl->output.get_position();
-		impl->local_header = ZipLocalFileHeader();
-		impl->local_header.version_needed_to_extract = 20;
-		if (impl->storeFilenamesAsUTF8)
-			impl->local_header.general_purpose_bit_flag = ZIP_USE_UTF8;
-		else
-			impl->local_header.general_purpose_bit_flag = 0;
-		impl->local_header.compression_method = compress ? zip_compress_deflate : zip_compress_store;
-		ZipArchive_Impl::calc_time_and_date(
-			impl->local_header.last_mod_file_date,
-			impl->local_header.last_mod_file_time);
-		impl->local_header.crc32 = 0;
-		impl->local_header.uncompressed_size = 0;
-		impl->local_header.compressed_size = 0;
-		impl->local_header.file_name_length = filename.length();
-		impl->local_header.filename = filename;
-
-		if (!impl->storeFilenamesAsUTF8) // Add UTF-8 as extra field if we aren't storing normal UTF-8 filenames
+		if (impl->queue)
 		{
-			// -Info-ZIP Unicode Path Extra Field (0x7075)
-			std::string filename_cp437 = StringHelp::text_to_cp437(filename);
-			std::string filename_utf8 = StringHelp::text_to_utf8(filename);
-			DataBuffer unicode_path(9 + filename_utf8.length());
-			uint16_t *extra_id = (uint16_t *)(unicode_path.get_data());
-			uint16_t *extra_len = (uint16_t *)(unicode_path.get_data() + 2);
-			uint8_t *extra_version = (uint8_t *)(unicode_path.get_data() + 4);
-			uint32_t *extra_crc32 = (uint32_t *)(unicode_path.get_data() + 5);
-			*extra_id = 0x7075;
-			*extra_len = 5 + filename_utf8.length();
-			*extra_version = 1;
-			*extra_crc32 = ZipArchive_Impl::calc_crc32(filename_cp437.data(), filename_cp437.size());
-			memcpy(unicode_path.get_data() + 9, filename_utf8.data(), filename_utf8.length());
-			impl->local_header.extra_field_length = unicode_path.get_size();
-			impl->local_header.extra_field = unicode_path;
+			impl->file_data = DataBuffer();
+			return;
 		}
 
+		impl->local_header_offset = impl->output.get_position();
 		impl->local_header.save(impl->output);
 
-		if (compress)
+		if (method == zip_compress_lz4)
+		{
+			char frame_header[ZipLZ4::frame_header_size];
+			ZipLZ4::write_frame_header(frame_header);
+			impl->output.write(frame_header, ZipLZ4::frame_header_size);
+			impl->compressed_length += ZipLZ4::frame_header_size;
+			impl->lz4_block.set_size(0);
+		}
+		else if (method == zip_compress_deflate)
 		{
 			memset(&impl->zs, 0, sizeof(mz_stream));
-			int result = mz_deflateInit2(&impl->zs, MZ_DEFAULT_COMPRESSION, MZ_DEFLATED, -15, 8, MZ_DEFAULT_STRATEGY); // Undocumented: if wbits is negative, zlib skips header check
+			int result = mz_deflateInit2(&impl->zs, impl->compression_level, MZ_DEFLATED, -15, 8, MZ_DEFAULT_STRATEGY); // Undocumented: if wbits is negative, zlib skips header check
 			if (result != MZ_OK)
 				throw Exception("Zlib deflateInit failed for zip index!");
 		}
@@ -146,7 +204,49 @@ namespace clan
 
 		impl->uncompressed_length += size;
 
-		if (impl->compress)
+		if (impl->queue)
+		{
+			unsigned int pos = impl->file_data.get_size();
+			if (impl->uncompressed_length > 0xffffffff)
+				throw Exception("Zip file entry too large");
+			if (impl->uncompressed_length > impl->file_data.get_capacity())
+				impl->file_data.set_capacity((unsigned int)std::min(std::max(impl->uncompressed_length, (int64_t)impl->file_data.get_capacity() * 2), (int64_t)0xffffffff));
+			impl->file_data.set_size((unsigned int)impl->uncompressed_length);
+			memcpy(impl->file_data.get_data() + pos, data, size);
+			return;
+		}
+
+		impl->crc32 = ZipArchive_Impl::calc_crc32(data, size, impl->crc32, false);
+
+		if (impl->method == zip_compress_lz4)
+		{
+			const char *d = (const char *)data;
+			while (size > 0)
+			{
+				unsigned int block_pos = impl->lz4_block.get_size();
+				if (block_pos == 0 && size >= ZipLZ4::block_size)
+				{
+					// Compress whole blocks straight from the caller's data
+					int64_t length = size - size % ZipLZ4::block_size;
+					impl->write_lz4_blocks(d, length);
+					d += length;
+					size -= length;
+					continue;
+				}
+
+				unsigned int length = (unsigned int)std::min((int64_t)(ZipLZ4::block_size - block_pos), size);
+				impl->lz4_block.set_size(block_pos + length);
+				memcpy(impl->lz4_block.get_data() + block_pos, d, length);
+				d += length;
+				size -= length;
+				if (impl->lz4_block.get_size() == ZipLZ4::block_size)
+				{
+					impl->write_lz4_blocks(impl->lz4_block.get_data(), ZipLZ4::block_size);
+					impl->lz4_block.set_size(0);
+				}
+			}
+		}
+		else if (impl->method == zip_compress_deflate)
 		{
 			impl->zs.next_in = (unsigned char *)data;
 			impl->zs.avail_in = size;
@@ -156,11 +256,7 @@ namespace clan
 				impl->zs.next_out = (unsigned char *)impl->zbuffer;
 				impl->zs.avail_out = 16 * 1024;
 				int result = mz_deflate(&impl->zs, MZ_NO_FLUSH);
-				if (result == MZ_NEED_DICT) throw Exception("Zlib deflate wants a dictionary!");
-				if (result == MZ_DATA_ERROR) throw Exception("Zip data stream is corrupted");
-				if (result == MZ_STREAM_ERROR) throw Exception("Zip stream structure was inconsistent!");
-				if (result == MZ_MEM_ERROR) throw Exception("Zlib did not have enough memory to compress file!");
-				if (result == MZ_BUF_ERROR) throw Exception("Not enough data in buffer when Z_FINISH was used");
+				ZipWriter_Impl::throw_if_deflate_failed(result);
 				if (result != MZ_OK) throw Exception("Zlib deflate failed while compressing zip file!");
 
 				int64_t zsize = 16 * 1024 - impl->zs.avail_out;
@@ -176,8 +272,6 @@ namespace clan
 			impl->compressed_length += size;
 			impl->output.write(data, size);
 		}
-
-		impl->crc32 = ZipArchive_Impl::calc_crc32(data, size, impl->crc32, false);
 	}
 
 	void ZipWriter::end_file()
@@ -185,7 +279,26 @@ namespace clan
 		if (!impl->file_begun)
 			return;
 
-		if (impl->compress)
+		if (impl->queue)
+		{
+			impl->file_begun = false;
+			DataBuffer data = impl->file_data;
+			impl->file_data = DataBuffer();
+			impl->queue_file(data, impl->method);
+			return;
+		}
+
+		if (impl->method == zip_compress_lz4)
+		{
+			if (impl->lz4_block.get_size() > 0)
+				impl->write_lz4_blocks(impl->lz4_block.get_data(), impl->lz4_block.get_size());
+			impl->lz4_block.set_size(0);
+
+			char end_mark[ZipLZ4::end_mark_size] = { 0 };
+			impl->output.write(end_mark, ZipLZ4::end_mark_size);
+			impl->compressed_length += ZipLZ4::end_mark_size;
+		}
+		else if (impl->method == zip_compress_deflate)
 		{
 			impl->zs.next_in = nullptr;
 			impl->zs.avail_in = 0;
@@ -195,11 +308,7 @@ namespace clan
 				impl->zs.next_out = (unsigned char *)impl->zbuffer;
 				impl->zs.avail_out = 16 * 1024;
 				int result = mz_deflate(&impl->zs, MZ_FINISH);
-				if (result == MZ_NEED_DICT) throw Exception("Zlib deflate wants a dictionary!");
-				if (result == MZ_DATA_ERROR) throw Exception("Zip data stream is corrupted");
-				if (result == MZ_STREAM_ERROR) throw Exception("Zip stream structure was inconsistent!");
-				if (result == MZ_MEM_ERROR) throw Exception("Zlib did not have enough memory to compress file!");
-				if (result == MZ_BUF_ERROR) throw Exception("Not enough data in buffer when Z_FINISH was used");
+				ZipWriter_Impl::throw_if_deflate_failed(result);
 				if (result != MZ_OK && result != MZ_STREAM_END) throw Exception("Zlib deflate failed while compressing zip file!");
 				int64_t zsize = 16 * 1024 - impl->zs.avail_out;
 				if (zsize == 0)
@@ -212,8 +321,8 @@ namespace clan
 			}
 
 			mz_deflateEnd(&impl->zs);
-			impl->compress = false;
 		}
+		impl->method = zip_compress_store;
 
 		impl->local_header.uncompressed_size = impl->uncompressed_length;
 		impl->local_header.compressed_size = impl->compressed_length;
@@ -232,11 +341,39 @@ namespace clan
 		impl->file_begun = false;
 	}
 
+	void ZipWriter::add_file(const std::string &filename, const DataBuffer &data, bool compress)
+	{
+		add_file(filename, data, compress ? compress_deflate : compress_store);
+	}
+
+	void ZipWriter::add_file(const std::string &filename, const DataBuffer &data, CompressionMethod compression_method)
+	{
+		if (impl->file_begun)
+			throw Exception("ZipWriter already writing a file");
+
+		ZipCompressionMethod method = impl->get_method(compression_method);
+		impl->init_local_header(filename, method);
+
+		if (impl->queue)
+		{
+			impl->queue_file(data, method);
+		}
+		else
+		{
+			std::vector<ZipWriterChunk> chunks(1);
+			ZipWriter_Impl::compress_chunk(data.get_data(), data.get_size(), true, impl->compression_level, method, chunks[0]);
+			impl->write_buffered_file(impl->local_header, data, method, chunks);
+		}
+	}
+
 	void ZipWriter::write_toc()
 	{
 		if (impl->file_begun)
 			throw Exception("Cannot write zip TOC when already writing a file entry");
 
+		while (!impl->pending_files.empty())
+			impl->write_pending_file();
+
 		int64_t offset_start_central_dir = impl->output.get_position();
 
 		// write central directory entries.
@@ -282,4 +419,232 @@ namespace clan
 		central_dir_end.file_comment = "";
 		central_dir_end.save(impl->output);
 	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	ZipCompressionMethod ZipWriter_Impl::get_method(ZipWriter::CompressionMethod method) const
+	{
+		if (compression_level == 0)
+			return zip_compress_store;
+
+		switch (method)
+		{
+		case ZipWriter::compress_store:
+			return zip_compress_store;
+		case ZipWriter::compress_deflate:
+			return zip_compress_deflate;
+		case ZipWriter::compress_lz4:
+			return zip_compress_lz4;
+		}
+		throw Exception("Unknown zip compression method");
+	}
+
+	void ZipWriter_Impl::init_local_header(const std::string &filename, ZipCompressionMethod method)
+	{
+		local_header = ZipLocalFileHeader();
+		local_header.version_needed_to_extract = 20;
+		if (storeFilenamesAsUTF8)
+			local_header.general_purpose_bit_flag = ZIP_USE_UTF8;
+		else
+			local_header.general_purpose_bit_flag = 0;
+		local_header.compression_method = method;
+		ZipArchive_Impl::calc_time_and_date(
+			local_header.last_mod_file_date,
+			local_header.last_mod_file_time);
+		local_header.crc32 = 0;
+		local_header.uncompressed_size = 0;
+		local_header.compressed_size = 0;
+		local_header.file_name_length = filename.length();
+		local_header.filename = filename;
+
+		if (!storeFilenamesAsUTF8) // Add UTF-8 as extra field if we aren't storing normal UTF-8 filenames
+		{
+			// -Info-ZIP Unicode Path Extra Field (0x7075)
+			std::string filename_cp437 = StringHelp::text_to_cp437(filename);
+			std::string filename_utf8 = StringHelp::text_to_utf8(filename);
+			DataBuffer unicode_path(9 + filename_utf8.length());
+			uint16_t *extra_id = (uint16_t *)(unicode_path.get_data());
+			uint16_t *extra_len = (uint16_t *)(unicode_path.get_data() + 2);
+			uint8_t *extra_version = (uint8_t *)(unicode_path.get_data() + 4);
+			uint32_t *extra_crc32 = (uint32_t *)(unicode_path.get_data() + 5);
+			*extra_id = 0x7075;
+			*extra_len = 5 + filename_utf8.length();
+			*extra_version = 1;
+			*extra_crc32 = ZipArchive_Impl::calc_crc32(filename_cp437.data(), filename_cp437.size());
+			memcpy(unicode_path.get_data() + 9, filename_utf8.data(), filename_utf8.length());
+			local_header.extra_field_length = unicode_path.get_size();
+			local_header.extra_field = unicode_path;
+		}
+	}
+
+	void ZipWriter_Impl::write_lz4_blocks(const void *data, int64_t size)
+	{
+		if (lz4_output.get_size() < ZipLZ4::compress_bound(size))
+			lz4_output = DataBuffer((unsigned int)ZipLZ4::compress_bound(size));
+		int64_t length = ZipLZ4::compress_blocks(data, size, lz4_output.get_data());
+		output.write(lz4_output.get_data(), length);
+		compressed_length += length;
+	}
+
+	void ZipWriter_Impl::queue_file(const DataBuffer &data, ZipCompressionMethod method)
+	{
+		auto file = std::make_shared<ZipWriterPendingFile>();
+		file->local_header = local_header;
+		file->data = data;
+		file->method = method;
+
+		// Each chunk is compressed on its own. Deflate chunks other than the last end with a sync flush so that the concatenated chunks form a single deflate stream.
+		// LZ4 chunks are a whole number of independent blocks.
+		int64_t size = data.get_size();
+		int num_chunks = (int)std::max((size + chunk_size - 1) / chunk_size, (int64_t)1);
+		file->chunks.resize(num_chunks);
+		int level = compression_level;
+		for (int i = 0; i < num_chunks; i++)
+		{
+			int64_t offset = (int64_t)i * chunk_size;
+			int64_t length = std::min((int64_t)chunk_size, size - offset);
+			bool last_chunk = (i + 1 == num_chunks);
+			file->tasks.push_back(Task::run_async(*queue, [=]()
+			{
+				compress_chunk(file->data.get_data() + offset, length, last_chunk, level, file->method, file->chunks[i]);
+			}));
+		}
+
+		pending_files.push_back(file);
+		pending_bytes += size;
+
+		write_completed_files();
+		while (pending_bytes > max_pending_bytes && !pending_files.empty())
+			write_pending_file();
+	}
+
+	void ZipWriter_Impl::write_completed_files()
+	{
+		while (!pending_files.empty())
+		{
+			for (const auto &task : pending_files.front()->tasks)
+			{
+				if (!task.is_completed())
+					return;
+			}
+			write_pending_file();
+		}
+	}
+
+	void ZipWriter_Impl::write_pending_file()
+	{
+		std::shared_ptr<ZipWriterPendingFile> file = pending_files.front();
+		pending_files.pop_front();
+		pending_bytes -= file->data.get_size();
+
+		for (const auto &task : file->tasks)
+			task.wait();
+
+		write_buffered_file(file->local_header, file->data, file->method, file->chunks);
+	}
+
+	void ZipWriter_Impl::write_buffered_file(const ZipLocalFileHeader &header, const DataBuffer &data, ZipCompressionMethod method, const std::vector<ZipWriterChunk> &chunks)
+	{
+		uint32_t crc = chunks[0].crc32;
+		int64_t compressed_size = chunks[0].compressed.get_size();
+		for (size_t i = 1; i < chunks.size(); i++)
+		{
+			crc = ZipArchive_Impl::crc32_combine(crc, chunks[i].crc32, chunks[i].size);
+			compressed_size += chunks[i].compressed.get_size();
+		}
+
+		if (method == zip_compress_lz4)
+			compressed_size += ZipLZ4::frame_header_size + ZipLZ4::end_mark_size;
+
+		if (method != zip_compress_store && store_incompressible && compressed_size >= data.get_size())
+			method = zip_compress_store;
+
+		FileEntry file_entry;
+		file_entry.local_header = header;
+		file_entry.local_header.compression_method = method;
+		file_entry.local_header.crc32 = crc;
+		file_entry.local_header.uncompressed_size = data.get_size();
+		file_entry.local_header.compressed_size = method != zip_compress_store ? compressed_size : data.get_size();
+		file_entry.local_header_offset = output.get_position();
+		file_entry.local_header.save(output);
+
+		if (method == zip_compress_lz4)
+		{
+			char frame_header[ZipLZ4::frame_header_size];
+			ZipLZ4::write_frame_header(frame_header);
+			output.write(frame_header, ZipLZ4::frame_header_size);
+			for (const auto &chunk : chunks)
+				output.write(chunk.compressed.get_data(), chunk.compressed.get_size());
+			char end_mark[ZipLZ4::end_mark_size] = { 0 };
+			output.write(end_mark, ZipLZ4::end_mark_size);
+		}
+		else if (method == zip_compress_deflate)
+		{
+			for (const auto &chunk : chunks)
+				output.write(chunk.compressed.get_data(), chunk.compressed.get_size());
+		}
+		else
+		{
+			output.write(data.get_data(), data.get_size());
+		}
+
+		written_files.push_back(file_entry);
+	}
+
+	void ZipWriter_Impl::compress_chunk(const char *data, int64_t size, bool last_chunk, int level, ZipCompressionMethod method, ZipWriterChunk &out_chunk)
+	{
+		out_chunk.size = size;
+		out_chunk.crc32 = ZipArchive_Impl::calc_crc32(data, size);
+		if (method == zip_compress_store)
+			return;
+
+		if (method == zip_compress_lz4)
+		{
+			DataBuffer compressed((unsigned int)ZipLZ4::compress_bound(size));
+			compressed.set_size((unsigned int)ZipLZ4::compress_blocks(data, size, compressed.get_data()));
+			out_chunk.compressed = compressed;
+			return;
+		}
+
+		mz_stream zs;
+		memset(&zs, 0, sizeof(mz_stream));
+		int result = mz_deflateInit2(&zs, level, MZ_DEFLATED, -15, 8, MZ_DEFAULT_STRATEGY);
+		if (result != MZ_OK)
+			throw Exception("Zlib deflateInit failed for zip index!");
+
+		DataBuffer compressed(mz_deflateBound(&zs, size) + 64);
+		zs.next_in = (const unsigned char *)data;
+		zs.avail_in = size;
+
+		int flush = last_chunk ? MZ_FINISH : MZ_SYNC_FLUSH;
+		while (true)
+		{
+			zs.next_out = (unsigned char *)compressed.get_data() + zs.total_out;
+			zs.avail_out = compressed.get_size() - zs.total_out;
+			result = mz_deflate(&zs, flush);
+			if (result == MZ_STREAM_END || (result == MZ_OK && zs.avail_in == 0 && zs.avail_out > 0 && !last_chunk))
+				break;
+
+			if (result != MZ_OK && result != MZ_BUF_ERROR)
+			{
+				mz_deflateEnd(&zs);
+				throw_if_deflate_failed(result);
+				throw Exception("Zlib deflate failed while compressing zip file!");
+			}
+			compressed.set_size(compressed.get_size() * 2);
+		}
+
+		compressed.set_size(zs.total_out);
+		mz_deflateEnd(&zs);
+		out_chunk.compressed = compressed;
+	}
+
+	void ZipWriter_Impl::throw_if_deflate_failed(int result)
+	{
+		if (result == MZ_NEED_DICT) throw Exception("Zlib deflate wants a dictionary!");
+		if (result == MZ_DATA_ERROR) throw Exception("Zip data stream is corrupted");
+		if (result == MZ_STREAM_ERROR) throw Exception("Zip stream structure was inconsistent!");
+		if (result == MZ_MEM_ERROR) throw Exception("Zlib did not have enough memory to compress file!");
+		if (result == MZ_BUF_ERROR) throw Exception("Not enough data in buffer when Z_FINISH was used");
+	}
 }
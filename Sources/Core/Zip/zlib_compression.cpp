@@ -33,9 +33,27 @@
 
 #define INCLUDED_FROM_ZLIB_COMPRESSION_CPP
 #include "miniz.h"
+#include "zip_inflate_index.h"
 
 namespace clan
 {
+	// The inflate state is only declared in the miniz implementation, so the checkpoint helpers live here
+
+	int zip_inflate_state_size()
+	{
+		return sizeof(inflate_state);
+	}
+
+	void zip_inflate_save_state(const mz_stream *zs, void *state)
+	{
+		memcpy(state, zs->state, sizeof(inflate_state));
+	}
+
+	void zip_inflate_restore_state(mz_stream *zs, const void *state)
+	{
+		memcpy(zs->state, state, sizeof(inflate_state));
+	}
+
 	DataBuffer ZLibCompression::compress(const DataBuffer &data, bool raw, int compression_level, CompressionMode mode)
 	{
 		const int window_bits = 15;
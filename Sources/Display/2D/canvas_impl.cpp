@@ -33,6 +33,7 @@
 #include "API/Display/Render/shared_gc_data.h"
 #include "API/Display/TargetProviders/graphic_context_provider.h"
 #include "API/Display/2D/gradient.h"
+#include "API/Core/System/profiler.h"
 
 namespace clan
 {
@@ -109,6 +110,7 @@ namespace clan
 
 	void Canvas_Impl::flush()
 	{
+		ProfileZone zone("Canvas::flush");
 		batcher.flush();
 	}
 
@@ -72,6 +72,14 @@ namespace clan
 
 	void PNGLoader::read_chunks()
 	{
+		const unsigned char *mapped_data = static_cast<const unsigned char *>(file.get_mapped_data());
+		if (mapped_data)
+		{
+			int position = file.get_position();
+			read_chunks_in_place(mapped_data + position, file.get_size() - position);
+			return;
+		}
+
 		file.set_big_endian_mode();
 
 		std::map<std::string, DataBuffer> chunks;
@@ -133,6 +141,76 @@ namespace clan
 			throw Exception("Invalid PNG image file");
 	}
 
+	void PNGLoader::read_chunks_in_place(const unsigned char *data, int size)
+	{
+		// Same as read_chunks, except the IDAT chunks are checked and concatenated straight from the mapped file
+		std::map<std::string, DataBuffer> chunks;
+
+		std::vector<std::pair<const unsigned char *, unsigned int>> idat_chunks;
+		uint64_t total_idat_size = 0;
+
+		int pos = 0;
+		while (true)
+		{
+			if (size - pos < 12)
+				throw Exception("Invalid PNG image file");
+
+			unsigned int length = from_network_order(*reinterpret_cast<const unsigned int*>(data + pos));
+			char name[5];
+			memcpy(name, data + pos + 4, 4);
+			name[4] = 0;
+			const unsigned char *chunk_data = data + pos + 8;
+
+			if (length > (unsigned int)(size - pos - 12))
+				throw Exception("Invalid PNG image file");
+
+			unsigned int crc32 = from_network_order(*reinterpret_cast<const unsigned int*>(chunk_data + length));
+			unsigned int compare_crc32 = PNGCRC32::crc(name, chunk_data, length);
+			if (crc32 != compare_crc32)
+				throw Exception("CRC32 error");
+
+			pos += length + 12;
+
+			if (name == std::string("IDAT"))
+			{
+				total_idat_size += length;
+				idat_chunks.push_back(std::make_pair(chunk_data, length));
+			}
+			else
+			{
+				chunks[name] = DataBuffer(chunk_data, length);
+				if (name == std::string("IEND"))
+					break;
+			}
+		}
+
+		if (total_idat_size >= (1 << 31))
+			throw Exception("PNG image file too big!");
+
+		idat = DataBuffer((int)total_idat_size);
+		int idat_pos = 0;
+		for (auto & idat_chunk : idat_chunks)
+		{
+			memcpy(idat.get_data() + idat_pos, idat_chunk.first, idat_chunk.second);
+			idat_pos += idat_chunk.second;
+		}
+
+		file.seek(pos, IODevice::seek_cur);
+
+		ihdr = chunks["IHDR"];
+		plte = chunks["PLTE"];
+
+		trns = chunks["tRNS"];
+		chrm = chunks["cHRM"];
+		gama = chunks["gAMA"];
+		iccp = chunks["iCCP"];
+		sbit = chunks["sBIT"];
+		srgb = chunks["sRGB"];
+
+		if (ihdr.is_null() || idat_chunks.empty() || ihdr.get_size() != 13) // Always required chunks
+			throw Exception("Invalid PNG image file");
+	}
+
 	void PNGLoader::decode_header()
 	{
 		image_width = from_network_order(*reinterpret_cast<unsigned int*>(ihdr.get_data()));
@@ -45,6 +45,7 @@ namespace clan
 		~PNGLoader();
 		void read_magic();
 		void read_chunks();
+		void read_chunks_in_place(const unsigned char *data, int size);
 		void decode_header();
 		void decode_palette();
 		void decode_colorkey();
@@ -46,14 +46,14 @@ namespace clan
 		const FileSystem &fs,
 		bool srgb)
 	{
-		return PNGLoader::load(fs.open_file(filename), srgb);
+		return PNGLoader::load(fs.open_file(filename, File::open_existing, File::access_read, File::share_read, File::flag_memory_mapped), srgb);
 	}
 
 	PixelBuffer PNGProvider::load(
 		const std::string &fullname,
 		bool srgb)
 	{
-		File file(fullname);
+		File file = File::open_mapped(fullname);
 		return PNGLoader::load(file, srgb);
 	}
 
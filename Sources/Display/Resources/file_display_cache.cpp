@@ -36,6 +36,7 @@
 #include "API/Display/Font/font_description.h"
 #include "API/Display/Font/font_metrics.h"
 #include "API/Display/Render/texture.h"
+#include "API/Core/System/profiler.h"
 #include "API/Core/Text/string_format.h"
 #include "API/Core/Text/string_help.h"
 #include "API/Core/IOData/path_help.h"
@@ -63,6 +64,7 @@ namespace clan
 			return sprite;
 		}
 
+		ProfileZone zone("FileDisplayCache::load sprite");
 		Resource<Sprite> sprite = Sprite(canvas, id, doc.get_file_system());
 		sprites[id] = sprite;
 		sprite.get() = sprite.get().clone();
@@ -79,6 +81,7 @@ namespace clan
 			return image;
 		}
 
+		ProfileZone zone("FileDisplayCache::load image");
 		Resource<Image> image = Image(canvas, id, doc.get_file_system());
 		images[id] = image;
 		image.get() = image.get().clone();
@@ -91,6 +94,7 @@ namespace clan
 		if (it != textures.end())
 			return it->second;
 
+		ProfileZone zone("FileDisplayCache::load texture");
 		Resource<Texture> texture = Texture2D(gc, id, doc.get_file_system());
 		textures[id] = texture;
 		return texture;
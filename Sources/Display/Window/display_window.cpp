@@ -33,6 +33,7 @@
 #include "../Render/graphic_context_impl.h"
 #include "../setup_display.h"
 #include "API/Display/Window/input_device.h"
+#include "API/Core/System/profiler.h"
 
 namespace clan
 {
@@ -453,7 +454,11 @@ namespace clan
 	void DisplayWindow::flip(int interval)
 	{
 		impl->sig_window_flip();
-		impl->provider->flip(interval);
+		{
+			ProfileZone zone("DisplayWindow::flip");
+			impl->provider->flip(interval);
+		}
+		Profiler::mark_frame();
 	}
 
 	void DisplayWindow::show_cursor()
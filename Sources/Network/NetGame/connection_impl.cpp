@@ -31,6 +31,7 @@
 #include "API/Network/NetGame/connection.h"
 #include "API/Network/NetGame/connection_site.h"
 #include "API/Core/System/databuffer.h"
+#include "API/Core/System/profiler.h"
 #include "network_event.h"
 #include "network_data.h"
 #include "connection_impl.h"
@@ -124,6 +125,7 @@ namespace clan
 
 	bool NetGameConnection_Impl::read_connection_data(DataBuffer &receive_buffer, int &bytes_received)
 	{
+		ProfileZone zone("NetGameConnection::read");
 		while (true)
 		{
 			int bytes = connection.read(receive_buffer.get_data() + bytes_received, receive_buffer.get_size() - bytes_received);
@@ -155,6 +157,7 @@ namespace clan
 
 	bool NetGameConnection_Impl::write_connection_data(DataBuffer &send_buffer, int &bytes_sent, bool &send_graceful_close)
 	{
+		ProfileZone zone("NetGameConnection::write");
 		while (true)
 		{
 			int bytes = connection.write(send_buffer.get_data() + bytes_sent, send_buffer.get_size() - bytes_sent);
@@ -184,6 +187,8 @@ namespace clan
 
 	void NetGameConnection_Impl::connection_main()
 	{
+		Profiler::set_thread_name("NetGame connection");
+
 		try
 		{
 			if (!is_connected)
@@ -84,13 +84,16 @@ namespace clan
 			unsigned char type = d[pos++];
 			if (type == 0)
 				break;
-			e.add_argument(decode_value(type, d, length, pos));
+			e.add_argument(decode_value(type, data, pos));
 		}
 		return e;
 	}
 
-	NetGameEventValue NetGameNetworkData::decode_value(unsigned char type, const unsigned char *d, unsigned int length, unsigned int &pos)
+	NetGameEventValue NetGameNetworkData::decode_value(unsigned char type, const DataBuffer &data, unsigned int &pos)
 	{
+		const unsigned char *d = data.get_data<unsigned char>();
+		unsigned int length = data.get_size();
+
 		switch (type)
 		{
 		case 1: // null
@@ -145,7 +148,7 @@ namespace clan
 				unsigned char type = d[pos++];
 				if (type == 0)
 					break;
-				value.add_member(decode_value(type, d, length, pos));
+				value.add_member(decode_value(type, data, pos));
 			}
 			return value;
 		}
@@ -173,7 +176,7 @@ namespace clan
 			pos += 2;
 			if (pos + binary_length > length)
 				throw Exception("Invalid network data");
-			DataBuffer value(reinterpret_cast<const char*>(d + pos), binary_length);
+			DataBuffer value(data, pos, binary_length);
 			pos += binary_length;
 			return NetGameEventValue(value);
 		}
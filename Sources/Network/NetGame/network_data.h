@@ -49,7 +49,7 @@ namespace clan
 		static unsigned int get_encoded_length(const NetGameEventValue &value);
 		static unsigned int encode_value(unsigned char *d, const NetGameEventValue &value);
 
-		static NetGameEventValue decode_value(unsigned char type, const unsigned char *d, unsigned int length, unsigned int &pos);
+		static NetGameEventValue decode_value(unsigned char type, const DataBuffer &data, unsigned int &pos);
 
 		enum { packet_limit = 32000 };
 	};
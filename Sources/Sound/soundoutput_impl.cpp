@@ -32,6 +32,7 @@
 #include "API/Sound/soundfilter.h"
 #include <algorithm>
 #include "API/Sound/sound_sse.h"
+#include "API/Core/System/profiler.h"
 
 namespace clan
 {
@@ -105,6 +106,7 @@ namespace clan
 
 	void SoundOutput_Impl::mix_fragment()
 	{
+		ProfileZone zone("SoundOutput::mix_fragment");
 		resize_mix_buffers();
 		clear_mix_buffers();
 		fill_mix_buffers();
@@ -117,6 +119,7 @@ namespace clan
 	void SoundOutput_Impl::mixer_thread()
 	{
 		mixer_thread_starting();
+		Profiler::set_thread_name("Sound mixer");
 
 		while (if_continue_mixing())
 		{
@@ -68,8 +68,8 @@ namespace clan
 	{
 		if (impl)
 		{
-			DomString value = impl->get_tree_node()->get_node_value();
-			impl->get_tree_node()->node_value += arg;
+			DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
+			impl->get_tree_node()->append_node_value(doc_impl, arg);
 		}
 	}
 
@@ -80,7 +80,8 @@ namespace clan
 			DomString value = impl->get_tree_node()->get_node_value();
 			if (offset > value.length())
 				offset = value.length();
-			impl->get_tree_node()->node_value = value.substr(0, offset) + arg + value.substr(offset);
+			DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
+			impl->get_tree_node()->set_node_value(doc_impl, value.substr(0, offset) + arg + value.substr(offset));
 		}
 	}
 
@@ -104,7 +105,8 @@ namespace clan
 			{
 				value = DomString();
 			}
-			impl->get_tree_node()->node_value = value;
+			DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
+			impl->get_tree_node()->set_node_value(doc_impl, value);
 		}
 	}
 
@@ -44,6 +44,7 @@
 #include "API/XML/xml_writer.h"
 #include "API/XML/xml_token.h"
 #include "dom_document_generic.h"
+#include "dom_tree_node.h"
 #include <stack>
 
 namespace clan
@@ -54,10 +55,11 @@ namespace clan
 		impl->owner_document = impl;
 	}
 
-	DomDocument::DomDocument(IODevice &input, bool eat_whitespace)
+	DomDocument::DomDocument(IODevice &input, bool eat_whitespace, bool element_index)
 		: DomNode(std::shared_ptr<DomNode_Impl>(new DomDocument_Impl))
 	{
 		impl->owner_document = impl;
+		set_element_index_enabled(element_index);
 		load(input, eat_whitespace);
 	}
 
@@ -168,7 +170,17 @@ namespace clan
 
 	DomNodeList DomDocument::get_elements_by_tag_name(const DomString &tag_name)
 	{
-		return DomNodeList(*this, tag_name);
+		DomNodeList list;
+		if (impl)
+		{
+			DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
+			for (unsigned int node_index : doc_impl->find_elements_by_tag_name(tag_name))
+			{
+				DomNode node(doc_impl->get_dom_node(node_index));
+				list.add_item(node);
+			}
+		}
+		return list;
 	}
 
 	DomNodeList DomDocument::get_elements_by_tag_name_ns(
@@ -180,7 +192,34 @@ namespace clan
 
 	DomElement DomDocument::get_element_by_id(const DomString &element_id)
 	{
-		throw Exception("Implement me");
+		if (impl)
+		{
+			DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
+			unsigned int node_index = doc_impl->find_element_by_id(element_id);
+			if (node_index != cl_null_node_index)
+				return DomElement(doc_impl->get_dom_node(node_index));
+		}
+		return DomElement();
+	}
+
+	void DomDocument::set_element_index_enabled(bool enable)
+	{
+		if (impl)
+		{
+			DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
+			doc_impl->element_index_enabled = enable;
+			if (!enable)
+			{
+				doc_impl->element_index_valid = false;
+				doc_impl->element_id_index.clear();
+				doc_impl->element_name_index.clear();
+			}
+		}
+	}
+
+	bool DomDocument::is_element_index_enabled() const
+	{
+		return impl && ((DomDocument_Impl *)impl->owner_document.lock().get())->element_index_enabled;
 	}
 
 	DomNode DomDocument::import_node(const DomNode &node, bool deep)
@@ -357,6 +396,11 @@ namespace clan
 			}
 			throw;
 		}
+
+		DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
+		if (doc_impl->element_index_enabled)
+			doc_impl->update_element_index();
+
 		return result;
 	}
 
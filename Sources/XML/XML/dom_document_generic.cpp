@@ -35,6 +35,13 @@
 
 namespace clan
 {
+	const DomString DomDocument_Impl::empty_string;
+	const DomString DomDocument_Impl::cdata_section_name("#cdata-section");
+	const DomString DomDocument_Impl::comment_name("#comment");
+	const DomString DomDocument_Impl::document_name("#document");
+	const DomString DomDocument_Impl::document_fragment_name("#document-fragment");
+	const DomString DomDocument_Impl::text_name("#text");
+
 	DomDocument_Impl::DomDocument_Impl()
 	{
 		node_index = DomDocument_Impl::allocate_tree_node();
@@ -68,24 +75,24 @@ namespace clan
 		const DomNode &search_node)
 	{
 		static DomString xmlns_prefix("xmlns:");
-		DomString name = qualified_name;
-		DomString prefix;
-		DomString::size_type pos = name.find(':');
-		if (pos != DomString::npos)
-			prefix = name.substr(0, pos);
+		DomString::size_type prefix_length = qualified_name.find(':');
+		if (prefix_length == DomString::npos)
+			prefix_length = 0;
 
 		int size = (int)search_token.attributes.size();
 		for (int i = 0; i < size; i++)
 		{
-			if (prefix.empty())
+			const DomString &attribute_name = search_token.attributes[i].first;
+			if (prefix_length == 0)
 			{
-				if (search_token.attributes[i].first == "xmlns")
+				if (attribute_name == "xmlns")
 					return search_token.attributes[i].second;
 			}
 			else
 			{
-				if (search_token.attributes[i].first.substr(0, 6) == xmlns_prefix &&
-					search_token.attributes[i].first.substr(6) == prefix)
+				if (attribute_name.length() == 6 + prefix_length &&
+					attribute_name.compare(0, 6, xmlns_prefix) == 0 &&
+					attribute_name.compare(6, prefix_length, qualified_name, 0, prefix_length) == 0)
 					return search_token.attributes[i].second;
 			}
 		}
@@ -93,6 +100,126 @@ namespace clan
 		return search_node.find_namespace_uri(qualified_name);
 	}
 
+	const DomString *DomDocument_Impl::intern(const DomString &str)
+	{
+		if (str.empty())
+			return &empty_string;
+		auto result = string_pool.insert(str);
+		if (result.second && str.compare(0, 5, "xmlns") == 0)
+			has_xmlns_names = true;
+		return &*result.first;
+	}
+
+	bool DomDocument_Impl::is_id_attribute(const DomString &name)
+	{
+		return name == "id" || name == "ID" || name == "xml:id";
+	}
+
+	unsigned int DomDocument_Impl::get_next_in_preorder(unsigned int index) const
+	{
+		const DomTreeNode *tree_node = nodes[index];
+		if (tree_node->first_child != cl_null_node_index)
+			return tree_node->first_child;
+
+		while (index != node_index)
+		{
+			tree_node = nodes[index];
+			if (tree_node->next_sibling != cl_null_node_index)
+				return tree_node->next_sibling;
+			index = tree_node->parent;
+			if (index == cl_null_node_index)
+				break;
+		}
+		return cl_null_node_index;
+	}
+
+	void DomDocument_Impl::update_element_index()
+	{
+		if (element_index_valid && element_index_modification_count == modification_count)
+			return;
+
+		element_id_index.clear();
+		element_name_index.clear();
+		for (unsigned int index = get_next_in_preorder(node_index); index != cl_null_node_index; index = get_next_in_preorder(index))
+		{
+			const DomTreeNode *tree_node = nodes[index];
+			if (tree_node->node_type != DomNode::ELEMENT_NODE)
+				continue;
+
+			element_name_index[tree_node->node_name].push_back(index);
+			for (unsigned int attribute = tree_node->first_attribute; attribute != cl_null_node_index; attribute = nodes[attribute]->next_sibling)
+			{
+				// insert() keeps the first element in document order when an ID is used twice
+				if (is_id_attribute(nodes[attribute]->get_node_name()))
+					element_id_index.insert(std::make_pair(nodes[attribute]->get_node_value(), index));
+			}
+		}
+
+		element_index_modification_count = modification_count;
+		element_index_valid = true;
+	}
+
+	unsigned int DomDocument_Impl::find_element_by_id(const DomString &element_id)
+	{
+		if (element_index_enabled)
+		{
+			update_element_index();
+			auto it = element_id_index.find(element_id);
+			return it != element_id_index.end() ? it->second : cl_null_node_index;
+		}
+
+		for (unsigned int index = get_next_in_preorder(node_index); index != cl_null_node_index; index = get_next_in_preorder(index))
+		{
+			const DomTreeNode *tree_node = nodes[index];
+			if (tree_node->node_type != DomNode::ELEMENT_NODE)
+				continue;
+
+			for (unsigned int attribute = tree_node->first_attribute; attribute != cl_null_node_index; attribute = nodes[attribute]->next_sibling)
+			{
+				if (is_id_attribute(nodes[attribute]->get_node_name()) && nodes[attribute]->node_value_equals(element_id))
+					return index;
+			}
+		}
+		return cl_null_node_index;
+	}
+
+	std::vector<unsigned int> DomDocument_Impl::find_elements_by_tag_name(const DomString &tag_name)
+	{
+		bool match_all = (tag_name == "*");
+		const DomString *name = nullptr;
+		if (!match_all)
+		{
+			// Tag names are interned, so a name missing from the pool cannot match any element
+			auto it = string_pool.find(tag_name);
+			if (it == string_pool.end())
+				return std::vector<unsigned int>();
+			name = &*it;
+		}
+
+		if (element_index_enabled && !match_all)
+		{
+			update_element_index();
+			auto it = element_name_index.find(name);
+			return it != element_name_index.end() ? it->second : std::vector<unsigned int>();
+		}
+
+		std::vector<unsigned int> elements;
+		for (unsigned int index = get_next_in_preorder(node_index); index != cl_null_node_index; index = get_next_in_preorder(index))
+		{
+			const DomTreeNode *tree_node = nodes[index];
+			if (tree_node->node_type == DomNode::ELEMENT_NODE && (match_all || tree_node->node_name == name))
+				elements.push_back(index);
+		}
+		return elements;
+	}
+
+	std::shared_ptr<DomNode_Impl> DomDocument_Impl::get_dom_node(unsigned int index)
+	{
+		DomNode_Impl *dom_node = allocate_dom_node();
+		dom_node->node_index = index;
+		return std::shared_ptr<DomNode_Impl>(dom_node, NodeDeleter(this));
+	}
+
 	unsigned int DomDocument_Impl::allocate_tree_node()
 	{
 		if (free_nodes.empty())
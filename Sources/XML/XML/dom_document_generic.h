@@ -30,8 +30,12 @@
 
 #include "dom_node_generic.h"
 #include "API/Core/System/block_allocator.h"
+#include "API/XML/dom_string.h"
+#include "API/XML/xpath_evaluator.h"
 #include <vector>
 #include <stack>
+#include <unordered_set>
+#include <unordered_map>
 
 namespace clan
 {
@@ -50,16 +54,60 @@ namespace clan
 		std::string system_id;
 		std::string internal_subset;
 		BlockAllocator node_allocator;
+		BlockAllocator string_allocator; // Node values. Kept apart from node_allocator as it does not align allocations
+		std::unordered_set<DomString> string_pool; // Node names and namespace URIs
+		bool has_xmlns_names = false; // True once a name starting with "xmlns" has been interned
 		std::vector<DomTreeNode *> nodes;
 		std::vector<int> free_nodes;
 		std::vector<DomNode_Impl *> free_dom_nodes;
 		std::vector<DomNamedNodeMap_Impl *> free_named_node_maps;
 
+		// Used by DomNode::select_nodes, so repeated queries on the document hit its compiled expression cache
+		XPathEvaluator xpath_evaluator;
+
+		// Element indexes. Rebuilt on first use after modification_count changed
+		bool element_index_enabled = false;
+		unsigned int modification_count = 0; // Bumped by changes to the tree, node names and ID attributes
+		unsigned int element_index_modification_count = 0;
+		bool element_index_valid = false;
+		std::unordered_map<DomString, unsigned int> element_id_index; // ID attribute value to element
+		std::unordered_map<const DomString *, std::vector<unsigned int> > element_name_index; // Interned tag name to elements in document order
+
 		static DomString find_namespace_uri(
 			const DomString &qualified_name,
 			const XMLToken &search_token,
 			const DomNode &search_node);
 
+		static const DomString empty_string;
+
+		// Names returned by DomNode::get_node_name for node types without a tag name
+		static const DomString cdata_section_name;
+		static const DomString comment_name;
+		static const DomString document_name;
+		static const DomString document_fragment_name;
+		static const DomString text_name;
+
+		/// \brief Returns the pooled copy of str. The pointer stays valid for the lifetime of the document
+		const DomString *intern(const DomString &str);
+
+		/// \brief Returns true for the attribute names treated as element IDs: id, ID and xml:id
+		static bool is_id_attribute(const DomString &name);
+
+		void tree_changed() { modification_count++; }
+		void id_attribute_changed(const DomString &name) { if (is_id_attribute(name)) modification_count++; }
+
+		/// \brief Returns the node following node_index in a preorder traversal of the document, or cl_null_node_index
+		unsigned int get_next_in_preorder(unsigned int node_index) const;
+
+		/// \brief Rebuilds element_id_index and element_name_index if the document changed since they were built
+		void update_element_index();
+
+		unsigned int find_element_by_id(const DomString &element_id);
+		std::vector<unsigned int> find_elements_by_tag_name(const DomString &tag_name);
+
+		/// \brief Returns a node handle for a tree node
+		std::shared_ptr<DomNode_Impl> get_dom_node(unsigned int node_index);
+
 		unsigned int allocate_tree_node();
 		void free_tree_node(unsigned int node_index);
 		DomNode_Impl *allocate_dom_node();
@@ -154,12 +154,11 @@ namespace clan
 			const DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
 			while (cur_attribute)
 			{
-				std::string lname = cur_attribute->get_node_name();
-				std::string::size_type lpos = lname.find_first_of(':');
-				if (lpos != std::string::npos)
-					lname = lname.substr(lpos + 1);
+				const DomString &qualified_name = cur_attribute->get_node_name();
+				DomString::size_type lpos = qualified_name.find_first_of(':');
+				lpos = (lpos != DomString::npos) ? lpos + 1 : 0;
 
-				if (cur_attribute->get_namespace_uri() == namespace_uri && lname == local_name)
+				if (cur_attribute->get_namespace_uri() == namespace_uri && qualified_name.compare(lpos, DomString::npos, local_name) == 0)
 					return cur_attribute->get_node_value();
 
 				cur_index = cur_attribute->next_sibling;
@@ -183,12 +182,11 @@ namespace clan
 			const DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
 			while (cur_attribute)
 			{
-				std::string lname = cur_attribute->get_node_name();
-				std::string::size_type lpos = lname.find_first_of(':');
-				if (lpos != std::string::npos)
-					lname = lname.substr(lpos + 1);
+				const DomString &qualified_name = cur_attribute->get_node_name();
+				DomString::size_type lpos = qualified_name.find_first_of(':');
+				lpos = (lpos != DomString::npos) ? lpos + 1 : 0;
 
-				if (cur_attribute->get_namespace_uri() == namespace_uri && lname == local_name)
+				if (cur_attribute->get_namespace_uri() == namespace_uri && qualified_name.compare(lpos, DomString::npos, local_name) == 0)
 					return cur_attribute->get_node_value();
 
 				cur_index = cur_attribute->next_sibling;
@@ -105,12 +105,11 @@ namespace clan
 		const DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
 		while (cur_attribute)
 		{
-			std::string lname = cur_attribute->get_node_name();
-			std::string::size_type lpos = lname.find_first_of(':');
-			if (lpos != std::string::npos)
-				lname = lname.substr(lpos + 1);
+			const DomString &qualified_name = cur_attribute->get_node_name();
+			DomString::size_type lpos = qualified_name.find_first_of(':');
+			lpos = (lpos != DomString::npos) ? lpos + 1 : 0;
 
-			if (cur_attribute->get_namespace_uri() == namespace_uri && lname == local_name)
+			if (cur_attribute->get_namespace_uri() == namespace_uri && qualified_name.compare(lpos, DomString::npos, local_name) == 0)
 			{
 				DomNode_Impl *dom_node = doc_impl->allocate_dom_node();
 				dom_node->node_index = cur_index;
@@ -132,6 +131,7 @@ namespace clan
 		DomTreeNode *tree_node = impl->get_tree_node();
 		if (new_tree_node == tree_node)
 			return node;
+		doc_impl->id_attribute_changed(new_tree_node->get_node_name());
 		unsigned int cur_index = tree_node->first_attribute;
 		unsigned int last_index = cl_null_node_index;
 		DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
@@ -148,6 +148,7 @@ namespace clan
 					cur_attribute->get_previous_sibling(doc_impl)->next_sibling = node.impl->node_index;
 				if (cur_attribute->next_sibling != cl_null_node_index)
 					cur_attribute->get_next_sibling(doc_impl)->previous_sibling = node.impl->node_index;
+				doc_impl->id_attribute_changed(cur_attribute->get_node_name());
 				cur_attribute->parent = cl_null_node_index;
 				cur_attribute->previous_sibling = cl_null_node_index;
 				cur_attribute->next_sibling = cl_null_node_index;
@@ -179,23 +180,39 @@ namespace clan
 		if (!impl)
 			return DomNode();
 		DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-		DomString namespace_uri = node.get_namespace_uri();
-		DomString local_name = node.get_local_name();
 		DomTreeNode *new_tree_node = (DomTreeNode *)node.impl->get_tree_node();
 		DomTreeNode *tree_node = impl->get_tree_node();
 		if (new_tree_node == tree_node)
 			return node;
+		doc_impl->id_attribute_changed(new_tree_node->get_node_name());
+
+		const DomString &new_qualified_name = new_tree_node->get_node_name();
+		DomString::size_type new_lpos = new_qualified_name.find_first_of(':');
+		new_lpos = (new_lpos != DomString::npos) ? new_lpos + 1 : 0;
+
 		unsigned int cur_index = tree_node->first_attribute;
 		unsigned int last_index = cl_null_node_index;
 		DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
 		while (cur_attribute)
 		{
-			std::string lname = cur_attribute->get_node_name();
-			std::string::size_type lpos = lname.find_first_of(':');
-			if (lpos != std::string::npos)
-				lname = lname.substr(lpos + 1);
+			// Names and namespace URIs are interned by the document, so equal strings have equal pointers
+			bool same_name = false;
+			if (cur_attribute->namespace_uri == new_tree_node->namespace_uri)
+			{
+				if (cur_attribute->node_name == new_tree_node->node_name)
+				{
+					same_name = true;
+				}
+				else
+				{
+					const DomString &qualified_name = cur_attribute->get_node_name();
+					DomString::size_type lpos = qualified_name.find_first_of(':');
+					lpos = (lpos != DomString::npos) ? lpos + 1 : 0;
+					same_name = qualified_name.compare(lpos, DomString::npos, new_qualified_name, new_lpos, DomString::npos) == 0;
+				}
+			}
 
-			if (cur_attribute->get_namespace_uri() == namespace_uri && lname == local_name)
+			if (same_name)
 			{
 				new_tree_node->parent = cur_attribute->parent;
 				new_tree_node->previous_sibling = cur_attribute->previous_sibling;
@@ -206,6 +223,7 @@ namespace clan
 					cur_attribute->get_previous_sibling(doc_impl)->next_sibling = node.impl->node_index;
 				if (cur_attribute->next_sibling != cl_null_node_index)
 					cur_attribute->get_next_sibling(doc_impl)->previous_sibling = node.impl->node_index;
+				doc_impl->id_attribute_changed(cur_attribute->get_node_name());
 				cur_attribute->parent = cl_null_node_index;
 				cur_attribute->previous_sibling = cl_null_node_index;
 				cur_attribute->next_sibling = cl_null_node_index;
@@ -251,6 +269,7 @@ namespace clan
 					cur_attribute->get_previous_sibling(doc_impl)->next_sibling = cur_attribute->next_sibling;
 				if (cur_attribute->next_sibling != cl_null_node_index)
 					cur_attribute->get_next_sibling(doc_impl)->previous_sibling = cur_attribute->previous_sibling;
+				doc_impl->id_attribute_changed(cur_attribute->get_node_name());
 				cur_attribute->parent = cl_null_node_index;
 				cur_attribute->previous_sibling = cl_null_node_index;
 				cur_attribute->next_sibling = cl_null_node_index;
@@ -280,12 +299,11 @@ namespace clan
 		DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
 		while (cur_attribute)
 		{
-			std::string lname = cur_attribute->get_node_name();
-			std::string::size_type lpos = lname.find_first_of(':');
-			if (lpos != std::string::npos)
-				lname = lname.substr(lpos + 1);
+			const DomString &qualified_name = cur_attribute->get_node_name();
+			DomString::size_type lpos = qualified_name.find_first_of(':');
+			lpos = (lpos != DomString::npos) ? lpos + 1 : 0;
 
-			if (cur_attribute->get_namespace_uri() == namespace_uri && lname == local_name)
+			if (cur_attribute->get_namespace_uri() == namespace_uri && qualified_name.compare(lpos, DomString::npos, local_name) == 0)
 			{
 				if (cur_attribute->previous_sibling == cl_null_node_index)
 					tree_node->first_attribute = cur_attribute->next_sibling;
@@ -293,6 +311,7 @@ namespace clan
 					cur_attribute->get_previous_sibling(doc_impl)->next_sibling = cur_attribute->next_sibling;
 				if (cur_attribute->next_sibling != cl_null_node_index)
 					cur_attribute->get_next_sibling(doc_impl)->previous_sibling = cur_attribute->previous_sibling;
+				doc_impl->id_attribute_changed(cur_attribute->get_node_name());
 				cur_attribute->parent = cl_null_node_index;
 				cur_attribute->previous_sibling = cl_null_node_index;
 				cur_attribute->next_sibling = cl_null_node_index;
@@ -80,7 +80,7 @@ namespace clan
 	{
 	}
 
-	DomString DomNode::get_node_name() const
+	const DomString &DomNode::get_node_name() const
 	{
 		if (impl)
 		{
@@ -88,15 +88,15 @@ namespace clan
 			switch (tree_node->node_type)
 			{
 			case CDATA_SECTION_NODE:
-				return "#cdata-section";
+				return DomDocument_Impl::cdata_section_name;
 			case COMMENT_NODE:
-				return "#comment";
+				return DomDocument_Impl::comment_name;
 			case DOCUMENT_NODE:
-				return "#document";
+				return DomDocument_Impl::document_name;
 			case DOCUMENT_FRAGMENT_NODE:
-				return "#document-fragment";
+				return DomDocument_Impl::document_fragment_name;
 			case TEXT_NODE:
-				return "#text";
+				return DomDocument_Impl::text_name;
 			case ATTRIBUTE_NODE:
 			case DOCUMENT_TYPE_NODE:
 			case ELEMENT_NODE:
@@ -108,7 +108,7 @@ namespace clan
 				return tree_node->get_node_name();
 			}
 		}
-		return DomString();
+		return DomDocument_Impl::empty_string;
 	}
 
 	DomString DomNode::get_node_value() const
@@ -137,18 +137,18 @@ namespace clan
 		return DomString();
 	}
 
-	DomString DomNode::get_namespace_uri() const
+	const DomString &DomNode::get_namespace_uri() const
 	{
 		if (impl)
 			return impl->get_tree_node()->get_namespace_uri();
-		return DomString();
+		return DomDocument_Impl::empty_string;
 	}
 
 	DomString DomNode::get_prefix() const
 	{
 		if (impl)
 		{
-			DomString node_name = impl->get_tree_node()->get_node_name();
+			const DomString &node_name = impl->get_tree_node()->get_node_name();
 			DomString::size_type pos = node_name.find(':');
 			if (pos != DomString::npos)
 				return node_name.substr(0, pos);
@@ -174,7 +174,7 @@ namespace clan
 	{
 		if (impl)
 		{
-			DomString node_name = impl->get_tree_node()->get_node_name();
+			const DomString &node_name = impl->get_tree_node()->get_node_name();
 			DomString::size_type pos = node_name.find(':');
 			if (pos != DomString::npos)
 				return node_name.substr(pos + 1);
@@ -448,6 +448,7 @@ namespace clan
 			if (tree_node->first_child == ref_child.impl->node_index)
 				tree_node->first_child = new_child.impl->node_index;
 			new_tree_node->parent = impl->node_index;
+			doc_impl->tree_changed();
 
 			return new_child;
 		}
@@ -458,6 +459,7 @@ namespace clan
 	{
 		if (impl && new_child.impl && old_child.impl)
 		{
+			DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
 			DomTreeNode *tree_node = impl->get_tree_node();
 			DomTreeNode *new_tree_node = new_child.impl->get_tree_node();
 			DomTreeNode *old_tree_node = old_child.impl->get_tree_node();
@@ -472,6 +474,7 @@ namespace clan
 			old_tree_node->previous_sibling = cl_null_node_index;
 			old_tree_node->next_sibling = cl_null_node_index;
 			old_tree_node->parent = cl_null_node_index;
+			doc_impl->tree_changed();
 
 			return new_child;
 		}
@@ -500,6 +503,7 @@ namespace clan
 			old_tree_node->previous_sibling = cl_null_node_index;
 			old_tree_node->next_sibling = cl_null_node_index;
 			old_tree_node->parent = cl_null_node_index;
+			doc_impl->tree_changed();
 		}
 		return DomNode();
 	}
@@ -524,6 +528,7 @@ namespace clan
 				tree_node->last_child = new_child.impl->node_index;
 			}
 			new_tree_node->parent = impl->node_index;
+			doc_impl->tree_changed();
 			return new_child;
 		}
 		return DomNode();
@@ -662,13 +667,16 @@ namespace clan
 			return xmlns_xmlns;
 
 		DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
+		if (!doc_impl->has_xmlns_names)
+			return DomString(); // No namespace declarations anywhere in the document
+
 		const DomTreeNode *cur = impl->get_tree_node();
 		while (cur)
 		{
 			const DomTreeNode *cur_attr = cur->get_first_attribute(doc_impl);
 			while (cur_attr)
 			{
-				std::string node_name = cur_attr->get_node_name();
+				const DomString &node_name = cur_attr->get_node_name();
 				if (prefix.empty())
 				{
 					if (node_name == xmlns_xmlns)
@@ -676,7 +684,7 @@ namespace clan
 				}
 				else
 				{
-					if (node_name.substr(0, 6) == xmlns_prefix && node_name.substr(6) == prefix)
+					if (node_name.length() == 6 + prefix.length() && node_name.compare(0, 6, xmlns_prefix) == 0 && node_name.compare(6, DomString::npos, prefix) == 0)
 						return cur_attr->get_node_value();
 				}
 				cur_attr = cur_attr->get_next_sibling(doc_impl);
@@ -709,8 +717,11 @@ namespace clan
 
 	std::vector<DomNode> DomNode::select_nodes(const DomString &xpath_expression) const
 	{
-		XPathEvaluator evaluator;
-		return evaluator.evaluate(xpath_expression, *this).get_node_set();
+		if (!impl)
+			return XPathEvaluator().evaluate(xpath_expression, *this).get_node_set();
+
+		DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
+		return doc_impl->xpath_evaluator.evaluate(xpath_expression, *this).get_node_set();
 	}
 
 	DomNode DomNode::select_node(const DomString &xpath_expression) const
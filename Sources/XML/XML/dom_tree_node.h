@@ -29,7 +29,9 @@
 #pragma once
 
 #include "API/Core/System/block_allocator.h"
+#include "API/XML/dom_node.h"
 #include "dom_document_generic.h"
+#include <cstring>
 
 namespace clan
 {
@@ -41,19 +43,23 @@ namespace clan
 	{
 	public:
 		DomTreeNode()
-			: node_type(0), parent(cl_null_node_index), first_child(cl_null_node_index),
+			: node_name(&DomDocument_Impl::empty_string), namespace_uri(&DomDocument_Impl::empty_string),
+			node_value(nullptr), node_value_length(0), node_value_capacity(0),
+			node_type(0), parent(cl_null_node_index), first_child(cl_null_node_index),
 			last_child(cl_null_node_index), previous_sibling(cl_null_node_index),
 			next_sibling(cl_null_node_index), first_attribute(cl_null_node_index)
 		{
 		}
 
-		virtual ~DomTreeNode()
+		~DomTreeNode()
 		{
 		}
 
-		std::string node_name;
-		std::string node_value;
-		std::string namespace_uri;
+		const DomString *node_name; // Interned in DomDocument_Impl::string_pool
+		const DomString *namespace_uri; // Interned in DomDocument_Impl::string_pool
+		char *node_value; // Allocated from DomDocument_Impl::string_allocator
+		unsigned int node_value_length;
+		unsigned int node_value_capacity;
 		unsigned short node_type;
 		unsigned int parent;
 		unsigned int first_child;
@@ -64,9 +70,10 @@ namespace clan
 
 		void reset()
 		{
-			node_name.clear();
-			node_value.clear();
-			namespace_uri.clear();
+			// The value buffer is kept for reuse by the next node allocated at this index
+			node_name = &DomDocument_Impl::empty_string;
+			namespace_uri = &DomDocument_Impl::empty_string;
+			node_value_length = 0;
 			node_type = 0;
 			parent = cl_null_node_index;
 			first_child = cl_null_node_index;
@@ -76,34 +83,61 @@ namespace clan
 			first_attribute = cl_null_node_index;
 		}
 
-		std::string get_node_name() const
+		const DomString &get_node_name() const
 		{
-			return node_name;
+			return *node_name;
 		}
 
-		std::string get_node_value() const
+		DomString get_node_value() const
 		{
-			return node_value;
+			return node_value_length ? DomString(node_value, node_value_length) : DomString();
 		}
 
-		std::string get_namespace_uri() const
+		bool node_value_equals(const DomString &str) const
 		{
-			return namespace_uri;
+			return str.length() == node_value_length && (node_value_length == 0 || memcmp(node_value, str.data(), node_value_length) == 0);
+		}
+
+		const DomString &get_namespace_uri() const
+		{
+			return *namespace_uri;
 		}
 
 		void set_node_name(DomDocument_Impl *owner_document, const DomString &str)
 		{
-			node_name = str;
+			node_name = owner_document->intern(str);
+			owner_document->tree_changed();
 		}
 
 		void set_node_value(DomDocument_Impl *owner_document, const DomString &str)
 		{
-			node_value = str;
+			node_value_length = 0;
+			append_node_value(owner_document, str);
+		}
+
+		void append_node_value(DomDocument_Impl *owner_document, const DomString &str)
+		{
+			unsigned int length = node_value_length + (unsigned int)str.length();
+			if (length > node_value_capacity)
+			{
+				// Grow geometrically so that repeated appends do not fill the arena with discarded copies
+				unsigned int capacity = length > node_value_capacity * 2 ? length : node_value_capacity * 2;
+				char *buffer = (char *)owner_document->string_allocator.allocate(capacity);
+				if (node_value_length)
+					memcpy(buffer, node_value, node_value_length);
+				node_value = buffer;
+				node_value_capacity = capacity;
+			}
+			if (!str.empty())
+				memcpy(node_value + node_value_length, str.data(), str.length());
+			node_value_length = length;
+			if (node_type == DomNode::ATTRIBUTE_NODE)
+				owner_document->id_attribute_changed(*node_name);
 		}
 
 		void set_namespace_uri(DomDocument_Impl *owner_document, const DomString &str)
 		{
-			namespace_uri = str;
+			namespace_uri = owner_document->intern(str);
 		}
 
 		DomTreeNode *get_parent(DomDocument_Impl *owner_document)
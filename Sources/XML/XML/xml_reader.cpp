@@ -0,0 +1,269 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#include "XML/precomp.h"
+#include "API/XML/xml_reader.h"
+#include "API/Core/IOData/iodevice.h"
+#include "xml_tokenizer_generic.h"
+
+namespace clan
+{
+	class XMLReader_Impl
+	{
+	public:
+		XMLTokenizer_Impl tokenizer;
+		int depth = 0;
+
+		XMLStringView name;
+		XMLStringView value;
+		std::vector<XMLStringView> attribute_names;
+		std::vector<XMLStringView> attribute_values;
+
+		// Unescaped copies of values containing entities. Index 0 is the node value, index i + 1 attribute i
+		std::vector<std::string> unescaped;
+
+		void update_views();
+		XMLStringView get_view(const XMLTokenizer_Impl::Range &range, size_t unescaped_index);
+	};
+
+	XMLReader::XMLReader()
+	{
+	}
+
+	XMLReader::XMLReader(IODevice &input) : impl(std::make_shared<XMLReader_Impl>())
+	{
+		impl->tokenizer.input = input;
+		impl->tokenizer.start();
+	}
+
+	XMLReader::~XMLReader()
+	{
+	}
+
+	bool XMLReader::get_eat_whitespace() const
+	{
+		return impl->tokenizer.eat_whitespace;
+	}
+
+	void XMLReader::set_eat_whitespace(bool enable)
+	{
+		impl->tokenizer.eat_whitespace = enable;
+	}
+
+	bool XMLReader::next()
+	{
+		if (!impl)
+			return false;
+
+		XMLTokenizer_Impl &tokenizer = impl->tokenizer;
+		if (tokenizer.token_type == XMLToken::ELEMENT_TOKEN && tokenizer.token_variant == XMLToken::BEGIN)
+			impl->depth++;
+
+		bool found = tokenizer.next_token();
+		if (tokenizer.token_type == XMLToken::ELEMENT_TOKEN && tokenizer.token_variant == XMLToken::END)
+			impl->depth--;
+
+		impl->update_views();
+		return found;
+	}
+
+	XMLToken::TokenType XMLReader::get_type() const
+	{
+		return impl ? impl->tokenizer.token_type : XMLToken::NULL_TOKEN;
+	}
+
+	XMLToken::TokenVariant XMLReader::get_variant() const
+	{
+		return impl ? impl->tokenizer.token_variant : XMLToken::SINGLE;
+	}
+
+	bool XMLReader::is_start_element() const
+	{
+		return get_type() == XMLToken::ELEMENT_TOKEN && get_variant() != XMLToken::END;
+	}
+
+	bool XMLReader::is_start_element(const char *name) const
+	{
+		return is_start_element() && impl->name == name;
+	}
+
+	bool XMLReader::is_end_element() const
+	{
+		return get_type() == XMLToken::ELEMENT_TOKEN && get_variant() == XMLToken::END;
+	}
+
+	int XMLReader::get_depth() const
+	{
+		return impl ? impl->depth : 0;
+	}
+
+	XMLStringView XMLReader::get_name() const
+	{
+		return impl ? impl->name : XMLStringView();
+	}
+
+	XMLStringView XMLReader::get_value() const
+	{
+		return impl ? impl->value : XMLStringView();
+	}
+
+	int XMLReader::get_attribute_count() const
+	{
+		return impl ? (int)impl->attribute_names.size() : 0;
+	}
+
+	XMLStringView XMLReader::get_attribute_name(int index) const
+	{
+		return impl->attribute_names.at(index);
+	}
+
+	XMLStringView XMLReader::get_attribute_value(int index) const
+	{
+		return impl->attribute_values.at(index);
+	}
+
+	bool XMLReader::has_attribute(const char *name) const
+	{
+		if (!impl)
+			return false;
+		for (const auto &attribute_name : impl->attribute_names)
+		{
+			if (attribute_name == name)
+				return true;
+		}
+		return false;
+	}
+
+	XMLStringView XMLReader::get_attribute(const char *name) const
+	{
+		if (!impl)
+			return XMLStringView();
+		for (size_t i = 0; i < impl->attribute_names.size(); i++)
+		{
+			if (impl->attribute_names[i] == name)
+				return impl->attribute_values[i];
+		}
+		return XMLStringView();
+	}
+
+	void XMLReader::skip_element()
+	{
+		if (get_type() != XMLToken::ELEMENT_TOKEN || get_variant() != XMLToken::BEGIN)
+			return;
+
+		int element_depth = impl->depth;
+		while (next())
+		{
+			if (impl->depth == element_depth && is_end_element())
+				break;
+		}
+	}
+
+	void XMLReader::parse(XMLHandler &handler)
+	{
+		while (next())
+		{
+			switch (get_type())
+			{
+			case XMLToken::ELEMENT_TOKEN:
+				if (get_variant() != XMLToken::END)
+					handler.start_element(*this);
+				if (get_variant() != XMLToken::BEGIN)
+					handler.end_element(impl->name);
+				break;
+			case XMLToken::TEXT_TOKEN:
+				handler.text(impl->value);
+				break;
+			case XMLToken::CDATA_SECTION_TOKEN:
+				handler.cdata_section(impl->value);
+				break;
+			case XMLToken::COMMENT_TOKEN:
+				handler.comment(impl->value);
+				break;
+			case XMLToken::PROCESSING_INSTRUCTION_TOKEN:
+				handler.processing_instruction(impl->name, impl->value);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	void XMLReader_Impl::update_views()
+	{
+		size_t count = tokenizer.token_attribute_count;
+		if (unescaped.size() < count + 1)
+			unescaped.resize(count + 1);
+
+		switch (tokenizer.token_type)
+		{
+		case XMLToken::ELEMENT_TOKEN:
+		case XMLToken::PROCESSING_INSTRUCTION_TOKEN:
+			name = get_view(tokenizer.token_name, 0);
+			break;
+		default:
+			name = XMLStringView();
+			break;
+		}
+
+		switch (tokenizer.token_type)
+		{
+		case XMLToken::TEXT_TOKEN:
+		case XMLToken::COMMENT_TOKEN:
+		case XMLToken::CDATA_SECTION_TOKEN:
+		case XMLToken::PROCESSING_INSTRUCTION_TOKEN:
+			value = get_view(tokenizer.token_value, 0);
+			break;
+		default:
+			value = XMLStringView();
+			break;
+		}
+
+		attribute_names.resize(count);
+		attribute_values.resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			attribute_names[i] = get_view(tokenizer.token_attributes[i].name, i + 1);
+			attribute_values[i] = get_view(tokenizer.token_attributes[i].value, i + 1);
+		}
+	}
+
+	XMLStringView XMLReader_Impl::get_view(const XMLTokenizer_Impl::Range &range, size_t unescaped_index)
+	{
+		if (!range.has_entity)
+			return XMLStringView(tokenizer.data.data() + range.pos, range.length);
+
+		std::string &text = unescaped[unescaped_index];
+		text.assign(tokenizer.data, range.pos, range.length);
+		XMLTokenizer_Impl::unescape(text);
+		return XMLStringView(text.data(), text.length());
+	}
+}
@@ -0,0 +1,77 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#ifndef CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace clan
+{
+	/// \brief Delimiter scanning for XMLTokenizer, 16 bytes at a time where SSE2 is available
+	class XMLScanner
+	{
+	public:
+		/// \brief Returns the first occurrence of a or b in [p, end), or end
+		static const char *find_any(const char *p, const char *end, char a, char b)
+		{
+#ifndef CL_DISABLE_SSE2
+			const __m128i match_a = _mm_set1_epi8(a);
+			const __m128i match_b = _mm_set1_epi8(b);
+			while (end - p >= 16)
+			{
+				__m128i chars = _mm_loadu_si128((const __m128i*)p);
+				unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chars, match_a), _mm_cmpeq_epi8(chars, match_b)));
+				if (mask != 0)
+					return p + count_trailing_zeros(mask);
+				p += 16;
+			}
+#endif
+			while (p != end && *p != a && *p != b)
+				p++;
+			return p;
+		}
+
+	private:
+		static int count_trailing_zeros(unsigned int mask)
+		{
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward(&index, mask);
+			return (int)index;
+#else
+			return __builtin_ctz(mask);
+#endif
+		}
+	};
+}
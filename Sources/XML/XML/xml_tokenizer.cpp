@@ -33,6 +33,7 @@
 #include "API/Core/Text/string_format.h"
 #include "API/Core/Text/string_help.h"
 #include "xml_tokenizer_generic.h"
+#include "xml_scanner.h"
 #include <algorithm>
 #include <utility>
 
@@ -49,32 +50,7 @@ namespace clan
 	XMLTokenizer::XMLTokenizer(IODevice &input) : impl(std::make_shared<XMLTokenizer_Impl>())
 	{
 		impl->input = input;
-		impl->size = input.get_size();
-		impl->pos = 0;
-
-		DataBuffer buffer(impl->size);
-		input.receive(buffer.get_data(), buffer.get_size(), true);
-
-		StringHelp::BOMType bom_type = StringHelp::detect_bom(buffer.get_data(), buffer.get_size());
-		switch (bom_type)
-		{
-		default:
-		case StringHelp::bom_none:
-			impl->data = StringHelp::utf8_to_text(std::string(buffer.get_data(), buffer.get_size()));
-			break;
-		case StringHelp::bom_utf32_be:
-		case StringHelp::bom_utf32_le:
-			throw Exception("UTF-16 XML files not supported yet");
-			break;
-		case StringHelp::bom_utf16_be:
-		case StringHelp::bom_utf16_le:
-			throw Exception("UTF-32 XML files not supported yet");
-			break;
-		case StringHelp::bom_utf8:
-			impl->data = StringHelp::utf8_to_text(std::string(buffer.get_data() + 3, buffer.get_size() - 3));
-			break;
-		}
-
+		impl->start();
 	}
 
 	XMLTokenizer::~XMLTokenizer()
@@ -99,11 +75,32 @@ namespace clan
 		while (!out_token->attributes.empty())
 			out_token->attributes.pop_back();
 
-		if (impl)
+		if (impl && impl->next_token())
 		{
-			if (impl->next_text_node(out_token))
-				return;
-			impl->next_tag_node(out_token);
+			out_token->type = impl->token_type;
+			out_token->variant = impl->token_variant;
+			switch (impl->token_type)
+			{
+			case XMLToken::ELEMENT_TOKEN:
+				out_token->name = impl->get_string(impl->token_name);
+				for (size_t i = 0; i < impl->token_attribute_count; i++)
+				{
+					const XMLTokenizer_Impl::RawAttribute &attribute = impl->token_attributes[i];
+					out_token->attributes.push_back(XMLToken::Attribute(impl->get_string(attribute.name), impl->get_string(attribute.value)));
+				}
+				break;
+			case XMLToken::PROCESSING_INSTRUCTION_TOKEN:
+				out_token->name = impl->get_string(impl->token_name);
+				out_token->value = impl->get_string(impl->token_value);
+				break;
+			case XMLToken::TEXT_TOKEN:
+			case XMLToken::COMMENT_TOKEN:
+			case XMLToken::CDATA_SECTION_TOKEN:
+				out_token->value = impl->get_string(impl->token_value);
+				break;
+			default:
+				break;
+			}
 		}
 	}
 
@@ -116,39 +113,56 @@ namespace clan
 
 	/////////////////////////////////////////////////////////////////////////////
 
-	bool XMLTokenizer_Impl::next_text_node(XMLToken *out_token)
+	bool XMLTokenizer_Impl::next_token()
+	{
+		discard_consumed();
+		token_type = XMLToken::NULL_TOKEN;
+		token_variant = XMLToken::SINGLE;
+		token_attribute_count = 0;
+		return next_text_node() || next_tag_node();
+	}
+
+	std::string XMLTokenizer_Impl::get_string(const Range &range) const
+	{
+		std::string text = data.substr(range.pos, range.length);
+		if (range.has_entity)
+			unescape(text);
+		return text;
+	}
+
+	bool XMLTokenizer_Impl::next_text_node()
 	{
-		while (pos < size && data[pos] != '<')
+		while (has_data(pos) && data[pos] != '<')
 		{
 			std::string::size_type start_pos = pos;
-			std::string::size_type end_pos = data.find('<', start_pos);
+			bool has_entity = false;
+			std::string::size_type end_pos = find_delimiter(start_pos, '<', has_entity);
 			if (end_pos == data.npos) end_pos = size;
 			pos = end_pos;
 
-			std::string text;
-			std::string text_orig = data.substr(start_pos, end_pos - start_pos);
-			unescape(text, text_orig);
+			Range text(start_pos, end_pos - start_pos, has_entity);
 			if (eat_whitespace)
 			{
-				text = trim_whitespace(text);
-				if (text.empty())
+				// Entities never expand to or from whitespace, so trimming before unescaping gives the same result
+				trim_whitespace(text);
+				if (text.length == 0)
 					continue;
 			}
 
-			out_token->type = XMLToken::TEXT_TOKEN;
-			out_token->value = text;
+			token_type = XMLToken::TEXT_TOKEN;
+			token_value = text;
 			return true;
 		}
 		return false;
 	}
 
-	bool XMLTokenizer_Impl::next_tag_node(XMLToken *out_token)
+	bool XMLTokenizer_Impl::next_tag_node()
 	{
-		if (pos == size || data[pos] != '<')
+		if (!has_data(pos) || data[pos] != '<')
 			return false;
 
 		pos++;
-		if (pos == size)
+		if (!has_data(pos))
 			XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
 		// Try to early predict what sort of node it might be:
@@ -159,47 +173,47 @@ namespace clan
 		if (closing || questionMark || exclamationMark)
 		{
 			pos++;
-			if (pos == size)
+			if (!has_data(pos))
 				XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 		}
 
 		if (exclamationMark) // check for cdata section, comments or doctype
 		{
-			if (next_exclamation_mark_node(out_token))
+			if (next_exclamation_mark_node())
 				return true;
 		}
 
 		// Extract the tag name:
 		std::string::size_type start_pos = pos;
-		std::string::size_type end_pos = data.find_first_of(" \r\n\t?/>", start_pos);
+		std::string::size_type end_pos = find_first_of(" \r\n\t?/>", start_pos);
 		if (end_pos == data.npos)
 			XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 		pos = end_pos;
 
-		out_token->type = questionMark ? XMLToken::PROCESSING_INSTRUCTION_TOKEN : XMLToken::ELEMENT_TOKEN;
-		out_token->variant = closing ? XMLToken::END : XMLToken::BEGIN;
-		out_token->name = data.substr(start_pos, end_pos - start_pos);
+		token_type = questionMark ? XMLToken::PROCESSING_INSTRUCTION_TOKEN : XMLToken::ELEMENT_TOKEN;
+		token_variant = closing ? XMLToken::END : XMLToken::BEGIN;
+		token_name = Range(start_pos, end_pos - start_pos, false);
 
-		if (out_token->type == XMLToken::PROCESSING_INSTRUCTION_TOKEN)
+		if (token_type == XMLToken::PROCESSING_INSTRUCTION_TOKEN)
 		{
 			// Strip whitespace:
-			pos = data.find_first_not_of(" \r\n\t", pos);
+			pos = find_first_not_of(" \r\n\t", pos);
 			if (pos == data.npos)
 				XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
-			end_pos = data.find_first_of("?", pos);
+			end_pos = find_first_of("?", pos);
 			if (end_pos == data.npos)
 				XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
-			out_token->value = data.substr(pos, end_pos - pos);
+			token_value = Range(pos, end_pos - pos, false);
 			pos = end_pos;
 		}
-		else // out_token->type == XMLToken::ELEMENT_TOKEN
+		else // token_type == XMLToken::ELEMENT_TOKEN
 		{
 			// Check for possible attributes:
 			while (true)
 			{
 				// Strip whitespace:
-				pos = data.find_first_not_of(" \r\n\t", pos);
+				pos = find_first_not_of(" \r\n\t", pos);
 				if (pos == data.npos)
 					XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
@@ -209,67 +223,62 @@ namespace clan
 
 				// Extract attribute name:
 				std::string::size_type start_pos = pos;
-				std::string::size_type end_pos = data.find_first_of(" \r\n\t=", start_pos);
+				std::string::size_type end_pos = find_first_of(" \r\n\t=", start_pos);
 				if (end_pos == data.npos)
 					XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 				pos = end_pos;
 
-				std::string attributeName = data.substr(start_pos, end_pos - start_pos);
+				Range attributeName(start_pos, end_pos - start_pos, false);
 
 				// Find seperator:
-				pos = data.find_first_not_of(" \r\n\t", pos);
-				if (pos == data.npos || pos == size - 1)
+				pos = find_first_not_of(" \r\n\t", pos);
+				if (pos == data.npos || !has_data(pos + 1))
 					XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 				if (data[pos++] != '=')
-					XMLTokenizer_Impl::throw_exception(string_format("XML error(s), parser confused at line %1 (tag=%2, attributeName=%3)", get_line_number(), out_token->name, attributeName));
+					XMLTokenizer_Impl::throw_exception(string_format("XML error(s), parser confused at line %1 (tag=%2, attributeName=%3)", get_line_number(), get_string(token_name), get_string(attributeName)));
 
 				// Strip whitespace:
-				pos = data.find_first_not_of(" \r\n\t", pos);
+				pos = find_first_not_of(" \r\n\t", pos);
 				if (pos == data.npos)
 					XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
 				// Extract attribute value:
-				std::string::value_type const * first_of = " \r\n\t";
-				if (data[pos] == '"')
+				std::string::value_type quote = 0;
+				if (data[pos] == '"' || data[pos] == '\'')
 				{
-					first_of = "\"";
+					quote = data[pos];
 					pos++;
-					if (pos == size)
+					if (!has_data(pos))
 						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 				}
-				else
-					if (data[pos] == '\'')
-					{
-						first_of = "'";
-						pos++;
-						if (pos == size)
-							XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
-					}
 
 				start_pos = pos;
-				end_pos = data.find_first_of(first_of, start_pos);
+				bool has_entity = (quote == 0);
+				end_pos = quote ? find_delimiter(start_pos, quote, has_entity) : find_first_of(" \r\n\t", start_pos);
 				if (end_pos == data.npos)
 					XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
-				std::string attributeValue;
-				std::string attributeValueOrig = data.substr(start_pos, end_pos - start_pos);
-				unescape(attributeValue, attributeValueOrig);
+				Range attributeValue(start_pos, end_pos - start_pos, has_entity);
 
 				pos = end_pos + 1;
-				if (pos == size)
+				if (!has_data(pos))
 					XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
 				// Finally apply attribute to token:
-				out_token->attributes.push_back(XMLToken::Attribute(attributeName, attributeValue));
+				if (token_attribute_count == token_attributes.size())
+					token_attributes.push_back(RawAttribute());
+				token_attributes[token_attribute_count].name = attributeName;
+				token_attributes[token_attribute_count].value = attributeValue;
+				token_attribute_count++;
 			}
 		}
 
 		// Check if its singular:
 		if (data[pos] == '/' || data[pos] == '?')
 		{
-			out_token->variant = XMLToken::SINGLE;
+			token_variant = XMLToken::SINGLE;
 			pos++;
-			if (pos == size)
+			if (!has_data(pos))
 				XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 		}
 
@@ -281,50 +290,48 @@ namespace clan
 		return true;
 	}
 
-	bool XMLTokenizer_Impl::next_exclamation_mark_node(XMLToken *out_token)
+	bool XMLTokenizer_Impl::next_exclamation_mark_node()
 	{
-		if (pos + 2 >= size)
+		if (!has_data(pos + 2))
 			XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
 		if (data.compare(pos, 2, "--") == 0) // comment block
 		{
 			std::string::size_type start_pos = pos + 2;
-			std::string::size_type end_pos = data.find("-->", start_pos);
+			std::string::size_type end_pos = find("-->", start_pos);
 			if (end_pos == data.npos)
 				XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 			pos = end_pos + 3;
 
-			std::string text;
-			std::string text_orig = data.substr(start_pos, end_pos - start_pos);
-			unescape(text, text_orig);
+			Range text(start_pos, end_pos - start_pos, true);
 			if (eat_whitespace)
-				text = trim_whitespace(text);
+				trim_whitespace(text);
 
-			out_token->type = XMLToken::COMMENT_TOKEN;
-			out_token->variant = XMLToken::SINGLE;
-			out_token->value = text;
+			token_type = XMLToken::COMMENT_TOKEN;
+			token_variant = XMLToken::SINGLE;
+			token_value = text;
 			return true;
 		}
 
-		if (pos + 7 >= size)
+		if (!has_data(pos + 7))
 			XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
 		if (data.compare(pos, 7, "DOCTYPE") == 0)
 		{
 			// Strip whitespace:
-			pos = data.find_first_not_of(" \r\n\t", pos + 7);
+			pos = find_first_not_of(" \r\n\t", pos + 7);
 			if (pos == data.npos)
 				XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
 			// Find doctype name:				
 			std::string::size_type name_start = pos;
-			std::string::size_type name_end = data.find_first_of(" \r\n\t?/>", name_start);
+			std::string::size_type name_end = find_first_of(" \r\n\t?/>", name_start);
 			if (name_end == data.npos)
 				XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 			pos = name_end;
 
 			// Strip whitespace:
-			pos = data.find_first_not_of(" \r\n\t", pos);
+			pos = find_first_not_of(" \r\n\t", pos);
 			if (pos == data.npos)
 				XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
@@ -338,17 +345,17 @@ namespace clan
 			// Look for possible external id:
 			if (data[pos] != '[' && data[pos] != '>')
 			{
-				if (pos + 6 >= size)
+				if (!has_data(pos + 6))
 					XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
 				if (data.compare(pos, 6, "SYSTEM") == 0)
 				{
 					pos += 6;
-					if (pos == size)
+					if (!has_data(pos))
 						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
 					// Strip whitespace:
-					pos = data.find_first_not_of(" \r\n\t", pos);
+					pos = find_first_not_of(" \r\n\t", pos);
 					if (pos == data.npos)
 						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
@@ -358,21 +365,21 @@ namespace clan
 						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
 					system_start = pos + 1;
-					system_end = data.find(literal_char, system_start);
+					system_end = find(literal_char, system_start);
 					if (system_end == data.npos)
 						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 					pos = system_end + 1;
-					if (pos >= size)
+					if (!has_data(pos))
 						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 				}
 				else if (data.compare(pos, 6, "PUBLIC") == 0)
 				{
 					pos += 6;
-					if (pos == size)
+					if (!has_data(pos))
 						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
 					// Strip whitespace:
-					pos = data.find_first_not_of(" \r\n\t", pos);
+					pos = find_first_not_of(" \r\n\t", pos);
 					if (pos == data.npos)
 						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
@@ -382,15 +389,15 @@ namespace clan
 						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
 					public_start = pos + 1;
-					public_end = data.find(literal_char, public_start);
+					public_end = find(literal_char, public_start);
 					if (public_end == data.npos)
 						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 					pos = public_end + 1;
-					if (pos >= size)
+					if (!has_data(pos))
 						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
 					// Strip whitespace:
-					pos = data.find_first_not_of(" \r\n\t", pos);
+					pos = find_first_not_of(" \r\n\t", pos);
 					if (pos == data.npos)
 						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
@@ -400,18 +407,18 @@ namespace clan
 						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
 					system_start = pos + 1;
-					system_end = data.find(literal_char, system_start);
+					system_end = find(literal_char, system_start);
 					if (system_end == data.npos)
 						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 					pos = system_end + 1;
-					if (pos >= size)
+					if (!has_data(pos))
 						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 				}
 				else
 					XMLTokenizer_Impl::throw_exception(string_format("Error in XML stream, line %1 (unknown external identifier type in DOCTYPE)", get_line_number()));
 
 				// Strip whitespace:
-				pos = data.find_first_not_of(" \r\n\t", pos);
+				pos = find_first_not_of(" \r\n\t", pos);
 				if (pos == data.npos)
 					XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 			}
@@ -423,7 +430,7 @@ namespace clan
 
 				// Search for the end of the internal subset:
 				// (to avoid parsing it, we search backwards)
-				std::string::size_type end_pos = data.find('>', pos + 1);
+				std::string::size_type end_pos = find('>', pos + 1);
 				if (end_pos == data.npos)
 					XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
@@ -439,27 +446,25 @@ namespace clan
 				XMLTokenizer_Impl::throw_exception(string_format("Error in XML stream, line %1 (expected end of DOCTYPE)", get_line_number()));
 			pos++;
 
-			out_token->type = XMLToken::DOCUMENT_TYPE_TOKEN;
+			token_type = XMLToken::DOCUMENT_TYPE_TOKEN;
 			return true;
 		}
 		else if (data.compare(pos, 7, "[CDATA[") == 0)
 		{
 			std::string::size_type start_pos = pos + 7;
-			std::string::size_type end_pos = data.find("]]>", start_pos);
+			std::string::size_type end_pos = find("]]>", start_pos);
 			if (end_pos == data.npos)
 				XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 			pos = end_pos + 3;
 
-			std::string value = data.substr(start_pos, end_pos - start_pos);
-
-			out_token->type = XMLToken::CDATA_SECTION_TOKEN;
-			out_token->variant = XMLToken::SINGLE;
-			out_token->value = value;
+			token_type = XMLToken::CDATA_SECTION_TOKEN;
+			token_variant = XMLToken::SINGLE;
+			token_value = Range(start_pos, end_pos - start_pos, false);
 			return true;
 		}
 		else
 		{
-			XMLTokenizer_Impl::throw_exception(string_format("Error in XML stream at position %1", static_cast<int>(pos)));
+			XMLTokenizer_Impl::throw_exception(string_format("Error in XML stream at position %1", static_cast<int>(discarded_bytes + pos)));
 			return false;
 		}
 	}
@@ -471,66 +476,322 @@ namespace clan
 
 	int XMLTokenizer_Impl::get_line_number()
 	{
-		int line = 1;
-		std::string::size_type tmp_pos = 0;
+		std::string::size_type end_pos = std::min(pos + 1, size);
+		return discarded_lines + 1 + (int)std::count(data.begin(), data.begin() + end_pos, '\n');
+	}
+
+	void XMLTokenizer_Impl::start()
+	{
+		chunk.resize(chunk_size);
 
-		std::string::const_iterator it;
-		for (it = data.begin(); it != data.end() && tmp_pos <= pos; ++it, tmp_pos++)
+		// Enough bytes to recognize the encoding
+		int received = 0;
+		while (received < 4)
 		{
-			if ((*it) == '\n')
-				line++;
+			int result = input.is_null() ? 0 : input.read(chunk.data() + received, chunk_size - received, false);
+			if (result <= 0)
+			{
+				end_of_input = true;
+				break;
+			}
+			received += result;
 		}
 
-		return line;
+		const unsigned char *bytes = (const unsigned char *)chunk.data();
+		int bom_length = 0;
+		switch (StringHelp::detect_bom(bytes, received))
+		{
+		default:
+		case StringHelp::bom_none:
+			// XML without a byte order mark must start with "<?xml" when it is not UTF-8
+			if (received >= 4 && bytes[0] == '<' && bytes[1] == 0 && bytes[2] == 0 && bytes[3] == 0)
+				encoding = encoding_utf32_le;
+			else if (received >= 4 && bytes[0] == 0 && bytes[1] == 0 && bytes[2] == 0 && bytes[3] == '<')
+				encoding = encoding_utf32_be;
+			else if (received >= 4 && bytes[0] == '<' && bytes[1] == 0 && bytes[2] == '?' && bytes[3] == 0)
+				encoding = encoding_utf16_le;
+			else if (received >= 4 && bytes[0] == 0 && bytes[1] == '<' && bytes[2] == 0 && bytes[3] == '?')
+				encoding = encoding_utf16_be;
+			break;
+		case StringHelp::bom_utf32_be:
+			encoding = encoding_utf32_be;
+			bom_length = 4;
+			break;
+		case StringHelp::bom_utf32_le:
+			encoding = encoding_utf32_le;
+			bom_length = 4;
+			break;
+		case StringHelp::bom_utf16_be:
+			encoding = encoding_utf16_be;
+			bom_length = 2;
+			break;
+		case StringHelp::bom_utf16_le:
+			encoding = encoding_utf16_le;
+			bom_length = 2;
+			break;
+		case StringHelp::bom_utf8:
+			bom_length = 3;
+			break;
+		}
+
+		decode(chunk.data() + bom_length, received - bom_length);
 	}
 
-	inline void XMLTokenizer_Impl::unescape(std::string &unescaped, const std::string &text)
+	void XMLTokenizer_Impl::discard_consumed()
 	{
-		static const std::string quot("&quot;");
-		static const std::string apos("&apos;");
-		static const std::string lt("&lt;");
-		static const std::string gt("&gt;");
-		static const std::string amp("&amp;");
-
-		unescaped = text;
-		unescape(unescaped, quot, '"');
-		unescape(unescaped, apos, '\'');
-		unescape(unescaped, lt, '<');
-		unescape(unescaped, gt, '>');
-		unescape(unescaped, amp, '&');
+		// Only worth the move when a good part of the buffer is behind us
+		if (pos >= (std::string::size_type)chunk_size && pos <= size)
+		{
+			discarded_lines += (int)std::count(data.begin(), data.begin() + pos, '\n');
+			discarded_bytes += pos;
+			data.erase(0, pos);
+			size = data.size();
+			pos = 0;
+		}
+	}
+
+	bool XMLTokenizer_Impl::read_more()
+	{
+		if (end_of_input)
+			return false;
+
+		int received = input.is_null() ? 0 : input.read(chunk.data(), chunk_size, false);
+		if (received > 0)
+		{
+			decode(chunk.data(), received);
+			return true;
+		}
+
+		end_of_input = true;
+		if (undecoded.length() >= 2 && encoding != encoding_utf32_le && encoding != encoding_utf32_be)
+		{
+			// Lone high surrogate at the end of the input
+			data += "\xef\xbf\xbd";
+			size = data.size();
+			return true;
+		}
+		return false;
+	}
+
+	namespace
+	{
+		void append_utf8(std::string &text, unsigned int c)
+		{
+			if (c < 0x80)
+			{
+				text += (char)c;
+			}
+			else if (c < 0x800)
+			{
+				text += (char)(0xc0 | (c >> 6));
+				text += (char)(0x80 | (c & 0x3f));
+			}
+			else if (c < 0x10000)
+			{
+				text += (char)(0xe0 | (c >> 12));
+				text += (char)(0x80 | ((c >> 6) & 0x3f));
+				text += (char)(0x80 | (c & 0x3f));
+			}
+			else
+			{
+				text += (char)(0xf0 | (c >> 18));
+				text += (char)(0x80 | ((c >> 12) & 0x3f));
+				text += (char)(0x80 | ((c >> 6) & 0x3f));
+				text += (char)(0x80 | (c & 0x3f));
+			}
+		}
 	}
 
-	inline void XMLTokenizer_Impl::unescape(std::string &text, const std::string &search, std::string::value_type replace)
+	void XMLTokenizer_Impl::decode(const char *bytes, std::string::size_type length)
 	{
+		if (encoding == encoding_utf8)
+		{
+			data.append(bytes, length);
+			size = data.size();
+			return;
+		}
+
+		undecoded.append(bytes, length);
+		const unsigned char *p = (const unsigned char *)undecoded.data();
+		std::string::size_type available = undecoded.length();
 		std::string::size_type read_pos = 0;
-		std::string::size_type length = text.length();
-		std::string::size_type search_length = search.length();
+		if (encoding == encoding_utf16_le || encoding == encoding_utf16_be)
+		{
+			bool big_endian = (encoding == encoding_utf16_be);
+			while (read_pos + 2 <= available)
+			{
+				unsigned int unit = big_endian ? ((p[read_pos] << 8) | p[read_pos + 1]) : (p[read_pos] | (p[read_pos + 1] << 8));
+				if (unit >= 0xd800 && unit <= 0xdbff)
+				{
+					if (read_pos + 4 > available)
+						break;
+					unsigned int low = big_endian ? ((p[read_pos + 2] << 8) | p[read_pos + 3]) : (p[read_pos + 2] | (p[read_pos + 3] << 8));
+					if (low >= 0xdc00 && low <= 0xdfff)
+					{
+						append_utf8(data, 0x10000 + ((unit - 0xd800) << 10) + (low - 0xdc00));
+						read_pos += 4;
+					}
+					else
+					{
+						append_utf8(data, 0xfffd);
+						read_pos += 2;
+					}
+				}
+				else
+				{
+					append_utf8(data, (unit >= 0xdc00 && unit <= 0xdfff) ? 0xfffd : unit);
+					read_pos += 2;
+				}
+			}
+		}
+		else
+		{
+			bool big_endian = (encoding == encoding_utf32_be);
+			while (read_pos + 4 <= available)
+			{
+				const unsigned char *q = p + read_pos;
+				unsigned int c = big_endian ? ((q[0] << 24) | (q[1] << 16) | (q[2] << 8) | q[3]) : (q[0] | (q[1] << 8) | (q[2] << 16) | (q[3] << 24));
+				append_utf8(data, (c > 0x10ffff || (c >= 0xd800 && c <= 0xdfff)) ? 0xfffd : c);
+				read_pos += 4;
+			}
+		}
+		undecoded.erase(0, read_pos);
+		size = data.size();
+	}
+
+	bool XMLTokenizer_Impl::has_data(std::string::size_type position)
+	{
+		while (position >= size)
+		{
+			if (!read_more())
+				return false;
+		}
+		return true;
+	}
+
+	std::string::size_type XMLTokenizer_Impl::find(char c, std::string::size_type start)
+	{
 		while (true)
 		{
-			std::string::size_type next_match = text.find(search, read_pos);
-			if (next_match == std::string::npos)
-				break;
+			std::string::size_type result = data.find(c, start);
+			if (result != std::string::npos)
+				return result;
+			start = std::max(start, size);
+			if (!read_more())
+				return std::string::npos;
+		}
+	}
 
-			std::string::size_type copy_size = length - (next_match + search_length);
-			if (copy_size > 0)
-				memmove(&text[next_match + 1], &text[next_match + search_length], copy_size * sizeof(std::string::value_type));
-			text[next_match] = replace;
-			length -= search_length - 1;
-			read_pos = next_match + 1;
-			if (read_pos > length)
-				break;
+	std::string::size_type XMLTokenizer_Impl::find(const char *str, std::string::size_type start)
+	{
+		std::string::size_type length = strlen(str);
+		while (true)
+		{
+			std::string::size_type result = data.find(str, start);
+			if (result != std::string::npos)
+				return result;
+			// The match may straddle the end of the buffer
+			if (size >= length)
+				start = std::max(start, size - length + 1);
+			if (!read_more())
+				return std::string::npos;
+		}
+	}
+
+	std::string::size_type XMLTokenizer_Impl::find_first_of(const char *chars, std::string::size_type start)
+	{
+		while (true)
+		{
+			std::string::size_type result = data.find_first_of(chars, start);
+			if (result != std::string::npos)
+				return result;
+			start = std::max(start, size);
+			if (!read_more())
+				return std::string::npos;
+		}
+	}
+
+	std::string::size_type XMLTokenizer_Impl::find_first_not_of(const char *chars, std::string::size_type start)
+	{
+		while (true)
+		{
+			std::string::size_type result = data.find_first_not_of(chars, start);
+			if (result != std::string::npos)
+				return result;
+			start = std::max(start, size);
+			if (!read_more())
+				return std::string::npos;
+		}
+	}
+
+	std::string::size_type XMLTokenizer_Impl::find_delimiter(std::string::size_type start, char delimiter, bool &has_entity)
+	{
+		while (true)
+		{
+			const char *begin = data.data();
+			const char *p = XMLScanner::find_any(begin + std::min(start, size), begin + size, delimiter, '&');
+			start = p - begin;
+			if (start < size)
+			{
+				if (*p == delimiter)
+					return start;
+				has_entity = true;
+				start++;
+			}
+			else if (!read_more())
+			{
+				return std::string::npos;
+			}
+		}
+	}
+
+	void XMLTokenizer_Impl::unescape(std::string &text)
+	{
+		std::string::size_type read_pos = text.find('&');
+		if (read_pos == std::string::npos)
+			return;
+
+		static const struct { const char *entity; std::string::size_type length; std::string::value_type replace; } entities[] =
+		{
+			{ "&quot;", 6, '"' },
+			{ "&apos;", 6, '\'' },
+			{ "&lt;", 4, '<' },
+			{ "&gt;", 4, '>' },
+			{ "&amp;", 5, '&' }
+		};
+
+		std::string::size_type write_pos = read_pos;
+		std::string::size_type length = text.length();
+		while (read_pos < length)
+		{
+			std::string::value_type c = text[read_pos];
+			if (c == '&')
+			{
+				for (const auto &entity : entities)
+				{
+					if (text.compare(read_pos, entity.length, entity.entity) == 0)
+					{
+						c = entity.replace;
+						read_pos += entity.length - 1;
+						break;
+					}
+				}
+			}
+			text[write_pos++] = c;
+			read_pos++;
 		}
-		text.resize(length);
+		text.resize(write_pos);
 	}
 
-	inline std::string XMLTokenizer_Impl::trim_whitespace(const std::string &text)
+	void XMLTokenizer_Impl::trim_whitespace(Range &range) const
 	{
-		std::string::size_type pos_start = text.find_first_not_of(" \t\r\n");
-		if (pos_start == std::string::npos)
-			return std::string();
-		std::string::size_type pos_end = text.find_last_not_of(" \t\r\n");
-		if (pos_end == std::string::npos)
-			return std::string();
-		return text.substr(pos_start, pos_end - pos_start + 1);
+		std::string::size_type start_pos = range.pos;
+		std::string::size_type end_pos = range.pos + range.length;
+		while (start_pos < end_pos && is_whitespace(data[start_pos]))
+			start_pos++;
+		while (end_pos > start_pos && is_whitespace(data[end_pos - 1]))
+			end_pos--;
+		range.pos = start_pos;
+		range.length = end_pos - start_pos;
 	}
 }
@@ -29,6 +29,8 @@
 #pragma once
 
 #include "API/Core/IOData/iodevice.h"
+#include "API/XML/xml_token.h"
+#include <vector>
 
 namespace clan
 {
@@ -37,21 +39,80 @@ namespace clan
 	public:
 		XMLTokenizer_Impl() : pos(0), size(0), eat_whitespace(true) { }
 
+		enum Encoding
+		{
+			encoding_utf8,
+			encoding_utf16_le,
+			encoding_utf16_be,
+			encoding_utf32_le,
+			encoding_utf32_be
+		};
+
+		static const int chunk_size = 64 * 1024;
+
+		// Part of data. has_entity is set when the characters must be unescaped before use
+		struct Range
+		{
+			Range() : pos(0), length(0), has_entity(false) { }
+			Range(std::string::size_type pos, std::string::size_type length, bool has_entity) : pos(pos), length(length), has_entity(has_entity) { }
+
+			std::string::size_type pos;
+			std::string::size_type length;
+			bool has_entity;
+		};
+
+		struct RawAttribute
+		{
+			Range name;
+			Range value;
+		};
+
 		IODevice input;
+		Encoding encoding = encoding_utf8;
+		bool end_of_input = false;
+		std::vector<char> chunk;
+		std::string undecoded; // UTF-16 and UTF-32 bytes not yet converted, such as half a surrogate pair at the end of a chunk
+
+		// UTF-8 window into the input. Everything before pos is discarded between tokens.
 		std::string::size_type pos, size;
 		std::string data;
+		std::string::size_type discarded_bytes = 0;
+		int discarded_lines = 0;
 		bool eat_whitespace;
 
+		// The current token. The ranges stay valid until the next call to next_token()
+		XMLToken::TokenType token_type = XMLToken::NULL_TOKEN;
+		XMLToken::TokenVariant token_variant = XMLToken::SINGLE;
+		Range token_name;
+		Range token_value;
+		std::vector<RawAttribute> token_attributes; // Only the first token_attribute_count are used, the rest are kept for reuse
+		size_t token_attribute_count = 0;
+
+		void start();
+		bool next_token();
+		std::string get_string(const Range &range) const;
+
 		static void throw_exception(const std::string &str);
-		bool next_text_node(XMLToken *out_token);
-		bool next_tag_node(XMLToken *out_token);
-		bool next_exclamation_mark_node(XMLToken *out_token);
+		bool next_text_node();
+		bool next_tag_node();
+		bool next_exclamation_mark_node();
 
 		// used to get the line number when there is an error in the xml file
 		int get_line_number();
 
-		void unescape(std::string &text_out, const std::string &text_in);
-		void unescape(std::string &text, const std::string &search, std::string::value_type replace);
-		std::string trim_whitespace(const std::string &text);
+		void discard_consumed();
+		bool read_more();
+		void decode(const char *bytes, std::string::size_type length);
+		bool has_data(std::string::size_type position);
+
+		std::string::size_type find(char c, std::string::size_type start);
+		std::string::size_type find(const char *str, std::string::size_type start);
+		std::string::size_type find_first_of(const char *chars, std::string::size_type start);
+		std::string::size_type find_first_not_of(const char *chars, std::string::size_type start);
+		std::string::size_type find_delimiter(std::string::size_type start, char delimiter, bool &has_entity);
+
+		static void unescape(std::string &text);
+		void trim_whitespace(Range &range) const;
+		static bool is_whitespace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
 	};
 }
@@ -43,11 +43,19 @@ namespace clan
 
 	XPathObject XPathEvaluator::evaluate(const std::string &expression, const DomNode &context_node) const
 	{
+		return evaluate(impl->get_cached_expression(expression), context_node);
+	}
+
+	XPathObject XPathEvaluator::evaluate(const XPathExpression &expression, const DomNode &context_node) const
+	{
+		if (expression.is_null())
+			throw XPathException("Cannot evaluate a null XPath expression");
+
 		XPathToken prev_token;
 		std::vector<DomNode> nodelist(1, context_node);
-		XPathEvaluateResult result = impl->evaluate(expression, nodelist, 0, prev_token);
+		XPathEvaluateResult result = impl->evaluate(*expression.impl, nodelist, 0, prev_token);
 		if (result.next_token.type != XPathToken::type_none)
-			throw XPathException("Expected end of expression", expression, result.next_token);
+			throw XPathException("Expected end of expression", expression.impl->text, result.next_token);
 		return result.result;
 	}
 }
@@ -33,20 +33,25 @@
 #include "API/XML/dom_node.h"
 #include "API/XML/dom_named_node_map.h"
 #include "API/XML/dom_element.h"
+#include "API/XML/dom_document.h"
 #include "API/XML/xpath_exception.h"
 #include "API/Core/Text/string_help.h"
 #include "API/Core/Text/string_format.h"
 #include "API/Core/Math/cl_math.h"
+#include "dom_node_generic.h"
+#include "dom_document_generic.h"
+#include "dom_tree_node.h"
 #include "xpath_evaluator_impl.h"
 #include "xpath_token.h"
 #include "xpath_location_step.h"
+#include "xpath_expression_impl.h"
 #include <cmath>
 #include <limits>
 
 namespace clan
 {
 	XPathEvaluateResult XPathEvaluator_Impl::evaluate(
-		const std::string &expression,
+		const XPathExpression_Impl &expression,
 		const XPathNodeSet &context,
 		XPathNodeSet::size_type context_node_index,
 		XPathToken prev_token) const
@@ -99,7 +104,7 @@ namespace clan
 			}
 			else if (cur_token.type == XPathToken::type_number)
 			{
-				operand_stack.push_back(XPathObject(StringHelp::text_to_double(cur_token.value.str)));
+				operand_stack.push_back(XPathObject(cur_token.value.number));
 			}
 			else if (cur_token.type == XPathToken::type_function_name)
 			{
@@ -108,7 +113,7 @@ namespace clan
 				if (cur_token.type != XPathToken::type_operator ||
 					cur_token.value.oper != XPathToken::operator_parenthesis_begin)
 				{
-					throw XPathException("Expected '(' after function name", expression, cur_token);
+					throw XPathException("Expected '(' after function name", expression.text, cur_token);
 				}
 
 				std::vector<XPathObject> parameters;
@@ -123,7 +128,7 @@ namespace clan
 						cur_token.value.oper == XPathToken::operator_parenthesis_end)
 						break;
 					if (cur_token.type != XPathToken::type_comma)
-						throw XPathException("Expected ',' or ')' in function call", expression, cur_token);
+						throw XPathException("Expected ',' or ')' in function call", expression.text, cur_token);
 				}
 
 				XPathObject obj = call_function(context, context_node_index, function_name, parameters);
@@ -132,23 +137,19 @@ namespace clan
 			else if (cur_token.type == XPathToken::type_bracket_begin)
 			{
 				if (operand_stack.empty())
-					throw XPathException("Missing operand before predicate", expression, cur_token);
+					throw XPathException("Missing operand before predicate", expression.text, cur_token);
 
 				Operand cur_operand = operand_stack.back();
 				operand_stack.pop_back();
 				if (cur_operand.get_type() != XPathObject::type_node_set)
-					throw XPathException("Expected node-set operand before '['", expression, cur_token);
-
-				XPathToken end_token = cur_token;
-				while (end_token.type != XPathToken::type_bracket_end && end_token.type != XPathToken::type_none)
-					end_token = read_token(expression, end_token);
+					throw XPathException("Expected node-set operand before '['", expression.text, cur_token);
 
+				XPathToken end_token = skip_predicate_expression(expression, cur_token);
 				if (end_token.type == XPathToken::type_none)
-					throw XPathException("Missing matching ']' in expression", expression, cur_token);
+					throw XPathException("Missing matching ']' in expression", expression.text, cur_token);
 
 				XPathLocationStep::Predicate predicate;
-				predicate.pos = cur_token.pos + cur_token.length;
-				predicate.length = end_token.pos - predicate.pos;
+				predicate.begin_token = cur_token.index;
 
 				XPathNodeSet filtered_nodes;
 				XPathNodeSet nodes = cur_operand.get_node_set();
@@ -198,7 +199,7 @@ namespace clan
 			}
 			else
 			{
-				throw XPathException("Unexpected token", expression, cur_token);
+				throw XPathException("Unexpected token", expression.text, cur_token);
 			}
 
 			prev_token = cur_token;
@@ -213,7 +214,7 @@ namespace clan
 				cur_token.type == XPathToken::type_operator &&
 				cur_token.value.oper == XPathToken::operator_parenthesis_end))
 		{
-			throw XPathException("Expected operand", expression, cur_token);
+			throw XPathException("Expected operand", expression.text, cur_token);
 		}
 
 		XPathEvaluateResult result;
@@ -222,6 +223,75 @@ namespace clan
 		return result;
 	}
 
+	void XPathEvaluator_Impl::compile(XPathExpression_Impl &expression) const
+	{
+		XPathToken token;
+		do
+		{
+			int index = (int)expression.tokens.size();
+			token = scan_token(expression.text, token);
+			token.index = index;
+			if (token.type == XPathToken::type_number)
+				token.value.number = StringHelp::text_to_double(token.value.str);
+			expression.tokens.push_back(token);
+		} while (token.type != XPathToken::type_none);
+
+		// Parse the location steps starting at every token that can begin one, so that
+		// evaluating the expression never has to parse them again.
+		expression.location_steps.resize(expression.tokens.size());
+		for (const auto &start_token : expression.tokens)
+		{
+			if (start_token.type == XPathToken::type_axis_name ||
+				start_token.type == XPathToken::type_name_test ||
+				start_token.type == XPathToken::type_node_type ||
+				start_token.type == XPathToken::type_at_sign ||
+				start_token.type == XPathToken::type_dot ||
+				start_token.type == XPathToken::type_double_dot ||
+				(start_token.type == XPathToken::type_operator && start_token.value.oper == XPathToken::operator_double_slash))
+			{
+				XPathCompiledSteps &compiled = expression.location_steps[start_token.index];
+				try
+				{
+					compiled.end_token = parse_location_steps(expression, start_token, compiled.steps).index;
+					compiled.is_valid = true;
+				}
+				catch (const XPathException &)
+				{
+					// Only an error if evaluation reaches these steps
+					compiled.steps.clear();
+				}
+			}
+		}
+	}
+
+	XPathExpression XPathEvaluator_Impl::get_cached_expression(const std::string &text)
+	{
+		{
+			std::lock_guard<std::mutex> lock(cache_mutex);
+			auto it = cache_lookup.find(text);
+			if (it != cache_lookup.end())
+			{
+				cached_expressions.splice(cached_expressions.begin(), cached_expressions, it->second);
+				return cached_expressions.front();
+			}
+		}
+
+		XPathExpression expression(text);
+
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		if (cache_lookup.find(text) == cache_lookup.end())
+		{
+			cached_expressions.push_front(expression);
+			cache_lookup[text] = cached_expressions.begin();
+			if (cached_expressions.size() > max_cached_expressions)
+			{
+				cache_lookup.erase(cached_expressions.back().get_expression());
+				cached_expressions.pop_back();
+			}
+		}
+		return expression;
+	}
+
 	XPathObject XPathEvaluator_Impl::call_function(const XPathNodeSet& context, XPathNodeSet::size_type context_node_index, const std::string &name, const std::vector<XPathObject> &parameters) const
 	{
 		if (name == "last")
@@ -858,7 +928,7 @@ namespace clan
 	}
 
 	XPathToken XPathEvaluator_Impl::read_location_path(
-		const std::string &expression,
+		const XPathExpression_Impl &expression,
 		XPathToken cur_token,
 		const XPathNodeSet &context,
 		XPathNodeSet::size_type context_node_index,
@@ -917,13 +987,31 @@ namespace clan
 	}
 
 	XPathToken XPathEvaluator_Impl::read_location_steps(
-		const std::string &expression,
+		const XPathExpression_Impl &expression,
 		XPathToken cur_token,
 		const XPathNodeSet &context,
 		XPathNodeSet::size_type context_node_index,
 		std::vector<XPathEvaluator_Impl::Operand> &operand_stack) const
 	{
-		std::vector<XPathLocationStep> steps;
+		const XPathCompiledSteps &compiled = expression.location_steps[cur_token.index];
+		if (!compiled.is_valid)
+		{
+			// Parsing failed when the expression was compiled. Parse again to report the error
+			std::vector<XPathLocationStep> steps;
+			parse_location_steps(expression, cur_token, steps);
+		}
+
+		XPathNodeSet nodeset;
+		evaluate_location_step(context, context_node_index, compiled.steps, 0, expression, nodeset);
+		operand_stack.push_back(XPathObject(nodeset));
+		return expression.tokens[compiled.end_token];
+	}
+
+	XPathToken XPathEvaluator_Impl::parse_location_steps(
+		const XPathExpression_Impl &expression,
+		XPathToken cur_token,
+		std::vector<XPathLocationStep> &steps) const
+	{
 		while (true)
 		{
 			XPathLocationStep step;
@@ -955,15 +1043,11 @@ namespace clan
 				break;
 			}
 		}
-
-		XPathNodeSet nodeset;
-		evaluate_location_step(context, context_node_index, steps, 0, expression, nodeset);
-		operand_stack.push_back(XPathObject(nodeset));
 		return cur_token;
 	}
 
 	XPathToken XPathEvaluator_Impl::read_location_step(
-		const std::string &expression,
+		const XPathExpression_Impl &expression,
 		XPathToken cur_token,
 		XPathLocationStep &step) const
 	{
@@ -991,19 +1075,19 @@ namespace clan
 	*/
 		if (cur_token.type == XPathToken::type_dot)
 		{
-			step.axis = "self";
+			step.axis = XPathLocationStep::axis_self;
 			step.test_type = XPathLocationStep::type_node;
 			step.node_type = XPathToken::node_type_node;
 		}
 		else if (cur_token.type == XPathToken::type_double_dot)
 		{
-			step.axis = "parent";
+			step.axis = XPathLocationStep::axis_parent;
 			step.test_type = XPathLocationStep::type_node;
 			step.node_type = XPathToken::node_type_node;
 		}
 		else if (cur_token.type == XPathToken::type_operator && cur_token.value.oper == XPathToken::operator_double_slash)
 		{
-			step.axis = "descendant-or-self";
+			step.axis = XPathLocationStep::axis_descendant_or_self;
 			step.test_type = XPathLocationStep::type_node;
 			step.node_type = XPathToken::node_type_node;
 		}
@@ -1012,20 +1096,49 @@ namespace clan
 			// Read AxisSpecifier:
 			if (cur_token.type == XPathToken::type_axis_name)
 			{
-				step.axis = cur_token.value.str;
+				const std::string &axis = cur_token.value.str;
+				if (axis == "ancestor")
+					step.axis = XPathLocationStep::axis_ancestor;
+				else if (axis == "ancestor-or-self")
+					step.axis = XPathLocationStep::axis_ancestor_or_self;
+				else if (axis == "attribute")
+					step.axis = XPathLocationStep::axis_attribute;
+				else if (axis == "child")
+					step.axis = XPathLocationStep::axis_child;
+				else if (axis == "descendant")
+					step.axis = XPathLocationStep::axis_descendant;
+				else if (axis == "descendant-or-self")
+					step.axis = XPathLocationStep::axis_descendant_or_self;
+				else if (axis == "following")
+					step.axis = XPathLocationStep::axis_following;
+				else if (axis == "following-sibling")
+					step.axis = XPathLocationStep::axis_following_sibling;
+				else if (axis == "namespace")
+					step.axis = XPathLocationStep::axis_namespace;
+				else if (axis == "parent")
+					step.axis = XPathLocationStep::axis_parent;
+				else if (axis == "preceding")
+					step.axis = XPathLocationStep::axis_preceding;
+				else if (axis == "preceding-sibling")
+					step.axis = XPathLocationStep::axis_preceding_sibling;
+				else if (axis == "self")
+					step.axis = XPathLocationStep::axis_self;
+				else
+					throw XPathException("Unknown location step axis", expression.text, cur_token);
+
 				cur_token = read_token(expression, cur_token);
 				if (cur_token.type != XPathToken::type_double_colon)
-					throw XPathException("Expected '::' after axis name", expression, cur_token);
+					throw XPathException("Expected '::' after axis name", expression.text, cur_token);
 				cur_token = read_token(expression, cur_token);
 			}
 			else if (cur_token.type == XPathToken::type_at_sign) // Abbreviated axis specifier
 			{
-				step.axis = "attribute";
+				step.axis = XPathLocationStep::axis_attribute;
 				cur_token = read_token(expression, cur_token);
 			}
 			else // Abbreviated syntax
 			{
-				step.axis = "child";
+				step.axis = XPathLocationStep::axis_child;
 			}
 
 			// Read Node Test:
@@ -1040,7 +1153,7 @@ namespace clan
 				step.node_type = cur_token.value.node_type;
 				cur_token = read_token(expression, cur_token);
 				if (cur_token.type != XPathToken::type_operator || cur_token.value.oper != XPathToken::operator_parenthesis_begin)
-					throw XPathException("Expected '(' after node-type test", expression, cur_token);
+					throw XPathException("Expected '(' after node-type test", expression.text, cur_token);
 				cur_token = read_token(expression, cur_token);
 				if (cur_token.type == XPathToken::type_literal && step.node_type == XPathToken::node_type_processing_instruction)
 				{
@@ -1048,20 +1161,19 @@ namespace clan
 					cur_token = read_token(expression, cur_token);
 				}
 				if (cur_token.type != XPathToken::type_operator || cur_token.value.oper != XPathToken::operator_parenthesis_end)
-					throw XPathException("Expected ')' after node-type test", expression, cur_token);
+					throw XPathException("Expected ')' after node-type test", expression.text, cur_token);
 			}
 			else
 			{
-				throw XPathException("Unknown node test type", expression, cur_token);
+				throw XPathException("Unknown node test type", expression.text, cur_token);
 			}
 
 			XPathToken next_token = read_token(expression, cur_token);
 			while (next_token.type == XPathToken::type_bracket_begin)
 			{
 				XPathLocationStep::Predicate predicate;
-				predicate.pos = next_token.pos + next_token.length;
+				predicate.begin_token = next_token.index;
 				cur_token = skip_predicate_expression(expression, next_token);
-				predicate.length = cur_token.pos - predicate.pos;
 				step.predicates.push_back(predicate);
 				next_token = read_token(expression, cur_token);
 			}
@@ -1069,7 +1181,7 @@ namespace clan
 		return cur_token;
 	}
 
-	XPathToken XPathEvaluator_Impl::skip_predicate_expression(const std::string &expression, const XPathToken &previous_token) const
+	XPathToken XPathEvaluator_Impl::skip_predicate_expression(const XPathExpression_Impl &expression, const XPathToken &previous_token) const
 	{
 		int bracket_count = 1;
 		XPathToken cur_token = previous_token;
@@ -1094,38 +1206,56 @@ namespace clan
 		return cur_token;
 	}
 
-	void XPathEvaluator_Impl::evaluate_location_step(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &nodes) const
+	void XPathEvaluator_Impl::evaluate_location_step(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &nodes) const
 	{
-		if (step_index < steps.size())
+		if (is_descendant_name_steps(steps, step_index) && context[context_node_index].is_document())
+		{
+			select_nodes_document_by_name(context, context_node_index, steps, step_index, expression, nodes);
+		}
+		else if (step_index < steps.size())
 		{
-			if (steps[step_index].axis == "ancestor")
+			switch (steps[step_index].axis)
+			{
+			case XPathLocationStep::axis_ancestor:
 				select_nodes_ancestor(context, context_node_index, steps, step_index, expression, nodes);
-			else if (steps[step_index].axis == "ancestor-or-self")
+				break;
+			case XPathLocationStep::axis_ancestor_or_self:
 				select_nodes_ancestor_or_self(context, context_node_index, steps, step_index, expression, nodes);
-			else if (steps[step_index].axis == "attribute")
+				break;
+			case XPathLocationStep::axis_attribute:
 				select_nodes_attribute(context, context_node_index, steps, step_index, expression, nodes);
-			else if (steps[step_index].axis == "child")
+				break;
+			case XPathLocationStep::axis_child:
 				select_nodes_child(context, context_node_index, steps, step_index, expression, nodes);
-			else if (steps[step_index].axis == "descendant")
+				break;
+			case XPathLocationStep::axis_descendant:
 				select_nodes_descendant(context, context_node_index, steps, step_index, expression, nodes);
-			else if (steps[step_index].axis == "descendant-or-self")
+				break;
+			case XPathLocationStep::axis_descendant_or_self:
 				select_nodes_descendant_or_self(context, context_node_index, steps, step_index, expression, nodes);
-			else if (steps[step_index].axis == "following")
+				break;
+			case XPathLocationStep::axis_following:
 				select_nodes_following(context, context_node_index, steps, step_index, expression, nodes);
-			else if (steps[step_index].axis == "follwing-sibling")
+				break;
+			case XPathLocationStep::axis_following_sibling:
 				select_nodes_following_sibling(context, context_node_index, steps, step_index, expression, nodes);
-			else if (steps[step_index].axis == "namespace")
+				break;
+			case XPathLocationStep::axis_namespace:
 				select_nodes_namespace(context, context_node_index, steps, step_index, expression, nodes);
-			else if (steps[step_index].axis == "parent")
+				break;
+			case XPathLocationStep::axis_parent:
 				select_nodes_parent(context, context_node_index, steps, step_index, expression, nodes);
-			else if (steps[step_index].axis == "preceding")
+				break;
+			case XPathLocationStep::axis_preceding:
 				select_nodes_preceding(context, context_node_index, steps, step_index, expression, nodes);
-			else if (steps[step_index].axis == "preceding-sibling")
+				break;
+			case XPathLocationStep::axis_preceding_sibling:
 				select_nodes_preceding_sibling(context, context_node_index, steps, step_index, expression, nodes);
-			else if (steps[step_index].axis == "self")
+				break;
+			case XPathLocationStep::axis_self:
 				select_nodes_self(context, context_node_index, steps, step_index, expression, nodes);
-			else
-				throw XPathException(string_format("Unknown location step axis", steps[step_index].axis), expression);
+				break;
+			}
 		}
 		else
 		{
@@ -1133,7 +1263,7 @@ namespace clan
 		}
 	}
 
-	void XPathEvaluator_Impl::select_nodes_ancestor(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &nodes) const
+	void XPathEvaluator_Impl::select_nodes_ancestor(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &nodes) const
 	{
 		XPathNodeSet nodeset;
 		DomNode parent = context[context_node_index].get_parent_node();
@@ -1148,7 +1278,7 @@ namespace clan
 		evaluate_location_step_predicates(nodeset, steps, step_index, expression, nodes);
 	}
 
-	void XPathEvaluator_Impl::select_nodes_ancestor_or_self(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &nodes) const
+	void XPathEvaluator_Impl::select_nodes_ancestor_or_self(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &nodes) const
 	{
 		XPathNodeSet nodeset;
 		DomNode parent = context[context_node_index];
@@ -1163,7 +1293,7 @@ namespace clan
 		evaluate_location_step_predicates(nodeset, steps, step_index, expression, nodes);
 	}
 
-	void XPathEvaluator_Impl::select_nodes_attribute(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &nodes) const
+	void XPathEvaluator_Impl::select_nodes_attribute(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &nodes) const
 	{
 		XPathNodeSet nodeset;
 		DomNamedNodeMap attributes = context[context_node_index].get_attributes();
@@ -1178,7 +1308,7 @@ namespace clan
 		evaluate_location_step_predicates(nodeset, steps, step_index, expression, nodes);
 	}
 
-	void XPathEvaluator_Impl::select_nodes_child(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &nodes) const
+	void XPathEvaluator_Impl::select_nodes_child(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &nodes) const
 	{
 		XPathNodeSet nodeset;
 		DomNode cur_node = context[context_node_index].get_first_child();
@@ -1192,7 +1322,7 @@ namespace clan
 		evaluate_location_step_predicates(nodeset, steps, step_index, expression, nodes);
 	}
 
-	void XPathEvaluator_Impl::select_nodes_descendant(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &nodes) const
+	void XPathEvaluator_Impl::select_nodes_descendant(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &nodes) const
 	{
 		XPathNodeSet parentNodes;
 		XPathNodeSet nodeset;
@@ -1218,7 +1348,7 @@ namespace clan
 		evaluate_location_step_predicates(nodeset, steps, step_index, expression, nodes);
 	}
 
-	void XPathEvaluator_Impl::select_nodes_descendant_or_self(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &nodes) const
+	void XPathEvaluator_Impl::select_nodes_descendant_or_self(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &nodes) const
 	{
 		XPathNodeSet parentNodes;
 		XPathNodeSet nodeset;
@@ -1244,7 +1374,78 @@ namespace clan
 		evaluate_location_step_predicates(nodeset, steps, step_index, expression, nodes);
 	}
 
-	void XPathEvaluator_Impl::select_nodes_following(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &nodes) const
+	bool XPathEvaluator_Impl::is_descendant_name_steps(const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index)
+	{
+		// Matches '//name', that is descendant-or-self::node()/child::name
+		if (step_index + 1 >= steps.size())
+			return false;
+		const XPathLocationStep &descendant_step = steps[step_index];
+		const XPathLocationStep &name_step = steps[step_index + 1];
+		return descendant_step.axis == XPathLocationStep::axis_descendant_or_self &&
+			descendant_step.test_type == XPathLocationStep::type_node &&
+			descendant_step.node_type == XPathToken::node_type_node &&
+			descendant_step.predicates.empty() &&
+			name_step.axis == XPathLocationStep::axis_child &&
+			name_step.test_type == XPathLocationStep::type_name;
+	}
+
+	void XPathEvaluator_Impl::select_nodes_document_by_name(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &nodes) const
+	{
+		// '//name' from the document node covers every element in the document, so ask the
+		// document for the elements by name (using its element index when enabled) rather than
+		// visiting each node and its children. The elements come back in document order.
+		const XPathLocationStep &name_step = steps[step_index + 1];
+		DomDocument_Impl *doc_impl = (DomDocument_Impl *)context[context_node_index].impl->owner_document.lock().get();
+		std::vector<unsigned int> elements = doc_impl->find_elements_by_tag_name(name_step.test_str);
+
+		XPathNodeSet nodeset;
+		if (name_step.predicates.empty())
+		{
+			nodeset.reserve(elements.size());
+			for (unsigned int element : elements)
+				nodeset.push_back(DomNode(doc_impl->get_dom_node(element)));
+		}
+		else
+		{
+			// Predicates apply to child::name, so positions are counted among the elements sharing a parent
+			std::unordered_map<unsigned int, std::vector<std::vector<unsigned int>::size_type> > siblings;
+			for (std::vector<unsigned int>::size_type i = 0; i < elements.size(); i++)
+				siblings[doc_impl->nodes[elements[i]]->parent].push_back(i);
+
+			std::vector<bool> accepted(elements.size(), false);
+			for (auto &group : siblings)
+			{
+				std::vector<std::vector<unsigned int>::size_type> &positions = group.second;
+				for (const auto &predicate : name_step.predicates)
+				{
+					XPathNodeSet candidates;
+					for (auto position : positions)
+						candidates.push_back(DomNode(doc_impl->get_dom_node(elements[position])));
+
+					std::vector<std::vector<unsigned int>::size_type> filtered_positions;
+					for (XPathNodeSet::size_type node_index = 0, num_nodes = candidates.size(); node_index < num_nodes; node_index++)
+					{
+						if (confirm_step_predicate(candidates, node_index, predicate, expression))
+							filtered_positions.push_back(positions[node_index]);
+					}
+					positions.swap(filtered_positions);
+				}
+				for (auto position : positions)
+					accepted[position] = true;
+			}
+
+			for (std::vector<unsigned int>::size_type i = 0; i < elements.size(); i++)
+			{
+				if (accepted[i])
+					nodeset.push_back(DomNode(doc_impl->get_dom_node(elements[i])));
+			}
+		}
+
+		for (XPathNodeSet::size_type node_index = 0, num_nodes = nodeset.size(); node_index < num_nodes; node_index++)
+			evaluate_location_step(nodeset, node_index, steps, step_index + 2, expression, nodes);
+	}
+
+	void XPathEvaluator_Impl::select_nodes_following(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &nodes) const
 	{
 		XPathNodeSet nodeset;
 
@@ -1280,7 +1481,7 @@ namespace clan
 		evaluate_location_step_predicates(nodeset, steps, step_index, expression, nodes);
 	}
 
-	void XPathEvaluator_Impl::select_nodes_following_sibling(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &nodes) const
+	void XPathEvaluator_Impl::select_nodes_following_sibling(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &nodes) const
 	{
 		XPathNodeSet nodeset;
 		DomNode cur_node = context[context_node_index].get_next_sibling();
@@ -1294,11 +1495,11 @@ namespace clan
 		evaluate_location_step_predicates(nodeset, steps, step_index, expression, nodes);
 	}
 
-	void XPathEvaluator_Impl::select_nodes_namespace(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &nodes) const
+	void XPathEvaluator_Impl::select_nodes_namespace(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &nodes) const
 	{
 	}
 
-	void XPathEvaluator_Impl::select_nodes_parent(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &nodes) const
+	void XPathEvaluator_Impl::select_nodes_parent(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &nodes) const
 	{
 		XPathNodeSet nodeset;
 		DomNode parent = context[context_node_index].get_parent_node();
@@ -1311,7 +1512,7 @@ namespace clan
 		evaluate_location_step_predicates(nodeset, steps, step_index, expression, nodes);
 	}
 
-	void XPathEvaluator_Impl::select_nodes_preceding(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &nodes) const
+	void XPathEvaluator_Impl::select_nodes_preceding(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &nodes) const
 	{
 		XPathNodeSet nodeset;
 
@@ -1347,7 +1548,7 @@ namespace clan
 		evaluate_location_step_predicates(nodeset, steps, step_index, expression, nodes);
 	}
 
-	void XPathEvaluator_Impl::select_nodes_preceding_sibling(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &nodes) const
+	void XPathEvaluator_Impl::select_nodes_preceding_sibling(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &nodes) const
 	{
 		XPathNodeSet nodeset;
 		DomNode cur_node = context[context_node_index].get_previous_sibling();
@@ -1361,7 +1562,7 @@ namespace clan
 		evaluate_location_step_predicates(nodeset, steps, step_index, expression, nodes);
 	}
 
-	void XPathEvaluator_Impl::select_nodes_self(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &nodes) const
+	void XPathEvaluator_Impl::select_nodes_self(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &nodes) const
 	{
 		DomNode cur_node = context[context_node_index];
 		if (!cur_node.is_null())
@@ -1371,7 +1572,7 @@ namespace clan
 		}
 	}
 
-	bool XPathEvaluator_Impl::confirm_step_requirements(const DomNode &node, const XPathLocationStep &step, const std::string &expression) const
+	bool XPathEvaluator_Impl::confirm_step_requirements(const DomNode &node, const XPathLocationStep &step, const XPathExpression_Impl &expression) const
 	{
 		bool test_passed = false;
 		switch (step.test_type)
@@ -1410,9 +1611,9 @@ namespace clan
 		return test_passed;
 	}
 
-	bool XPathEvaluator_Impl::confirm_step_predicate(XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const XPathLocationStep::Predicate &predicate, const std::string &expression) const
+	bool XPathEvaluator_Impl::confirm_step_predicate(XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const XPathLocationStep::Predicate &predicate, const XPathExpression_Impl &expression) const
 	{
-		XPathEvaluateResult result = evaluate(expression.substr(predicate.pos, predicate.length), context, context_node_index, XPathToken());
+		XPathEvaluateResult result = evaluate(expression, context, context_node_index, expression.tokens[predicate.begin_token]);
 		bool include_in_nodeset = false;
 		switch (result.result.get_type())
 		{
@@ -1434,7 +1635,7 @@ namespace clan
 		return include_in_nodeset;
 	}
 
-	void XPathEvaluator_Impl::evaluate_location_step_predicates(const XPathNodeSet &context, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &nodes) const
+	void XPathEvaluator_Impl::evaluate_location_step_predicates(const XPathNodeSet &context, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &nodes) const
 	{
 		XPathNodeSet nodeset = context;
 		for (const auto & elem : steps[step_index].predicates)
@@ -1452,7 +1653,18 @@ namespace clan
 			evaluate_location_step(nodeset, node_index, steps, step_index+1, expression, nodes);
 	}
 
-	XPathToken XPathEvaluator_Impl::read_token(
+	const XPathToken &XPathEvaluator_Impl::read_token(
+		const XPathExpression_Impl &expression,
+		const XPathToken &previous_token) const
+	{
+		std::vector<XPathToken>::size_type index = previous_token.index + 1;
+		if (index < expression.tokens.size())
+			return expression.tokens[index];
+		else
+			return expression.tokens.back();
+	}
+
+	XPathToken XPathEvaluator_Impl::scan_token(
 		const std::string &expression,
 		const XPathToken &previous_token) const
 	{
@@ -1859,21 +2071,40 @@ namespace clan
 			root_node = root_node.get_parent_node();
 
 		XPathNodeSet filtered_nodes;
+		if (root_node.is_document())
+		{
+			// Let the document resolve the IDs, using its element index when enabled
+			DomDocument document = root_node.to_document();
+			for (std::vector<std::string>::const_iterator it = strings.begin(), itEnd = strings.end(); it != itEnd; ++it)
+			{
+				DomElement element = document.get_element_by_id(*it);
+				if (!element.is_null())
+					filtered_nodes.push_back(element);
+			}
+			return XPathObject(filtered_nodes);
+		}
+
 		for (std::vector<std::string>::const_iterator it = strings.begin(), itEnd = strings.end(); it != itEnd; ++it)
 		{
 			XPathNodeSet parent_nodes;
 			DomNode cur_node = root_node;
 			while (!cur_node.is_null())
 			{
+				bool id_found = false;
 				if (cur_node.has_attributes())
 				{
 					DomNamedNodeMap attributes = cur_node.get_attributes();
-					if (attributes.get_named_item("ID").get_node_value() == *it)
+					for (unsigned long idx = 0, num_attributes = attributes.get_length(); idx < num_attributes && !id_found; idx++)
 					{
-						filtered_nodes.push_back(cur_node);
-						break;
+						DomNode attribute = attributes.item(idx);
+						id_found = DomDocument_Impl::is_id_attribute(attribute.get_node_name()) && attribute.get_node_value() == *it;
 					}
 				}
+				if (id_found)
+				{
+					filtered_nodes.push_back(cur_node);
+					break;
+				}
 				parent_nodes.push_back(cur_node);
 				cur_node = cur_node.get_first_child();
 				while (cur_node.is_null())
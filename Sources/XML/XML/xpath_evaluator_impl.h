@@ -30,8 +30,13 @@
 #pragma once
 
 #include "API/XML/xpath_object.h"
+#include "API/XML/xpath_expression.h"
 #include "xpath_token.h"
 #include "xpath_location_step.h"
+#include "xpath_expression_impl.h"
+#include <list>
+#include <mutex>
+#include <unordered_map>
 
 namespace clan
 {
@@ -49,11 +54,17 @@ namespace clan
 
 	public:
 		XPathEvaluateResult evaluate(
-			const std::string &expression,
+			const XPathExpression_Impl &expression,
 			const XPathNodeSet &context,
 			XPathNodeSet::size_type context_node_index,
 			XPathToken prev_token) const;
 
+		/// \brief Tokenizes expression.text and parses the location steps found in it
+		void compile(XPathExpression_Impl &expression) const;
+
+		/// \brief Returns the compiled form of an expression, compiling it on a cache miss
+		XPathExpression get_cached_expression(const std::string &text);
+
 	private:
 		typedef XPathToken::Operator Operator;
 		typedef XPathObject Operand;
@@ -76,50 +87,61 @@ namespace clan
 		bool compare_string(const Operand &a, const Operand &b, Operator oper) const;
 
 		XPathToken read_location_path(
-			const std::string &expression,
+			const XPathExpression_Impl &expression,
 			XPathToken cur_token,
 			const XPathNodeSet &context,
 			XPathNodeSet::size_type context_node_index,
 			std::vector<Operand> &operand_stack) const;
 
 		XPathToken read_location_steps(
-			const std::string &expression,
+			const XPathExpression_Impl &expression,
 			XPathToken cur_token,
 			const XPathNodeSet &context,
 			XPathNodeSet::size_type context_node_index,
 			std::vector<XPathEvaluator_Impl::Operand> &operand_stack) const;
 
 		XPathToken read_location_step(
-			const std::string &expression,
+			const XPathExpression_Impl &expression,
 			XPathToken cur_token,
 			XPathLocationStep &step) const;
 
-		XPathToken read_token(
+		XPathToken parse_location_steps(
+			const XPathExpression_Impl &expression,
+			XPathToken cur_token,
+			std::vector<XPathLocationStep> &steps) const;
+
+		const XPathToken &read_token(
+			const XPathExpression_Impl &expression,
+			const XPathToken &previous_token) const;
+
+		XPathToken scan_token(
 			const std::string &expression,
-			const XPathToken &previous_token = XPathToken()) const;
+			const XPathToken &previous_token) const;
 
 		XPathToken skip_predicate_expression(
-			const std::string &expression,
-			const XPathToken &previous_token = XPathToken()) const;
-
-		void evaluate_location_step(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &out_nodeset) const;
-		void evaluate_location_step_predicates(const XPathNodeSet &context, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string & expression, XPathNodeSet & nodes) const;
-
-		void select_nodes_ancestor(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &out_nodeset) const;
-		void select_nodes_ancestor_or_self(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &out_nodeset) const;
-		void select_nodes_attribute(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &out_nodeset) const;
-		void select_nodes_child(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &out_nodeset) const;
-		void select_nodes_descendant(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &out_nodeset) const;
-		void select_nodes_descendant_or_self(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &out_nodeset) const;
-		void select_nodes_following(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &out_nodeset) const;
-		void select_nodes_following_sibling(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &out_nodeset) const;
-		void select_nodes_namespace(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &out_nodeset) const;
-		void select_nodes_parent(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &out_nodeset) const;
-		void select_nodes_preceding(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &out_nodeset) const;
-		void select_nodes_preceding_sibling(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &out_nodeset) const;
-		void select_nodes_self(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const std::string &expression, XPathNodeSet &out_nodeset) const;
-		bool confirm_step_requirements(const DomNode &node, const XPathLocationStep &step, const std::string &expression) const;
-		bool confirm_step_predicate(XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const XPathLocationStep::Predicate &predicate, const std::string &expression) const;
+			const XPathExpression_Impl &expression,
+			const XPathToken &previous_token) const;
+
+		void evaluate_location_step(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &out_nodeset) const;
+		void evaluate_location_step_predicates(const XPathNodeSet &context, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet & nodes) const;
+
+		void select_nodes_ancestor(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &out_nodeset) const;
+		void select_nodes_ancestor_or_self(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &out_nodeset) const;
+		void select_nodes_attribute(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &out_nodeset) const;
+		void select_nodes_child(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &out_nodeset) const;
+		void select_nodes_descendant(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &out_nodeset) const;
+		void select_nodes_descendant_or_self(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &out_nodeset) const;
+		void select_nodes_following(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &out_nodeset) const;
+		void select_nodes_following_sibling(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &out_nodeset) const;
+		void select_nodes_namespace(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &out_nodeset) const;
+		void select_nodes_parent(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &out_nodeset) const;
+		void select_nodes_preceding(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &out_nodeset) const;
+		void select_nodes_preceding_sibling(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &out_nodeset) const;
+		void select_nodes_self(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &out_nodeset) const;
+		void select_nodes_document_by_name(const XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index, const XPathExpression_Impl &expression, XPathNodeSet &out_nodeset) const;
+		static bool is_descendant_name_steps(const std::vector<XPathLocationStep> &steps, std::vector<XPathLocationStep>::size_type step_index);
+		bool confirm_step_requirements(const DomNode &node, const XPathLocationStep &step, const XPathExpression_Impl &expression) const;
+		bool confirm_step_predicate(XPathNodeSet &context, XPathNodeSet::size_type context_node_index, const XPathLocationStep::Predicate &predicate, const XPathExpression_Impl &expression) const;
 
 		XPathObject call_function(const XPathNodeSet& context, XPathNodeSet::size_type context_node_index, const std::string &name, const std::vector<XPathObject> &parameters) const;
 		XPathObject get_variable(const std::string &name) const;
@@ -164,5 +186,11 @@ namespace clan
 		static inline bool boolean(const DomNode &node);
 		static inline double number(const DomNode &node);
 		static inline std::string string(const DomNode &node);
+
+		static const size_t max_cached_expressions = 64;
+
+		std::mutex cache_mutex;
+		std::list<XPathExpression> cached_expressions;
+		std::unordered_map<std::string, std::list<XPathExpression>::iterator> cache_lookup;
 	};
 }
@@ -86,17 +86,26 @@ namespace clan
 
 		struct Value
 		{
+			Value()
+				: node_type(node_type_node), oper(operator_parenthesis_begin), number(0.0)
+			{
+			}
+
 			NodeType node_type;
 			Operator oper;
 			std::string str;
+			double number;
 		};
 
 		Type type;
 		Value value;
 		std::string::size_type pos, length;
 
+		/// \brief Position in the compiled token list, -1 before the first token
+		int index;
+
 		XPathToken()
-			: type(type_none), pos(0), length(0)
+			: type(type_none), pos(0), length(0), index(-1)
 		{
 		}
 	};
@@ -51,6 +51,7 @@ int TestApp::main()
 #endif
 		Console::write_line("Directory: API/Core/Math");
 
+		test_crc32();
 		test_md5();
 		test_rsa();
 		test_aes128();
@@ -71,6 +71,7 @@ private:
 	void convert_ascii(const char *src, std::vector<unsigned char> &dest);
 
 	void test_rsa();
+	void test_crc32();
 	void test_md5();
 	void test_hash(const MD5 &sha1, const char *hash_text);
 	void test_sha1();
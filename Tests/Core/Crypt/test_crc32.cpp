@@ -0,0 +1,129 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+
+namespace
+{
+	// Byte at a time reference implementation
+	uint32_t reference_crc32(const unsigned char *data, size_t size)
+	{
+		static uint32_t table[256];
+		static bool table_initialized = false;
+		if (!table_initialized)
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t crc = i;
+				for (int bit = 0; bit < 8; bit++)
+					crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+				table[i] = crc;
+			}
+			table_initialized = true;
+		}
+
+		uint32_t crc = 0xffffffff;
+		for (size_t i = 0; i < size; i++)
+			crc = (crc >> 8) ^ table[(crc ^ data[i]) & 0xff];
+		return ~crc;
+	}
+}
+
+void TestApp::test_crc32()
+{
+	Console::write_line(" Header: hash_functions.h");
+	Console::write_line("  Class: HashFunctions");
+	Console::write_line("   Function: crc32()");
+
+	const char *check_str = "123456789";
+	if (HashFunctions::crc32(check_str, strlen(check_str)) != 0xcbf43926)
+		fail();
+	if (HashFunctions::crc32(nullptr, 0) != 0)
+		fail();
+
+	std::vector<unsigned char> data(1024 * 1024 + 77);
+	unsigned int seed = 1;
+	for (auto &value : data)
+	{
+		seed = seed * 1103515245 + 12345;
+		value = (unsigned char)(seed >> 23);
+	}
+
+	// Every length and alignment around the block sizes of the accelerated paths
+	for (int offset = 0; offset < 16; offset++)
+	{
+		for (int length = 0; length < 300; length++)
+		{
+			if (HashFunctions::crc32(data.data() + offset, length) != reference_crc32(data.data() + offset, length))
+				fail();
+		}
+	}
+
+	uint32_t full_crc = reference_crc32(data.data(), data.size());
+	if (HashFunctions::crc32(data.data(), data.size()) != full_crc)
+		fail();
+
+	Console::write_line("   Function: crc32() running");
+	uint32_t running_crc = 0;
+	size_t pos = 0;
+	while (pos < data.size())
+	{
+		seed = seed * 1103515245 + 12345;
+		size_t length = std::min((size_t)(seed >> 16) % 5000, data.size() - pos);
+		running_crc = HashFunctions::crc32(data.data() + pos, length, running_crc);
+		pos += length;
+	}
+	if (running_crc != full_crc)
+		fail();
+
+	Console::write_line("   Function: crc32_combine()");
+	for (size_t split : { (size_t)0, (size_t)1, (size_t)63, (size_t)4096, data.size() / 2, data.size() - 1, data.size() })
+	{
+		uint32_t crc1 = HashFunctions::crc32(data.data(), split);
+		uint32_t crc2 = HashFunctions::crc32(data.data() + split, data.size() - split);
+		if (HashFunctions::crc32_combine(crc1, crc2, data.size() - split) != full_crc)
+			fail();
+	}
+
+	const int iterations = 64;
+	uint64_t start_time = System::get_microseconds();
+	uint32_t sum = 0;
+	for (int i = 0; i < iterations; i++)
+		sum += reference_crc32(data.data(), data.size());
+	uint64_t reference_time = System::get_microseconds() - start_time;
+
+	start_time = System::get_microseconds();
+	for (int i = 0; i < iterations; i++)
+		sum -= HashFunctions::crc32(data.data(), data.size());
+	uint64_t crc32_time = System::get_microseconds() - start_time;
+	if (sum != 0)
+		fail();
+
+	Console::write_line("   crc32 of %1 MB: byte table %2 ms, HashFunctions::crc32 %3 ms", iterations, (int)(reference_time / 1000), (int)(crc32_time / 1000));
+}
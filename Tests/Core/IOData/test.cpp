@@ -78,6 +78,9 @@ int TestApp::main()
 		test_directory_scanner();
 		test_iodevice();
 		test_iodevice_memory();
+		test_iodevice_buffered();
+		test_file_mapped();
+		test_async_file_loader();
 		test_virtual_directory_part2();
 		
 		Console::write_line("All Tests Complete");
@@ -67,6 +67,9 @@ private:
 	void test_directory_scanner(void);
 	void test_iodevice_memory(void);
 	void test_iodevice(void);
+	void test_file_mapped(void);
+	void test_iodevice_buffered(void);
+	void test_async_file_loader(void);
 	void test_virtual_directory_part2(void);
 	void fail(void);
 	void test_vfs();
@@ -0,0 +1,173 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+
+void TestApp::test_async_file_loader(void)
+{
+	Console::write_line(" Header: async_file_loader.h");
+	Console::write_line("  Class: AsyncFileLoader");
+
+	const std::string filename = "test_async_file_loader.tmp";
+	const std::string zip_filename = "test_async_file_loader.zip";
+	const int test_data_size = 600000;
+	DataBuffer test_data(test_data_size);
+	for (int cnt = 0; cnt < test_data_size; cnt++)
+		test_data.get_data()[cnt] = (char)(cnt * 7 + (cnt >> 12));
+	File::write_bytes(filename, test_data);
+	{
+		ZipArchive zip;
+		zip.add_file(filename, "data.bin");
+		zip.save(zip_filename);
+	}
+
+	Console::write_line("   Function: AsyncFileRequest read_bytes(const std::string &filename, int priority, const Callback &callback)");
+	{
+		AsyncFileLoader loader;
+		if (loader.get_num_threads() != 2) fail();
+
+		int callbacks_called = 0;
+		AsyncFileRequest request = loader.read_bytes(filename, 0, [&](const AsyncFileRequest &completed)
+		{
+			if (completed.get_status() != AsyncFileRequest::status_completed) fail();
+			callbacks_called++;
+		});
+		if (request.get_filename() != filename) fail();
+
+		DataBuffer data = request.get_data();
+		if (!request.is_done()) fail();
+		if (data.get_size() != test_data_size) fail();
+		if (memcmp(data.get_data(), test_data.get_data(), test_data_size)) fail();
+
+		// Callbacks are only invoked by process_completed when there is no dispatcher
+		if (callbacks_called != 0) fail();
+		loader.process_completed();
+		if (callbacks_called != 1) fail();
+
+		AsyncFileRequest missing = loader.read_bytes("this_file_does_not_exist.tmp");
+		missing.wait();
+		if (missing.get_status() != AsyncFileRequest::status_failed) fail();
+		if (missing.get_error().empty()) fail();
+		bool get_failed = false;
+		try
+		{
+			missing.get_data();
+		}
+		catch (const Exception &)
+		{
+			get_failed = true;
+		}
+		if (!get_failed) fail();
+	}
+
+	Console::write_line("   Function: AsyncFileRequest read_bytes(const FileSystem &fs, const std::string &filename, int priority, const Callback &callback)");
+	{
+		AsyncFileLoader loader;
+		FileSystem zip_fs(zip_filename, true);
+		FileSystem native_fs(".");
+
+		AsyncFileRequest zip_request = loader.read_bytes(zip_fs, "data.bin");
+		AsyncFileRequest native_request = loader.read_bytes(native_fs, filename);
+
+		DataBuffer data = zip_request.get_data();
+		if (data.get_size() != test_data_size) fail();
+		if (memcmp(data.get_data(), test_data.get_data(), test_data_size)) fail();
+
+		data = native_request.get_data();
+		if (data.get_size() != test_data_size) fail();
+		if (memcmp(data.get_data(), test_data.get_data(), test_data_size)) fail();
+
+		if (!native_request.wait(1000)) fail();
+	}
+
+	Console::write_line("   Function: AsyncFileLoader(int num_threads, const Dispatcher &dispatcher)");
+	{
+		std::mutex mutex;
+		std::vector<std::function<void()>> dispatched;
+		AsyncFileLoader loader(1, [&](std::function<void()> func)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			dispatched.push_back(func);
+		});
+
+		// With one thread the high priority request must be read before every low priority request still queued
+		std::vector<std::string> order;
+		auto callback = [&](const AsyncFileRequest &request) { order.push_back(string_format("%1", request.get_priority())); };
+		std::vector<AsyncFileRequest> requests;
+		for (int cnt = 0; cnt < 4; cnt++)
+			requests.push_back(loader.read_bytes(filename, 0, callback));
+		requests.push_back(loader.read_bytes(filename, 10, callback));
+
+		for (auto &request : requests)
+			request.wait();
+		while (loader.get_requests_pending() > 0)
+			System::sleep(1);
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			for (auto &func : dispatched)
+				func();
+		}
+		loader.process_completed();
+		if (order.size() != 5) fail();
+		if (order.back() == "10") fail();
+	}
+
+	Console::write_line("   Function: void cancel()");
+	{
+		AsyncFileLoader loader(1);
+		int callbacks_called = 0;
+		std::vector<AsyncFileRequest> requests;
+		for (int cnt = 0; cnt < 20; cnt++)
+			requests.push_back(loader.read_bytes(filename, 0, [&](const AsyncFileRequest &) { callbacks_called++; }));
+
+		requests.back().cancel();
+		loader.cancel_all();
+
+		int completed = 0;
+		for (auto &request : requests)
+		{
+			if (!request.wait(5000)) fail();
+			AsyncFileRequest::Status status = request.get_status();
+			if (status == AsyncFileRequest::status_completed)
+				completed++;
+			else if (status != AsyncFileRequest::status_cancelled)
+				fail();
+		}
+		if (requests.back().get_status() != AsyncFileRequest::status_cancelled) fail();
+
+		while (loader.get_requests_pending() > 0)
+			System::sleep(1);
+		loader.process_completed();
+		if (callbacks_called != completed) fail();
+	}
+
+	FileHelp::delete_file(filename);
+	FileHelp::delete_file(zip_filename);
+}
@@ -0,0 +1,130 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+
+void TestApp::test_file_mapped(void)
+{
+	Console::write_line(" Header: file.h");
+	Console::write_line("  Class: File (memory mapped)");
+
+	const std::string filename = "test_file_mapped.tmp";
+	const int test_data_size = 1000;
+	char test_data[test_data_size];
+	for (int cnt = 0; cnt < test_data_size; cnt++)
+		test_data[cnt] = (char)(cnt * 7);
+	File::write_bytes(filename, DataBuffer(test_data, test_data_size));
+
+	Console::write_line("   Function: static File open_mapped(const std::string &filename)");
+	{
+		File file = File::open_mapped(filename);
+		if (file.get_size() != test_data_size) fail();
+		if (file.get_position() != 0) fail();
+
+		const char *mapped = static_cast<const char *>(file.get_mapped_data());
+		if (mapped == nullptr) fail();
+		if (memcmp(mapped, test_data, test_data_size)) fail();
+
+		char buffer[test_data_size];
+		if (file.peek(buffer, 10) != 10) fail();
+		if (file.get_position() != 0) fail();
+		if (file.read(buffer, 100) != 100) fail();
+		if (memcmp(buffer, test_data, 100)) fail();
+		if (file.get_position() != 100) fail();
+
+		if (!file.seek(-10, IODevice::seek_end)) fail();
+		if (file.read(buffer, 100, false) != 10) fail();
+		if (memcmp(buffer, test_data + test_data_size - 10, 10)) fail();
+		if (file.read(buffer, 100, false) != 0) fail();
+		if (file.seek(test_data_size + 1)) fail();
+
+		file.seek(4);
+		file.set_little_endian_mode();
+		uint32_t value = file.read_uint32();
+		uint32_t expected;
+		memcpy(&expected, test_data + 4, 4);
+		if (value != expected) fail();
+
+		IODevice copy = file.duplicate();
+		if (copy.get_mapped_data() != file.get_mapped_data()) fail();
+		if (copy.get_position() != 0) fail();
+
+		bool write_failed = false;
+		try
+		{
+			file.write(test_data, 1);
+		}
+		catch (const Exception &)
+		{
+			write_failed = true;
+		}
+		if (!write_failed) fail();
+
+		file.close();
+		if (file.get_mapped_data() != nullptr) fail();
+	}
+
+	Console::write_line("   Function: File(..., flag_memory_mapped)");
+	{
+		File file(filename, File::open_existing, File::access_read, File::share_read, File::flag_memory_mapped);
+		if (file.get_mapped_data() == nullptr) fail();
+
+		File unmapped(filename);
+		if (unmapped.get_mapped_data() != nullptr) fail();
+
+		bool open_failed = false;
+		try
+		{
+			File writable(filename, File::open_existing, File::access_read_write, File::share_all, File::flag_memory_mapped);
+		}
+		catch (const Exception &)
+		{
+			open_failed = true;
+		}
+		if (!open_failed) fail();
+	}
+
+	Console::write_line("   Function: FileSystem::open_file(..., flag_memory_mapped)");
+	{
+		FileSystem fs(".");
+		IODevice device = fs.open_file(filename, File::open_existing, File::access_read, File::share_read, File::flag_memory_mapped);
+		if (device.get_mapped_data() == nullptr) fail();
+		if (memcmp(device.get_mapped_data(), test_data, test_data_size)) fail();
+	}
+
+	File::write_bytes(filename, DataBuffer());
+	{
+		File file = File::open_mapped(filename);
+		if (file.get_size() != 0) fail();
+		char buffer[1];
+		if (file.read(buffer, 1, false) != 0) fail();
+	}
+
+	FileHelp::delete_file(filename);
+}
@@ -0,0 +1,263 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+
+namespace
+{
+	// Memory provider that counts the calls reaching it
+	class CountingProvider : public IODeviceProvider
+	{
+	public:
+		CountingProvider(std::vector<char> *data) : data(data) { }
+
+		int get_size() const override { return (int)data->size(); }
+		int get_position() const override { return position; }
+
+		int send(const void *src, int len, bool send_all) override
+		{
+			send_calls++;
+			if (position + len > (int)data->size())
+				data->resize(position + len);
+			memcpy(data->data() + position, src, len);
+			position += len;
+			return len;
+		}
+
+		int receive(void *dest, int len, bool receive_all) override
+		{
+			receive_calls++;
+			int size = std::min(len, (int)data->size() - position);
+			memcpy(dest, data->data() + position, size);
+			position += size;
+			return size;
+		}
+
+		int peek(void *dest, int len) override
+		{
+			int size = std::min(len, (int)data->size() - position);
+			memcpy(dest, data->data() + position, size);
+			return size;
+		}
+
+		bool seek(int new_position, IODevice::SeekMode mode) override
+		{
+			seek_calls++;
+			switch (mode)
+			{
+			case IODevice::seek_set: break;
+			case IODevice::seek_cur: new_position += position; break;
+			case IODevice::seek_end: new_position += (int)data->size(); break;
+			}
+			if (new_position < 0 || new_position > (int)data->size())
+				return false;
+			position = new_position;
+			return true;
+		}
+
+		IODeviceProvider *duplicate() override { return new CountingProvider(data); }
+
+		std::vector<char> *data;
+		int position = 0;
+		int send_calls = 0;
+		int receive_calls = 0;
+		int seek_calls = 0;
+	};
+}
+
+void TestApp::test_iodevice_buffered(void)
+{
+	Console::write_line(" Header: iodevice.h");
+	Console::write_line("  Class: IODevice (buffered)");
+
+	std::vector<char> data(10000);
+	for (size_t cnt = 0; cnt < data.size(); cnt++)
+		data[cnt] = (char)(cnt * 13);
+
+	Console::write_line("   Function: void set_buffer_size(int read_ahead_size, int write_behind_size)");
+	{
+		CountingProvider *provider = new CountingProvider(&data);
+		IODevice device(provider);
+		device.set_buffer_size(1024);
+		if (device.get_read_ahead_size() != 1024) fail();
+		if (device.get_write_behind_size() != 0) fail();
+
+		for (int cnt = 0; cnt < 256; cnt++)
+		{
+			uint32_t expected;
+			memcpy(&expected, data.data() + cnt * 4, 4);
+			if (device.read_uint32() != expected) fail();
+		}
+		if (provider->receive_calls != 1) fail();
+		if (device.get_position() != 1024) fail();
+
+		// Request spanning the buffer end
+		char buffer[4096];
+		if (device.read(buffer, 100) != 100) fail();
+		if (memcmp(buffer, data.data() + 1024, 100)) fail();
+
+		// Requests larger than the buffer go directly to the provider
+		if (device.read(buffer, 4000) != 4000) fail();
+		if (memcmp(buffer, data.data() + 1124, 4000)) fail();
+		if (device.get_position() != 5124) fail();
+
+		if (device.peek(buffer, 10) != 10) fail();
+		if (memcmp(buffer, data.data() + 5124, 10)) fail();
+		if (device.get_position() != 5124) fail();
+		if (device.read_uint8() != (uint8_t)data[5124]) fail();
+
+		// Seeking inside the buffer does not reach the provider
+		int seek_calls = provider->seek_calls;
+		int receive_calls = provider->receive_calls;
+		if (!device.seek(-1, IODevice::seek_cur)) fail();
+		if (device.read_uint8() != (uint8_t)data[5124]) fail();
+		if (!device.seek(5200)) fail();
+		if (device.read_uint8() != (uint8_t)data[5200]) fail();
+		if (provider->seek_calls != seek_calls) fail();
+		if (provider->receive_calls != receive_calls) fail();
+
+		// Seeking outside the buffer invalidates it
+		if (!device.seek(100)) fail();
+		if (device.get_position() != 100) fail();
+		if (device.read_uint8() != (uint8_t)data[100]) fail();
+		if (!device.seek(-10, IODevice::seek_end)) fail();
+		if (device.read(buffer, 100, false) != 10) fail();
+		if (memcmp(buffer, data.data() + data.size() - 10, 10)) fail();
+		if (device.read(buffer, 100, false) != 0) fail();
+		if (!device.seek(5000, IODevice::seek_set)) fail();
+		if (!device.seek(2000, IODevice::seek_cur)) fail();
+		if (device.get_position() != 7000) fail();
+		if (device.read_uint8() != (uint8_t)data[7000]) fail();
+
+		// Direct provider access sees the logical position
+		if (device.get_provider()->get_position() != 7001) fail();
+	}
+
+	Console::write_line("   Function: void flush()");
+	{
+		std::vector<char> output;
+		CountingProvider *provider = new CountingProvider(&output);
+		IODevice device(provider);
+		device.set_buffer_size(0, 256);
+
+		for (int cnt = 0; cnt < 100; cnt++)
+			device.write_int32(cnt);
+		if (provider->send_calls != 1) fail();
+		if (device.get_position() != 400) fail();
+		device.flush();
+		if (provider->send_calls != 2) fail();
+		if (output.size() != 400) fail();
+
+		device.write_int16(1234);
+		if (device.get_size() != 402) fail();
+		if (!device.seek(0)) fail();
+		for (int cnt = 0; cnt < 100; cnt++)
+		{
+			if (device.read_int32() != cnt) fail();
+		}
+		if (device.read_int16() != 1234) fail();
+	}
+
+	Console::write_line("   Function: mixed buffered reads and writes");
+	{
+		std::vector<char> copy = data;
+		IODevice device(new CountingProvider(&copy));
+		device.set_buffer_size(512, 512);
+
+		if (device.read_uint8() != (uint8_t)data[0]) fail();
+		device.write_uint8(0xAB);
+		if (device.get_position() != 2) fail();
+		if (device.read_uint8() != (uint8_t)data[2]) fail();
+		if ((uint8_t)copy[1] != 0xAB) fail();
+		if ((uint8_t)copy[2] != (uint8_t)data[2]) fail();
+
+		device.write_uint8(0xCD);
+		device.seek(3);
+		if (device.read_uint8() != 0xCD) fail();
+	}
+
+	Console::write_line("   Function: File default read-ahead");
+	{
+		const std::string filename = "test_iodevice_buffered.tmp";
+		File::write_bytes(filename, DataBuffer(data.data(), data.size()));
+
+		File file(filename);
+		if (file.get_read_ahead_size() == 0) fail();
+		if (file.read_uint16() != *(uint16_t *)data.data()) fail();
+		if (file.get_position() != 2) fail();
+		file.seek(0);
+		DataBuffer contents(file.get_size());
+		if (file.read(contents.get_data(), contents.get_size()) != (int)data.size()) fail();
+		if (memcmp(contents.get_data(), data.data(), data.size())) fail();
+		file.close();
+
+		File output(filename, File::create_always, File::access_write);
+		output.set_buffer_size(0, 4096);
+		for (int cnt = 0; cnt < 1000; cnt++)
+			output.write_int32(cnt);
+		output.close();
+
+		File input(filename);
+		for (int cnt = 0; cnt < 1000; cnt++)
+		{
+			if (input.read_int32() != cnt) fail();
+		}
+		input.close();
+
+		const int iterations = 250000;
+		output.open(filename, File::create_always, File::access_write);
+		output.set_buffer_size(0, 0);
+		for (int cnt = 0; cnt < iterations; cnt++)
+			output.write_uint32(cnt);
+		output.close();
+
+		uint64_t sum_unbuffered = 0;
+		uint64_t start_time = System::get_microseconds();
+		input.open(filename);
+		input.set_buffer_size(0);
+		for (int cnt = 0; cnt < iterations; cnt++)
+			sum_unbuffered += input.read_uint32();
+		input.close();
+		uint64_t unbuffered_time = System::get_microseconds() - start_time;
+
+		uint64_t sum_buffered = 0;
+		start_time = System::get_microseconds();
+		input.open(filename);
+		input.set_buffer_size(4096);
+		for (int cnt = 0; cnt < iterations; cnt++)
+			sum_buffered += input.read_uint32();
+		input.close();
+		uint64_t buffered_time = System::get_microseconds() - start_time;
+
+		if (sum_buffered != sum_unbuffered) fail();
+		Console::write_line(string_format("    %1 x read_uint32: unbuffered %2 ms, buffered %3 ms", iterations, (int)(unbuffered_time / 1000), (int)(buffered_time / 1000)));
+
+		FileHelp::delete_file(filename);
+	}
+}
@@ -0,0 +1,264 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "test.h"
+
+namespace
+{
+	DataBuffer from_hex(const std::string &hex)
+	{
+		DataBuffer buffer(hex.size() / 2);
+		for (size_t i = 0; i < buffer.get_size(); i++)
+			buffer.get_data()[i] = (char)(unsigned char)StringHelp::text_to_uint(hex.substr(i * 2, 2), 16);
+		return buffer;
+	}
+
+	std::string to_hex(const DataBuffer &buffer)
+	{
+		static const char digits[] = "0123456789abcdef";
+		std::string hex;
+		for (size_t i = 0; i < buffer.get_size(); i++)
+		{
+			unsigned char c = (unsigned char)buffer.get_data()[i];
+			hex += digits[c >> 4];
+			hex += digits[c & 15];
+		}
+		return hex;
+	}
+}
+
+void TestApp::test_json_cbor()
+{
+	Console::write_line(" Header: json_value.h, cbor_writer.h");
+	Console::write_line("  CBOR encoding");
+
+	Console::write_line("   Function: JsonValue::from_cbor() with RFC 8949 examples");
+	{
+		struct { const char *cbor; const char *json; } cases[] =
+		{
+			{ "00", "0" }, { "17", "23" }, { "1818", "24" }, { "1903e8", "1000" }, { "1a000f4240", "1000000" },
+			{ "1b000000e8d4a51000", "1000000000000" }, { "20", "-1" }, { "3863", "-100" }, { "3903e7", "-1000" },
+			{ "f90000", "0" }, { "f93c00", "1" }, { "f93e00", "1.5" }, { "f97bff", "65504" }, { "f90001", "5.960464477539063e-8" },
+			{ "f9c400", "-4" }, { "fa47c35000", "100000" }, { "fb3ff199999999999a", "1.1" }, { "fbc010666666666666", "-4.1" },
+			{ "f4", "false" }, { "f5", "true" }, { "f6", "null" }, { "60", "\"\"" }, { "6161", "\"a\"" },
+			{ "6449455446", "\"IETF\"" }, { "62225c", "\"\\\"\\\\\"" }, { "63e6b0b4", "\"\xe6\xb0\xb4\"" },
+			{ "80", "[]" }, { "83010203", "[1,2,3]" }, { "8301820203820405", "[1,[2,3],[4,5]]" }, { "a0", "{}" },
+			{ "a26161016162820203", "{\"a\":1,\"b\":[2,3]}" }, { "a201020304", "{\"1\":2,\"3\":4}" },
+			{ "7f657374726561646d696e67ff", "\"streaming\"" }, { "9fff", "[]" }, { "9f018202039f0405ffff", "[1,[2,3],[4,5]]" },
+			{ "83018202039f0405ff", "[1,[2,3],[4,5]]" }, { "bf61610161629f0203ffff", "{\"a\":1,\"b\":[2,3]}" },
+			{ "bf6346756ef563416d7421ff", "{\"Amt\":-2,\"Fun\":true}" }, { "c074323031332d30332d32315432303a30343a30305a", "\"2013-03-21T20:04:00Z\"" },
+			{ "4401020304", "\"\\u0001\\u0002\\u0003\\u0004\"" }
+		};
+		for (const auto &c : cases)
+		{
+			std::string json = JsonValue::from_cbor(from_hex(c.cbor)).to_json();
+			if (json != JsonValue::parse(c.json).to_json())
+				throw Exception(string_format("CBOR test failed: %1 decoded as ", c.cbor) + json);
+		}
+	}
+
+	Console::write_line("   Function: JsonValue::to_cbor() writes the shortest encoding");
+	{
+		struct { const char *json; const char *cbor; } cases[] =
+		{
+			{ "0", "00" }, { "23", "17" }, { "24", "1818" }, { "1000", "1903e8" }, { "1000000000000", "1b000000e8d4a51000" },
+			{ "-1", "20" }, { "-1000", "3903e7" }, { "1.5", "fa3fc00000" }, { "1.1", "fb3ff199999999999a" }, { "-0.0", "fa80000000" },
+			{ "false", "f4" }, { "true", "f5" }, { "null", "f6" }, { "\"IETF\"", "6449455446" },
+			{ "[1,[2,3],[4,5]]", "8301820203820405" }, { "{\"a\":1,\"b\":[2,3]}", "a26161016162820203" }
+		};
+		for (const auto &c : cases)
+		{
+			std::string hex = to_hex(JsonValue::parse(c.json).to_cbor());
+			if (hex != c.cbor)
+				throw Exception(string_format("CBOR test failed: %1 encoded as ", c.json) + hex);
+		}
+	}
+
+	Console::write_line("   Function: round trip");
+	{
+		const char *documents[] =
+		{
+			"{\"name\": \"ClanLib\", \"version\": 4.1, \"tags\": [\"game\", \"sdk\", \"\\u00e6\\u00f8\\u00e5\"], \"nested\": {\"deep\": [[[]], {}], \"empty\": \"\"}}",
+			"[0, -0.5, 1e300, -1e-300, 4294967296, -4294967297, 9007199254740993, 18446744073709551616, 3.4028234663852886e38]",
+			"[true, false, null, \"a\\nb\\u0000c\", {\"\": 1}]",
+			"12345.678"
+		};
+		for (const char *document : documents)
+		{
+			JsonValue value = JsonValue::parse(document);
+			if (JsonValue::from_cbor(value.to_cbor()).to_json() != value.to_json())
+				throw Exception(string_format("CBOR test failed: %1 did not round trip", document));
+
+			DataBuffer data;
+			MemoryDevice device(data);
+			value.to_cbor(device);
+			value.to_cbor(device);
+			device.seek(0);
+			if (JsonValue::from_cbor(device).to_json() != value.to_json() || JsonValue::from_cbor(device).to_json() != value.to_json())
+				throw Exception(string_format("CBOR test failed: %1 did not round trip through a device", document));
+		}
+	}
+
+	Console::write_line("   Class: CborWriter");
+	{
+		DataBuffer data;
+		MemoryDevice device(data);
+		{
+			CborWriter writer(device);
+			writer.begin_object(2);
+			writer.write_key("count");
+			writer.write_number(100000);
+			writer.write_key("items");
+			writer.begin_array();
+			for (int i = 0; i < 100000; i++)
+			{
+				writer.begin_object();
+				writer.write_key("id");
+				writer.write_number(i);
+				writer.write_key("ok");
+				writer.write_boolean(i % 2 == 0);
+				writer.write_key("tag");
+				writer.write_null();
+				writer.end_object();
+			}
+			writer.end_array();
+			writer.end_object();
+		}
+
+		JsonValue value = JsonValue::from_cbor(device.get_data());
+		const JsonValue &items = value.prop("items");
+		if (value.prop("count").to_int() != 100000 || items.size() != 100000 || items.at(99999).prop("id").to_int() != 99999 || items.at(2).prop("ok").to_boolean() != true || !items.at(3).prop("tag").is_null())
+			throw Exception("CBOR test failed: CborWriter output");
+
+		CborWriter writer(device);
+		writer.begin_array(1);
+		bool caught = false;
+		try
+		{
+			writer.end_array();
+		}
+		catch (const JsonException &)
+		{
+			caught = true;
+		}
+		if (!caught)
+			throw Exception("CBOR test failed: definite array with too few values was accepted");
+	}
+
+	Console::write_line("   Function: malformed input");
+	{
+		const char *cases[] = { "", "18", "1900", "62aa", "83010203ff", "8301", "a16161", "ff", "1c", "a1f501", "7f01ff", "9f01", "bf6161ff", "fb3ff1" };
+		for (const char *hex : cases)
+		{
+			bool caught = false;
+			try
+			{
+				DataBuffer data = from_hex(hex);
+				if (std::string(hex) == "83010203ff")
+					data.set_size(3);
+				JsonValue::from_cbor(data);
+			}
+			catch (const JsonException &)
+			{
+				caught = true;
+			}
+			if (!caught)
+				throw Exception(string_format("CBOR test failed: %1 was accepted", hex));
+		}
+
+		std::string deep(2000, '\x81');
+		deep += '\x00';
+		bool caught = false;
+		try
+		{
+			JsonValue::from_cbor(deep.data(), deep.size());
+		}
+		catch (const JsonException &)
+		{
+			caught = true;
+		}
+		if (!caught)
+			throw Exception("CBOR test failed: deep nesting was accepted");
+	}
+
+	Console::write_line("   Function: throughput");
+	{
+		JsonValue tree = JsonValue::array();
+		for (int i = 0; i < 40000; i++)
+		{
+			std::string number = StringHelp::int_to_text(i);
+			JsonValue item = JsonValue::object();
+			item["id"] = JsonValue::number(i);
+			item["name"] = JsonValue::string("item number " + number);
+			item["tags"] = JsonValue::array();
+			item["tags"].items().push_back(JsonValue::string("alpha"));
+			item["tags"].items().push_back(JsonValue::string("beta"));
+			item["active"] = JsonValue::boolean(true);
+			item["weight"] = JsonValue::number(i + 0.5);
+			tree.items().push_back(item);
+		}
+
+		// Best of several runs, each freeing its result before the next is timed, so the order of the runs does not skew the numbers
+		std::string json = tree.to_json();
+		DataBuffer cbor = tree.to_cbor();
+		uint64_t json_write_time = ~0ULL, json_read_time = ~0ULL, cbor_write_time = ~0ULL, cbor_read_time = ~0ULL;
+		for (int run = 0; run < 3; run++)
+		{
+			uint64_t start_time = System::get_microseconds();
+			{
+				std::string result = tree.to_json();
+			}
+			json_write_time = std::min(json_write_time, System::get_microseconds() - start_time);
+
+			start_time = System::get_microseconds();
+			{
+				JsonValue result = JsonValue::parse(json);
+			}
+			json_read_time = std::min(json_read_time, System::get_microseconds() - start_time);
+
+			start_time = System::get_microseconds();
+			{
+				DataBuffer result = tree.to_cbor();
+			}
+			cbor_write_time = std::min(cbor_write_time, System::get_microseconds() - start_time);
+
+			start_time = System::get_microseconds();
+			{
+				JsonValue result = JsonValue::from_cbor(cbor);
+			}
+			cbor_read_time = std::min(cbor_read_time, System::get_microseconds() - start_time);
+		}
+
+		JsonValue json_tree = JsonValue::parse(json);
+		JsonValue cbor_tree = JsonValue::from_cbor(cbor);
+		if (cbor_tree.to_json() != json || json_tree.to_json() != json)
+			throw Exception("CBOR test failed: throughput data");
+		Console::write_line("    JSON %1 KB: to_json %2 ms, parse %3 ms", (int)(json.size() / 1024), (int)(json_write_time / 1000), (int)(json_read_time / 1000));
+		Console::write_line("    CBOR %1 KB: to_cbor %2 ms, from_cbor %3 ms", (int)(cbor.get_size() / 1024), (int)(cbor_write_time / 1000), (int)(cbor_read_time / 1000));
+	}
+}
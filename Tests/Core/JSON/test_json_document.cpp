@@ -0,0 +1,181 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#include "test.h"
+
+void TestApp::test_json_document()
+{
+	Console::write_line(" Header: json_document.h");
+	Console::write_line("  Class: JsonDocument");
+
+	std::string json = "{\"name\": \"ClanLib\", \"version\": 4.1, \"stable\": true, \"license\": null, \"text\": \"\\u00e6\\t\\\"\", "
+		"\"list\": [1, 2, 3, {\"name\": \"inner\"}], \"empty\": {}, \"none\": [], \"name\": \"duplicate\"}";
+
+	Console::write_line("   Function: parse(), prop(), items()");
+	{
+		JsonDocument document = JsonDocument::parse(json);
+		JsonNode root = document.root();
+		if (!root.is_object() || root.size() != 9)
+			throw Exception("JsonDocument test failed: root");
+		if (root.prop("name").to_string() != "duplicate" || document["version"].to_number() != 4.1 || !root["stable"].to_boolean() || !root["license"].is_null())
+			throw Exception("JsonDocument test failed: scalar members");
+		if (root["text"].to_string() != "\xc3\xa6\t\"" || root["text"].get_string_data()[root["text"].get_string_length()] != 0)
+			throw Exception("JsonDocument test failed: string member");
+		if (!root["missing"].is_undefined() || !root["missing"]["deeper"].is_undefined() || root["missing"].size() != 0)
+			throw Exception("JsonDocument test failed: missing member");
+
+		JsonNode list = root["list"];
+		int sum = 0;
+		for (JsonNode item : list.items())
+		{
+			if (item.is_number())
+				sum += item.to_int();
+		}
+		if (list.size() != 4 || sum != 6 || list.items()[3]["name"].to_string() != "inner" || list[size_t(1)].to_int() != 2)
+			throw Exception("JsonDocument test failed: array");
+		if (!root["empty"].is_object() || root["empty"].size() != 0 || !root["none"].is_array() || !root["none"].items().empty())
+			throw Exception("JsonDocument test failed: empty containers");
+
+		std::string names;
+		for (JsonNodeMember member : root.properties())
+			names += member.name() + " ";
+		if (names != "name version stable license text list empty none name ")
+			throw Exception("JsonDocument test failed: member order");
+
+		// Member names are interned once per document
+		if (root.properties().begin().operator*().get_name_data() != list[size_t(3)].properties().begin().operator*().get_name_data())
+			throw Exception("JsonDocument test failed: interned names");
+	}
+
+	Console::write_line("   Function: hash indexed objects");
+	{
+		JsonValue value = JsonValue::object();
+		for (int i = 0; i < 1000; i++)
+			value.prop("key" + StringHelp::int_to_text(i)) = JsonValue::number(i);
+		JsonDocument document(value);
+		for (int i = 0; i < 1000; i++)
+		{
+			if (document["key" + StringHelp::int_to_text(i)].to_int() != i)
+				throw Exception("JsonDocument test failed: indexed lookup");
+		}
+		if (!document["key1000"].is_undefined() || !document["key"].is_undefined())
+			throw Exception("JsonDocument test failed: indexed lookup of missing member");
+
+		std::string duplicates = "{";
+		for (int i = 0; i < 20; i++)
+			duplicates += "\"k" + StringHelp::int_to_text(i % 10) + "\": " + StringHelp::int_to_text(i) + ",";
+		duplicates += "\"last\": 0}";
+		JsonDocument duplicate_document = JsonDocument::parse(duplicates);
+		for (int i = 0; i < 10; i++)
+		{
+			if (duplicate_document["k" + StringHelp::int_to_text(i)].to_int() != i + 10)
+				throw Exception("JsonDocument test failed: indexed duplicate member");
+		}
+	}
+
+	Console::write_line("   Function: to_value() and to_json()");
+	{
+		JsonDocument document = JsonDocument::parse(json);
+		JsonValue value = document.root().to_value();
+		if (value.prop("name").to_string() != "duplicate" || value.prop("list").items()[3].prop("name").to_string() != "inner" || !value.prop("license").is_null())
+			throw Exception("JsonDocument test failed: to_value");
+		if (JsonDocument(value).root().to_json() != value.to_json())
+			throw Exception("JsonDocument test failed: to_json");
+		if (JsonDocument::parse("[1,\"a\\u0001\",true,null,{\"b\":[]}]").root().to_json() != "[1,\"a\\u0001\",true,null,{\"b\":[]}]")
+			throw Exception("JsonDocument test failed: to_json array");
+	}
+
+	Console::write_line("   Function: malformed input");
+	{
+		const char *bad[] = { "", "{\"a\": 1} 2", "[1, 2", "{\"a\"}" };
+		for (const char *text : bad)
+		{
+			bool failed = false;
+			try
+			{
+				JsonDocument::parse(text);
+			}
+			catch (const JsonException &)
+			{
+				failed = true;
+			}
+			if (!failed)
+				throw Exception(string_format("JsonDocument test failed: accepted %1", text));
+		}
+	}
+
+	Console::write_line("   Function: memory use and lookups");
+	{
+		std::string big = "[";
+		for (int i = 0; i < 40000; i++)
+		{
+			if (i > 0)
+				big += ",\n";
+			std::string number = StringHelp::int_to_text(i);
+			big += "  {\"id\": " + number + ", \"name\": \"item number " + number + "\", \"tags\": [\"alpha\", \"beta\", \"gamma\"], \"active\": true, \"weight\": " + number + ".5}";
+		}
+		big += "]";
+
+		uint64_t start_time = System::get_microseconds();
+		JsonValue value = JsonValue::parse(big);
+		uint64_t value_parse_time = System::get_microseconds() - start_time;
+
+		start_time = System::get_microseconds();
+		JsonDocument document = JsonDocument::parse(big);
+		uint64_t document_parse_time = System::get_microseconds() - start_time;
+
+		start_time = System::get_microseconds();
+		double value_sum = 0.0;
+		for (int pass = 0; pass < 10; pass++)
+		{
+			for (const auto &item : value.items())
+				value_sum += item["weight"].to_number() + item["id"].to_number();
+		}
+		uint64_t value_lookup_time = System::get_microseconds() - start_time;
+
+		start_time = System::get_microseconds();
+		double document_sum = 0.0;
+		for (int pass = 0; pass < 10; pass++)
+		{
+			for (JsonNode item : document.root().items())
+				document_sum += item["weight"].to_number() + item["id"].to_number();
+		}
+		uint64_t document_lookup_time = System::get_microseconds() - start_time;
+
+		if (value_sum != document_sum || document.root().size() != 40000)
+			throw Exception("JsonDocument test failed: lookup results");
+
+		// A JsonValue holds every container inline in every node, so its size is a lower bound of the tree's footprint
+		size_t value_nodes = 40000 * 9 + 1;
+		Console::write_line("    %1 KB input: JsonValue at least %2 KB, JsonDocument %3 KB", (int)(big.size() / 1024), (int)(value_nodes * sizeof(JsonValue) / 1024), (int)(document.get_memory_usage() / 1024));
+		Console::write_line("    parse: JsonValue %1 ms, JsonDocument %2 ms; lookups: JsonValue %3 ms, JsonDocument %4 ms", (int)(value_parse_time / 1000), (int)(document_parse_time / 1000), (int)(value_lookup_time / 1000), (int)(document_lookup_time / 1000));
+		if (document.get_memory_usage() * 2 > value_nodes * sizeof(JsonValue))
+			throw Exception("JsonDocument test failed: memory use");
+	}
+}
@@ -0,0 +1,199 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#include "test.h"
+#include <clocale>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+void TestApp::test_json_numbers()
+{
+	Console::write_line(" Header: json_value.h, string_help.h");
+	Console::write_line("  Number conversion");
+
+	Console::write_line("   Function: JsonValue::to_json() writes the shortest exact text");
+	{
+		struct { double value; const char *json; } cases[] =
+		{
+			{ 0.0, "0" }, { 42.0, "42" }, { -0.5, "-0.5" }, { 0.1, "0.1" }, { 1.0 / 3.0, "0.3333333333333333" },
+			{ 1e20, "100000000000000000000" }, { 1e21, "1e+21" }, { 1e-6, "0.000001" }, { 1e-7, "1e-7" },
+			{ 4294967296.5, "4294967296.5" }, { 5e-324, "5e-324" }, { 1.7976931348623157e308, "1.7976931348623157e+308" }
+		};
+		for (const auto &c : cases)
+		{
+			if (JsonValue::number(c.value).to_json() != c.json)
+				throw Exception(string_format("Number conversion test failed: %1 written as %2", c.json, JsonValue::number(c.value).to_json()));
+			if (JsonValue::parse(c.json).to_number() != c.value)
+				throw Exception(string_format("Number conversion test failed: %1 parsed wrong", c.json));
+		}
+		if (JsonValue::number(std::numeric_limits<double>::infinity()).to_json() != "null")
+			throw Exception("Number conversion test failed: infinity");
+	}
+
+	Console::write_line("   Function: round trip of random values");
+	{
+		std::mt19937_64 random(12345);
+		for (int i = 0; i < 200000; i++)
+		{
+			uint64_t bits = random();
+			double value;
+			memcpy(&value, &bits, sizeof(double));
+			if (value != value || value - value != 0.0)
+				continue;
+
+			std::string json = JsonValue::number(value).to_json();
+			double parsed = JsonValue::parse(json).to_number();
+			double reference = strtod(json.c_str(), nullptr);
+			if (memcmp(&parsed, &value, sizeof(double)) != 0 || reference != value)
+				throw Exception(string_format("Number conversion test failed: %1 did not round trip", json));
+
+			float float_value;
+			memcpy(&float_value, &bits, sizeof(float));
+			if (float_value == float_value && float_value - float_value == 0.0f)
+			{
+				std::string text = StringHelp::float_to_text(float_value, -1);
+				if (StringHelp::text_to_float(text) != float_value || strtof(text.c_str(), nullptr) != float_value)
+					throw Exception(string_format("Number conversion test failed: float %1 did not round trip", text));
+			}
+		}
+	}
+
+	Console::write_line("   Function: StringHelp fixed decimals and parsing");
+	{
+		if (StringHelp::double_to_text(0.1) != "0.100000" || StringHelp::double_to_text(2.5, 0) != "2" || StringHelp::double_to_text(-0.125, 2) != "-0.12" || StringHelp::double_to_text(0.1, -1) != "0.1")
+			throw Exception("Number conversion test failed: double_to_text");
+		if (StringHelp::float_to_text(1.5f) != "1.5" || StringHelp::float_to_text(100.0f) != "100" || StringHelp::float_to_text(0.1f, -1) != "0.1" || StringHelp::float_to_text(0.1f, 3, false) != "0.100")
+			throw Exception("Number conversion test failed: float_to_text");
+		if (StringHelp::double_to_text(1e300, 2).size() != 304 || StringHelp::double_to_ucs2(0.5, 1) != L"0.5")
+			throw Exception("Number conversion test failed: double_to_text large value");
+
+		if (StringHelp::text_to_double("  3.25abc") != 3.25 || StringHelp::text_to_double("-.5") != -0.5 || StringHelp::text_to_double("7.") != 7.0 || StringHelp::text_to_double("x") != 0.0)
+			throw Exception("Number conversion test failed: text_to_double");
+		if (!std::isinf(StringHelp::text_to_double("1e400")) || !std::isinf(StringHelp::text_to_double("-inf")) || StringHelp::text_to_float("0x1p3") != 8.0f || StringHelp::ucs2_to_double(L"1.25") != 1.25)
+			throw Exception("Number conversion test failed: text_to_double special values");
+		if (StringHelp::text_to_float("0.1") != 0.1f || StringHelp::text_to_float("16777217") != 16777216.0f || StringHelp::text_to_double("9007199254740993") != 9007199254740992.0)
+			throw Exception("Number conversion test failed: rounding");
+	}
+
+	Console::write_line("   Function: independent of the C locale");
+	{
+		const char *locales[] = { "de_DE.UTF-8", "de_DE", "fr_FR.UTF-8", "German" };
+		const char *found = nullptr;
+		for (const char *locale : locales)
+		{
+			if (setlocale(LC_NUMERIC, locale))
+			{
+				found = locale;
+				break;
+			}
+		}
+		bool ok = StringHelp::double_to_text(1.5, 1) == "1.5" && StringHelp::text_to_double("1.5") == 1.5 && JsonValue::parse("[1.5]").items()[0].to_number() == 1.5 && JsonValue::number(1.5).to_json() == "1.5";
+		setlocale(LC_NUMERIC, "C");
+		if (!ok)
+			throw Exception(string_format("Number conversion test failed: locale %1", found ? found : "C"));
+	}
+
+	Console::write_line("   Function: speed compared to the C library");
+	{
+		const int count = 500000;
+		std::mt19937_64 random(1);
+		std::vector<double> values(count);
+		for (auto &value : values)
+			value = std::ldexp((double)(random() >> 11), (int)(random() % 80) - 90);
+
+		std::vector<std::string> texts(count);
+		char buffer[64];
+		uint64_t start_time = System::get_microseconds();
+		for (int i = 0; i < count; i++)
+		{
+			snprintf(buffer, sizeof(buffer), "%.17g", values[i]);
+			texts[i] = buffer;
+		}
+		uint64_t printf_time = System::get_microseconds() - start_time;
+
+		start_time = System::get_microseconds();
+		for (int i = 0; i < count; i++)
+			texts[i] = StringHelp::double_to_text(values[i], -1);
+		uint64_t shortest_time = System::get_microseconds() - start_time;
+
+		start_time = System::get_microseconds();
+		for (int i = 0; i < count; i++)
+		{
+			snprintf(buffer, sizeof(buffer), "%.6f", values[i]);
+			texts[i] = buffer;
+		}
+		uint64_t printf_fixed_time = System::get_microseconds() - start_time;
+
+		start_time = System::get_microseconds();
+		for (int i = 0; i < count; i++)
+			texts[i] = StringHelp::double_to_text(values[i]);
+		uint64_t fixed_time = System::get_microseconds() - start_time;
+
+		for (int i = 0; i < count; i++)
+			texts[i] = StringHelp::double_to_text(values[i], -1);
+
+		double sum = 0.0;
+		start_time = System::get_microseconds();
+		for (int i = 0; i < count; i++)
+		{
+			double value = 0.0;
+			sscanf(texts[i].c_str(), "%lf", &value);
+			sum += value;
+		}
+		uint64_t sscanf_time = System::get_microseconds() - start_time;
+
+		double sum2 = 0.0;
+		start_time = System::get_microseconds();
+		for (int i = 0; i < count; i++)
+			sum2 += StringHelp::text_to_double(texts[i]);
+		uint64_t parse_time = System::get_microseconds() - start_time;
+
+		if (sum != sum2)
+			throw Exception("Number conversion test failed: parse results differ from sscanf");
+
+		std::string json = "[";
+		for (int i = 0; i < count; i++)
+		{
+			if (i > 0)
+				json += ",";
+			json += texts[i];
+		}
+		json += "]";
+		start_time = System::get_microseconds();
+		JsonValue array = JsonValue::parse(json);
+		std::string written = array.to_json();
+		uint64_t json_time = System::get_microseconds() - start_time;
+		if (written != json)
+			throw Exception("Number conversion test failed: JSON number array did not round trip");
+
+		Console::write_line("    %1 values: shortest %2 ms (printf %.17g %3 ms), 6 decimals %4 ms (printf %5 ms)", count, (int)(shortest_time / 1000), (int)(printf_time / 1000), (int)(fixed_time / 1000), (int)(printf_fixed_time / 1000));
+		Console::write_line("    parse %1 ms (sscanf %2 ms), JSON parse and write %3 ms", (int)(parse_time / 1000), (int)(sscanf_time / 1000), (int)(json_time / 1000));
+	}
+}
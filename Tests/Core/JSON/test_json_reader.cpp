@@ -0,0 +1,248 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#include "test.h"
+
+namespace
+{
+	// Describes the token stream in a compact form so the different input modes can be compared
+	std::string describe_tokens(JsonReader &reader)
+	{
+		std::string result;
+		while (true)
+		{
+			JsonToken token = reader.next();
+			switch (token)
+			{
+			case JsonToken::object_begin: result += "{"; break;
+			case JsonToken::object_end: result += "}"; break;
+			case JsonToken::array_begin: result += "["; break;
+			case JsonToken::array_end: result += "]"; break;
+			case JsonToken::key: result += "k:" + reader.get_string() + " "; break;
+			case JsonToken::string: result += "s:" + reader.get_string() + " "; break;
+			case JsonToken::number: result += "n:" + reader.get_number_text() + " "; break;
+			case JsonToken::boolean: result += reader.get_boolean() ? "true " : "false "; break;
+			case JsonToken::null: result += "null "; break;
+			case JsonToken::end_of_document: return result;
+			default: throw Exception("JsonReader test failed: unexpected token");
+			}
+		}
+	}
+
+	std::string describe_fed_bytes(const std::string &json)
+	{
+		JsonReader reader;
+		std::string result;
+		for (size_t pos = 0; pos <= json.size(); pos++)
+		{
+			if (pos < json.size())
+				reader.feed(json.data() + pos, 1);
+			else
+				reader.feed_end();
+
+			while (true)
+			{
+				JsonToken token = reader.next();
+				if (token == JsonToken::need_more_input)
+					break;
+				switch (token)
+				{
+				case JsonToken::object_begin: result += "{"; break;
+				case JsonToken::object_end: result += "}"; break;
+				case JsonToken::array_begin: result += "["; break;
+				case JsonToken::array_end: result += "]"; break;
+				case JsonToken::key: result += "k:" + reader.get_string() + " "; break;
+				case JsonToken::string: result += "s:" + reader.get_string() + " "; break;
+				case JsonToken::number: result += "n:" + reader.get_number_text() + " "; break;
+				case JsonToken::boolean: result += reader.get_boolean() ? "true " : "false "; break;
+				case JsonToken::null: result += "null "; break;
+				case JsonToken::end_of_document: return result;
+				default: throw Exception("JsonReader test failed: unexpected token");
+				}
+			}
+		}
+		throw Exception("JsonReader test failed: fed input did not end");
+	}
+
+	bool fails_to_parse(const std::string &json)
+	{
+		try
+		{
+			JsonReader reader(json.data(), json.size());
+			describe_tokens(reader);
+			return false;
+		}
+		catch (const JsonException &)
+		{
+			return true;
+		}
+	}
+}
+
+void TestApp::test_json_reader()
+{
+	Console::write_line(" Header: json_reader.h");
+	Console::write_line("  Class: JsonReader");
+
+	std::string json = " {\"name\": \"plain\", \"escaped\": \"a\\\"b\\\\c\\n\\u00e6\\ud83d\\ude00\", \"list\": [1, -2.5e3, 0.125, true, false, null, {}, []], \"nested\": {\"x\": {\"y\": [[]]}}} ";
+	std::string expected = "{k:name s:plain k:escaped s:a\"b\\c\n\xc3\xa6\xf0\x9f\x98\x80 k:list [n:1 n:-2.5e3 n:0.125 true false null {}[]]k:nested {k:x {k:y [[]]}}}";
+
+	Console::write_line("   Function: next() on a memory buffer");
+	{
+		JsonReader reader(json.data(), json.size());
+		if (describe_tokens(reader) != expected)
+			throw Exception("JsonReader test failed: memory buffer");
+	}
+
+	Console::write_line("   Function: feed() one byte at a time");
+	if (describe_fed_bytes(json) != expected)
+		throw Exception("JsonReader test failed: fed bytes");
+
+	Console::write_line("   Function: next() on a device with a small buffer");
+	{
+		DataBuffer data(json.data(), json.size());
+		MemoryDevice device(data);
+		JsonReader reader(device, 16);
+		if (describe_tokens(reader) != expected)
+			throw Exception("JsonReader test failed: device");
+	}
+
+	Console::write_line("   Function: get_string_data() returns views into the input");
+	{
+		JsonReader reader(json.data(), json.size());
+		reader.next();
+		reader.next();
+		if (reader.get_string_data() != json.data() + json.find("name") || !reader.string_equals("name") || reader.string_equals("nam"))
+			throw Exception("JsonReader test failed: zero copy key");
+		reader.next();
+		if (reader.get_string_data() != json.data() + json.find("plain") || reader.get_string_length() != 5)
+			throw Exception("JsonReader test failed: zero copy string");
+	}
+
+	Console::write_line("   Function: get_number() and get_depth()");
+	{
+		std::string numbers = "[0, -0.5, 1e2, 12345678901234567]";
+		JsonReader reader(numbers.data(), numbers.size());
+		reader.next();
+		if (reader.get_depth() != 1)
+			throw Exception("JsonReader test failed: depth");
+		double values[] = { 0.0, -0.5, 100.0, 12345678901234567.0 };
+		for (double value : values)
+		{
+			if (reader.next() != JsonToken::number || reader.get_number() != value)
+				throw Exception("JsonReader test failed: number value");
+		}
+		if (reader.next() != JsonToken::array_end || reader.get_depth() != 0)
+			throw Exception("JsonReader test failed: array end");
+	}
+
+	Console::write_line("   Function: multiple documents");
+	{
+		std::string lines = "{\"a\":1}\n{\"a\":2}\n\"three\"\n4";
+		JsonReader reader(lines.data(), lines.size());
+		if (describe_tokens(reader) != "{k:a n:1 }{k:a n:2 }s:three n:4 ")
+			throw Exception("JsonReader test failed: multiple documents");
+		if (describe_fed_bytes(lines) != "{k:a n:1 }{k:a n:2 }s:three n:4 ")
+			throw Exception("JsonReader test failed: multiple fed documents");
+	}
+
+	Console::write_line("   Function: skip_value() and read_value()");
+	{
+		JsonReader reader(json.data(), json.size());
+		reader.next();
+		JsonValue list;
+		while (reader.next() == JsonToken::key)
+		{
+			bool is_list = reader.string_equals("list");
+			reader.next();
+			if (is_list)
+				list = reader.read_value();
+			else
+				reader.skip_value();
+		}
+		if (reader.get_token() != JsonToken::object_end || reader.next() != JsonToken::end_of_document)
+			throw Exception("JsonReader test failed: skip_value");
+		if (!list.is_array() || list.size() != 8 || list.items()[1].to_number() != -2500.0 || !list.items()[3].to_boolean() || !list.items()[6].is_object())
+			throw Exception("JsonReader test failed: read_value");
+
+		JsonReader object_reader(json.data(), json.size());
+		object_reader.next();
+		JsonValue value = object_reader.read_value();
+		if (value.prop("escaped").to_string() != "a\"b\\c\n\xc3\xa6\xf0\x9f\x98\x80" || !value.prop("nested").prop("x").prop("y").items()[0].is_array())
+			throw Exception("JsonReader test failed: read_value object");
+	}
+
+	Console::write_line("   Function: malformed input");
+	{
+		const char *bad[] = { "{", "[1,]", "{\"a\" 1}", "{\"a\":1,}", "[01]", "[1.]", "[-]", "[1e]", "tru", "nul", "[\"abc", "[\"\\x\"]", "[\"\\u12g4\"]", "{1:2}", "[1 2]", "]" };
+		for (const char *text : bad)
+		{
+			if (!fails_to_parse(text))
+				throw Exception(string_format("JsonReader test failed: accepted %1", text));
+		}
+		if (fails_to_parse("  ") || fails_to_parse("[ ]") || fails_to_parse("{\t}\r\n"))
+			throw Exception("JsonReader test failed: rejected valid input");
+	}
+
+	Console::write_line("   Function: throughput");
+	{
+		std::string big = "[";
+		for (int i = 0; i < 40000; i++)
+		{
+			if (i > 0)
+				big += ",\n";
+			std::string number = StringHelp::int_to_text(i);
+			big += "  {\"id\": " + number + ", \"name\": \"item number " + number + "\", \"tags\": [\"alpha\", \"beta\", \"gamma\"], \"active\": true, \"weight\": " + number + ".5}";
+		}
+		big += "]";
+
+		uint64_t start_time = System::get_microseconds();
+		JsonValue tree = JsonValue::parse(big);
+		uint64_t tree_time = System::get_microseconds() - start_time;
+
+		start_time = System::get_microseconds();
+		JsonReader reader(big.data(), big.size());
+		double id_sum = 0.0;
+		int tokens = 0;
+		while (reader.next() != JsonToken::end_of_document)
+		{
+			tokens++;
+			if (reader.get_token() == JsonToken::key && reader.string_equals("id"))
+			{
+				reader.next();
+				id_sum += reader.get_number();
+			}
+		}
+		uint64_t reader_time = System::get_microseconds() - start_time;
+
+		if (tree.size() != 40000 || id_sum != 39999.0 * 40000.0 / 2.0)
+			throw Exception("JsonReader test failed: throughput data");
+		Console::write_line("    %1 KB: JsonValue::parse %2 ms, JsonReader %3 ms (%4 tokens)", (int)(big.size() / 1024), (int)(tree_time / 1000), (int)(reader_time / 1000), tokens);
+	}
+}
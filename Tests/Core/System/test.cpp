@@ -55,6 +55,13 @@ int TestApp::main()
 		Console::write_line("Directory: API/Core/System");
 
 		test_datetime();
+		test_work_queue();
+		test_task();
+		test_allocators();
+		test_databuffer();
+		test_signal();
+		test_logger();
+		test_profiler();
 		
 		Console::write_line("All Tests Complete");
 		console.display_close_message();
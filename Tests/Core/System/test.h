@@ -72,6 +72,13 @@ public:
 	int main();
 private:
 	void test_datetime();
+	void test_work_queue();
+	void test_task();
+	void test_allocators();
+	void test_databuffer();
+	void test_signal();
+	void test_logger();
+	void test_profiler();
 
 	std::string convert_time(DateTime &datetime);
 	void fail(void);
@@ -0,0 +1,179 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+#include <thread>
+
+namespace
+{
+	class PooledObject : public PoolAllocated
+	{
+	public:
+		PooledObject(int value) : value(value) { g_bConstructor++; }
+		~PooledObject() { g_bDestructor++; }
+
+		int value;
+		char padding[40];
+	};
+}
+
+void TestApp::test_allocators()
+{
+	Console::write_line(" Header: arena_allocator.h");
+	Console::write_line("  Class: ArenaAllocator");
+
+	Console::write_line("   Function: allocate()");
+	{
+		ArenaAllocator arena(1024, true);
+		char *a = static_cast<char*>(arena.allocate(10));
+		char *b = static_cast<char*>(arena.allocate(100, 64));
+		if (((size_t)a & 15) != 0) fail();
+		if (((size_t)b & 63) != 0) fail();
+		if (b < a + 10) fail();
+
+		// Larger than the block size
+		char *c = static_cast<char*>(arena.allocate(5000));
+		memset(c, 0xcc, 5000);
+
+		AllocatorStatistics stats = arena.get_statistics();
+		if (stats.live_bytes != 5110) fail();
+		if (stats.num_allocations != 3) fail();
+		if (stats.reserved_bytes < 5110) fail();
+	}
+
+	Console::write_line("   Function: get_marker(), reset()");
+	{
+		ArenaAllocator arena(1024, true);
+		arena.allocate(100);
+		ArenaMarker marker = arena.get_marker();
+		void *first = arena.allocate(200);
+		for (int i = 0; i < 100; i++)
+			arena.allocate(100);
+		size_t reserved = arena.get_statistics().reserved_bytes;
+
+		arena.reset(marker);
+		if (arena.get_statistics().live_bytes != 100) fail();
+		if (arena.allocate(200) != first) fail();
+
+		// Blocks are kept for reuse
+		arena.reset();
+		for (int i = 0; i < 101; i++)
+			arena.allocate(100);
+		if (arena.get_statistics().reserved_bytes != reserved) fail();
+		if (arena.get_statistics().peak_live_bytes != 10300) fail();
+
+		arena.free();
+		if (arena.get_statistics().reserved_bytes != 0) fail();
+	}
+
+	Console::write_line("  Class: ArenaScope");
+	{
+		ArenaAllocator &arena = ArenaAllocator::get_thread_arena();
+		void *before = arena.allocate(16);
+		ArenaMarker marker = arena.get_marker();
+		{
+			ArenaScope scope;
+			arena.allocate(1000);
+		}
+		ArenaMarker after = arena.get_marker();
+		if (after.block != marker.block || after.pos != marker.pos) fail();
+		if (before == nullptr) fail();
+	}
+
+	Console::write_line("   Function: get_thread_arena(), get_thread_pool()");
+	{
+		ArenaAllocator *main_arena = &ArenaAllocator::get_thread_arena();
+		PoolAllocator *main_pool = &PoolAllocator::get_thread_pool();
+		if (&ArenaAllocator::get_thread_arena() != main_arena || &PoolAllocator::get_thread_pool() != main_pool) fail();
+
+		ArenaAllocator *other_arena = nullptr;
+		PoolAllocator *other_pool = nullptr;
+		std::thread thread([&]() { other_arena = &ArenaAllocator::get_thread_arena(); other_pool = &PoolAllocator::get_thread_pool(); });
+		thread.join();
+		if (!other_arena || other_arena == main_arena || !other_pool || other_pool == main_pool) fail();
+	}
+
+	Console::write_line(" Header: pool_allocator.h");
+	Console::write_line("  Class: PoolAllocator");
+
+	Console::write_line("   Function: allocate(), deallocate()");
+	{
+		PoolAllocator pool(true);
+		std::vector<void *> blocks;
+		for (int i = 1; i < 3000; i += 7)
+		{
+			char *data = static_cast<char*>(pool.allocate(i));
+			if (((size_t)data & 15) != 0) fail();
+			memset(data, i & 0xff, i);
+			blocks.push_back(data);
+		}
+		AllocatorStatistics stats = pool.get_statistics();
+		if (stats.num_allocations != blocks.size()) fail();
+		size_t peak = stats.live_bytes;
+
+		// Individual frees go back to the size class free list and are reused
+		void *freed = blocks[5];
+		pool.deallocate(freed);
+		if (pool.allocate(5 * 7 + 1) != freed) fail();
+
+		for (auto &block : blocks)
+			pool.deallocate(block);
+		stats = pool.get_statistics();
+		if (stats.live_bytes != 0) fail();
+		if (stats.peak_live_bytes != peak) fail();
+		if (stats.get_fragmentation() != 1.0f) fail();
+
+		PoolAllocator other;
+		void *data = other.allocate(32);
+		bool caught = false;
+		try
+		{
+			pool.deallocate(data);
+		}
+		catch (const Exception &)
+		{
+			caught = true;
+		}
+		if (!caught) fail();
+		other.deallocate(data);
+
+		pool.free();
+		if (pool.get_statistics().reserved_bytes != 0) fail();
+	}
+
+	Console::write_line("  Class: PoolAllocated");
+	{
+		g_bConstructor = 0;
+		g_bDestructor = 0;
+		PooledObject *obj = new(&PoolAllocator::get_thread_pool()) PooledObject(5);
+		if (obj->value != 5) fail();
+		delete obj;
+		if (g_bConstructor != 1 || g_bDestructor != 1) fail();
+	}
+}
@@ -0,0 +1,137 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+
+void TestApp::test_databuffer()
+{
+	Console::write_line(" Header: databuffer.h");
+	Console::write_line("  Class: DataBuffer");
+
+	Console::write_line("   Function: DataBuffer()");
+	{
+		DataBuffer empty;
+		if (empty.get_data() != nullptr) fail();
+		if (empty.get_capacity() != 0) fail();
+
+		DataBuffer zero_size(0);
+		if (zero_size.get_data() != nullptr) fail();
+		if (zero_size.get_capacity() != 0) fail();
+	}
+
+	Console::write_line("   Function: DataBuffer(const void *data, unsigned int size)");
+	{
+		const char small_text[] = "small";
+		DataBuffer small(small_text, 5);
+		if (small.get_size() != 5) fail();
+		if (memcmp(small.get_data(), small_text, 5)) fail();
+
+		std::vector<char> large_text(1000, 'x');
+		DataBuffer large(large_text.data(), 1000);
+		if (large.get_size() != 1000) fail();
+		if (memcmp(large.get_data(), large_text.data(), 1000)) fail();
+	}
+
+	Console::write_line("   Function: set_size()");
+	{
+		DataBuffer buffer(10);
+		for (unsigned int i = 0; i < 10; i++)
+		{
+			if (buffer[i] != 0) fail();
+			buffer[i] = (char)i;
+		}
+		buffer.set_size(100);
+		for (unsigned int i = 0; i < 100; i++)
+		{
+			if (buffer[i] != (i < 10 ? (char)i : 0)) fail();
+		}
+		if (buffer.get_capacity() < 100) fail();
+	}
+
+	Console::write_line("   Function: DataBuffer(const DataBuffer &data, unsigned int pos, unsigned int size)");
+	{
+		DataBuffer buffer(1000);
+		for (unsigned int i = 0; i < 1000; i++)
+			buffer[i] = (char)i;
+
+		DataBuffer slice(buffer, 100, 500);
+		if (slice.get_size() != 500) fail();
+		if (slice.get_data() != buffer.get_data() + 100) fail();
+
+		DataBuffer slice_of_slice(slice, 50, 100);
+		if (slice_of_slice.get_data() != buffer.get_data() + 150) fail();
+
+		// The slice keeps the memory alive
+		buffer = DataBuffer();
+		for (unsigned int i = 0; i < 100; i++)
+		{
+			if (slice_of_slice[i] != (char)(i + 150)) fail();
+		}
+
+		// Growing a slice moves it to its own memory
+		const char *old_data = slice.get_data();
+		slice.set_size(600);
+		if (slice.get_data() == old_data) fail();
+		if (slice[0] != (char)100 || slice[599] != 0) fail();
+		if (slice_of_slice[0] != (char)150) fail();
+
+		// Small slices are copied into the slice object
+		DataBuffer small_slice(slice, 1, 4);
+		if (small_slice.get_data() == slice.get_data() + 1) fail();
+		if (small_slice[0] != (char)101) fail();
+
+		bool caught = false;
+		try
+		{
+			DataBuffer out_of_bounds(slice, 500, 101);
+		}
+		catch (const Exception &)
+		{
+			caught = true;
+		}
+		if (!caught) fail();
+	}
+
+	Console::write_line("   Function: DataBuffer(DataBuffer &&move)");
+	{
+		DataBuffer buffer(100);
+		const char *data = buffer.get_data();
+		DataBuffer moved(std::move(buffer));
+		if (moved.get_data() != data) fail();
+		if (!buffer.is_null()) fail();
+		if (buffer.get_size() != 0) fail();
+
+		buffer.set_size(10);
+		if (buffer.get_size() != 10) fail();
+
+		DataBuffer assigned;
+		assigned = std::move(moved);
+		if (assigned.get_data() != data) fail();
+	}
+}
@@ -0,0 +1,222 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+#include <thread>
+#include <mutex>
+
+namespace
+{
+	class MemoryLogger : public Logger
+	{
+	public:
+		void log(const std::string &type, const std::string &text) override
+		{
+			lines.push_back(type + ": " + text);
+		}
+
+		void flush() override
+		{
+			flush_calls++;
+		}
+
+		std::vector<std::string> lines;
+		int flush_calls = 0;
+	};
+
+	void test_sync()
+	{
+		MemoryLogger logger;
+		log_event("info", "plain %1");
+		log_event("info", "value %1 %2 %3", 5, std::string("text"), 7u);
+		if (logger.lines.size() != 2) throw Exception("Failed Test");
+		if (logger.lines[0] != "info: plain %1") throw Exception("Failed Test");
+		if (logger.lines[1] != "info: value 5 text 7") throw Exception("Failed Test");
+		if (logger.flush_calls != 2) throw Exception("Failed Test");
+	}
+
+	void test_async()
+	{
+		MemoryLogger logger;
+		Logger::start_async(64, LogOverflowPolicy::block);
+		if (!Logger::is_async()) throw Exception("Failed Test");
+
+		const int num_threads = 4;
+		const int num_events = 1000;
+		std::vector<std::thread> threads;
+		for (int t = 0; t < num_threads; t++)
+		{
+			threads.push_back(std::thread([t]()
+			{
+				for (int i = 0; i < num_events; i++)
+					log_event("thread", "%1 %2", t, i);
+			}));
+		}
+		for (auto &thread : threads)
+			thread.join();
+
+		Logger::flush_async();
+		std::unique_lock<std::recursive_mutex> lock(Logger::mutex);
+		if (logger.lines.size() != num_threads * num_events) throw Exception("Failed Test");
+
+		// Events from one thread keep their order
+		std::vector<int> next(num_threads, 0);
+		for (const auto &line : logger.lines)
+		{
+			std::vector<std::string> parts = StringHelp::split_text(line, " ");
+			int t = StringHelp::text_to_int(parts[1]);
+			int i = StringHelp::text_to_int(parts[2]);
+			if (next[t] != i) throw Exception("Failed Test");
+			next[t]++;
+		}
+		if (logger.flush_calls == 0 || logger.flush_calls >= num_threads * num_events) throw Exception("Failed Test");
+		lock.unlock();
+
+		Logger::stop_async();
+		if (Logger::is_async()) throw Exception("Failed Test");
+
+		// Back to synchronous logging
+		logger.lines.clear();
+		log_event("info", "sync");
+		if (logger.lines.size() != 1) throw Exception("Failed Test");
+	}
+
+	void test_async_drop()
+	{
+		MemoryLogger logger;
+		Logger::start_async(16, LogOverflowPolicy::drop);
+		{
+			// Stall the writer thread so that the ring fills up
+			std::unique_lock<std::recursive_mutex> lock(Logger::mutex);
+			for (int i = 0; i < 100; i++)
+				log_event("info", "%1", i);
+			System::sleep(50);
+			for (int i = 0; i < 100; i++)
+				log_event("info", "%1", i);
+		}
+		Logger::stop_async();
+
+		bool found_dropped = false;
+		for (const auto &line : logger.lines)
+		{
+			if (line.find("events dropped") != std::string::npos)
+				found_dropped = true;
+		}
+		if (!found_dropped) throw Exception("Failed Test");
+		if (logger.lines.size() >= 200) throw Exception("Failed Test");
+	}
+
+	void test_async_stop()
+	{
+		// Events logged while asynchronous mode starts and stops must not be lost
+		MemoryLogger logger;
+		const int num_threads = 4;
+		const int num_events = 5000;
+		std::vector<std::thread> threads;
+		for (int t = 0; t < num_threads; t++)
+		{
+			threads.push_back(std::thread([t]()
+			{
+				for (int i = 0; i < num_events; i++)
+					log_event("thread", "%1 %2", t, i);
+			}));
+		}
+
+		for (int cycle = 0; cycle < 10; cycle++)
+		{
+			Logger::start_async(8, cycle % 2 ? LogOverflowPolicy::block : LogOverflowPolicy::drop);
+			System::sleep(1);
+			Logger::stop_async();
+		}
+		Logger::start_async(8, LogOverflowPolicy::block);
+		for (auto &thread : threads)
+			thread.join();
+		Logger::stop_async();
+
+		int thread_lines = 0;
+		for (const auto &line : logger.lines)
+		{
+			if (line.compare(0, 7, "thread:") == 0)
+				thread_lines++;
+		}
+		int dropped = 0;
+		for (const auto &line : logger.lines)
+		{
+			if (line.find("events dropped") != std::string::npos)
+				dropped += StringHelp::text_to_int(StringHelp::split_text(line, " ")[1]);
+		}
+		if (thread_lines + dropped != num_threads * num_events) throw Exception("Failed Test");
+	}
+
+	uint64_t benchmark_log_event(const std::string &filename, bool async, int num_events)
+	{
+		FileLogger logger(filename);
+		if (async)
+			Logger::start_async(num_events);
+
+		// Warm up the ring buffer of this thread
+		log_event("bench", "Warm up");
+		Logger::flush_async();
+
+		uint64_t start_time = System::get_microseconds();
+		for (int i = 0; i < num_events; i++)
+			log_event("bench", "Event %1 of %2", i, num_events);
+		uint64_t elapsed = System::get_microseconds() - start_time;
+
+		if (async)
+			Logger::stop_async();
+		return elapsed;
+	}
+}
+
+void TestApp::test_logger()
+{
+	Console::write_line(" Header: logger.h");
+	Console::write_line("  Class: Logger");
+
+	Console::write_line("   Function: log_event() - synchronous");
+	test_sync();
+
+	Console::write_line("   Function: start_async(), flush_async(), stop_async()");
+	test_async();
+
+	Console::write_line("   Function: start_async() - drop policy");
+	test_async_drop();
+
+	Console::write_line("   Function: stop_async() - concurrent logging threads");
+	test_async_stop();
+
+	const std::string filename = "test_logger.tmp";
+	const int num_events = 20000;
+	Console::write_line(string_format("   Calling thread benchmark (%1 events to FileLogger, microseconds)", num_events));
+	uint64_t sync_time = benchmark_log_event(filename, false, num_events);
+	uint64_t async_time = benchmark_log_event(filename, true, num_events);
+	Console::write_line(string_format("    Synchronous: %1  Asynchronous: %2", (int)sync_time, (int)async_time));
+	FileHelp::delete_file(filename);
+}
@@ -0,0 +1,142 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+#include <thread>
+
+namespace
+{
+	int count_occurrences(const std::string &text, const std::string &search)
+	{
+		int count = 0;
+		for (size_t pos = text.find(search); pos != std::string::npos; pos = text.find(search, pos + 1))
+			count++;
+		return count;
+	}
+
+	void test_disabled()
+	{
+		Profiler::clear();
+		{
+			ProfileZone zone("Disabled zone");
+		}
+		Profiler::mark_frame();
+		if (Profiler::get_chrome_trace().find("Disabled zone") != std::string::npos) throw Exception("Failed Test");
+	}
+
+	void test_zones()
+	{
+		Profiler::enable(1024);
+		Profiler::clear();
+		Profiler::set_thread_name("Main \"thread\"");
+
+		for (int frame = 0; frame < 3; frame++)
+		{
+			Profiler::mark_frame();
+			ProfileZone outer("Outer");
+			for (int i = 0; i < 2; i++)
+			{
+				ProfileZone inner("Inner");
+			}
+		}
+		Profiler::mark_frame();
+
+		std::thread worker([]()
+		{
+			Profiler::set_thread_name("Worker");
+			ProfileZone zone("Worker zone");
+		});
+		worker.join();
+
+		Profiler::disable();
+
+		std::string trace = Profiler::get_chrome_trace();
+		JsonValue json = JsonValue::parse(trace);
+		if (!json.prop("traceEvents").is_array()) throw Exception("Failed Test");
+		if (count_occurrences(trace, "\"name\":\"Outer\"") != 3) throw Exception("Failed Test");
+		if (count_occurrences(trace, "\"name\":\"Inner\"") != 6) throw Exception("Failed Test");
+		if (count_occurrences(trace, "\"name\":\"Frame\"") != 4) throw Exception("Failed Test");
+		if (count_occurrences(trace, "\"name\":\"Worker zone\"") != 1) throw Exception("Failed Test");
+		if (trace.find("Main \\\"thread\\\"") == std::string::npos) throw Exception("Failed Test");
+
+		std::string report = Profiler::get_report();
+		if (report.find("Inner: 6,") == std::string::npos) throw Exception("Failed Test");
+		if (report.find("Outer: 3,") == std::string::npos) throw Exception("Failed Test");
+		if (report.find("3 frames") == std::string::npos) throw Exception("Failed Test");
+	}
+
+	void test_ring_buffer()
+	{
+		Profiler::enable(16);
+		Profiler::clear();
+		std::thread worker([]()
+		{
+			for (int i = 0; i < 100; i++)
+				ProfileZone zone("Ring zone");
+		});
+		worker.join();
+		Profiler::disable();
+
+		// Only the most recent events of the thread are kept
+		if (count_occurrences(Profiler::get_chrome_trace(), "\"name\":\"Ring zone\"") != 16) throw Exception("Failed Test");
+		Profiler::clear();
+	}
+
+	uint64_t benchmark_zones(int num_zones)
+	{
+		uint64_t start_time = System::get_microseconds();
+		for (int i = 0; i < num_zones; i++)
+			ProfileZone zone("Benchmark zone");
+		return System::get_microseconds() - start_time;
+	}
+}
+
+void TestApp::test_profiler()
+{
+	Console::write_line(" Header: profiler.h");
+	Console::write_line("  Class: Profiler");
+
+	Console::write_line("   Function: is_enabled()");
+	test_disabled();
+
+	Console::write_line("   Function: get_chrome_trace(), get_report()");
+	test_zones();
+
+	Console::write_line("   Function: enable() - ring buffer");
+	test_ring_buffer();
+
+	const int num_zones = 1000000;
+	Console::write_line(string_format("   Zone benchmark (%1 zones, microseconds)", num_zones));
+	uint64_t disabled_time = benchmark_zones(num_zones);
+	Profiler::enable();
+	uint64_t enabled_time = benchmark_zones(num_zones);
+	Profiler::disable();
+	Profiler::clear();
+	Console::write_line(string_format("    Disabled: %1  Enabled: %2", (int)disabled_time, (int)enabled_time));
+}
@@ -0,0 +1,191 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+
+namespace
+{
+	// Copy of the previous Signal dispatch, which copied the slot vector and locked every weak_ptr per emit
+	namespace legacy
+	{
+		template<typename FuncType>
+		class LegacySlot
+		{
+		public:
+			LegacySlot(const std::function<FuncType> &callback) : callback(callback) { }
+			std::function<FuncType> callback;
+		};
+
+		template<typename FuncType>
+		class LegacySignal
+		{
+		public:
+			template<typename... Args>
+			void operator()(Args&&... args)
+			{
+				std::vector<std::weak_ptr<LegacySlot<FuncType>>> copy = slots;
+				for (std::weak_ptr<LegacySlot<FuncType>> &weak_slot : copy)
+				{
+					std::shared_ptr<LegacySlot<FuncType>> slot = weak_slot.lock();
+					if (slot)
+						slot->callback(std::forward<Args>(args)...);
+				}
+			}
+
+			std::shared_ptr<LegacySlot<FuncType>> connect(const std::function<FuncType> &func)
+			{
+				auto slot = std::make_shared<LegacySlot<FuncType>>(func);
+				slots.push_back(slot);
+				return slot;
+			}
+
+		private:
+			std::vector<std::weak_ptr<LegacySlot<FuncType>>> slots;
+		};
+	}
+
+	void test_emit()
+	{
+		Signal<void(int)> signal;
+		int sum = 0;
+		Slot slot1 = signal.connect([&](int value) { sum += value; });
+		Slot slot2 = signal.connect([&](int value) { sum += value * 10; });
+		signal(1);
+		if (sum != 11) throw Exception("Failed Test");
+
+		slot1 = Slot();
+		signal(1);
+		if (sum != 21) throw Exception("Failed Test");
+
+		// Slot outliving its signal
+		{
+			Signal<void(int)> temp_signal;
+			slot1 = temp_signal.connect([&](int value) { sum += value; });
+		}
+		slot1 = Slot();
+	}
+
+	void test_disconnect_during_emit()
+	{
+		Signal<void()> signal;
+		int calls1 = 0, calls2 = 0, calls3 = 0;
+		Slot slot1, slot2, slot3;
+
+		// Disconnect a later slot and the currently running slot
+		slot1 = signal.connect([&]() { calls1++; slot2 = Slot(); slot1 = Slot(); });
+		slot2 = signal.connect([&]() { calls2++; });
+		slot3 = signal.connect([&]() { calls3++; });
+		signal();
+		if (calls1 != 1 || calls2 != 0 || calls3 != 1) throw Exception("Failed Test");
+		signal();
+		if (calls1 != 1 || calls2 != 0 || calls3 != 2) throw Exception("Failed Test");
+
+		// Slots connected during emit are first called on the next emit
+		Slot added;
+		slot1 = signal.connect([&]() { if (!added) added = signal.connect([&]() { calls2++; }); });
+		signal();
+		if (calls2 != 0) throw Exception("Failed Test");
+		signal();
+		if (calls2 != 1) throw Exception("Failed Test");
+
+		// Recursive emit with disconnect in the inner emit
+		Signal<void(int)> recursive;
+		int inner_calls = 0;
+		Slot r1, r2;
+		r1 = recursive.connect([&](int depth) { if (depth == 0) recursive(1); });
+		r2 = recursive.connect([&](int depth) { inner_calls++; if (depth == 1) r2 = Slot(); });
+		recursive(0);
+		if (inner_calls != 1) throw Exception("Failed Test");
+
+		// Destroying the signal from inside its own emit
+		std::unique_ptr<Signal<void()>> owned(new Signal<void()>());
+		int after_destroy = 0;
+		Slot o1 = owned->connect([&]() { owned.reset(); });
+		Slot o2 = owned->connect([&]() { after_destroy++; });
+		(*owned)();
+		if (owned || after_destroy != 1) throw Exception("Failed Test");
+	}
+
+	void test_slot_container()
+	{
+		Signal<void(int)> signal;
+		int sum = 0;
+		{
+			SlotContainer slots;
+			slots.connect(signal, [&](int value) { sum += value; });
+			slots.connect(signal, [&](int value) { sum += value; });
+			signal(2);
+		}
+		signal(2);
+		if (sum != 4) throw Exception("Failed Test");
+	}
+
+	template<typename SignalType, typename SlotType>
+	uint64_t benchmark_emit(int num_slots, int num_emits)
+	{
+		SignalType signal;
+		std::vector<SlotType> slots;
+		int sum = 0;
+		for (int i = 0; i < num_slots; i++)
+			slots.push_back(signal.connect([&sum](int x, int y) { sum += x + y; }));
+
+		uint64_t start_time = System::get_microseconds();
+		for (int i = 0; i < num_emits; i++)
+			signal(i, 1);
+		uint64_t elapsed = System::get_microseconds() - start_time;
+		if (sum == 0) throw Exception("Failed Test");
+		return elapsed;
+	}
+}
+
+void TestApp::test_signal()
+{
+	Console::write_line(" Header: signal.h");
+	Console::write_line("  Class: Signal");
+
+	Console::write_line("   Function: operator()");
+	test_emit();
+
+	Console::write_line("   Function: operator() - disconnect during emit");
+	test_disconnect_during_emit();
+
+	Console::write_line("  Class: SlotContainer");
+	Console::write_line("   Function: connect()");
+	test_slot_container();
+
+	const int num_emits = 1000000;
+	Console::write_line(string_format("   Emit benchmark (%1 emits, microseconds)", num_emits));
+	Console::write_line("    Slots  Previous  Current");
+	for (int num_slots : { 1, 4, 16 })
+	{
+		uint64_t previous = benchmark_emit<legacy::LegacySignal<void(int, int)>, std::shared_ptr<legacy::LegacySlot<void(int, int)>>>(num_slots, num_emits);
+		uint64_t current = benchmark_emit<Signal<void(int, int)>, Slot>(num_slots, num_emits);
+		Console::write_line(string_format("    %1  %2  %3", num_slots, (int)previous, (int)current));
+	}
+}
@@ -0,0 +1,158 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+#include <atomic>
+
+void TestApp::test_task()
+{
+	Console::write_line(" Header: task.h");
+	Console::write_line("  Class: Task");
+
+	WorkQueue queue(false, true);
+
+	Console::write_line("   Function: run(), wait()");
+	{
+		std::atomic_int value(0);
+		Task task = Task::run_async(queue, [&]() { value = 42; });
+		task.wait();
+		if (!task.is_completed()) fail();
+		if (value != 42) fail();
+	}
+
+	Console::write_line("   Function: add_dependency(), then()");
+	{
+		std::mutex mutex;
+		std::vector<int> order;
+		auto record = [&](int step) { std::unique_lock<std::mutex> lock(mutex); order.push_back(step); };
+
+		Task first(queue, [&]() { System::sleep(10); record(1); });
+		Task second(queue, [&]() { record(2); });
+		second.add_dependency(first);
+		Task third = second.then(queue, [&]() { record(3); });
+		second.run();
+		first.run();
+		third.wait();
+		if (order.size() != 3 || order[0] != 1 || order[1] != 2 || order[2] != 3) fail();
+	}
+
+	Console::write_line("   Function: when_all()");
+	{
+		std::atomic_int value(0);
+		std::vector<Task> tasks;
+		for (int i = 0; i < 16; i++)
+			tasks.push_back(Task::run_async(queue, [&]() { value++; }));
+		int result = 0;
+		Task::when_all(queue, tasks, [&]() { result = value; }).wait();
+		if (result != 16) fail();
+	}
+
+	Console::write_line("   Function: then() - queue released while the dependency runs");
+	for (int work_stealing = 0; work_stealing < 2; work_stealing++)
+	{
+		std::atomic_bool started(false);
+		std::atomic_bool released(false);
+		std::atomic_int value(0);
+		Task first, second;
+		{
+			WorkQueue local_queue(false, work_stealing != 0, 1);
+			first = Task::run_async(local_queue, [&]() { started = true; while (!released) System::sleep(1); value = 1; });
+			second = first.then(local_queue, [&]() { value = 2; });
+			while (!started)
+				System::sleep(1);
+		}
+		released = true;
+
+		// The continuation releases the last queue reference on the queue's own worker thread
+		first.wait();
+		second.wait();
+		if (value != 2) fail();
+	}
+
+	Console::write_line("   Function: wait() rethrows");
+	{
+		Task task = Task::run_async(queue, []() { throw Exception("Expected"); });
+		bool caught = false;
+		try
+		{
+			task.wait();
+		}
+		catch (const Exception &)
+		{
+			caught = true;
+		}
+		if (!caught) fail();
+	}
+
+	Console::write_line(" Header: parallel.h");
+	Console::write_line("   Function: parallel_for()");
+	{
+		std::vector<int> values(100000, 0);
+		parallel_for(queue, 0, (int)values.size(), [&](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+				values[i] += i;
+		});
+		for (int i = 0; i < (int)values.size(); i++)
+		{
+			if (values[i] != i) fail();
+		}
+
+		// Nested parallel_for from worker threads must not deadlock
+		std::atomic_int count(0);
+		parallel_for(queue, 0, 8, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+				parallel_for(queue, 0, 1000, [&](int inner_begin, int inner_end) { count += inner_end - inner_begin; });
+		}, 1);
+		if (count != 8000) fail();
+	}
+
+	Console::write_line("   Function: parallel_for_async()");
+	{
+		std::atomic_int count(0);
+		Task task = parallel_for_async(queue, 10, 5010, [&](int begin, int end) { count += end - begin; });
+		task.wait();
+		if (count != 5000) fail();
+	}
+
+	Console::write_line("   Function: parallel_reduce()");
+	{
+		int64_t sum = parallel_reduce(queue, 0, 100000, (int64_t)0,
+			[](int begin, int end, int64_t init) { for (int i = begin; i < end; i++) init += i; return init; },
+			[](int64_t a, int64_t b) { return a + b; });
+		if (sum != (int64_t)99999 * 100000 / 2) fail();
+	}
+
+	while (queue.get_items_queued() > 0)
+	{
+		queue.process_work_completed();
+		System::sleep(0);
+	}
+}
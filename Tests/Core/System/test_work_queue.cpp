@@ -0,0 +1,146 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+#include <atomic>
+
+namespace
+{
+	void wait_for_queue(WorkQueue &queue)
+	{
+		while (queue.get_items_queued() > 0)
+		{
+			queue.process_work_completed();
+			System::sleep(0);
+		}
+	}
+
+	class CountingWorkItem : public WorkItem
+	{
+	public:
+		CountingWorkItem(std::atomic_int &processed, int &completed) : processed(processed), completed(completed) { }
+
+		void process_work() override { processed++; }
+		void work_completed() override { completed++; }
+
+	private:
+		std::atomic_int &processed;
+		int &completed;
+	};
+
+	// Each item queues two children until depth reaches zero, so most items are queued from worker threads
+	void queue_tree(WorkQueue &queue, std::atomic_int &processed, int depth)
+	{
+		queue.queue([&queue, &processed, depth]()
+		{
+			processed++;
+			if (depth > 0)
+			{
+				queue_tree(queue, processed, depth - 1);
+				queue_tree(queue, processed, depth - 1);
+			}
+		});
+	}
+
+	void test_queue_contract(bool work_stealing, int num_threads)
+	{
+		WorkQueue queue(false, work_stealing, num_threads);
+
+		std::atomic_int processed(0);
+		int completed = 0;
+		const int num_items = 5000;
+		for (int i = 0; i < num_items; i++)
+			queue.queue(new CountingWorkItem(processed, completed));
+		wait_for_queue(queue);
+		if (processed != num_items) throw Exception("Failed Test");
+		if (completed != num_items) throw Exception("Failed Test");
+
+		processed = 0;
+		const int depth = 12;
+		queue_tree(queue, processed, depth);
+		wait_for_queue(queue);
+		if (processed != (1 << (depth + 1)) - 1) throw Exception("Failed Test");
+
+		int main_thread_calls = 0;
+		queue.work_completed([&]() { main_thread_calls++; });
+		wait_for_queue(queue);
+		if (main_thread_calls != 1) throw Exception("Failed Test");
+	}
+
+	uint64_t benchmark_queue(bool work_stealing, int num_threads, bool nested)
+	{
+		WorkQueue queue(false, work_stealing, num_threads);
+		std::atomic_int processed(0);
+
+		// Warm up the worker threads
+		queue.queue([]() { });
+		wait_for_queue(queue);
+
+		uint64_t start_time = System::get_microseconds();
+		if (nested)
+		{
+			queue_tree(queue, processed, 15);
+		}
+		else
+		{
+			for (int i = 0; i < 65535; i++)
+				queue.queue([&processed]() { processed++; });
+		}
+		wait_for_queue(queue);
+		return System::get_microseconds() - start_time;
+	}
+}
+
+void TestApp::test_work_queue()
+{
+	Console::write_line(" Header: work_queue.h");
+	Console::write_line("  Class: WorkQueue");
+
+	int num_cores = System::get_num_cores();
+
+	Console::write_line("   Function: queue() - shared queue");
+	test_queue_contract(false, 0);
+	test_queue_contract(false, 1);
+
+	Console::write_line("   Function: queue() - work stealing");
+	test_queue_contract(true, 0);
+	test_queue_contract(true, 1);
+	test_queue_contract(true, num_cores);
+
+	Console::write_line("   Contention benchmark (65535 tiny items, microseconds)");
+	Console::write_line("    Threads  Shared/flat  Stealing/flat  Shared/nested  Stealing/nested");
+	for (int num_threads = 1; num_threads <= num_cores; num_threads++)
+	{
+		uint64_t shared_flat = benchmark_queue(false, num_threads, false);
+		uint64_t stealing_flat = benchmark_queue(true, num_threads, false);
+		uint64_t shared_nested = benchmark_queue(false, num_threads, true);
+		uint64_t stealing_nested = benchmark_queue(true, num_threads, true);
+		Console::write_line(string_format("    %1  %2  %3  %4  %5", num_threads, (int)shared_flat, (int)stealing_flat, (int)shared_nested, (int)stealing_nested));
+	}
+}
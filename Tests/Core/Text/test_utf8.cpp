@@ -0,0 +1,313 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "test.h"
+#include <random>
+
+namespace
+{
+	int reference_trailing_bytes(unsigned char c)
+	{
+		return c < 0xc0 ? 0 : c < 0xe0 ? 1 : c < 0xf0 ? 2 : c < 0xf8 ? 3 : c < 0xfc ? 4 : 5;
+	}
+
+	// RFC 3629 decoding, one code point at a time
+	bool reference_is_valid(const std::string &text)
+	{
+		size_t pos = 0;
+		while (pos < text.length())
+		{
+			unsigned char c = text[pos];
+			int trailing = reference_trailing_bytes(c);
+			if ((c >= 0x80 && c < 0xc0) || trailing > 3 || pos + trailing >= text.length() + (trailing > 0 ? 0 : 1))
+				return false;
+			unsigned int code_point = c & (0x7f >> trailing);
+			for (int i = 1; i <= trailing; i++)
+			{
+				unsigned char cont = text[pos + i];
+				if ((cont & 0xc0) != 0x80)
+					return false;
+				code_point = (code_point << 6) | (cont & 0x3f);
+			}
+			static const unsigned int min_value[4] = { 0, 0x80, 0x800, 0x10000 };
+			if (code_point < min_value[trailing] || code_point > 0x10ffff || (code_point >= 0xd800 && code_point <= 0xdfff))
+				return false;
+			pos += 1 + trailing;
+		}
+		return true;
+	}
+
+	// The byte at a time conversion StringHelp used before the bulk versions
+	std::wstring reference_utf8_to_ucs2(const std::string &utf8)
+	{
+		std::wstring ucs2;
+		size_t pos = 0;
+		while (pos < utf8.length())
+		{
+			unsigned char c = utf8[pos++];
+			int trailing_bytes = reference_trailing_bytes(c);
+			if (pos + trailing_bytes > utf8.length())
+				break;
+			unsigned int ucs4 = c & (0x7f >> trailing_bytes);
+			for (int i = 0; i < trailing_bytes; i++)
+			{
+				c = utf8[pos + i];
+				if (c < 0xc0)
+				{
+					ucs4 = (ucs4 << 6) + (c & 0x3f);
+				}
+				else
+				{
+					ucs4 = L'?';
+					break;
+				}
+			}
+			ucs2 += (ucs4 > 0 && ucs4 <= 0xffff) ? (wchar_t)ucs4 : L'?';
+			pos += trailing_bytes;
+		}
+		return ucs2;
+	}
+
+	std::string reference_ucs2_to_utf8(const std::wstring &ucs2)
+	{
+		std::string utf8;
+		for (wchar_t c : ucs2)
+		{
+			if (c < 0x0080)
+			{
+				utf8 += (char)c;
+			}
+			else if (c < 0x0800)
+			{
+				utf8 += (char)(0xc0 + (c >> 6));
+				utf8 += (char)(0x80 + (c & 0x3f));
+			}
+			else
+			{
+				utf8 += (char)(0xe0 + (c >> 12));
+				utf8 += (char)(0x80 + ((c >> 6) & 0x3f));
+				utf8 += (char)(0x80 + (c & 0x3f));
+			}
+		}
+		return utf8;
+	}
+
+	// Mostly ASCII runs and valid characters, with the occasional random byte when corrupt is set
+	std::string random_text(std::mt19937 &random, bool corrupt)
+	{
+		std::string text;
+		int pieces = random() % 12;
+		for (int i = 0; i < pieces; i++)
+		{
+			switch (random() % (corrupt ? 6 : 5))
+			{
+			case 0:
+			case 1:
+				text += std::string(random() % 70, (char)('a' + random() % 26));
+				break;
+			case 2:
+				text += StringHelp::unicode_to_utf8(0x80 + random() % (0x800 - 0x80));
+				break;
+			case 3:
+			{
+				unsigned int code_point = 0x800 + random() % (0x10000 - 0x800);
+				if (code_point < 0xd800 || code_point > 0xdfff)
+					text += StringHelp::unicode_to_utf8(code_point);
+				break;
+			}
+			case 4:
+				text += StringHelp::unicode_to_utf8(0x10000 + random() % (0x110000 - 0x10000));
+				break;
+			default:
+				text += (char)(random() % 256);
+				break;
+			}
+		}
+		return text;
+	}
+}
+
+void TestApp::test_utf8()
+{
+	Console::write_line(" Header: string_help.h, utf8_reader.h");
+	Console::write_line("  UTF-8 bulk functions");
+
+	Console::write_line("   Function: is_valid_utf8() at every block offset");
+	{
+		struct { const char *bytes; bool valid; } cases[] =
+		{
+			{ "a", true }, { "\xc3\xa6", true }, { "\xe2\x82\xac", true }, { "\xf0\x9f\x98\x80", true },
+			{ "\xef\xbf\xbf", true }, { "\xf4\x8f\xbf\xbf", true }, { "\xed\x9f\xbf", true }, { "\xee\x80\x80", true },
+			{ "\x80", false }, { "\xbf", false }, { "\xc0\x80", false }, { "\xc1\xbf", false }, { "\xc3", false },
+			{ "\xc3\x28", false }, { "\xe0\x80\x80", false }, { "\xe0\x9f\xbf", false }, { "\xed\xa0\x80", false },
+			{ "\xed\xbf\xbf", false }, { "\xe2\x82", false }, { "\xe2\x28\xa1", false }, { "\xf0\x80\x80\x80", false },
+			{ "\xf0\x8f\xbf\xbf", false }, { "\xf4\x90\x80\x80", false }, { "\xf5\x80\x80\x80", false },
+			{ "\xf0\x9f\x98", false }, { "\xf8\x88\x80\x80\x80", false }, { "\xff", false }, { "\xc3\xa6\xa6", false }
+		};
+		for (const auto &c : cases)
+		{
+			for (int prefix = 0; prefix < 70; prefix++)
+			{
+				for (int suffix = 0; suffix < 3; suffix++)
+				{
+					std::string text = std::string(prefix, 'x') + c.bytes + std::string(suffix * 33, 'y');
+					if (StringHelp::is_valid_utf8(text) != c.valid || reference_is_valid(text) != c.valid)
+						throw Exception(string_format("UTF-8 test failed: validation of case at offset %1", prefix));
+				}
+			}
+		}
+	}
+
+	Console::write_line("   Function: is_valid_utf8() on random text");
+	{
+		std::mt19937 random(4711);
+		for (int i = 0; i < 100000; i++)
+		{
+			std::string text = random_text(random, i % 2 == 1);
+			if (StringHelp::is_valid_utf8(text) != reference_is_valid(text))
+				throw Exception(string_format("UTF-8 test failed: validation of random text %1", i));
+		}
+	}
+
+	Console::write_line("   Function: utf8_to_ucs2() and ucs2_to_utf8()");
+	{
+		std::mt19937 random(1234);
+		for (int i = 0; i < 50000; i++)
+		{
+			std::string text = random_text(random, i % 2 == 1);
+			if (i % 7 == 0)
+				text.insert(random() % (text.length() + 1), 1, '\0');
+
+			std::wstring ucs2 = StringHelp::utf8_to_ucs2(text);
+			if (ucs2 != reference_utf8_to_ucs2(text))
+				throw Exception(string_format("UTF-8 test failed: utf8_to_ucs2 of random text %1", i));
+			if (StringHelp::ucs2_to_utf8(ucs2) != reference_ucs2_to_utf8(ucs2))
+				throw Exception(string_format("UTF-8 test failed: ucs2_to_utf8 of random text %1", i));
+		}
+
+		std::wstring wide = std::wstring(40, L'a') + L'\0' + std::wstring(20, L'b') + (wchar_t)0x20ac + std::wstring(17, L'c');
+		if (StringHelp::ucs2_to_utf8(wide) != reference_ucs2_to_utf8(wide) || StringHelp::ucs2_to_utf8(wide).length() != 81)
+			throw Exception("UTF-8 test failed: ucs2_to_utf8 with embedded null");
+	}
+
+	Console::write_line("   Function: text_to_upper(), text_to_lower(), ucs2_to_upper() and ucs2_to_lower()");
+	{
+		std::mt19937 random(99);
+		for (int i = 0; i < 20000; i++)
+		{
+			std::string text = random_text(random, true);
+			for (char &c : text)
+			{
+				if (random() % 4 == 0)
+					c = (char)(0x20 + random() % 0x60);
+			}
+
+			std::string upper = text, lower = text;
+			for (char &c : upper)
+				c = (char)toupper((unsigned char)c);
+			for (char &c : lower)
+				c = (char)tolower((unsigned char)c);
+			if (StringHelp::text_to_upper(text) != upper || StringHelp::text_to_lower(text) != lower)
+				throw Exception(string_format("UTF-8 test failed: case conversion of random text %1", i));
+
+			std::wstring wide = StringHelp::utf8_to_ucs2(text);
+			std::wstring wide_upper = wide, wide_lower = wide;
+			for (wchar_t &c : wide_upper)
+				c = towupper(c);
+			for (wchar_t &c : wide_lower)
+				c = towlower(c);
+			if (StringHelp::ucs2_to_upper(wide) != wide_upper || StringHelp::ucs2_to_lower(wide) != wide_lower)
+				throw Exception(string_format("UTF-8 test failed: wide case conversion of random text %1", i));
+		}
+	}
+
+	Console::write_line("   Class: UTF8_Reader");
+	{
+		std::mt19937 random(5);
+		for (int i = 0; i < 20000; i++)
+		{
+			std::string text = random_text(random, i % 2 == 1);
+
+			std::string::size_type expected = 0;
+			UTF8_Reader reference(text.data(), text.length());
+			while (!reference.is_end())
+			{
+				expected++;
+				reference.next();
+			}
+			if (StringHelp::utf8_length(text) != expected)
+				throw Exception(string_format("UTF-8 test failed: utf8_length of random text %1", i));
+
+			UTF8_Reader reader(text.data(), text.length());
+			std::string::size_type ascii = reader.skip_ascii();
+			if (ascii != text.length() && (unsigned char)text[ascii] < 0x80)
+				throw Exception("UTF-8 test failed: skip_ascii stopped early");
+			for (std::string::size_type pos = 0; pos < ascii; pos++)
+			{
+				if ((unsigned char)text[pos] >= 0x80)
+					throw Exception("UTF-8 test failed: skip_ascii skipped past a non-ASCII character");
+			}
+			if (reader.get_position() != ascii)
+				throw Exception("UTF-8 test failed: skip_ascii position");
+		}
+	}
+
+	Console::write_line("   Function: throughput");
+	{
+		std::mt19937 random(8);
+		std::string text;
+		while (text.length() < 8 * 1024 * 1024)
+			text += random_text(random, false);
+
+		uint64_t start_time = System::get_microseconds();
+		bool valid = StringHelp::is_valid_utf8(text);
+		uint64_t validate_time = System::get_microseconds() - start_time;
+
+		start_time = System::get_microseconds();
+		bool reference_valid = reference_is_valid(text);
+		uint64_t reference_validate_time = System::get_microseconds() - start_time;
+
+		start_time = System::get_microseconds();
+		std::wstring ucs2 = StringHelp::utf8_to_ucs2(text);
+		uint64_t to_ucs2_time = System::get_microseconds() - start_time;
+
+		start_time = System::get_microseconds();
+		std::wstring reference_ucs2 = reference_utf8_to_ucs2(text);
+		uint64_t reference_to_ucs2_time = System::get_microseconds() - start_time;
+
+		start_time = System::get_microseconds();
+		std::string upper = StringHelp::text_to_upper(text);
+		uint64_t upper_time = System::get_microseconds() - start_time;
+
+		if (!valid || !reference_valid || ucs2 != reference_ucs2 || upper.length() != text.length())
+			throw Exception("UTF-8 test failed: throughput data");
+
+		Console::write_line("    %1 KB: is_valid_utf8 %2 ms (per character %3 ms)", (int)(text.length() / 1024), (int)(validate_time / 1000), (int)(reference_validate_time / 1000));
+		Console::write_line("    utf8_to_ucs2 %1 ms (per character %2 ms), text_to_upper %3 ms", (int)(to_ucs2_time / 1000), (int)(reference_to_ucs2_time / 1000), (int)(upper_time / 1000));
+	}
+}
@@ -0,0 +1,181 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#include "test.h"
+
+namespace
+{
+	DomDocument load_document(const std::string &text, bool element_index)
+	{
+		DataBuffer buffer(text.data(), text.length());
+		MemoryDevice device(buffer);
+		return DomDocument(device, true, element_index);
+	}
+
+	std::string id_of(const DomElement &element)
+	{
+		return element.is_null() ? "null" : element.get_attribute("name");
+	}
+
+	std::string names_of(const DomNodeList &list)
+	{
+		std::string result;
+		for (int i = 0; i < list.get_length(); i++)
+			result += (i ? " " : "") + list.item(i).to_element().get_attribute("name");
+		return result;
+	}
+
+	std::string names_of(const std::vector<DomNode> &nodes)
+	{
+		std::string result;
+		for (size_t i = 0; i < nodes.size(); i++)
+			result += (i ? " " : "") + nodes[i].to_element().get_attribute("name");
+		return result;
+	}
+
+	void check(const std::string &result, const std::string &expected, const std::string &what)
+	{
+		if (result != expected)
+			throw Exception("DOM index test failed: " + what + " returned '" + result + "', expected '" + expected + "'");
+	}
+}
+
+void TestApp::test_dom_index()
+{
+	Console::write_line(" Header: dom_document.h");
+
+	const std::string text =
+		"<root name='root'>"
+		"<item id='a' name='a1'><item name='a2'/><other ID='b' name='b1'/></item>"
+		"<other name='o1'><item xml:id='c' name='c1'/></other>"
+		"<item id='a' name='dup'/>"
+		"</root>";
+
+	Console::write_line("  Function: get_element_by_id and get_elements_by_tag_name");
+	for (int indexed = 0; indexed < 2; indexed++)
+	{
+		DomDocument document = load_document(text, indexed != 0);
+		if (document.is_element_index_enabled() != (indexed != 0))
+			throw Exception("DOM index test failed: is_element_index_enabled");
+
+		check(id_of(document.get_element_by_id("a")), "a1", "get_element_by_id(a)");
+		check(id_of(document.get_element_by_id("b")), "b1", "get_element_by_id(b)");
+		check(id_of(document.get_element_by_id("c")), "c1", "get_element_by_id(c)");
+		check(id_of(document.get_element_by_id("missing")), "null", "get_element_by_id(missing)");
+		check(names_of(document.get_elements_by_tag_name("item")), "a1 a2 c1 dup", "get_elements_by_tag_name(item)");
+		check(names_of(document.get_elements_by_tag_name("other")), "b1 o1", "get_elements_by_tag_name(other)");
+		check(names_of(document.get_elements_by_tag_name("*")), "root a1 a2 b1 o1 c1 dup", "get_elements_by_tag_name(*)");
+		check(names_of(document.get_elements_by_tag_name("missing")), "", "get_elements_by_tag_name(missing)");
+
+		check(names_of(document.select_nodes("//item")), "a1 a2 c1 dup", "//item");
+		check(names_of(document.select_nodes("//item[1]")), "a1 a2 c1", "//item[1]");
+		check(names_of(document.select_nodes("//item[@id]/other")), "b1", "//item[@id]/other");
+		check(names_of(document.select_nodes("id('c b a')")), "c1 b1 a1", "id('c b a')");
+	}
+
+	Console::write_line("  Function: index updates on DOM mutation");
+	{
+		DomDocument document = load_document(text, true);
+		DomElement root = document.get_document_element();
+
+		DomElement added = document.create_element("item");
+		added.set_attribute("name", "new");
+		added.set_attribute("id", "n");
+		check(id_of(document.get_element_by_id("n")), "null", "detached element");
+		root.append_child(added);
+		check(id_of(document.get_element_by_id("n")), "new", "appended element");
+		check(names_of(document.select_nodes("//item")), "a1 a2 c1 dup new", "//item after append");
+
+		added.set_attribute("id", "m");
+		check(id_of(document.get_element_by_id("n")), "null", "changed id (old value)");
+		check(id_of(document.get_element_by_id("m")), "new", "changed id (new value)");
+
+		added.remove_attribute("id");
+		check(id_of(document.get_element_by_id("m")), "null", "removed id attribute");
+
+		DomElement first = document.get_element_by_id("a");
+		root.remove_child(first);
+		check(id_of(document.get_element_by_id("a")), "dup", "removed element with duplicate id");
+		check(id_of(document.get_element_by_id("b")), "null", "removed subtree");
+		check(names_of(document.get_elements_by_tag_name("item")), "c1 dup new", "get_elements_by_tag_name after remove");
+
+		DomNode first_child = root.get_first_child();
+		root.insert_before(first, first_child);
+		check(id_of(document.get_element_by_id("a")), "a1", "reinserted element");
+		check(id_of(document.get_element_by_id("b")), "b1", "reinserted subtree");
+
+		document.set_element_index_enabled(false);
+		root.remove_child(first);
+		document.set_element_index_enabled(true);
+		check(id_of(document.get_element_by_id("b")), "null", "changed while index was disabled");
+
+		document.clear_all();
+		check(names_of(document.get_elements_by_tag_name("item")), "", "clear_all");
+		if (!document.is_element_index_enabled())
+			throw Exception("DOM index test failed: clear_all disabled the index");
+	}
+
+	Console::write_line("  Benchmark: lookups on a large document");
+	{
+		std::string large = "<root>";
+		for (int i = 0; i < 2000; i++)
+			large += "<group><item id='i" + StringHelp::int_to_text(i) + "'/><other/></group>";
+		large += "</root>";
+
+		const int iterations = 200;
+		int id_time[2] = { 0, 0 };
+		int name_time[2] = { 0, 0 };
+		for (int indexed = 0; indexed < 2; indexed++)
+		{
+			DomDocument document = load_document(large, indexed != 0);
+			int found = 0;
+
+			uint64_t start = System::get_microseconds();
+			for (int i = 0; i < iterations; i++)
+			{
+				if (!document.get_element_by_id("i" + StringHelp::int_to_text((i * 7) % 2000)).is_null())
+					found++;
+			}
+			id_time[indexed] = (int)(System::get_microseconds() - start);
+
+			start = System::get_microseconds();
+			for (int i = 0; i < iterations; i++)
+			{
+				if (document.select_nodes("//item").size() == 2000)
+					found++;
+			}
+			name_time[indexed] = (int)(System::get_microseconds() - start);
+
+			if (found != 2 * iterations)
+				throw Exception("DOM index test failed: benchmark result");
+		}
+		Console::write_line(string_format("    %1 get_element_by_id: tree walk %2 us, element index %3 us", iterations, id_time[0], id_time[1]));
+		Console::write_line(string_format("    %1 //item: tree walk %2 us, element index %3 us", iterations, name_time[0], name_time[1]));
+	}
+}
@@ -0,0 +1,129 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#include "test.h"
+
+namespace
+{
+	DomDocument load_document(const std::string &text)
+	{
+		DataBuffer buffer(text.data(), text.length());
+		MemoryDevice device(buffer);
+		return DomDocument(device);
+	}
+}
+
+void TestApp::test_dom_strings()
+{
+	Console::write_line(" Header: dom_node.h, dom_element.h, dom_character_data.h");
+	Console::write_line("  Interned names and node values");
+
+	Console::write_line("   Function: get_node_name() and get_namespace_uri()");
+	{
+		DomDocument document = load_document("<root><item a='1'/><item a='2'/><other/></root>");
+		DomElement root = document.get_document_element();
+		DomNode first = root.get_first_child();
+		DomNode second = first.get_next_sibling();
+		if (root.get_node_name() != "root" || first.get_node_name() != "item" || second.get_next_sibling().get_node_name() != "other")
+			throw Exception("DOM string test failed: element names");
+		if (&first.get_node_name() != &second.get_node_name())
+			throw Exception("DOM string test failed: equal names are not shared");
+		if (document.get_node_name() != "#document" || document.create_text_node("x").get_node_name() != "#text" || DomNode().get_node_name() != "")
+			throw Exception("DOM string test failed: fixed names");
+
+		DomElement renamed = document.create_element("item");
+		renamed.set_prefix("p");
+		if (renamed.get_node_name() != "p:item" || first.get_node_name() != "item")
+			throw Exception("DOM string test failed: set_prefix() changed other nodes");
+	}
+
+	Console::write_line("   Function: find_namespace_uri()");
+	{
+		DomDocument document = load_document("<root xmlns='urn:default' xmlns:x='urn:x'><a><x:b x:attr='1' plain='2'/></a></root>");
+		DomElement a = document.get_document_element().get_first_child().to_element();
+		DomElement b = a.get_first_child().to_element();
+		if (a.get_namespace_uri() != "urn:default" || b.get_namespace_uri() != "urn:x")
+			throw Exception("DOM string test failed: element namespaces");
+		if (b.get_attribute_ns("urn:x", "attr") != "1" || !b.has_attribute_ns("urn:x", "attr"))
+			throw Exception("DOM string test failed: attribute namespaces");
+
+		DomDocument plain = load_document("<root><a x='1'/></root>");
+		if (plain.get_document_element().get_first_child().get_namespace_uri() != "")
+			throw Exception("DOM string test failed: namespace without declarations");
+	}
+
+	Console::write_line("   Function: set_attribute_ns() replacing attributes");
+	{
+		DomDocument document;
+		DomElement element = document.create_element("e");
+		document.append_child(element);
+		element.set_attribute_ns("urn:x", "p:name", "1");
+		element.set_attribute_ns("urn:x", "p:name", "2");
+		element.set_attribute_ns("urn:x", "q:name", "3");
+		element.set_attribute_ns("urn:y", "p:name", "4");
+		element.set_attribute("other", "5");
+		if (element.get_attributes().get_length() != 3)
+			throw Exception("DOM string test failed: attribute count after replacing");
+		if (element.get_attribute_ns("urn:x", "name") != "3" || element.get_attribute_ns("urn:y", "name") != "4" || element.get_attribute("other") != "5")
+			throw Exception("DOM string test failed: attribute values after replacing");
+	}
+
+	Console::write_line("   Function: node values");
+	{
+		DomDocument document;
+		DomText text = document.create_text_node("hello");
+		text.append_data(" world");
+		for (int i = 0; i < 100; i++)
+			text.append_data("!");
+		if (text.get_node_value() != "hello world" + std::string(100, '!'))
+			throw Exception("DOM string test failed: append_data()");
+
+		text.set_node_value("abcdef");
+		text.insert_data(3, "XYZ");
+		text.delete_data(0, 2);
+		if (text.get_node_value() != "cXYZdef" || text.substring_data(1, 3) != "XYZ")
+			throw Exception("DOM string test failed: insert_data() and delete_data()");
+
+		text.set_node_value("");
+		if (text.get_node_value() != "")
+			throw Exception("DOM string test failed: empty value");
+
+		// Freed tree nodes are reused and must not keep their old values
+		DomElement parent = document.create_element("parent");
+		document.append_child(parent);
+		for (int i = 0; i < 10; i++)
+		{
+			DomAttr attribute = document.create_attribute("a");
+			attribute.set_node_value(std::string(i * 10, 'x'));
+		}
+		DomAttr reused = document.create_attribute("b");
+		if (reused.get_node_value() != "" || reused.get_node_name() != "b")
+			throw Exception("DOM string test failed: reused node");
+	}
+}
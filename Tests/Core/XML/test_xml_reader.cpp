@@ -0,0 +1,228 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#include "test.h"
+#include <chrono>
+#include <random>
+
+namespace
+{
+	// Resource file shaped document: many elements with a few attributes each
+	std::string build_resource_document(unsigned int seed, size_t min_length)
+	{
+		std::mt19937 random(seed);
+		std::string document = "<?xml version=\"1.0\"?>\n<resources>\n";
+		while (document.length() < min_length)
+		{
+			int id = random() % 100000;
+			document += "\t<sprite name=\"sprite" + std::to_string(id) + "\" file=\"images/sprite&amp;" + std::to_string(id) + ".png\">\n";
+			int frames = random() % 6;
+			for (int i = 0; i < frames; i++)
+				document += "\t\t<frame x=\"" + std::to_string(i * 32) + "\" y='0' width=\"32\" height=\"32\"/>\n";
+			if (random() % 4 == 0)
+				document += "\t\t<!-- unused -->\n\t\t<description>A &lt;sprite&gt; with text</description>\n";
+			if (random() % 8 == 0)
+				document += "\t\t<data><![CDATA[raw <data>]]></data>\n";
+			document += "\t</sprite>\n";
+		}
+		document += "</resources>\n";
+		return document;
+	}
+
+	MemoryDevice memory_device(const std::string &document)
+	{
+		DataBuffer buffer(document.data(), document.length());
+		return MemoryDevice(buffer);
+	}
+
+	class CountingHandler : public XMLHandler
+	{
+	public:
+		int elements = 0;
+		int end_elements = 0;
+		int texts = 0;
+		int cdata_sections = 0;
+		int comments = 0;
+		int instructions = 0;
+		int frames = 0;
+		std::string last_description;
+
+		void start_element(const XMLReader &reader) override
+		{
+			elements++;
+			if (reader.get_name() == "frame" && reader.get_attribute("width") == "32")
+				frames++;
+		}
+
+		void end_element(const XMLStringView &name) override { end_elements++; }
+		void text(const XMLStringView &text) override { texts++; last_description = text.to_string(); }
+		void cdata_section(const XMLStringView &data) override { cdata_sections++; }
+		void comment(const XMLStringView &text) override { comments++; }
+		void processing_instruction(const XMLStringView &target, const XMLStringView &data) override { instructions++; }
+	};
+
+	double seconds_since(const std::chrono::steady_clock::time_point &start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+void TestApp::test_xml_reader()
+{
+	Console::write_line(" Header: xml_reader.h");
+	Console::write_line("  Class: XMLReader");
+
+	Console::write_line("   Function: next() and node accessors");
+	{
+		MemoryDevice device = memory_device("<?xml version=\"1.0\"?><root a=\"1 &lt; 2\" b='x'>\n  text &amp; more  \n<empty/><!-- note --><![CDATA[<raw>]]></root>");
+		XMLReader reader(device);
+
+		if (!reader.next() || reader.get_type() != XMLToken::PROCESSING_INSTRUCTION_TOKEN || reader.get_name() != "xml" || reader.get_value() != "version=\"1.0\"")
+			throw Exception("XMLReader test failed: processing instruction");
+
+		if (!reader.next() || !reader.is_start_element("root") || reader.get_depth() != 0 || reader.get_attribute_count() != 2)
+			throw Exception("XMLReader test failed: start element");
+		if (reader.get_attribute_name(0) != "a" || reader.get_attribute_value(0) != "1 < 2" || reader.get_attribute("b") != "x")
+			throw Exception("XMLReader test failed: attributes");
+		if (!reader.has_attribute("b") || reader.has_attribute("c") || !reader.get_attribute("c").empty())
+			throw Exception("XMLReader test failed: missing attribute");
+
+		if (!reader.next() || reader.get_type() != XMLToken::TEXT_TOKEN || reader.get_value() != "text & more" || reader.get_depth() != 1)
+			throw Exception("XMLReader test failed: text");
+
+		if (!reader.next() || !reader.is_start_element("empty") || reader.get_variant() != XMLToken::SINGLE || reader.get_depth() != 1)
+			throw Exception("XMLReader test failed: empty element");
+
+		if (!reader.next() || reader.get_type() != XMLToken::COMMENT_TOKEN || reader.get_value() != "note")
+			throw Exception("XMLReader test failed: comment");
+
+		if (!reader.next() || reader.get_type() != XMLToken::CDATA_SECTION_TOKEN || reader.get_value() != "<raw>")
+			throw Exception("XMLReader test failed: CDATA section");
+
+		if (!reader.next() || !reader.is_end_element() || reader.get_name() != "root" || reader.get_depth() != 0)
+			throw Exception("XMLReader test failed: end element");
+
+		if (reader.next() || reader.get_type() != XMLToken::NULL_TOKEN)
+			throw Exception("XMLReader test failed: end of input");
+	}
+
+	Console::write_line("   Function: skip_element()");
+	{
+		MemoryDevice device = memory_device("<a><b><b/><c>x</c></b><d/></a>");
+		XMLReader reader(device);
+		reader.next();
+		reader.next();
+		reader.skip_element();
+		if (!reader.is_end_element() || reader.get_name() != "b")
+			throw Exception("XMLReader test failed: skip_element() stopped early");
+		if (!reader.next() || !reader.is_start_element("d"))
+			throw Exception("XMLReader test failed: skip_element() went too far");
+	}
+
+	Console::write_line("   Function: next() matches XMLTokenizer");
+	std::string document = build_resource_document(1, 1024 * 1024);
+	{
+		MemoryDevice tokenizer_device = memory_device(document);
+		MemoryDevice reader_device = memory_device(document);
+		XMLTokenizer tokenizer(tokenizer_device);
+		XMLReader reader(reader_device);
+
+		int count = 0;
+		while (true)
+		{
+			XMLToken token = tokenizer.next();
+			bool found = reader.next();
+			if (found != (token.type != XMLToken::NULL_TOKEN))
+				throw Exception(string_format("XMLReader test failed: end of input at node %1", count));
+			if (!found)
+				break;
+
+			bool same = reader.get_type() == token.type && reader.get_variant() == token.variant && reader.get_attribute_count() == (int)token.attributes.size();
+			if (token.type == XMLToken::ELEMENT_TOKEN || token.type == XMLToken::PROCESSING_INSTRUCTION_TOKEN)
+				same = same && reader.get_name() == token.name;
+			if (token.type != XMLToken::ELEMENT_TOKEN && token.type != XMLToken::DOCUMENT_TYPE_TOKEN)
+				same = same && reader.get_value() == token.value;
+			for (int i = 0; same && i < (int)token.attributes.size(); i++)
+				same = reader.get_attribute_name(i) == token.attributes[i].first && reader.get_attribute_value(i) == token.attributes[i].second;
+			if (!same)
+				throw Exception(string_format("XMLReader test failed: node %1", count));
+			count++;
+		}
+	}
+
+	Console::write_line("   Function: parse()");
+	{
+		MemoryDevice device = memory_device("<?xml version=\"1.0\"?><a><b x='32'/><frame width='32'/>text<![CDATA[c]]><!--d--></a>");
+		XMLReader reader(device);
+		CountingHandler handler;
+		reader.parse(handler);
+		if (handler.elements != 3 || handler.end_elements != 3 || handler.frames != 1 || handler.texts != 1 || handler.last_description != "text" || handler.cdata_sections != 1 || handler.comments != 1 || handler.instructions != 1)
+			throw Exception("XMLReader test failed: handler callbacks");
+	}
+
+	Console::write_line("   Benchmark: XMLReader vs DomDocument::load");
+	{
+		document = build_resource_document(2, 16 * 1024 * 1024);
+		int megabytes = (int)(document.length() / (1024 * 1024));
+
+		auto start = std::chrono::steady_clock::now();
+		int dom_frames = 0;
+		{
+			MemoryDevice device = memory_device(document);
+			DomDocument dom(device);
+			for (DomNode sprite = dom.get_document_element().get_first_child(); !sprite.is_null(); sprite = sprite.get_next_sibling())
+			{
+				for (DomNode frame = sprite.get_first_child(); !frame.is_null(); frame = frame.get_next_sibling())
+				{
+					if (frame.get_node_name() == "frame" && frame.to_element().get_attribute("width") == "32")
+						dom_frames++;
+				}
+			}
+		}
+		double dom_time = seconds_since(start);
+
+		start = std::chrono::steady_clock::now();
+		int reader_frames = 0;
+		{
+			MemoryDevice device = memory_device(document);
+			XMLReader reader(device);
+			while (reader.next())
+			{
+				if (reader.is_start_element("frame") && reader.get_attribute("width") == "32")
+					reader_frames++;
+			}
+		}
+		double reader_time = seconds_since(start);
+
+		if (dom_frames != reader_frames)
+			throw Exception("XMLReader test failed: benchmark results differ");
+
+		Console::write_line(string_format("    %1 MB: DomDocument %2 MB/s, XMLReader %3 MB/s", megabytes, (int)(megabytes / dom_time), (int)(megabytes / reader_time)));
+	}
+}
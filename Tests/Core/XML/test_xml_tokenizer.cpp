@@ -0,0 +1,329 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#include "test.h"
+#include <chrono>
+#include <random>
+
+namespace
+{
+	struct ExpectedToken
+	{
+		XMLToken::TokenType type;
+		XMLToken::TokenVariant variant;
+		std::string name;
+		std::string value;
+		std::vector<XMLToken::Attribute> attributes;
+	};
+
+	// Builds a document together with the tokens the tokenizer should return for it
+	class DocumentBuilder
+	{
+	public:
+		DocumentBuilder(unsigned int seed) : random(seed) { }
+
+		std::string document;
+		std::vector<ExpectedToken> tokens;
+
+		void build(size_t min_length)
+		{
+			document = "<?xml version=\"1.0\"?>\n";
+			add(XMLToken::PROCESSING_INSTRUCTION_TOKEN, XMLToken::SINGLE, "xml", "version=\"1.0\"");
+			document += "<root>";
+			add(XMLToken::ELEMENT_TOKEN, XMLToken::BEGIN, "root");
+			while (document.length() < min_length)
+			{
+				switch (random() % 6)
+				{
+				case 0:
+				{
+					// Followed by an element so that text never merges with the next text
+					std::string value;
+					document += text(value) + "<br/>";
+					add(XMLToken::TEXT_TOKEN, XMLToken::SINGLE, std::string(), value.substr(0, value.find_last_not_of(' ') + 1));
+					add(XMLToken::ELEMENT_TOKEN, XMLToken::SINGLE, "br");
+					break;
+				}
+				case 1:
+				case 2:
+				{
+					ExpectedToken token = { XMLToken::ELEMENT_TOKEN, random() % 2 ? XMLToken::SINGLE : XMLToken::BEGIN, name(), std::string(), std::vector<XMLToken::Attribute>() };
+					document += "<" + token.name;
+					int count = random() % 4;
+					for (int i = 0; i < count; i++)
+					{
+						std::string value;
+						std::string escaped = text(value);
+						if (random() % 2)
+						{
+							// Whitespace in attribute values is kept as is
+							escaped += "\n\t";
+							value += "\n\t";
+						}
+						char quote = random() % 2 ? '"' : '\'';
+						document += std::string(1 + random() % 3, random() % 2 ? ' ' : '\n') + "a" + std::to_string(i) + "=" + quote + escaped + quote;
+						token.attributes.push_back(XMLToken::Attribute("a" + std::to_string(i), value));
+					}
+					document += token.variant == XMLToken::SINGLE ? "/>" : ">";
+					tokens.push_back(token);
+					if (token.variant == XMLToken::BEGIN)
+					{
+						document += "</" + token.name + ">";
+						add(XMLToken::ELEMENT_TOKEN, XMLToken::END, token.name);
+					}
+					break;
+				}
+				case 3:
+				{
+					std::string dashes(random() % 100, '-');
+					document += "<!-- a &lt; comment " + dashes + "x -->";
+					add(XMLToken::COMMENT_TOKEN, XMLToken::SINGLE, std::string(), "a < comment " + dashes + "x");
+					break;
+				}
+				case 4:
+				{
+					std::string value = "raw &amp; <data> " + std::string(random() % 200, 'c');
+					document += "<![CDATA[" + value + "]]>";
+					add(XMLToken::CDATA_SECTION_TOKEN, XMLToken::SINGLE, std::string(), value);
+					break;
+				}
+				default:
+					document += std::string(random() % 300, ' ') + "\r\n";
+					break;
+				}
+			}
+			document += "</root>";
+			add(XMLToken::ELEMENT_TOKEN, XMLToken::END, "root");
+		}
+
+	private:
+		void add(XMLToken::TokenType type, XMLToken::TokenVariant variant, const std::string &name, const std::string &value = std::string())
+		{
+			ExpectedToken token = { type, variant, name, value, std::vector<XMLToken::Attribute>() };
+			tokens.push_back(token);
+		}
+
+		std::string name()
+		{
+			static const char *names[] = { "a", "item", "ns:element", "long-element-name-with-dashes" };
+			return names[random() % 4];
+		}
+
+		// Returns the escaped form and sets value to what the tokenizer should produce for it
+		std::string text(std::string &value)
+		{
+			static const struct { const char *escaped; const char *unescaped; } pieces[] =
+			{
+				{ "plain", "plain" }, { "&amp;", "&" }, { "&lt;", "<" }, { "&gt;", ">" }, { "&quot;", "\"" }, { "&apos;", "'" },
+				{ "&amp;lt;", "&lt;" }, { "&unknown;", "&unknown;" }, { "\xc3\xa6\xc3\xb8\xc3\xa5", "\xc3\xa6\xc3\xb8\xc3\xa5" },
+				{ "\xe2\x82\xac", "\xe2\x82\xac" }, { "\xf0\x9f\x98\x80", "\xf0\x9f\x98\x80" }, { " ", " " }
+			};
+			std::string escaped = "x";
+			value = "x";
+			int count = random() % 40;
+			for (int i = 0; i < count; i++)
+			{
+				const auto &piece = pieces[random() % 12];
+				escaped += piece.escaped;
+				value += piece.unescaped;
+			}
+			if (random() % 8 == 0)
+			{
+				std::string padding(random() % 5000, 'y');
+				escaped += padding;
+				value += padding;
+			}
+			return escaped;
+		}
+
+		std::mt19937 random;
+	};
+
+	std::string encode(const std::string &utf8, bool utf32, bool big_endian, bool bom)
+	{
+		std::vector<unsigned int> units;
+		if (bom)
+			units.push_back(0xfeff);
+		UTF8_Reader reader(utf8.data(), utf8.length());
+		while (!reader.is_end())
+		{
+			unsigned int c = reader.get_char();
+			reader.next();
+			if (!utf32 && c >= 0x10000)
+			{
+				units.push_back(0xd800 + ((c - 0x10000) >> 10));
+				units.push_back(0xdc00 + ((c - 0x10000) & 0x3ff));
+			}
+			else
+			{
+				units.push_back(c);
+			}
+		}
+
+		int unit_size = utf32 ? 4 : 2;
+		std::string bytes;
+		bytes.reserve(units.size() * unit_size);
+		for (unsigned int unit : units)
+		{
+			for (int i = 0; i < unit_size; i++)
+			{
+				int shift = big_endian ? (unit_size - 1 - i) * 8 : i * 8;
+				bytes += (char)((unit >> shift) & 0xff);
+			}
+		}
+		return bytes;
+	}
+
+	void check_tokens(const std::string &bytes, const std::vector<ExpectedToken> &expected, const char *description)
+	{
+		DataBuffer buffer(bytes.data(), bytes.length());
+		MemoryDevice device(buffer);
+		XMLTokenizer tokenizer(device);
+
+		for (size_t i = 0; i < expected.size(); i++)
+		{
+			XMLToken token = tokenizer.next();
+			const ExpectedToken &e = expected[i];
+			bool same = token.type == e.type && token.variant == e.variant && token.name == e.name && token.value == e.value && token.attributes.size() == e.attributes.size();
+			for (size_t j = 0; same && j < e.attributes.size(); j++)
+				same = token.attributes[j].first == e.attributes[j].first && token.attributes[j].second == e.attributes[j].second;
+			if (!same)
+				throw Exception(string_format("XMLTokenizer test failed: %1, token %2", description, (int)i));
+		}
+		if (tokenizer.next().type != XMLToken::NULL_TOKEN)
+			throw Exception(string_format("XMLTokenizer test failed: %1, tokens after end", description));
+	}
+
+	std::vector<XMLToken> tokenize(const std::string &bytes)
+	{
+		DataBuffer buffer(bytes.data(), bytes.length());
+		MemoryDevice device(buffer);
+		XMLTokenizer tokenizer(device);
+		std::vector<XMLToken> tokens;
+		while (true)
+		{
+			XMLToken token = tokenizer.next();
+			if (token.type == XMLToken::NULL_TOKEN)
+				break;
+			tokens.push_back(token);
+		}
+		return tokens;
+	}
+}
+
+void TestApp::test_xml_tokenizer()
+{
+	Console::write_line(" Header: xml_tokenizer.h");
+	Console::write_line("  Class: XMLTokenizer");
+
+	Console::write_line("   Function: next() on small documents");
+	{
+		std::vector<XMLToken> tokens = tokenize("<a x=\"1 &amp;&amp; 2\" y='&lt;&quot;&gt;' z=plain&amp; >t &apos;&amp;quot; t<b/></a>");
+		if (tokens.size() != 4 || tokens[0].attributes.size() != 3)
+			throw Exception("XMLTokenizer test failed: small document");
+		if (tokens[0].attributes[0].second != "1 && 2" || tokens[0].attributes[1].second != "<\">" || tokens[0].attributes[2].second != "plain&")
+			throw Exception("XMLTokenizer test failed: attribute entities");
+		if (tokens[1].value != "t '&quot; t" || tokens[2].name != "b" || tokens[2].variant != XMLToken::SINGLE)
+			throw Exception("XMLTokenizer test failed: text entities");
+
+		tokens = tokenize("");
+		if (!tokens.empty())
+			throw Exception("XMLTokenizer test failed: empty document");
+
+		tokens = tokenize("\xef\xbb\xbf<a>text</a>");
+		if (tokens.size() != 3 || tokens[0].name != "a" || tokens[1].value != "text")
+			throw Exception("XMLTokenizer test failed: UTF-8 byte order mark");
+	}
+
+	Console::write_line("   Function: next() across chunk boundaries");
+	std::string reference_document;
+	std::vector<ExpectedToken> reference_tokens;
+	for (unsigned int seed = 1; seed <= 6; seed++)
+	{
+		DocumentBuilder builder(seed);
+		builder.build(seed == 1 ? 2 * 1024 * 1024 : 300 * 1024);
+		check_tokens(builder.document, builder.tokens, "UTF-8 document");
+		if (seed == 2)
+		{
+			reference_document = builder.document;
+			reference_tokens = builder.tokens;
+		}
+	}
+
+	Console::write_line("   Function: next() on UTF-16 and UTF-32 documents");
+	{
+		check_tokens(encode(reference_document, false, false, true), reference_tokens, "UTF-16LE document");
+		check_tokens(encode(reference_document, false, true, true), reference_tokens, "UTF-16BE document");
+		check_tokens(encode(reference_document, false, false, false), reference_tokens, "UTF-16LE document without byte order mark");
+		check_tokens(encode(reference_document, false, true, false), reference_tokens, "UTF-16BE document without byte order mark");
+		check_tokens(encode(reference_document, true, false, true), reference_tokens, "UTF-32LE document");
+		check_tokens(encode(reference_document, true, true, false), reference_tokens, "UTF-32BE document without byte order mark");
+
+		// Unpaired surrogates become U+FFFD
+		std::string bytes = encode("<a>x</a>", false, false, true);
+		bytes.insert(8, std::string("\x00\xd8", 2));
+		std::vector<XMLToken> tokens = tokenize(bytes);
+		if (tokens.size() != 3 || tokens[1].value != "\xef\xbf\xbdx")
+			throw Exception("XMLTokenizer test failed: unpaired surrogate");
+
+		bytes = encode("<a/>", false, true, true) + std::string("\xd8\x00", 2);
+		tokens = tokenize(bytes);
+		if (tokens.size() != 2 || tokens[1].value != "\xef\xbf\xbd")
+			throw Exception("XMLTokenizer test failed: surrogate at end of input");
+	}
+
+	Console::write_line("   Function: error line numbers after discarded chunks");
+	{
+		std::string document = "<root>\n";
+		for (int i = 0; i < 20000; i++)
+			document += "<item value=\"some text to fill the line\"/>\n";
+		document += "<broken attribute x=\"1\"/>\n</root>";
+		try
+		{
+			tokenize(document);
+			throw Exception("XMLTokenizer test failed: malformed document accepted");
+		}
+		catch (const Exception &e)
+		{
+			if (e.message.find("at line 20002 ") == std::string::npos)
+				throw Exception("XMLTokenizer test failed: wrong line number: " + e.message);
+		}
+	}
+
+	Console::write_line("   Throughput");
+	{
+		DocumentBuilder builder(4711);
+		builder.build(16 * 1024 * 1024);
+		auto start = std::chrono::steady_clock::now();
+		size_t count = tokenize(builder.document).size();
+		auto end = std::chrono::steady_clock::now();
+		double seconds = std::chrono::duration<double>(end - start).count();
+		Console::write_line(string_format("    %1 MB, %2 tokens: %3 MB/s", (int)(builder.document.length() / (1024 * 1024)), (int)count, (int)(builder.document.length() / (1024 * 1024) / seconds)));
+	}
+}
@@ -0,0 +1,211 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "test.h"
+
+namespace
+{
+	DomDocument load_document(const std::string &text)
+	{
+		DataBuffer buffer(text.data(), text.length());
+		MemoryDevice device(buffer);
+		return DomDocument(device);
+	}
+
+	std::string to_string(const XPathObject &object)
+	{
+		switch (object.get_type())
+		{
+		case XPathObject::type_null:
+			return "null";
+		case XPathObject::type_boolean:
+			return object.get_boolean() ? "true" : "false";
+		case XPathObject::type_number:
+			return StringHelp::int_to_text((int)object.get_number());
+		case XPathObject::type_string:
+			return "'" + object.get_string() + "'";
+		case XPathObject::type_node_set:
+		default:
+		{
+			std::string result = "{";
+			for (auto &node : object.get_node_set())
+				result += " " + node.get_node_name() + "=" + node.get_node_value() + (node.is_element() ? node.to_element().get_text() : std::string());
+			return result + " }";
+		}
+		}
+	}
+
+	void check(const XPathObject &object, const std::string &expected, const std::string &expression)
+	{
+		std::string result = to_string(object);
+		if (result != expected)
+			throw Exception("XPath test failed: " + expression + " returned " + result + ", expected " + expected);
+	}
+}
+
+void TestApp::test_xpath()
+{
+	Console::write_line(" Header: xpath_evaluator.h, xpath_expression.h");
+	Console::write_line("  Compiled and cached expressions");
+
+	DomDocument document = load_document(
+		"<root>"
+		"<item id='a' value='3'><name>First</name></item>"
+		"<item id='b' value='7'><name>Second</name><tag>x</tag></item>"
+		"<item id='c' value='9'><name>Third</name><tag>y</tag><tag>z</tag></item>"
+		"</root>");
+
+	struct Case
+	{
+		const char *expression;
+		const char *expected;
+	};
+	const Case cases[] =
+	{
+		{ "root/item[@value > 5]/name", "{ name=Second name=Third }" },
+		{ "root/item[2]/@id", "{ id=b }" },
+		{ "root/item[tag[2] = 'z']/name", "{ name=Third }" },
+		{ "root/item[count(tag) = 1 or @id = 'a']/@id", "{ id=a id=b }" },
+		{ "(root/item)[last()]/name", "{ name=Third }" },
+		{ "//tag[1]", "{ tag=x tag=y }" },
+		{ "root/item[1]/following-sibling::item/@id", "{ id=b id=c }" },
+		{ "root/item[name = 'Second']/preceding-sibling::item/@id", "{ id=a }" },
+		{ "2 * sum(root/item/@value)", "38" },
+		{ "concat(root/item[3]/name, '-', root/item[1]/@id)", "'Third-a'" },
+		{ "not(root/item[@value > 10])", "true" },
+	};
+
+	Console::write_line("   Function: evaluate(const std::string &)");
+	{
+		XPathEvaluator evaluator;
+		for (int pass = 0; pass < 2; pass++)
+		{
+			for (const auto &test_case : cases)
+				check(evaluator.evaluate(test_case.expression, document), test_case.expected, test_case.expression);
+		}
+	}
+
+	Console::write_line("   Function: evaluate(const XPathExpression &)");
+	{
+		XPathEvaluator evaluator;
+		for (const auto &test_case : cases)
+		{
+			XPathExpression expression(test_case.expression);
+			if (expression.is_null() || expression.get_expression() != test_case.expression)
+				throw Exception("XPath test failed: get_expression()");
+			check(evaluator.evaluate(expression, document), test_case.expected, test_case.expression);
+			check(XPathEvaluator().evaluate(expression, document), test_case.expected, test_case.expression);
+		}
+
+		// One compiled expression evaluated against different context nodes
+		XPathExpression name("name");
+		std::string names;
+		for (DomNode item = document.get_document_element().get_first_child(); !item.is_null(); item = item.get_next_sibling())
+			names += evaluator.evaluate(name, item).get_node_set().at(0).to_element().get_text();
+		if (names != "FirstSecondThird")
+			throw Exception("XPath test failed: compiled expression with several context nodes");
+	}
+
+	Console::write_line("   Function: expression cache eviction");
+	{
+		XPathEvaluator evaluator;
+		for (int i = 0; i < 200; i++)
+		{
+			std::string expression = string_format("count(root/item[@value > %1])", i % 100);
+			double expected = (i % 100) < 3 ? 3 : (i % 100) < 7 ? 2 : (i % 100) < 9 ? 1 : 0;
+			if (evaluator.evaluate(expression, document).get_number() != expected)
+				throw Exception("XPath test failed: " + expression);
+		}
+		check(evaluator.evaluate(cases[0].expression, document), cases[0].expected, cases[0].expression);
+	}
+
+	Console::write_line("   Function: syntax errors");
+	{
+		const char *invalid[] = { "'unterminated", "root/item[", "root/item]", "bogus::item", "" };
+		XPathEvaluator evaluator;
+		for (auto expression : invalid)
+		{
+			for (int pass = 0; pass < 2; pass++)
+			{
+				bool thrown = false;
+				try
+				{
+					evaluator.evaluate(expression, document);
+				}
+				catch (const XPathException &)
+				{
+					thrown = true;
+				}
+				if (!thrown)
+					throw Exception(std::string("XPath test failed: no exception for ") + expression);
+			}
+		}
+
+		bool thrown = false;
+		try
+		{
+			evaluator.evaluate(XPathExpression(), document);
+		}
+		catch (const Exception &)
+		{
+			thrown = true;
+		}
+		if (!thrown)
+			throw Exception("XPath test failed: null expression was evaluated");
+	}
+
+	Console::write_line("   Benchmark: repeated evaluation");
+	{
+		std::string text = "<root>";
+		for (int i = 0; i < 20; i++)
+			text += string_format("<item id='i%1' value='%2'><name>Item</name></item>", i, i % 10);
+		text += "</root>";
+		DomDocument small = load_document(text);
+
+		const std::string expression_text = "count(root/item[@value > 5 and @id != 'i3']/name)";
+		const int iterations = 5000;
+
+		uint64_t start = System::get_microseconds();
+		double total = 0.0;
+		for (int i = 0; i < iterations; i++)
+			total += XPathEvaluator().evaluate(expression_text, small).get_number();
+		uint64_t uncached_time = System::get_microseconds() - start;
+
+		XPathEvaluator evaluator;
+		XPathExpression expression(expression_text);
+		start = System::get_microseconds();
+		for (int i = 0; i < iterations; i++)
+			total += evaluator.evaluate(expression, small).get_number();
+		uint64_t compiled_time = System::get_microseconds() - start;
+
+		if (total != 2 * iterations * 8)
+			throw Exception("XPath test failed: benchmark result");
+
+		Console::write_line(string_format("    %1 evaluations: compiled each time %2 ms, compiled once %3 ms", iterations, (int)(uncached_time / 1000), (int)(compiled_time / 1000)));
+	}
+}
@@ -1,6 +1,5 @@
 
-#include <ClanLib/core.h>
-using namespace clan;
+#include "test.h"
 
 void TestXMLFile(const std::string &filename)
 {
@@ -27,13 +26,40 @@ void TestXMLFile(const std::string &filename)
 
 int main(int, char**)
 {
+	TestApp program;
+	return program.main();
+}
+
+int TestApp::main()
+{
+	ConsoleWindow console("Console");
+
+	try
+	{
+		test_xml_files();
+		test_xml_tokenizer();
+		test_xml_reader();
+		test_dom_strings();
+		test_xpath();
+		test_dom_index();
+		console.display_close_message();
+	}
+	catch(Exception error)
+	{
+		Console::write_line("Unhandled exception: %1", error.message);
+		console.display_close_message();
+		return -1;
+	}
+
+	return 0;
+}
 
+void TestApp::test_xml_files()
+{
 	TestXMLFile("test-emeditor-utf8-iso-8859-1.xml");
 	TestXMLFile("test-emeditor-utf8-withoutsignature.xml");
 	TestXMLFile("test-emeditor-utf8-withsignature.xml");
 	TestXMLFile("test-notepad-utf8.xml");
 	TestXMLFile("test-notepad-unicode.xml");
 	TestXMLFile("test-notepad-ansi.xml");
-
-	return 0;
 }
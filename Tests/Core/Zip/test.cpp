@@ -41,6 +41,10 @@ int TestApp::main()
 	try
 	{
 		run_test();
+		test_zip_archive();
+		test_zip_seek();
+		test_zip_writer();
+		test_zip_lz4();
 		console.display_close_message();
 	}
 	catch(Exception error)
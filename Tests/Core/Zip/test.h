@@ -40,6 +40,10 @@ public:
 
 private:
 	void run_test();
+	void test_zip_archive();
+	void test_zip_seek();
+	void test_zip_writer();
+	void test_zip_lz4();
 };
 
 #endif
@@ -0,0 +1,137 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#include "test.h"
+
+namespace
+{
+	void check(bool condition, const char *message)
+	{
+		if (!condition)
+			throw Exception(string_format("ZipArchive test failed: %1", message));
+	}
+
+	bool contains(const std::vector<ZipFileEntry> &entries, const std::string &name, bool is_directory)
+	{
+		for (const auto &entry : entries)
+		{
+			if (entry.get_archive_filename() == name && entry.is_directory() == is_directory)
+				return true;
+		}
+		return false;
+	}
+}
+
+void TestApp::test_zip_archive()
+{
+	const std::string filename = "ZipArchiveIndex.zip";
+	const int num_directories = 100;
+	const int files_per_directory = 200;
+
+	{
+		File file(filename, File::create_always, File::access_write);
+		file.set_buffer_size(0, 64 * 1024);
+		ZipWriter zip_writer(file);
+		zip_writer.begin_file("readme.txt", false);
+		zip_writer.write_file_data("root", 4);
+		zip_writer.end_file();
+		zip_writer.begin_file("empty/", false);
+		zip_writer.end_file();
+		for (int dir = 0; dir < num_directories; dir++)
+		{
+			for (int cnt = 0; cnt < files_per_directory; cnt++)
+			{
+				std::string name = string_format("assets/dir%1/file%2.txt", dir, cnt);
+				zip_writer.begin_file(name, false);
+				zip_writer.write_file_data(name.data(), name.size());
+				zip_writer.end_file();
+			}
+		}
+		zip_writer.write_toc();
+		file.close();
+	}
+
+	uint64_t start_time = System::get_microseconds();
+	ZipArchive archive(filename);
+	uint64_t load_time = System::get_microseconds() - start_time;
+
+	check(archive.get_file_list().size() == 2 + num_directories * files_per_directory, "file count");
+
+	std::vector<ZipFileEntry> root = archive.get_file_list("/");
+	check(root.size() == 3, "root listing size");
+	check(root[0].get_archive_filename() == "readme.txt" && !root[0].is_directory(), "root listing order");
+	check(contains(root, "empty", true), "directory record listed");
+	check(contains(root, "assets", true), "implicit directory listed");
+	check(archive.get_file_list("").size() == 3, "empty path lists root");
+	check(archive.get_file_list("empty").empty(), "empty directory");
+	check(archive.get_file_list("missing/").empty(), "missing directory");
+	check(archive.get_file_list("assets").size() == num_directories, "subdirectory listing");
+
+	std::vector<ZipFileEntry> dir = archive.get_file_list("/assets/dir42/");
+	check(dir.size() == files_per_directory, "file listing size");
+	check(contains(dir, "file7.txt", false), "file listed");
+
+	std::string contents(4, 0);
+	IODevice device = archive.open_file("readme.txt");
+	device.read(&contents[0], 4);
+	check(contents == "root", "open root file");
+
+	bool not_found = false;
+	try
+	{
+		archive.open_file("assets/dir0/missing.txt");
+	}
+	catch (const Exception &)
+	{
+		not_found = true;
+	}
+	check(not_found, "missing file throws");
+
+	const int lookups = 10000;
+	start_time = System::get_microseconds();
+	for (int cnt = 0; cnt < lookups; cnt++)
+	{
+		std::string name = string_format("assets/dir%1/file%2.txt", (cnt * 7) % num_directories, (cnt * 13) % files_per_directory);
+		IODevice file = archive.open_file(name);
+		std::string data(file.get_size(), 0);
+		file.read(&data[0], data.size());
+		check(data == name, "file contents");
+	}
+	uint64_t lookup_time = System::get_microseconds() - start_time;
+
+	start_time = System::get_microseconds();
+	for (int cnt = 0; cnt < lookups; cnt++)
+		archive.get_file_list(string_format("assets/dir%1", cnt % num_directories));
+	uint64_t listing_time = System::get_microseconds() - start_time;
+
+	Console::write_line("ZipArchive with %1 entries: load %2 ms, %3 opens %4 ms, %5 listings %6 ms",
+		num_directories * files_per_directory + 2, (int)(load_time / 1000), lookups, (int)(lookup_time / 1000), lookups, (int)(listing_time / 1000));
+
+	FileHelp::delete_file(filename);
+}
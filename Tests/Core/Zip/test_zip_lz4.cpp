@@ -0,0 +1,178 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#include "test.h"
+
+void TestApp::test_zip_lz4()
+{
+	const std::string filename = "ZipLZ4.zip";
+
+	// Random sentences from a small vocabulary
+	const char *words[] = { "pack ", "my ", "box ", "with ", "five ", "dozen ", "liquor ", "jugs. " };
+	DataBuffer text(3 * 1024 * 1024 + 333);
+	unsigned int seed = 7;
+	for (unsigned int pos = 0; pos < text.get_size();)
+	{
+		seed = seed * 1103515245 + 12345;
+		const char *word = words[(seed >> 16) % 8];
+		for (int i = 0; word[i] && pos < text.get_size(); i++)
+			text[pos++] = word[i];
+	}
+	DataBuffer random_data(200 * 1024);
+	for (unsigned int pos = 0; pos < random_data.get_size(); pos++)
+	{
+		seed = seed * 1103515245 + 12345;
+		random_data[pos] = (char)(seed >> 24);
+	}
+
+	{
+		WorkQueue queue;
+		File file(filename, File::create_always, File::access_write);
+		ZipWriter zip_writer(file);
+
+		// Streamed in uneven pieces so blocks are assembled across write calls
+		zip_writer.begin_file("streamed.txt", ZipWriter::compress_lz4);
+		unsigned int pos = 0;
+		for (unsigned int piece = 1; pos < text.get_size(); piece = piece * 3 + 1)
+		{
+			unsigned int length = std::min(piece % 100000, text.get_size() - pos);
+			zip_writer.write_file_data(text.get_data() + pos, length);
+			pos += length;
+		}
+		zip_writer.end_file();
+
+		zip_writer.begin_file("deflate.txt", ZipWriter::compress_deflate);
+		zip_writer.write_file_data(text.get_data(), text.get_size());
+		zip_writer.end_file();
+
+		zip_writer.add_file("tiny.txt", DataBuffer("tiny", 4), ZipWriter::compress_lz4);
+		zip_writer.begin_file("empty.txt", ZipWriter::compress_lz4);
+		zip_writer.end_file();
+		zip_writer.add_file("random.bin", random_data, ZipWriter::compress_lz4);
+		zip_writer.write_toc();
+		file.close();
+	}
+
+	{
+		WorkQueue queue;
+		File file("ZipLZ4Parallel.zip", File::create_always, File::access_write);
+		ZipWriter zip_writer(file, queue);
+		zip_writer.add_file("parallel.txt", text, ZipWriter::compress_lz4);
+		zip_writer.write_toc();
+		file.close();
+	}
+
+	ZipArchive archive(filename);
+	ZipArchive parallel_archive("ZipLZ4Parallel.zip");
+	std::vector<ZipFileEntry> files = archive.get_file_list();
+	if (files[0].get_compressed_size() >= text.get_size() / 2)
+		throw Exception("ZipArchive LZ4 test failed: text did not compress");
+	if (files[4].get_compressed_size() != random_data.get_size())
+		throw Exception("ZipArchive LZ4 test failed: incompressible entry was not stored");
+	if (parallel_archive.get_file_list()[0].get_compressed_size() != files[0].get_compressed_size())
+		throw Exception("ZipArchive LZ4 test failed: parallel output differs");
+
+	auto check_entry = [&](ZipArchive &zip, const std::string &name, const DataBuffer &expected)
+	{
+		IODevice device = zip.open_file(name);
+		if (device.get_size() != (int)expected.get_size())
+			throw Exception(string_format("ZipArchive LZ4 test failed: size of %1", name));
+		DataBuffer data(expected.get_size());
+		if (data.get_size() > 0 && device.read(data.get_data(), data.get_size()) != (int)data.get_size())
+			throw Exception(string_format("ZipArchive LZ4 test failed: read of %1", name));
+		if (data.get_size() > 0 && memcmp(data.get_data(), expected.get_data(), data.get_size()) != 0)
+			throw Exception(string_format("ZipArchive LZ4 test failed: data in %1", name));
+	};
+	check_entry(archive, "streamed.txt", text);
+	check_entry(archive, "tiny.txt", DataBuffer("tiny", 4));
+	check_entry(archive, "empty.txt", DataBuffer());
+	check_entry(archive, "random.bin", random_data);
+	check_entry(parallel_archive, "parallel.txt", text);
+
+	// Random seeks, both directions
+	IODevice device = archive.open_file("streamed.txt");
+	for (int cnt = 0; cnt < 200; cnt++)
+	{
+		seed = seed * 1103515245 + 12345;
+		int position = (seed >> 8) % (text.get_size() - 4);
+		device.seek(position);
+		char value[4];
+		device.read(value, 4);
+		if (memcmp(value, text.get_data() + position, 4) != 0)
+			throw Exception(string_format("ZipArchive LZ4 test failed: seek to %1", position));
+	}
+
+	// Sequential reads with ZipReader, walking every entry
+	const char *entry_names[] = { "streamed.txt", "deflate.txt", "tiny.txt", "empty.txt", "random.bin" };
+	DataBuffer entry_data[] = { text, text, DataBuffer("tiny", 4), DataBuffer(), random_data };
+	File file(filename, File::open_existing, File::access_read);
+	ZipReader reader(file);
+	int entry_count = 0;
+	while (reader.read_local_file_header())
+	{
+		if (entry_count == 5 || reader.get_filename() != entry_names[entry_count])
+			throw Exception(string_format("ZipReader LZ4 test failed: header %1", entry_count));
+		const DataBuffer &expected = entry_data[entry_count];
+		if (reader.get_uncompressed_size() != expected.get_size())
+			throw Exception(string_format("ZipReader LZ4 test failed: size of %1", reader.get_filename()));
+		DataBuffer data(expected.get_size());
+		if (data.get_size() > 0 && (reader.read_file_data(data.get_data(), data.get_size()) != data.get_size() || memcmp(data.get_data(), expected.get_data(), data.get_size()) != 0))
+			throw Exception(string_format("ZipReader LZ4 test failed: data in %1", reader.get_filename()));
+		entry_count++;
+	}
+	if (entry_count != 5)
+		throw Exception("ZipReader LZ4 test failed: not all entries were read");
+	file.close();
+
+	// An entry that is only partly read is skipped by the next read_local_file_header
+	File partial_file(filename, File::open_existing, File::access_read);
+	ZipReader partial_reader(partial_file);
+	char prefix[16];
+	if (!partial_reader.read_local_file_header() || partial_reader.read_file_data(prefix, 16) != 16 || memcmp(prefix, text.get_data(), 16) != 0)
+		throw Exception("ZipReader LZ4 test failed: partial read");
+	if (!partial_reader.read_local_file_header() || partial_reader.get_filename() != "deflate.txt")
+		throw Exception("ZipReader LZ4 test failed: skip after partial read");
+	partial_file.close();
+
+	const int iterations = 10;
+	DataBuffer buffer(text.get_size());
+	uint64_t start_time = System::get_microseconds();
+	for (int cnt = 0; cnt < iterations; cnt++)
+		archive.open_file("deflate.txt").read(buffer.get_data(), buffer.get_size());
+	uint64_t deflate_time = System::get_microseconds() - start_time;
+	start_time = System::get_microseconds();
+	for (int cnt = 0; cnt < iterations; cnt++)
+		archive.open_file("streamed.txt").read(buffer.get_data(), buffer.get_size());
+	uint64_t lz4_time = System::get_microseconds() - start_time;
+	Console::write_line("ZipArchive read %1 MB: deflate %2 ms (%3 bytes), lz4 %4 ms (%5 bytes)",
+		iterations * 3, (int)(deflate_time / 1000), (int)files[1].get_compressed_size(), (int)(lz4_time / 1000), (int)files[0].get_compressed_size());
+
+	FileHelp::delete_file(filename);
+	FileHelp::delete_file("ZipLZ4Parallel.zip");
+}
@@ -0,0 +1,90 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#include "test.h"
+
+void TestApp::test_zip_seek()
+{
+	const std::string filename = "ZipSeek.zip";
+	const int data_size = 8 * 1024 * 1024;
+
+	// Compressible data where every position has a unique value
+	std::vector<uint32_t> data(data_size / 4);
+	for (size_t cnt = 0; cnt < data.size(); cnt++)
+		data[cnt] = (uint32_t)(cnt * 2654435761u) & 0x00ff00ff;
+
+	{
+		File file(filename, File::create_always, File::access_write);
+		ZipWriter zip_writer(file);
+		zip_writer.begin_file("data.bin", true);
+		zip_writer.write_file_data(data.data(), data_size);
+		zip_writer.end_file();
+		zip_writer.write_toc();
+		file.close();
+	}
+
+	ZipArchive archive(filename);
+	IODevice device = archive.open_file("data.bin");
+	if (device.get_size() != data_size)
+		throw Exception("ZipArchive seek test failed: size");
+
+	// The first pass decompresses the whole entry once and records access points
+	const int num_seeks = 500;
+	uint64_t start_time = System::get_microseconds();
+	for (int pass = 0; pass < 2; pass++)
+	{
+		unsigned int seed = 12345;
+		for (int cnt = 0; cnt < num_seeks; cnt++)
+		{
+			seed = seed * 1103515245 + 12345;
+			int index = (seed >> 8) % data.size();
+			if (!device.seek(index * 4))
+				throw Exception("ZipArchive seek test failed: seek");
+			if (device.read_uint32() != data[index])
+				throw Exception(string_format("ZipArchive seek test failed: data at %1", index * 4));
+		}
+		if (pass == 0)
+		{
+			Console::write_line("ZipArchive deflate seeks: first %1 random reads %2 ms", num_seeks, (int)((System::get_microseconds() - start_time) / 1000));
+			start_time = System::get_microseconds();
+		}
+	}
+	Console::write_line("ZipArchive deflate seeks: next %1 random reads %2 ms", num_seeks, (int)((System::get_microseconds() - start_time) / 1000));
+
+	// A second device on the same entry reuses the access points
+	IODevice device2 = archive.open_file("data.bin");
+	device2.seek(data_size - 4);
+	if (device2.read_uint32() != data.back())
+		throw Exception("ZipArchive seek test failed: second device");
+	device2.seek(-8, IODevice::seek_cur);
+	if (device2.read_uint32() != data[data.size() - 2])
+		throw Exception("ZipArchive seek test failed: relative seek");
+
+	FileHelp::delete_file(filename);
+}
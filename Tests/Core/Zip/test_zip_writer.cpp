@@ -0,0 +1,150 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#include "test.h"
+
+void TestApp::test_zip_writer()
+{
+	const std::string filename = "ZipWriterParallel.zip";
+
+	// Text-like data that compresses well, small entries and random data that doesn't compress at all
+	std::vector<DataBuffer> entries;
+	std::vector<std::string> names;
+	for (int cnt = 0; cnt < 8; cnt++)
+	{
+		DataBuffer data(4 * 1024 * 1024 + cnt * 1001);
+		unsigned int seed = cnt + 1;
+		for (unsigned int pos = 0; pos < data.get_size(); pos++)
+		{
+			seed = seed * 1103515245 + 12345;
+			data[pos] = "the quick brown fox jumps over the lazy dog "[(pos + (seed >> 28)) % 44];
+		}
+		entries.push_back(data);
+		names.push_back(string_format("text%1.txt", cnt));
+	}
+	entries.push_back(DataBuffer("tiny", 4));
+	names.push_back("tiny.txt");
+	entries.push_back(DataBuffer());
+	names.push_back("empty.txt");
+	DataBuffer random_data(1024 * 1024);
+	unsigned int seed = 42;
+	for (unsigned int pos = 0; pos < random_data.get_size(); pos++)
+	{
+		seed = seed * 1103515245 + 12345;
+		random_data[pos] = (char)(seed >> 24);
+	}
+	entries.push_back(random_data);
+	names.push_back("random.bin");
+
+	int64_t serial_size = 0;
+	uint64_t start_time = System::get_microseconds();
+	{
+		File file(filename, File::create_always, File::access_write);
+		ZipWriter zip_writer(file);
+		for (size_t cnt = 0; cnt < entries.size(); cnt++)
+		{
+			zip_writer.begin_file(names[cnt], true);
+			zip_writer.write_file_data(entries[cnt].get_data(), entries[cnt].get_size());
+			zip_writer.end_file();
+		}
+		zip_writer.write_toc();
+		serial_size = file.get_size();
+		file.close();
+	}
+	Console::write_line("ZipWriter: serial %1 ms", (int)((System::get_microseconds() - start_time) / 1000));
+
+	int64_t parallel_size = 0;
+	start_time = System::get_microseconds();
+	{
+		WorkQueue queue;
+		File file(filename, File::create_always, File::access_write);
+		ZipWriter zip_writer(file, queue);
+		for (size_t cnt = 0; cnt < entries.size(); cnt++)
+		{
+			if (cnt % 2)
+			{
+				zip_writer.add_file(names[cnt], entries[cnt], true);
+			}
+			else
+			{
+				// Write in pieces to exercise the entry buffering
+				zip_writer.begin_file(names[cnt], true);
+				unsigned int half = entries[cnt].get_size() / 2;
+				zip_writer.write_file_data(entries[cnt].get_data(), half);
+				zip_writer.write_file_data(entries[cnt].get_data() + half, entries[cnt].get_size() - half);
+				zip_writer.end_file();
+			}
+		}
+		zip_writer.write_toc();
+		parallel_size = file.get_size();
+		file.close();
+	}
+	Console::write_line("ZipWriter: parallel %1 ms on %2 threads", (int)((System::get_microseconds() - start_time) / 1000), WorkQueue().get_num_threads());
+
+	// Chunks don't share a dictionary, so the parallel archive may only be slightly larger. The random entry is stored.
+	if (parallel_size > serial_size * 105 / 100)
+		throw Exception(string_format("ZipWriter parallel output too large: %1 vs %2", (int)parallel_size, (int)serial_size));
+
+	ZipArchive archive(filename);
+	std::vector<ZipFileEntry> files = archive.get_file_list();
+	if (files.size() != entries.size())
+		throw Exception("ZipWriter parallel test failed: entry count");
+	for (size_t cnt = 0; cnt < entries.size(); cnt++)
+	{
+		if (files[cnt].get_archive_filename() != names[cnt])
+			throw Exception("ZipWriter parallel test failed: entry order");
+		if (files[cnt].get_uncompressed_size() != entries[cnt].get_size())
+			throw Exception("ZipWriter parallel test failed: entry size");
+
+		IODevice device = archive.open_file(names[cnt]);
+		DataBuffer data(entries[cnt].get_size());
+		if (data.get_size() > 0)
+			device.read(data.get_data(), data.get_size());
+		if (data.get_size() > 0 && memcmp(data.get_data(), entries[cnt].get_data(), data.get_size()) != 0)
+			throw Exception(string_format("ZipWriter parallel test failed: data in %1", names[cnt]));
+	}
+	if (files.back().get_compressed_size() != random_data.get_size())
+		throw Exception("ZipWriter parallel test failed: incompressible entry was not stored");
+
+	// Level 0 stores everything
+	{
+		WorkQueue queue;
+		File file(filename, File::create_always, File::access_write);
+		ZipWriter zip_writer(file, queue);
+		zip_writer.set_compression_level(0);
+		zip_writer.add_file(names[0], entries[0], true);
+		zip_writer.write_toc();
+		file.close();
+	}
+	ZipArchive stored_archive(filename);
+	if (stored_archive.get_file_list()[0].get_compressed_size() != entries[0].get_size())
+		throw Exception("ZipWriter parallel test failed: compression level 0");
+
+	FileHelp::delete_file(filename);
+}